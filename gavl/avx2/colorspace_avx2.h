@@ -0,0 +1,439 @@
+/*****************************************************************
+ * gavl - a general purpose audio/video processing library
+ *
+ * Copyright (c) 2001 - 2012 Members of the Gmerlin project
+ * gmerlin-general@lists.sourceforge.net
+ * http://gmerlin.sourceforge.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * *****************************************************************/
+
+/*
+ *  Helpers for the AVX2 colorspace conversions.
+ *
+ *  8 bit routines handle 16 pixels at once. Pixels are kept as 16 bit
+ *  words in a ymm register, pixels 0-7 in the lower and 8-15 in the
+ *  upper 128 bit lane. 16 bit routines handle 8 pixels as floats.
+ */
+
+#include <config.h>
+#include <string.h>
+#include <immintrin.h>
+
+#include <gavl/gavl.h>
+#include <video.h>
+#include <colorspace.h>
+#include <attributes.h>
+
+/* Byte shuffle masks */
+
+static const uint8_t shuffle_yuy2_u[32] =
+  { 0,1,0,1,4,5,4,5,8,9,8,9,12,13,12,13,
+    0,1,0,1,4,5,4,5,8,9,8,9,12,13,12,13 };
+
+static const uint8_t shuffle_yuy2_v[32] =
+  { 2,3,2,3,6,7,6,7,10,11,10,11,14,15,14,15,
+    2,3,2,3,6,7,6,7,10,11,10,11,14,15,14,15 };
+
+/* 4 RGBA pixels -> 4 RGB pixels */
+static const uint8_t shuffle_32_24[16] =
+  { 0,1,2,4,5,6,8,9,10,12,13,14,0x80,0x80,0x80,0x80 };
+
+/* 4 RGBA pixels -> R0-3 G0-3 B0-3 A0-3 */
+static const uint8_t shuffle_32_planar[16] =
+  { 0,4,8,12,1,5,9,13,2,6,10,14,3,7,11,15 };
+
+/* 4 RGB pixels -> R0-3 G0-3 B0-3 0 */
+static const uint8_t shuffle_24_planar[16] =
+  { 0,3,6,9,1,4,7,10,2,5,8,11,0x80,0x80,0x80,0x80 };
+
+/* Same, but the pixels start at byte 4 */
+static const uint8_t shuffle_24_planar_4[16] =
+  { 4,7,10,13,5,8,11,14,6,9,12,15,0x80,0x80,0x80,0x80 };
+
+/* Even bytes of 16 bytes */
+static const uint8_t shuffle_even_8[16] =
+  { 0,2,4,6,8,10,12,14,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80 };
+
+/* Even words of 8 words */
+static const uint8_t shuffle_even_16[16] =
+  { 0,1,4,5,8,9,12,13,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80 };
+
+/* 8 pixels of RGB48 <-> planar words (see load_rgb_48 / store_rgb_48) */
+
+static const uint8_t shuffle_48[9][16] =
+  {
+    /* in0 -> R, G, B */
+    { 0,1,6,7,12,13,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80 },
+    { 2,3,8,9,14,15,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80 },
+    { 4,5,10,11,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80 },
+    /* in1 -> R, G, B */
+    { 0x80,0x80,0x80,0x80,0x80,0x80,2,3,8,9,14,15,0x80,0x80,0x80,0x80 },
+    { 0x80,0x80,0x80,0x80,0x80,0x80,4,5,10,11,0x80,0x80,0x80,0x80,0x80,0x80 },
+    { 0x80,0x80,0x80,0x80,0,1,6,7,12,13,0x80,0x80,0x80,0x80,0x80,0x80 },
+    /* in2 -> R, G, B */
+    { 0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,4,5,10,11 },
+    { 0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0,1,6,7,12,13 },
+    { 0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,2,3,8,9,14,15 },
+  };
+
+static const uint8_t shuffle_48_out[7][16] =
+  {
+    /* out0: R0 G0 B0 R1 G1 B1 R2 G2 from RG(0-3), B */
+    { 0,1,2,3,0x80,0x80,4,5,6,7,0x80,0x80,8,9,10,11 },
+    { 0x80,0x80,0x80,0x80,0,1,0x80,0x80,0x80,0x80,2,3,0x80,0x80,0x80,0x80 },
+    /* out1: B2 R3 G3 B3 R4 G4 B4 R5 from RG(0-3), RG(4-7), B */
+    { 0x80,0x80,12,13,14,15,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80 },
+    { 0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0,1,2,3,0x80,0x80,4,5 },
+    { 4,5,0x80,0x80,0x80,0x80,6,7,0x80,0x80,0x80,0x80,8,9,0x80,0x80 },
+    /* out2: G5 B5 R6 G6 B6 R7 G7 B7 from RG(4-7), B */
+    { 6,7,0x80,0x80,8,9,10,11,0x80,0x80,12,13,14,15,0x80,0x80 },
+    { 0x80,0x80,10,11,0x80,0x80,0x80,0x80,12,13,0x80,0x80,0x80,0x80,14,15 }
+  };
+
+/*
+ *  YUV -> RGB, 8 bit
+ *  Coefficients are the same as in the MMX version (scaled by 8192)
+ */
+
+#define Y_COEFF      9535 // (=          255.0/219.0 * 8192)
+#define V_RED       13074 // (=  1.40200*255.0/224.0 * 8192)
+#define U_GREEN     -3203 // (= -0.34414*255.0/224.0 * 8192)
+#define V_GREEN     -6660 // (= -0.71414*255.0/224.0 * 8192)
+#define U_BLUE      16531 // (=  1.77200*255.0/224.0 * 8192)
+
+#define YJ_COEFF     8192 // (=            8192)
+#define VJ_RED      11485 // (=  1.40200 * 8192)
+#define UJ_GREEN    -2819 // (= -0.34414 * 8192)
+#define VJ_GREEN    -5850 // (= -0.71414 * 8192)
+#define UJ_BLUE     14516 // (=  1.77200 * 8192)
+
+/* y, u and v are unsigned 8 bit values in 16 bit words */
+
+static inline void yuv_to_rgb_avx2(__m256i y, __m256i u, __m256i v,
+                                   __m256i * r, __m256i * g, __m256i * b,
+                                   int jpeg)
+  {
+  __m256i c_80 = _mm256_set1_epi16(128);
+  __m256i round = _mm256_set1_epi16(4);
+
+  /* Scale to 6 fractional bits, the multiplication leaves 3 */
+  if(jpeg)
+    y = _mm256_mulhi_epi16(_mm256_slli_epi16(y, 6),
+                           _mm256_set1_epi16(YJ_COEFF));
+  else
+    y = _mm256_mulhi_epi16(_mm256_slli_epi16(_mm256_sub_epi16(y, _mm256_set1_epi16(16)), 6),
+                           _mm256_set1_epi16(Y_COEFF));
+  u = _mm256_slli_epi16(_mm256_sub_epi16(u, c_80), 6);
+  v = _mm256_slli_epi16(_mm256_sub_epi16(v, c_80), 6);
+  y = _mm256_add_epi16(y, round);
+
+  *r = _mm256_add_epi16(y, _mm256_mulhi_epi16(v, _mm256_set1_epi16(jpeg ? VJ_RED : V_RED)));
+  *g = _mm256_add_epi16(y,
+                        _mm256_add_epi16(_mm256_mulhi_epi16(u, _mm256_set1_epi16(jpeg ? UJ_GREEN : U_GREEN)),
+                                         _mm256_mulhi_epi16(v, _mm256_set1_epi16(jpeg ? VJ_GREEN : V_GREEN))));
+  *b = _mm256_add_epi16(y, _mm256_mulhi_epi16(u, _mm256_set1_epi16(jpeg ? UJ_BLUE : U_BLUE)));
+
+  *r = _mm256_srai_epi16(*r, 3);
+  *g = _mm256_srai_epi16(*g, 3);
+  *b = _mm256_srai_epi16(*b, 3);
+  }
+
+/* Loaders for 16 pixels */
+
+static inline void load_yuv_planar_avx2(const uint8_t * src_y,
+                                        const uint8_t * src_u,
+                                        const uint8_t * src_v,
+                                        __m256i * y, __m256i * u, __m256i * v,
+                                        int sub_h)
+  {
+  *y = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)src_y));
+
+  if(sub_h == 2)
+    {
+    __m128i c;
+    c = _mm_loadl_epi64((const __m128i*)src_u);
+    *u = _mm256_cvtepu8_epi16(_mm_unpacklo_epi8(c, c));
+    c = _mm_loadl_epi64((const __m128i*)src_v);
+    *v = _mm256_cvtepu8_epi16(_mm_unpacklo_epi8(c, c));
+    }
+  else
+    {
+    *u = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)src_u));
+    *v = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)src_v));
+    }
+  }
+
+static inline void load_yuy2_avx2(const uint8_t * src,
+                                  __m256i * y, __m256i * u, __m256i * v,
+                                  int uyvy)
+  {
+  __m256i c;
+  __m256i d = _mm256_loadu_si256((const __m256i*)src);
+  __m256i mask = _mm256_set1_epi16(0x00ff);
+
+  if(uyvy)
+    {
+    *y = _mm256_srli_epi16(d, 8);
+    c = _mm256_and_si256(d, mask);
+    }
+  else
+    {
+    *y = _mm256_and_si256(d, mask);
+    c = _mm256_srli_epi16(d, 8);
+    }
+  *u = _mm256_shuffle_epi8(c, _mm256_loadu_si256((const __m256i*)shuffle_yuy2_u));
+  *v = _mm256_shuffle_epi8(c, _mm256_loadu_si256((const __m256i*)shuffle_yuy2_v));
+  }
+
+/* Store 16 pixels */
+
+static inline void store_rgb_avx2(uint8_t * dst,
+                                  __m256i r, __m256i g, __m256i b,
+                                  int bytes)
+  {
+  __m256i rg, ba, p0, p1, out0, out1;
+  __m256i a = _mm256_set1_epi8(0xff);
+
+  r = _mm256_packus_epi16(r, r);
+  g = _mm256_packus_epi16(g, g);
+  b = _mm256_packus_epi16(b, b);
+
+  rg = _mm256_unpacklo_epi8(r, g);
+  ba = _mm256_unpacklo_epi8(b, a);
+
+  p0 = _mm256_unpacklo_epi16(rg, ba); /* 0-3 | 8-11  */
+  p1 = _mm256_unpackhi_epi16(rg, ba); /* 4-7 | 12-15 */
+
+  out0 = _mm256_permute2x128_si256(p0, p1, 0x20);
+  out1 = _mm256_permute2x128_si256(p0, p1, 0x31);
+
+  if(bytes == 4)
+    {
+    _mm256_storeu_si256((__m256i*)dst, out0);
+    _mm256_storeu_si256((__m256i*)(dst+32), out1);
+    }
+  else
+    {
+    __m128i c;
+    int32_t tmp;
+    __m128i mask = _mm_loadu_si128((const __m128i*)shuffle_32_24);
+
+    /* The first 3 stores write 4 bytes too much, which are
+       overwritten by the next store */
+
+    c = _mm_shuffle_epi8(_mm256_castsi256_si128(out0), mask);
+    _mm_storeu_si128((__m128i*)dst, c);
+    c = _mm_shuffle_epi8(_mm256_extracti128_si256(out0, 1), mask);
+    _mm_storeu_si128((__m128i*)(dst+12), c);
+    c = _mm_shuffle_epi8(_mm256_castsi256_si128(out1), mask);
+    _mm_storeu_si128((__m128i*)(dst+24), c);
+    c = _mm_shuffle_epi8(_mm256_extracti128_si256(out1, 1), mask);
+    _mm_storel_epi64((__m128i*)(dst+36), c);
+    tmp = _mm_cvtsi128_si32(_mm_srli_si128(c, 8));
+    memcpy(dst+44, &tmp, 4);
+    }
+  }
+
+/*
+ *  RGB -> YUV, 8 bit
+ *  Coefficients are scaled by 32768
+ */
+
+#define R_TO_Y   8414 // (=  0.29900*219.0/255.0 * 32768)
+#define G_TO_Y  16519 // (=  0.58700*219.0/255.0 * 32768)
+#define B_TO_Y   3208 // (=  0.11400*219.0/255.0 * 32768)
+
+#define R_TO_U  -4857 // (= -0.16874*224.0/255.0 * 32768)
+#define G_TO_U  -9535 // (= -0.33126*224.0/255.0 * 32768)
+#define B_TO_U  14392 // (=  0.50000*224.0/255.0 * 32768)
+
+#define R_TO_V  14392 // (=  0.50000*224.0/255.0 * 32768)
+#define G_TO_V -12052 // (= -0.41869*224.0/255.0 * 32768)
+#define B_TO_V  -2340 // (= -0.08131*224.0/255.0 * 32768)
+
+/* Load 16 pixels, which are 3 or 4 bytes wide */
+
+static inline void load_rgb_avx2(const uint8_t * src,
+                                 __m256i * r, __m256i * g, __m256i * b,
+                                 int bytes)
+  {
+  __m128i c0, c1, c2, c3, t0, t1;
+
+  if(bytes == 4)
+    {
+    __m128i mask = _mm_loadu_si128((const __m128i*)shuffle_32_planar);
+    c0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)src), mask);
+    c1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src+16)), mask);
+    c2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src+32)), mask);
+    c3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src+48)), mask);
+    }
+  else
+    {
+    /* The last chunk is loaded from byte 32 so we don't read
+       beyond the end of the scanline */
+    __m128i mask = _mm_loadu_si128((const __m128i*)shuffle_24_planar);
+    c0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)src), mask);
+    c1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src+12)), mask);
+    c2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src+24)), mask);
+    c3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src+32)),
+                          _mm_loadu_si128((const __m128i*)shuffle_24_planar_4));
+    }
+
+  /* c0..c3: R R R R G G G G B B B B X X X X */
+
+  t0 = _mm_unpacklo_epi32(c0, c1); /* R0-3 R4-7 G0-3 G4-7 */
+  t1 = _mm_unpacklo_epi32(c2, c3); /* R8-11 R12-15 G8-11 G12-15 */
+
+  *r = _mm256_cvtepu8_epi16(_mm_unpacklo_epi64(t0, t1));
+  *g = _mm256_cvtepu8_epi16(_mm_unpackhi_epi64(t0, t1));
+
+  t0 = _mm_unpackhi_epi32(c0, c1); /* B0-3 B4-7 X X */
+  t1 = _mm_unpackhi_epi32(c2, c3); /* B8-11 B12-15 X X */
+  *b = _mm256_cvtepu8_epi16(_mm_unpacklo_epi64(t0, t1));
+  }
+
+static inline __m256i rgb_to_yuv_component_avx2(__m256i r, __m256i g,
+                                                __m256i b,
+                                                int cr, int cg, int cb,
+                                                int offset)
+  {
+  /* Values have 7 fractional bits before and 6 after the multiplication */
+  __m256i ret;
+  ret = _mm256_add_epi16(_mm256_mulhi_epi16(r, _mm256_set1_epi16(cr)),
+                         _mm256_mulhi_epi16(g, _mm256_set1_epi16(cg)));
+  ret = _mm256_add_epi16(ret, _mm256_mulhi_epi16(b, _mm256_set1_epi16(cb)));
+  ret = _mm256_add_epi16(ret, _mm256_set1_epi16((offset << 6) + 32));
+  return _mm256_srai_epi16(ret, 6);
+  }
+
+static inline void rgb_to_yuv_avx2(__m256i r, __m256i g, __m256i b,
+                                   __m256i * y, __m256i * u, __m256i * v)
+  {
+  r = _mm256_slli_epi16(r, 7);
+  g = _mm256_slli_epi16(g, 7);
+  b = _mm256_slli_epi16(b, 7);
+
+  *y = rgb_to_yuv_component_avx2(r, g, b, R_TO_Y, G_TO_Y, B_TO_Y, 16);
+  if(u)
+    {
+    *u = rgb_to_yuv_component_avx2(r, g, b, R_TO_U, G_TO_U, B_TO_U, 128);
+    *v = rgb_to_yuv_component_avx2(r, g, b, R_TO_V, G_TO_V, B_TO_V, 128);
+    }
+  }
+
+/* 16 words -> 16 bytes */
+
+static inline __m128i pack_8_avx2(__m256i v)
+  {
+  v = _mm256_packus_epi16(v, v);
+  v = _mm256_permute4x64_epi64(v, 0x08);
+  return _mm256_castsi256_si128(v);
+  }
+
+/* 16 words -> 8 bytes from the even pixels */
+
+static inline __m128i pack_8_even_avx2(__m256i v)
+  {
+  return _mm_shuffle_epi8(pack_8_avx2(v),
+                          _mm_loadu_si128((const __m128i*)shuffle_even_8));
+  }
+
+static inline void store_yuy2_avx2(uint8_t * dst,
+                                   __m256i y, __m256i u, __m256i v,
+                                   int uyvy)
+  {
+  __m128i y8, uv;
+  y8 = pack_8_avx2(y);
+  uv = _mm_unpacklo_epi8(pack_8_even_avx2(u), pack_8_even_avx2(v));
+
+  if(uyvy)
+    {
+    _mm_storeu_si128((__m128i*)dst,      _mm_unpacklo_epi8(uv, y8));
+    _mm_storeu_si128((__m128i*)(dst+16), _mm_unpackhi_epi8(uv, y8));
+    }
+  else
+    {
+    _mm_storeu_si128((__m128i*)dst,      _mm_unpacklo_epi8(y8, uv));
+    _mm_storeu_si128((__m128i*)(dst+16), _mm_unpackhi_epi8(y8, uv));
+    }
+  }
+
+/*
+ *  16 bit routines: 8 pixels in float
+ *  Coefficients are the ones of the C version
+ */
+
+static inline __m256 load_16_avx2(const uint16_t * src, int sub_h)
+  {
+  __m128i c;
+  if(sub_h == 2)
+    {
+    c = _mm_loadl_epi64((const __m128i*)src);
+    c = _mm_unpacklo_epi16(c, c);
+    }
+  else
+    c = _mm_loadu_si128((const __m128i*)src);
+  return _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(c));
+  }
+
+/* 8 floats -> 8 words with the same rounding as the C version */
+
+static inline __m128i pack_16_avx2(__m256 f)
+  {
+  __m256i i;
+  i = _mm256_cvttps_epi32(_mm256_floor_ps(f));
+  i = _mm256_packus_epi32(i, i);
+  i = _mm256_permute4x64_epi64(i, 0x08);
+  return _mm256_castsi256_si128(i);
+  }
+
+static inline void load_rgb_48_avx2(const uint16_t * src,
+                                    __m256 * r, __m256 * g, __m256 * b)
+  {
+  __m128i in0, in1, in2, c;
+  in0 = _mm_loadu_si128((const __m128i*)src);
+  in1 = _mm_loadu_si128((const __m128i*)(src+8));
+  in2 = _mm_loadu_si128((const __m128i*)(src+16));
+
+#define SHUF(v, i) _mm_shuffle_epi8(v, _mm_loadu_si128((const __m128i*)shuffle_48[i]))
+
+  c = _mm_or_si128(_mm_or_si128(SHUF(in0, 0), SHUF(in1, 3)), SHUF(in2, 6));
+  *r = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(c));
+  c = _mm_or_si128(_mm_or_si128(SHUF(in0, 1), SHUF(in1, 4)), SHUF(in2, 7));
+  *g = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(c));
+  c = _mm_or_si128(_mm_or_si128(SHUF(in0, 2), SHUF(in1, 5)), SHUF(in2, 8));
+  *b = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(c));
+#undef SHUF
+  }
+
+static inline void store_rgb_48_avx2(uint16_t * dst,
+                                     __m128i r, __m128i g, __m128i b)
+  {
+  __m128i rg_lo, rg_hi;
+
+  rg_lo = _mm_unpacklo_epi16(r, g);
+  rg_hi = _mm_unpackhi_epi16(r, g);
+
+#define SHUF(v, i) _mm_shuffle_epi8(v, _mm_loadu_si128((const __m128i*)shuffle_48_out[i]))
+
+  _mm_storeu_si128((__m128i*)dst,
+                   _mm_or_si128(SHUF(rg_lo, 0), SHUF(b, 1)));
+  _mm_storeu_si128((__m128i*)(dst+8),
+                   _mm_or_si128(_mm_or_si128(SHUF(rg_lo, 2), SHUF(rg_hi, 3)),
+                                SHUF(b, 4)));
+  _mm_storeu_si128((__m128i*)(dst+16),
+                   _mm_or_si128(SHUF(rg_hi, 5), SHUF(b, 6)));
+#undef SHUF
+  }
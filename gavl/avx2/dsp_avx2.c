@@ -0,0 +1,803 @@
+/*****************************************************************
+ * gavl - a general purpose audio/video processing library
+ *
+ * Copyright (c) 2001 - 2012 Members of the Gmerlin project
+ * gmerlin-general@lists.sourceforge.net
+ * http://gmerlin.sourceforge.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * *****************************************************************/
+
+/*
+ *  AVX2 versions of all DSP functions. They process 32 bytes at once,
+ *  the remaining elements at the end of a line are done in C.
+ *  The results are the same as the C versions, except for sad_f,
+ *  which adds the differences in another order, and interpolate_f,
+ *  which can differ in the last bit if the compiler uses fused
+ *  multiply-adds for only one of the versions.
+ */
+
+#include <config.h>
+#include <attributes.h>
+
+#include <gavl/gavl.h>
+#include <gavl/gavldsp.h>
+#include <dsp.h>
+#include <bswap.h>
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <immintrin.h>
+
+#define LOAD(p)     _mm256_loadu_si256((const __m256i*)(p))
+#define STORE(p, v) _mm256_storeu_si256((__m256i*)(p), v)
+
+#define CLIP(val, min, max) ((val)>(max)?(max):((val)<(min)?(min):(val)))
+
+/* Same as the gavl_rgb_5_to_8 and gavl_rgb_6_to_8 tables */
+
+#define RGB_5_TO_8(c) (((c) * 527 + 23) >> 6)
+#define RGB_6_TO_8(c) (((c) * 259 + 33) >> 6)
+
+static inline int hsum_32(__m256i v)
+  {
+  __m128i s = _mm_add_epi32(_mm256_castsi256_si128(v),
+                            _mm256_extracti128_si256(v, 1));
+  s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 0, 3, 2)));
+  s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(2, 3, 0, 1)));
+  return _mm_cvtsi128_si32(s);
+  }
+
+/* Sum of absolute differences */
+
+static inline int rgb_to_8(int p, int shift, int bits)
+  {
+  p = (p >> shift) & ((1 << bits) - 1);
+  return (bits == 6) ? RGB_6_TO_8(p) : RGB_5_TO_8(p);
+  }
+
+static inline __m256i rgb_to_8_v(__m256i p, int shift, int bits)
+  {
+  p = _mm256_and_si256(_mm256_srli_epi16(p, shift),
+                       _mm256_set1_epi16((1 << bits) - 1));
+  if(bits == 6)
+    p = _mm256_add_epi16(_mm256_mullo_epi16(p, _mm256_set1_epi16(259)),
+                         _mm256_set1_epi16(33));
+  else
+    p = _mm256_add_epi16(_mm256_mullo_epi16(p, _mm256_set1_epi16(527)),
+                         _mm256_set1_epi16(23));
+  return _mm256_srli_epi16(p, 6);
+  }
+
+#define ABS_DIFF_8(p1, p2, shift, bits) \
+  _mm256_abs_epi16(_mm256_sub_epi16(rgb_to_8_v(p1, shift, bits),      \
+                                    rgb_to_8_v(p2, shift, bits)))
+
+static inline int sad_rgb(const uint8_t * src_1, const uint8_t * src_2,
+                          int stride_1, int stride_2,
+                          int w, int h, const int g_bits)
+  {
+  int i, j, ret = 0;
+  __m256i p1, p2, sum;
+  __m256i acc = _mm256_setzero_si256();
+  const __m256i ones = _mm256_set1_epi16(1);
+  const uint16_t * s1, *s2;
+
+  for(i = 0; i < h; i++)
+    {
+    s1 = (const uint16_t*)src_1;
+    s2 = (const uint16_t*)src_2;
+
+    for(j = 0; j + 16 <= w; j += 16)
+      {
+      p1 = LOAD(s1 + j);
+      p2 = LOAD(s2 + j);
+
+      sum = _mm256_add_epi16(ABS_DIFF_8(p1, p2, 5 + g_bits, 5),
+                             ABS_DIFF_8(p1, p2, 5, g_bits));
+      sum = _mm256_add_epi16(sum, ABS_DIFF_8(p1, p2, 0, 5));
+      acc = _mm256_add_epi32(acc, _mm256_madd_epi16(sum, ones));
+      }
+    for(; j < w; j++)
+      {
+      ret +=
+        abs(rgb_to_8(s1[j], 5 + g_bits, 5) - rgb_to_8(s2[j], 5 + g_bits, 5)) +
+        abs(rgb_to_8(s1[j], 5, g_bits) - rgb_to_8(s2[j], 5, g_bits)) +
+        abs(rgb_to_8(s1[j], 0, 5) - rgb_to_8(s2[j], 0, 5));
+      }
+    src_1 += stride_1;
+    src_2 += stride_2;
+    }
+  return ret + hsum_32(acc);
+  }
+
+static int sad_rgb15_avx2(const uint8_t * src_1, const uint8_t * src_2,
+                          int stride_1, int stride_2,
+                          int w, int h)
+  {
+  return sad_rgb(src_1, src_2, stride_1, stride_2, w, h, 5);
+  }
+
+static int sad_rgb16_avx2(const uint8_t * src_1, const uint8_t * src_2,
+                          int stride_1, int stride_2,
+                          int w, int h)
+  {
+  return sad_rgb(src_1, src_2, stride_1, stride_2, w, h, 6);
+  }
+
+static int sad_8_avx2(const uint8_t * src_1, const uint8_t * src_2,
+                      int stride_1, int stride_2,
+                      int w, int h)
+  {
+  int i, j, ret = 0;
+  __m256i acc = _mm256_setzero_si256();
+
+  for(i = 0; i < h; i++)
+    {
+    for(j = 0; j + 32 <= w; j += 32)
+      acc = _mm256_add_epi64(acc, _mm256_sad_epu8(LOAD(src_1 + j),
+                                                  LOAD(src_2 + j)));
+    for(; j < w; j++)
+      ret += abs(src_1[j] - src_2[j]);
+
+    src_1 += stride_1;
+    src_2 += stride_2;
+    }
+  /* The sums are in the low 32 bits of the quadwords */
+  return ret + hsum_32(acc);
+  }
+
+static int sad_16_avx2(const uint8_t * src_1, const uint8_t * src_2,
+                       int stride_1, int stride_2,
+                       int w, int h)
+  {
+  int i, j, ret = 0;
+  __m256i p1, p2, diff;
+  __m256i acc = _mm256_setzero_si256();
+  const __m256i low_mask = _mm256_set1_epi32(0xffff);
+  const uint16_t * s1, *s2;
+
+  for(i = 0; i < h; i++)
+    {
+    s1 = (const uint16_t*)src_1;
+    s2 = (const uint16_t*)src_2;
+
+    for(j = 0; j + 16 <= w; j += 16)
+      {
+      p1 = LOAD(s1 + j);
+      p2 = LOAD(s2 + j);
+      diff = _mm256_or_si256(_mm256_subs_epu16(p1, p2),
+                             _mm256_subs_epu16(p2, p1));
+      acc = _mm256_add_epi32(acc, _mm256_and_si256(diff, low_mask));
+      acc = _mm256_add_epi32(acc, _mm256_srli_epi32(diff, 16));
+      }
+    for(; j < w; j++)
+      ret += abs(s1[j] - s2[j]);
+
+    src_1 += stride_1;
+    src_2 += stride_2;
+    }
+  return ret + hsum_32(acc);
+  }
+
+static float sad_f_avx2(const uint8_t * src_1, const uint8_t * src_2,
+                        int stride_1, int stride_2,
+                        int w, int h)
+  {
+  int i, j;
+  float ret = 0.0;
+  float sums[8];
+  __m256 acc = _mm256_setzero_ps();
+  const __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+  const float * s1, *s2;
+
+  for(i = 0; i < h; i++)
+    {
+    s1 = (const float*)src_1;
+    s2 = (const float*)src_2;
+
+    for(j = 0; j + 8 <= w; j += 8)
+      acc = _mm256_add_ps(acc,
+                          _mm256_and_ps(_mm256_sub_ps(_mm256_loadu_ps(s1 + j),
+                                                      _mm256_loadu_ps(s2 + j)),
+                                        abs_mask));
+    for(; j < w; j++)
+      ret += fabs(s1[j] - s2[j]);
+
+    src_1 += stride_1;
+    src_2 += stride_2;
+    }
+
+  _mm256_storeu_ps(sums, acc);
+  for(i = 0; i < 8; i++)
+    ret += sums[i];
+  return ret;
+  }
+
+/*
+ *  SADs for several candidate positions of one block. Blocks of 8 or 16
+ *  pixels width and up to 16 lines are kept in registers, 4 lines of
+ *  8 pixels or 2 lines of 16 pixels per register.
+ */
+
+#define MAX_CACHED_LINES 16
+
+static inline __m256i load_lines_8(const uint8_t * p, int stride)
+  {
+  __m128i lo, hi;
+  lo = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)p),
+                          _mm_loadl_epi64((const __m128i*)(p + stride)));
+  p += 2 * stride;
+  hi = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)p),
+                          _mm_loadl_epi64((const __m128i*)(p + stride)));
+  return _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+  }
+
+static inline __m256i load_lines_16(const uint8_t * p, int stride)
+  {
+  return _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)p)),
+                                 _mm_loadu_si128((const __m128i*)(p + stride)), 1);
+  }
+
+static inline void sad_candidates_cached(const uint8_t * block, int block_stride,
+                                         const uint8_t * ref, int ref_stride,
+                                         int h, const int * offsets, int num,
+                                         int * costs, const int lines_per_vec)
+  {
+  int i, j;
+  const uint8_t * r;
+  __m256i acc;
+  __m256i cached[MAX_CACHED_LINES / 2];
+  int num_vecs = h / lines_per_vec;
+
+  for(j = 0; j < num_vecs; j++)
+    {
+    r = block + j * lines_per_vec * block_stride;
+    cached[j] = (lines_per_vec == 4) ? load_lines_8(r, block_stride) :
+      load_lines_16(r, block_stride);
+    }
+
+  for(i = 0; i < num; i++)
+    {
+    acc = _mm256_setzero_si256();
+    r = ref + offsets[i];
+
+    for(j = 0; j < num_vecs; j++)
+      {
+      acc = _mm256_add_epi64(acc,
+                             _mm256_sad_epu8(cached[j],
+                                             (lines_per_vec == 4) ?
+                                             load_lines_8(r, ref_stride) :
+                                             load_lines_16(r, ref_stride)));
+      r += lines_per_vec * ref_stride;
+      }
+    costs[i] = hsum_32(acc);
+    }
+  }
+
+static void sad_candidates_8_avx2(const uint8_t * block, int block_stride,
+                                  const uint8_t * ref, int ref_stride,
+                                  int w, int h,
+                                  const int * offsets, int num, int * costs)
+  {
+  int i;
+
+  if((w == 8) && !(h % 4) && (h <= MAX_CACHED_LINES))
+    sad_candidates_cached(block, block_stride, ref, ref_stride,
+                          h, offsets, num, costs, 4);
+  else if((w == 16) && !(h % 2) && (h <= MAX_CACHED_LINES))
+    sad_candidates_cached(block, block_stride, ref, ref_stride,
+                          h, offsets, num, costs, 2);
+  else
+    {
+    for(i = 0; i < num; i++)
+      costs[i] = sad_8_avx2(block, ref + offsets[i], block_stride, ref_stride, w, h);
+    }
+  }
+
+/* Averaging */
+
+/*
+ *  Average the 5 or 6 bit components of 16 bit pixels without
+ *  carrying into the neighbours: (a & b) + ((a ^ b) >> 1) with the
+ *  lowest bit of each component cleared before the shift.
+ *  low_bits has the lowest bit of each component and the unused
+ *  bit, mask has all components.
+ */
+
+static inline void average_rgb(const uint8_t * src_1, const uint8_t * src_2,
+                               uint8_t * dst, int num,
+                               const int low_bits, const int mask)
+  {
+  int i;
+  __m256i p1, p2;
+  const __m256i low_bits_v = _mm256_set1_epi16(low_bits);
+  const __m256i mask_v = _mm256_set1_epi16(mask);
+  const uint16_t * s1 = (const uint16_t*)src_1;
+  const uint16_t * s2 = (const uint16_t*)src_2;
+  uint16_t * d = (uint16_t*)dst;
+
+  for(i = 0; i + 16 <= num; i += 16)
+    {
+    p1 = LOAD(s1 + i);
+    p2 = LOAD(s2 + i);
+    p1 = _mm256_add_epi16(_mm256_and_si256(p1, p2),
+                          _mm256_srli_epi16(_mm256_andnot_si256(low_bits_v,
+                                                                _mm256_xor_si256(p1, p2)), 1));
+    STORE(d + i, _mm256_and_si256(p1, mask_v));
+    }
+  for(; i < num; i++)
+    d[i] = ((s1[i] & s2[i]) + (((s1[i] ^ s2[i]) & ~low_bits) >> 1)) & mask;
+  }
+
+static void average_rgb15_avx2(const uint8_t * src_1, const uint8_t * src_2,
+                               uint8_t * dst, int num)
+  {
+  average_rgb(src_1, src_2, dst, num, 0x8421, 0x7fff);
+  }
+
+static void average_rgb16_avx2(const uint8_t * src_1, const uint8_t * src_2,
+                               uint8_t * dst, int num)
+  {
+  average_rgb(src_1, src_2, dst, num, 0x0821, 0xffff);
+  }
+
+static void average_8_avx2(const uint8_t * src_1, const uint8_t * src_2,
+                           uint8_t * dst, int num)
+  {
+  int i;
+  for(i = 0; i + 32 <= num; i += 32)
+    STORE(dst + i, _mm256_avg_epu8(LOAD(src_1 + i), LOAD(src_2 + i)));
+  for(; i < num; i++)
+    dst[i] = (src_1[i] + src_2[i] + 1) >> 1;
+  }
+
+static void average_16_avx2(const uint8_t * src_1, const uint8_t * src_2,
+                            uint8_t * dst, int num)
+  {
+  int i;
+  const uint16_t * s1 = (const uint16_t*)src_1;
+  const uint16_t * s2 = (const uint16_t*)src_2;
+  uint16_t * d = (uint16_t*)dst;
+
+  for(i = 0; i + 16 <= num; i += 16)
+    STORE(d + i, _mm256_avg_epu16(LOAD(s1 + i), LOAD(s2 + i)));
+  for(; i < num; i++)
+    d[i] = (s1[i] + s2[i] + 1) >> 1;
+  }
+
+static void average_f_avx2(const uint8_t * src_1, const uint8_t * src_2,
+                           uint8_t * dst, int num)
+  {
+  int i;
+  const float * s1 = (const float*)src_1;
+  const float * s2 = (const float*)src_2;
+  float * d = (float*)dst;
+  const __m256 half = _mm256_set1_ps(0.5);
+
+  for(i = 0; i + 8 <= num; i += 8)
+    _mm256_storeu_ps(d + i, _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(s1 + i),
+                                                        _mm256_loadu_ps(s2 + i)),
+                                          half));
+  for(; i < num; i++)
+    d[i] = (s1[i] + s2[i]) * 0.5;
+  }
+
+/* Interpolating */
+
+/*
+ *  (s1 * fac + s2 * anti_fac) >> 16 for unsigned 16 bit values with
+ *  0 < fac < 0x10000 and anti_fac = 0x10000 - fac. The upper halves of
+ *  the products are added and the carry from the lower halves is
+ *  added afterwards.
+ */
+
+static inline __m256i mix_16(__m256i s1, __m256i s2,
+                             __m256i fac, __m256i anti_fac)
+  {
+  __m256i lo1, lo, ret;
+
+  lo1 = _mm256_mullo_epi16(s1, fac);
+  lo  = _mm256_add_epi16(lo1, _mm256_mullo_epi16(s2, anti_fac));
+  ret = _mm256_add_epi16(_mm256_mulhi_epu16(s1, fac),
+                         _mm256_mulhi_epu16(s2, anti_fac));
+
+  /* Carry if lo < lo1: Add 1 and subtract it again where lo >= lo1 */
+  ret = _mm256_add_epi16(ret, _mm256_set1_epi16(1));
+  return _mm256_add_epi16(ret, _mm256_cmpeq_epi16(_mm256_max_epu16(lo, lo1), lo));
+  }
+
+static inline void interpolate_rgb(const uint8_t * src_1, const uint8_t * src_2,
+                                   uint8_t * dst, int num, float fac,
+                                   const int g_bits)
+  {
+  int i;
+  __m256i p1, p2, ret, fac_v, anti_fac_v, mask_5, mask_g;
+  const uint16_t * s1 = (const uint16_t*)src_1;
+  const uint16_t * s2 = (const uint16_t*)src_2;
+  uint16_t * d = (uint16_t*)dst;
+  int fac_i = (int)(fac * 0x10000 + 0.5);
+  int anti_fac = 0x10000 - fac_i;
+  const int mask_r = 0x1f << (5 + g_bits);
+  const int mask_gi = ((1 << g_bits) - 1) << 5;
+
+  i = 0;
+
+  if((fac_i > 0) && (fac_i < 0x10000))
+    {
+    fac_v = _mm256_set1_epi16(fac_i);
+    anti_fac_v = _mm256_set1_epi16(anti_fac);
+    mask_5 = _mm256_set1_epi16(0x1f);
+    mask_g = _mm256_set1_epi16((1 << g_bits) - 1);
+
+    for(; i + 16 <= num; i += 16)
+      {
+      p1 = LOAD(s1 + i);
+      p2 = LOAD(s2 + i);
+
+      ret = mix_16(_mm256_and_si256(p1, mask_5),
+                   _mm256_and_si256(p2, mask_5), fac_v, anti_fac_v);
+      ret = _mm256_or_si256(ret,
+                            _mm256_slli_epi16(mix_16(_mm256_and_si256(_mm256_srli_epi16(p1, 5), mask_g),
+                                                     _mm256_and_si256(_mm256_srli_epi16(p2, 5), mask_g),
+                                                     fac_v, anti_fac_v), 5));
+      ret = _mm256_or_si256(ret,
+                            _mm256_slli_epi16(mix_16(_mm256_and_si256(_mm256_srli_epi16(p1, 5 + g_bits), mask_5),
+                                                     _mm256_and_si256(_mm256_srli_epi16(p2, 5 + g_bits), mask_5),
+                                                     fac_v, anti_fac_v), 5 + g_bits));
+      STORE(d + i, ret);
+      }
+    }
+
+  for(; i < num; i++)
+    {
+    d[i] = (((s1[i] & 0x1f) * fac_i + (s2[i] & 0x1f) * anti_fac) >> 16) & 0x1f;
+    d[i] |= (((unsigned int)(s1[i] & mask_gi) * fac_i +
+              (unsigned int)(s2[i] & mask_gi) * anti_fac) >> 16) & mask_gi;
+    d[i] |= (((unsigned int)(s1[i] & mask_r) * fac_i +
+              (unsigned int)(s2[i] & mask_r) * anti_fac) >> 16) & mask_r;
+    }
+  }
+
+static void interpolate_rgb15_avx2(const uint8_t * src_1, const uint8_t * src_2,
+                                   uint8_t * dst, int num, float fac)
+  {
+  interpolate_rgb(src_1, src_2, dst, num, fac, 5);
+  }
+
+static void interpolate_rgb16_avx2(const uint8_t * src_1, const uint8_t * src_2,
+                                   uint8_t * dst, int num, float fac)
+  {
+  interpolate_rgb(src_1, src_2, dst, num, fac, 6);
+  }
+
+static void interpolate_8_avx2(const uint8_t * src_1, const uint8_t * src_2,
+                               uint8_t * dst, int num, float fac)
+  {
+  int i = 0;
+  __m256i p1, p2, lo, hi, fac_v, anti_fac_v;
+  const __m256i zero = _mm256_setzero_si256();
+  int fac_i = (int)(fac * 0x10000 + 0.5);
+  int anti_fac = 0x10000 - fac_i;
+
+  if((fac_i > 0) && (fac_i < 0x10000))
+    {
+    fac_v = _mm256_set1_epi16(fac_i);
+    anti_fac_v = _mm256_set1_epi16(anti_fac);
+
+    for(; i + 32 <= num; i += 32)
+      {
+      p1 = LOAD(src_1 + i);
+      p2 = LOAD(src_2 + i);
+      lo = mix_16(_mm256_unpacklo_epi8(p1, zero), _mm256_unpacklo_epi8(p2, zero),
+                  fac_v, anti_fac_v);
+      hi = mix_16(_mm256_unpackhi_epi8(p1, zero), _mm256_unpackhi_epi8(p2, zero),
+                  fac_v, anti_fac_v);
+      STORE(dst + i, _mm256_packus_epi16(lo, hi));
+      }
+    }
+
+  for(; i < num; i++)
+    dst[i] = (src_1[i] * fac_i + src_2[i] * anti_fac) >> 16;
+  }
+
+static void interpolate_16_avx2(const uint8_t * src_1, const uint8_t * src_2,
+                                uint8_t * dst, int num, float fac)
+  {
+  int i = 0;
+  __m256i p1, p2, lo1, hi1, lo2, hi2, lo, hi, fac_v, anti_fac_v;
+  const uint16_t * s1 = (const uint16_t*)src_1;
+  const uint16_t * s2 = (const uint16_t*)src_2;
+  uint16_t * d = (uint16_t*)dst;
+  int fac_i = (int)(fac * 0x8000 + 0.5);
+  int anti_fac = 0x8000 - fac_i;
+
+  if((fac_i >= 0) && (fac_i <= 0x8000))
+    {
+    fac_v = _mm256_set1_epi16(fac_i);
+    anti_fac_v = _mm256_set1_epi16(anti_fac);
+
+    for(; i + 16 <= num; i += 16)
+      {
+      p1 = LOAD(s1 + i);
+      p2 = LOAD(s2 + i);
+
+      /* 32 bit products */
+      lo1 = _mm256_mullo_epi16(p1, fac_v);
+      hi1 = _mm256_mulhi_epu16(p1, fac_v);
+      lo2 = _mm256_mullo_epi16(p2, anti_fac_v);
+      hi2 = _mm256_mulhi_epu16(p2, anti_fac_v);
+
+      lo = _mm256_add_epi32(_mm256_unpacklo_epi16(lo1, hi1),
+                            _mm256_unpacklo_epi16(lo2, hi2));
+      hi = _mm256_add_epi32(_mm256_unpackhi_epi16(lo1, hi1),
+                            _mm256_unpackhi_epi16(lo2, hi2));
+
+      STORE(d + i, _mm256_packus_epi32(_mm256_srli_epi32(lo, 15),
+                                       _mm256_srli_epi32(hi, 15)));
+      }
+    }
+
+  for(; i < num; i++)
+    d[i] = (s1[i] * fac_i + s2[i] * anti_fac) >> 15;
+  }
+
+static void interpolate_f_avx2(const uint8_t * src_1, const uint8_t * src_2,
+                               uint8_t * dst, int num, float fac)
+  {
+  int i;
+  const float * s1 = (const float*)src_1;
+  const float * s2 = (const float*)src_2;
+  float * d = (float*)dst;
+  float anti_fac = 1.0 - fac;
+  const __m256 fac_v = _mm256_set1_ps(fac);
+  const __m256 anti_fac_v = _mm256_set1_ps(anti_fac);
+
+  for(i = 0; i + 8 <= num; i += 8)
+    _mm256_storeu_ps(d + i,
+                     _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(s1 + i), fac_v),
+                                   _mm256_mul_ps(_mm256_loadu_ps(s2 + i), anti_fac_v)));
+  for(; i < num; i++)
+    d[i] = s1[i] * fac + s2[i] * anti_fac;
+  }
+
+/* Byte swapping */
+
+#define BSWAP_FUNC(bits, ...)                                           \
+static void bswap_##bits##_avx2(void * data, int len)                   \
+  {                                                                     \
+  int i;                                                                \
+  uint##bits##_t * ptr = data;                                          \
+  const __m256i mask =                                                  \
+    _mm256_broadcastsi128_si256(_mm_setr_epi8(__VA_ARGS__));            \
+                                                                        \
+  for(i = 0; i + 256 / bits <= len; i += 256 / bits)                    \
+    STORE(ptr + i, _mm256_shuffle_epi8(LOAD(ptr + i), mask));           \
+  for(; i < len; i++)                                                   \
+    ptr[i] = bswap_##bits(ptr[i]);                                      \
+  }
+
+BSWAP_FUNC(16, 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14)
+BSWAP_FUNC(32, 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12)
+BSWAP_FUNC(64, 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8)
+
+/* Add and subtract functions */
+
+#define SIGN_8  _mm256_set1_epi8(0x80)
+#define SIGN_16 _mm256_set1_epi16(0x8000)
+
+#define ADDS_U8_S(a, b) \
+  _mm256_xor_si256(_mm256_adds_epi8(_mm256_xor_si256(a, SIGN_8), \
+                                    _mm256_xor_si256(b, SIGN_8)), SIGN_8)
+#define SUBS_U8_S(a, b) \
+  _mm256_xor_si256(_mm256_subs_epi8(_mm256_xor_si256(a, SIGN_8), \
+                                    _mm256_xor_si256(b, SIGN_8)), SIGN_8)
+#define ADDS_U16_S(a, b) \
+  _mm256_xor_si256(_mm256_adds_epi16(_mm256_xor_si256(a, SIGN_16), \
+                                     _mm256_xor_si256(b, SIGN_16)), SIGN_16)
+#define SUBS_U16_S(a, b) \
+  _mm256_xor_si256(_mm256_subs_epi16(_mm256_xor_si256(a, SIGN_16), \
+                                     _mm256_xor_si256(b, SIGN_16)), SIGN_16)
+
+/* Saturate 32 bit results towards the sign of a, where the sign bit of
+   overflow is set */
+
+static inline __m256i saturate_32(__m256i a, __m256i result, __m256i overflow)
+  {
+  __m256i sat = _mm256_xor_si256(_mm256_srai_epi32(a, 31),
+                                 _mm256_set1_epi32(0x7fffffff));
+  return _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(result),
+                                              _mm256_castsi256_ps(sat),
+                                              _mm256_castsi256_ps(overflow)));
+  }
+
+static inline __m256i adds_s32(__m256i a, __m256i b)
+  {
+  __m256i result = _mm256_add_epi32(a, b);
+  return saturate_32(a, result,
+                     _mm256_andnot_si256(_mm256_xor_si256(a, b),
+                                         _mm256_xor_si256(a, result)));
+  }
+
+static inline __m256i subs_s32(__m256i a, __m256i b)
+  {
+  __m256i result = _mm256_sub_epi32(a, b);
+  return saturate_32(a, result,
+                     _mm256_and_si256(_mm256_xor_si256(a, b),
+                                      _mm256_xor_si256(a, result)));
+  }
+
+#define PS(v) _mm256_castsi256_ps(v)
+#define PD(v) _mm256_castsi256_pd(v)
+
+#define ADD_FLOAT(a, b)  _mm256_castps_si256(_mm256_add_ps(PS(a), PS(b)))
+#define SUB_FLOAT(a, b)  _mm256_castps_si256(_mm256_sub_ps(PS(a), PS(b)))
+#define ADD_DOUBLE(a, b) _mm256_castpd_si256(_mm256_add_pd(PD(a), PD(b)))
+#define SUB_DOUBLE(a, b) _mm256_castpd_si256(_mm256_sub_pd(PD(a), PD(b)))
+
+#define ARITH_FUNC(name, type, tmp_type, vec_op, scalar_op)             \
+static void name##_avx2(const void * _src1, const void * _src2,         \
+                        void * _dst, int num)                           \
+  {                                                                     \
+  int i;                                                                \
+  tmp_type a, b;                                                        \
+  const type * src1 = _src1;                                            \
+  const type * src2 = _src2;                                            \
+  type * dst = _dst;                                                    \
+                                                                        \
+  for(i = 0; i + 32 / (int)sizeof(type) <= num;                         \
+      i += 32 / (int)sizeof(type))                                      \
+    STORE(dst + i, vec_op(LOAD(src1 + i), LOAD(src2 + i)));             \
+  for(; i < num; i++)                                                   \
+    {                                                                   \
+    a = src1[i];                                                        \
+    b = src2[i];                                                        \
+    dst[i] = scalar_op;                                                 \
+    }                                                                   \
+  }
+
+ARITH_FUNC(add_u8,     uint8_t,  int, _mm256_adds_epu8,  CLIP(a + b, 0, 255))
+ARITH_FUNC(add_s8,     int8_t,   int, _mm256_adds_epi8,  CLIP(a + b, -128, 127))
+ARITH_FUNC(add_u8_s,   uint8_t,  int, ADDS_U8_S,         CLIP(a + b - 256, -128, 127) + 128)
+ARITH_FUNC(add_u16,    uint16_t, int, _mm256_adds_epu16, CLIP(a + b, 0, 65535))
+ARITH_FUNC(add_s16,    int16_t,  int, _mm256_adds_epi16, CLIP(a + b, -32768, 32767))
+ARITH_FUNC(add_u16_s,  uint16_t, int, ADDS_U16_S,        CLIP(a + b - 65536, -32768, 32767) + 32768)
+ARITH_FUNC(add_s32,    int32_t,  int64_t, adds_s32,      CLIP(a + b, -2147483648LL, 2147483647LL))
+ARITH_FUNC(add_float,  float,    float,  ADD_FLOAT,      a + b)
+ARITH_FUNC(add_double, double,   double, ADD_DOUBLE,     a + b)
+
+ARITH_FUNC(sub_u8,     uint8_t,  int, _mm256_subs_epu8,  CLIP(a - b, 0, 255))
+ARITH_FUNC(sub_s8,     int8_t,   int, _mm256_subs_epi8,  CLIP(a - b, -128, 127))
+ARITH_FUNC(sub_u8_s,   uint8_t,  int, SUBS_U8_S,         CLIP(a - b, -128, 127) + 128)
+ARITH_FUNC(sub_u16,    uint16_t, int, _mm256_subs_epu16, CLIP(a - b, 0, 65535))
+ARITH_FUNC(sub_s16,    int16_t,  int, _mm256_subs_epi16, CLIP(a - b, -32768, 32767))
+ARITH_FUNC(sub_u16_s,  uint16_t, int, SUBS_U16_S,        CLIP(a - b, -32768, 32767) + 32768)
+ARITH_FUNC(sub_s32,    int32_t,  int64_t, subs_s32,      CLIP(a - b, -2147483648LL, 2147483647LL))
+ARITH_FUNC(sub_float,  float,    float,  SUB_FLOAT,      a - b)
+ARITH_FUNC(sub_double, double,   double, SUB_DOUBLE,     a - b)
+
+/* Shifting */
+
+static void shift_up_16_avx2(void * _ptr, int num, int bits)
+  {
+  int i;
+  uint16_t * ptr = _ptr;
+  const __m128i count = _mm_cvtsi32_si128(bits);
+
+  for(i = 0; i + 16 <= num; i += 16)
+    STORE(ptr + i, _mm256_sll_epi16(LOAD(ptr + i), count));
+  for(; i < num; i++)
+    ptr[i] <<= bits;
+  }
+
+static void shift_down_16_avx2(void * _ptr, int num, int bits)
+  {
+  int i;
+  uint16_t * ptr = _ptr;
+  const __m128i count = _mm_cvtsi32_si128(bits);
+
+  for(i = 0; i + 16 <= num; i += 16)
+    STORE(ptr + i, _mm256_srl_epi16(LOAD(ptr + i), count));
+  for(; i < num; i++)
+    ptr[i] >>= bits;
+  }
+
+/* Shuffling */
+
+static void shuffle_8_4_avx2(void * _ptr, int num, uint8_t * mask)
+  {
+  int i;
+  uint8_t * ptr = _ptr;
+  uint8_t buf[32];
+  __m256i mask_v;
+
+  mask[0] &= (0x80 | 0x03);
+  mask[1] &= (0x80 | 0x03);
+  mask[2] &= (0x80 | 0x03);
+  mask[3] &= (0x80 | 0x03);
+
+  /* Indices are relative to the 128 bit lanes */
+  for(i = 0; i < 32; i++)
+    buf[i] = (i & 0x0c) | mask[i & 3];
+  mask_v = LOAD(buf);
+
+  for(i = 0; i + 8 <= num; i += 8)
+    STORE(ptr + 4 * i, _mm256_shuffle_epi8(LOAD(ptr + 4 * i), mask_v));
+
+  for(; i < num; i++)
+    {
+    buf[0] = mask[0] & 0x80 ? 0 : ptr[4 * i + mask[0]];
+    buf[1] = mask[1] & 0x80 ? 0 : ptr[4 * i + mask[1]];
+    buf[2] = mask[2] & 0x80 ? 0 : ptr[4 * i + mask[2]];
+    buf[3] = mask[3] & 0x80 ? 0 : ptr[4 * i + mask[3]];
+    ptr[4 * i]     = buf[0];
+    ptr[4 * i + 1] = buf[1];
+    ptr[4 * i + 2] = buf[2];
+    ptr[4 * i + 3] = buf[3];
+    }
+  }
+
+void gavl_dsp_init_avx2(gavl_dsp_funcs_t * funcs,
+                        int quality)
+  {
+  funcs->sad_rgb15 = sad_rgb15_avx2;
+  funcs->sad_rgb16 = sad_rgb16_avx2;
+  funcs->sad_8     = sad_8_avx2;
+  funcs->sad_16    = sad_16_avx2;
+  funcs->sad_f     = sad_f_avx2;
+
+  funcs->average_rgb15 = average_rgb15_avx2;
+  funcs->average_rgb16 = average_rgb16_avx2;
+  funcs->average_8     = average_8_avx2;
+  funcs->average_16    = average_16_avx2;
+  funcs->average_f     = average_f_avx2;
+
+  funcs->interpolate_rgb15 = interpolate_rgb15_avx2;
+  funcs->interpolate_rgb16 = interpolate_rgb16_avx2;
+  funcs->interpolate_8     = interpolate_8_avx2;
+  funcs->interpolate_16    = interpolate_16_avx2;
+  funcs->interpolate_f     = interpolate_f_avx2;
+
+  funcs->bswap_16          = bswap_16_avx2;
+  funcs->bswap_32          = bswap_32_avx2;
+  funcs->bswap_64          = bswap_64_avx2;
+
+  funcs->add_u8            = add_u8_avx2;
+  funcs->add_s8            = add_s8_avx2;
+  funcs->add_u8_s          = add_u8_s_avx2;
+  funcs->add_u16           = add_u16_avx2;
+  funcs->add_s16           = add_s16_avx2;
+  funcs->add_u16_s         = add_u16_s_avx2;
+  funcs->add_s32           = add_s32_avx2;
+  funcs->add_float         = add_float_avx2;
+  funcs->add_double        = add_double_avx2;
+
+  funcs->sub_u8            = sub_u8_avx2;
+  funcs->sub_s8            = sub_s8_avx2;
+  funcs->sub_u8_s          = sub_u8_s_avx2;
+  funcs->sub_u16           = sub_u16_avx2;
+  funcs->sub_s16           = sub_s16_avx2;
+  funcs->sub_u16_s         = sub_u16_s_avx2;
+  funcs->sub_s32           = sub_s32_avx2;
+  funcs->sub_float         = sub_float_avx2;
+  funcs->sub_double        = sub_double_avx2;
+
+  funcs->shift_up_16       = shift_up_16_avx2;
+  funcs->shift_down_16     = shift_down_16_avx2;
+
+  funcs->shuffle_8_4       = shuffle_8_4_avx2;
+
+  funcs->sad_candidates_8  = sad_candidates_8_avx2;
+  }
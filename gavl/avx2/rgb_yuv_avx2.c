@@ -0,0 +1,578 @@
+/*****************************************************************
+ * gavl - a general purpose audio/video processing library
+ *
+ * Copyright (c) 2001 - 2012 Members of the Gmerlin project
+ * gmerlin-general@lists.sourceforge.net
+ * http://gmerlin.sourceforge.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * *****************************************************************/
+
+#include "colorspace_avx2.h"
+#include "../c/colorspace_macros.h"
+
+/* RGB -> YUV conversions */
+
+#define INIT_8 __m256i y, u, v, r, g, b;
+
+/* RGB24 -> YUV */
+
+#define FUNC_NAME      rgb_24_to_yuv_420_p_avx2
+#define IN_TYPE        uint8_t
+#define OUT_TYPE       uint8_t
+#define IN_ADVANCE     48
+#define OUT_ADVANCE_Y  16
+#define OUT_ADVANCE_UV 8
+#define NUM_PIXELS     16
+#define CHROMA_SUB     2
+#define INIT           INIT_8
+#define CONVERT_YUV    \
+  load_rgb_avx2(src, &r, &g, &b, 3); \
+  rgb_to_yuv_avx2(r, g, b, &y, &u, &v); \
+  _mm_storeu_si128((__m128i*)dst_y, pack_8_avx2(y)); \
+  _mm_storel_epi64((__m128i*)dst_u, pack_8_even_avx2(u)); \
+  _mm_storel_epi64((__m128i*)dst_v, pack_8_even_avx2(v));
+#define CONVERT_Y      \
+  load_rgb_avx2(src, &r, &g, &b, 3); \
+  rgb_to_yuv_avx2(r, g, b, &y, NULL, NULL); \
+  _mm_storeu_si128((__m128i*)dst_y, pack_8_avx2(y));
+
+#include "../csp_packed_planar.h"
+
+#define FUNC_NAME      rgb_24_to_yuv_422_p_avx2
+#define IN_TYPE        uint8_t
+#define OUT_TYPE       uint8_t
+#define IN_ADVANCE     48
+#define OUT_ADVANCE_Y  16
+#define OUT_ADVANCE_UV 8
+#define NUM_PIXELS     16
+#define CHROMA_SUB     1
+#define INIT           INIT_8
+#define CONVERT_YUV    \
+  load_rgb_avx2(src, &r, &g, &b, 3); \
+  rgb_to_yuv_avx2(r, g, b, &y, &u, &v); \
+  _mm_storeu_si128((__m128i*)dst_y, pack_8_avx2(y)); \
+  _mm_storel_epi64((__m128i*)dst_u, pack_8_even_avx2(u)); \
+  _mm_storel_epi64((__m128i*)dst_v, pack_8_even_avx2(v));
+
+#include "../csp_packed_planar.h"
+
+#define FUNC_NAME      rgb_24_to_yuv_444_p_avx2
+#define IN_TYPE        uint8_t
+#define OUT_TYPE       uint8_t
+#define IN_ADVANCE     48
+#define OUT_ADVANCE_Y  16
+#define OUT_ADVANCE_UV 16
+#define NUM_PIXELS     16
+#define CHROMA_SUB     1
+#define INIT           INIT_8
+#define CONVERT_YUV    \
+  load_rgb_avx2(src, &r, &g, &b, 3); \
+  rgb_to_yuv_avx2(r, g, b, &y, &u, &v); \
+  _mm_storeu_si128((__m128i*)dst_y, pack_8_avx2(y)); \
+  _mm_storeu_si128((__m128i*)dst_u, pack_8_avx2(u)); \
+  _mm_storeu_si128((__m128i*)dst_v, pack_8_avx2(v));
+
+#include "../csp_packed_planar.h"
+
+#define FUNC_NAME   rgb_24_to_yuy2_avx2
+#define IN_TYPE     uint8_t
+#define OUT_TYPE    uint8_t
+#define IN_ADVANCE  48
+#define OUT_ADVANCE 32
+#define NUM_PIXELS  16
+#define INIT        INIT_8
+#define CONVERT     \
+  load_rgb_avx2(src, &r, &g, &b, 3); \
+  rgb_to_yuv_avx2(r, g, b, &y, &u, &v); \
+  store_yuy2_avx2(dst, y, u, v, 0);
+
+#include "../csp_packed_packed.h"
+
+#define FUNC_NAME   rgb_24_to_uyvy_avx2
+#define IN_TYPE     uint8_t
+#define OUT_TYPE    uint8_t
+#define IN_ADVANCE  48
+#define OUT_ADVANCE 32
+#define NUM_PIXELS  16
+#define INIT        INIT_8
+#define CONVERT     \
+  load_rgb_avx2(src, &r, &g, &b, 3); \
+  rgb_to_yuv_avx2(r, g, b, &y, &u, &v); \
+  store_yuy2_avx2(dst, y, u, v, 1);
+
+#include "../csp_packed_packed.h"
+
+/* BGR24 -> YUV */
+
+#define FUNC_NAME      bgr_24_to_yuv_420_p_avx2
+#define IN_TYPE        uint8_t
+#define OUT_TYPE       uint8_t
+#define IN_ADVANCE     48
+#define OUT_ADVANCE_Y  16
+#define OUT_ADVANCE_UV 8
+#define NUM_PIXELS     16
+#define CHROMA_SUB     2
+#define INIT           INIT_8
+#define CONVERT_YUV    \
+  load_rgb_avx2(src, &b, &g, &r, 3); \
+  rgb_to_yuv_avx2(r, g, b, &y, &u, &v); \
+  _mm_storeu_si128((__m128i*)dst_y, pack_8_avx2(y)); \
+  _mm_storel_epi64((__m128i*)dst_u, pack_8_even_avx2(u)); \
+  _mm_storel_epi64((__m128i*)dst_v, pack_8_even_avx2(v));
+#define CONVERT_Y      \
+  load_rgb_avx2(src, &b, &g, &r, 3); \
+  rgb_to_yuv_avx2(r, g, b, &y, NULL, NULL); \
+  _mm_storeu_si128((__m128i*)dst_y, pack_8_avx2(y));
+
+#include "../csp_packed_planar.h"
+
+#define FUNC_NAME      bgr_24_to_yuv_422_p_avx2
+#define IN_TYPE        uint8_t
+#define OUT_TYPE       uint8_t
+#define IN_ADVANCE     48
+#define OUT_ADVANCE_Y  16
+#define OUT_ADVANCE_UV 8
+#define NUM_PIXELS     16
+#define CHROMA_SUB     1
+#define INIT           INIT_8
+#define CONVERT_YUV    \
+  load_rgb_avx2(src, &b, &g, &r, 3); \
+  rgb_to_yuv_avx2(r, g, b, &y, &u, &v); \
+  _mm_storeu_si128((__m128i*)dst_y, pack_8_avx2(y)); \
+  _mm_storel_epi64((__m128i*)dst_u, pack_8_even_avx2(u)); \
+  _mm_storel_epi64((__m128i*)dst_v, pack_8_even_avx2(v));
+
+#include "../csp_packed_planar.h"
+
+#define FUNC_NAME      bgr_24_to_yuv_444_p_avx2
+#define IN_TYPE        uint8_t
+#define OUT_TYPE       uint8_t
+#define IN_ADVANCE     48
+#define OUT_ADVANCE_Y  16
+#define OUT_ADVANCE_UV 16
+#define NUM_PIXELS     16
+#define CHROMA_SUB     1
+#define INIT           INIT_8
+#define CONVERT_YUV    \
+  load_rgb_avx2(src, &b, &g, &r, 3); \
+  rgb_to_yuv_avx2(r, g, b, &y, &u, &v); \
+  _mm_storeu_si128((__m128i*)dst_y, pack_8_avx2(y)); \
+  _mm_storeu_si128((__m128i*)dst_u, pack_8_avx2(u)); \
+  _mm_storeu_si128((__m128i*)dst_v, pack_8_avx2(v));
+
+#include "../csp_packed_planar.h"
+
+#define FUNC_NAME   bgr_24_to_yuy2_avx2
+#define IN_TYPE     uint8_t
+#define OUT_TYPE    uint8_t
+#define IN_ADVANCE  48
+#define OUT_ADVANCE 32
+#define NUM_PIXELS  16
+#define INIT        INIT_8
+#define CONVERT     \
+  load_rgb_avx2(src, &b, &g, &r, 3); \
+  rgb_to_yuv_avx2(r, g, b, &y, &u, &v); \
+  store_yuy2_avx2(dst, y, u, v, 0);
+
+#include "../csp_packed_packed.h"
+
+#define FUNC_NAME   bgr_24_to_uyvy_avx2
+#define IN_TYPE     uint8_t
+#define OUT_TYPE    uint8_t
+#define IN_ADVANCE  48
+#define OUT_ADVANCE 32
+#define NUM_PIXELS  16
+#define INIT        INIT_8
+#define CONVERT     \
+  load_rgb_avx2(src, &b, &g, &r, 3); \
+  rgb_to_yuv_avx2(r, g, b, &y, &u, &v); \
+  store_yuy2_avx2(dst, y, u, v, 1);
+
+#include "../csp_packed_packed.h"
+
+/* RGB32 -> YUV */
+
+#define FUNC_NAME      rgb_32_to_yuv_420_p_avx2
+#define IN_TYPE        uint8_t
+#define OUT_TYPE       uint8_t
+#define IN_ADVANCE     64
+#define OUT_ADVANCE_Y  16
+#define OUT_ADVANCE_UV 8
+#define NUM_PIXELS     16
+#define CHROMA_SUB     2
+#define INIT           INIT_8
+#define CONVERT_YUV    \
+  load_rgb_avx2(src, &r, &g, &b, 4); \
+  rgb_to_yuv_avx2(r, g, b, &y, &u, &v); \
+  _mm_storeu_si128((__m128i*)dst_y, pack_8_avx2(y)); \
+  _mm_storel_epi64((__m128i*)dst_u, pack_8_even_avx2(u)); \
+  _mm_storel_epi64((__m128i*)dst_v, pack_8_even_avx2(v));
+#define CONVERT_Y      \
+  load_rgb_avx2(src, &r, &g, &b, 4); \
+  rgb_to_yuv_avx2(r, g, b, &y, NULL, NULL); \
+  _mm_storeu_si128((__m128i*)dst_y, pack_8_avx2(y));
+
+#include "../csp_packed_planar.h"
+
+#define FUNC_NAME      rgb_32_to_yuv_422_p_avx2
+#define IN_TYPE        uint8_t
+#define OUT_TYPE       uint8_t
+#define IN_ADVANCE     64
+#define OUT_ADVANCE_Y  16
+#define OUT_ADVANCE_UV 8
+#define NUM_PIXELS     16
+#define CHROMA_SUB     1
+#define INIT           INIT_8
+#define CONVERT_YUV    \
+  load_rgb_avx2(src, &r, &g, &b, 4); \
+  rgb_to_yuv_avx2(r, g, b, &y, &u, &v); \
+  _mm_storeu_si128((__m128i*)dst_y, pack_8_avx2(y)); \
+  _mm_storel_epi64((__m128i*)dst_u, pack_8_even_avx2(u)); \
+  _mm_storel_epi64((__m128i*)dst_v, pack_8_even_avx2(v));
+
+#include "../csp_packed_planar.h"
+
+#define FUNC_NAME      rgb_32_to_yuv_444_p_avx2
+#define IN_TYPE        uint8_t
+#define OUT_TYPE       uint8_t
+#define IN_ADVANCE     64
+#define OUT_ADVANCE_Y  16
+#define OUT_ADVANCE_UV 16
+#define NUM_PIXELS     16
+#define CHROMA_SUB     1
+#define INIT           INIT_8
+#define CONVERT_YUV    \
+  load_rgb_avx2(src, &r, &g, &b, 4); \
+  rgb_to_yuv_avx2(r, g, b, &y, &u, &v); \
+  _mm_storeu_si128((__m128i*)dst_y, pack_8_avx2(y)); \
+  _mm_storeu_si128((__m128i*)dst_u, pack_8_avx2(u)); \
+  _mm_storeu_si128((__m128i*)dst_v, pack_8_avx2(v));
+
+#include "../csp_packed_planar.h"
+
+#define FUNC_NAME   rgb_32_to_yuy2_avx2
+#define IN_TYPE     uint8_t
+#define OUT_TYPE    uint8_t
+#define IN_ADVANCE  64
+#define OUT_ADVANCE 32
+#define NUM_PIXELS  16
+#define INIT        INIT_8
+#define CONVERT     \
+  load_rgb_avx2(src, &r, &g, &b, 4); \
+  rgb_to_yuv_avx2(r, g, b, &y, &u, &v); \
+  store_yuy2_avx2(dst, y, u, v, 0);
+
+#include "../csp_packed_packed.h"
+
+#define FUNC_NAME   rgb_32_to_uyvy_avx2
+#define IN_TYPE     uint8_t
+#define OUT_TYPE    uint8_t
+#define IN_ADVANCE  64
+#define OUT_ADVANCE 32
+#define NUM_PIXELS  16
+#define INIT        INIT_8
+#define CONVERT     \
+  load_rgb_avx2(src, &r, &g, &b, 4); \
+  rgb_to_yuv_avx2(r, g, b, &y, &u, &v); \
+  store_yuy2_avx2(dst, y, u, v, 1);
+
+#include "../csp_packed_packed.h"
+
+/* BGR32 -> YUV */
+
+#define FUNC_NAME      bgr_32_to_yuv_420_p_avx2
+#define IN_TYPE        uint8_t
+#define OUT_TYPE       uint8_t
+#define IN_ADVANCE     64
+#define OUT_ADVANCE_Y  16
+#define OUT_ADVANCE_UV 8
+#define NUM_PIXELS     16
+#define CHROMA_SUB     2
+#define INIT           INIT_8
+#define CONVERT_YUV    \
+  load_rgb_avx2(src, &b, &g, &r, 4); \
+  rgb_to_yuv_avx2(r, g, b, &y, &u, &v); \
+  _mm_storeu_si128((__m128i*)dst_y, pack_8_avx2(y)); \
+  _mm_storel_epi64((__m128i*)dst_u, pack_8_even_avx2(u)); \
+  _mm_storel_epi64((__m128i*)dst_v, pack_8_even_avx2(v));
+#define CONVERT_Y      \
+  load_rgb_avx2(src, &b, &g, &r, 4); \
+  rgb_to_yuv_avx2(r, g, b, &y, NULL, NULL); \
+  _mm_storeu_si128((__m128i*)dst_y, pack_8_avx2(y));
+
+#include "../csp_packed_planar.h"
+
+#define FUNC_NAME      bgr_32_to_yuv_422_p_avx2
+#define IN_TYPE        uint8_t
+#define OUT_TYPE       uint8_t
+#define IN_ADVANCE     64
+#define OUT_ADVANCE_Y  16
+#define OUT_ADVANCE_UV 8
+#define NUM_PIXELS     16
+#define CHROMA_SUB     1
+#define INIT           INIT_8
+#define CONVERT_YUV    \
+  load_rgb_avx2(src, &b, &g, &r, 4); \
+  rgb_to_yuv_avx2(r, g, b, &y, &u, &v); \
+  _mm_storeu_si128((__m128i*)dst_y, pack_8_avx2(y)); \
+  _mm_storel_epi64((__m128i*)dst_u, pack_8_even_avx2(u)); \
+  _mm_storel_epi64((__m128i*)dst_v, pack_8_even_avx2(v));
+
+#include "../csp_packed_planar.h"
+
+#define FUNC_NAME      bgr_32_to_yuv_444_p_avx2
+#define IN_TYPE        uint8_t
+#define OUT_TYPE       uint8_t
+#define IN_ADVANCE     64
+#define OUT_ADVANCE_Y  16
+#define OUT_ADVANCE_UV 16
+#define NUM_PIXELS     16
+#define CHROMA_SUB     1
+#define INIT           INIT_8
+#define CONVERT_YUV    \
+  load_rgb_avx2(src, &b, &g, &r, 4); \
+  rgb_to_yuv_avx2(r, g, b, &y, &u, &v); \
+  _mm_storeu_si128((__m128i*)dst_y, pack_8_avx2(y)); \
+  _mm_storeu_si128((__m128i*)dst_u, pack_8_avx2(u)); \
+  _mm_storeu_si128((__m128i*)dst_v, pack_8_avx2(v));
+
+#include "../csp_packed_planar.h"
+
+#define FUNC_NAME   bgr_32_to_yuy2_avx2
+#define IN_TYPE     uint8_t
+#define OUT_TYPE    uint8_t
+#define IN_ADVANCE  64
+#define OUT_ADVANCE 32
+#define NUM_PIXELS  16
+#define INIT        INIT_8
+#define CONVERT     \
+  load_rgb_avx2(src, &b, &g, &r, 4); \
+  rgb_to_yuv_avx2(r, g, b, &y, &u, &v); \
+  store_yuy2_avx2(dst, y, u, v, 0);
+
+#include "../csp_packed_packed.h"
+
+#define FUNC_NAME   bgr_32_to_uyvy_avx2
+#define IN_TYPE     uint8_t
+#define OUT_TYPE    uint8_t
+#define IN_ADVANCE  64
+#define OUT_ADVANCE 32
+#define NUM_PIXELS  16
+#define INIT        INIT_8
+#define CONVERT     \
+  load_rgb_avx2(src, &b, &g, &r, 4); \
+  rgb_to_yuv_avx2(r, g, b, &y, &u, &v); \
+  store_yuy2_avx2(dst, y, u, v, 1);
+
+#include "../csp_packed_packed.h"
+
+/* RGBA32 -> YUV */
+
+#define FUNC_NAME      rgba_32_to_yuv_420_p_avx2
+#define IN_TYPE        uint8_t
+#define OUT_TYPE       uint8_t
+#define IN_ADVANCE     64
+#define OUT_ADVANCE_Y  16
+#define OUT_ADVANCE_UV 8
+#define NUM_PIXELS     16
+#define CHROMA_SUB     2
+#define INIT           INIT_8
+#define CONVERT_YUV    \
+  load_rgb_avx2(src, &r, &g, &b, 4); \
+  rgb_to_yuv_avx2(r, g, b, &y, &u, &v); \
+  _mm_storeu_si128((__m128i*)dst_y, pack_8_avx2(y)); \
+  _mm_storel_epi64((__m128i*)dst_u, pack_8_even_avx2(u)); \
+  _mm_storel_epi64((__m128i*)dst_v, pack_8_even_avx2(v));
+#define CONVERT_Y      \
+  load_rgb_avx2(src, &r, &g, &b, 4); \
+  rgb_to_yuv_avx2(r, g, b, &y, NULL, NULL); \
+  _mm_storeu_si128((__m128i*)dst_y, pack_8_avx2(y));
+
+#include "../csp_packed_planar.h"
+
+#define FUNC_NAME      rgba_32_to_yuv_422_p_avx2
+#define IN_TYPE        uint8_t
+#define OUT_TYPE       uint8_t
+#define IN_ADVANCE     64
+#define OUT_ADVANCE_Y  16
+#define OUT_ADVANCE_UV 8
+#define NUM_PIXELS     16
+#define CHROMA_SUB     1
+#define INIT           INIT_8
+#define CONVERT_YUV    \
+  load_rgb_avx2(src, &r, &g, &b, 4); \
+  rgb_to_yuv_avx2(r, g, b, &y, &u, &v); \
+  _mm_storeu_si128((__m128i*)dst_y, pack_8_avx2(y)); \
+  _mm_storel_epi64((__m128i*)dst_u, pack_8_even_avx2(u)); \
+  _mm_storel_epi64((__m128i*)dst_v, pack_8_even_avx2(v));
+
+#include "../csp_packed_planar.h"
+
+#define FUNC_NAME      rgba_32_to_yuv_444_p_avx2
+#define IN_TYPE        uint8_t
+#define OUT_TYPE       uint8_t
+#define IN_ADVANCE     64
+#define OUT_ADVANCE_Y  16
+#define OUT_ADVANCE_UV 16
+#define NUM_PIXELS     16
+#define CHROMA_SUB     1
+#define INIT           INIT_8
+#define CONVERT_YUV    \
+  load_rgb_avx2(src, &r, &g, &b, 4); \
+  rgb_to_yuv_avx2(r, g, b, &y, &u, &v); \
+  _mm_storeu_si128((__m128i*)dst_y, pack_8_avx2(y)); \
+  _mm_storeu_si128((__m128i*)dst_u, pack_8_avx2(u)); \
+  _mm_storeu_si128((__m128i*)dst_v, pack_8_avx2(v));
+
+#include "../csp_packed_planar.h"
+
+#define FUNC_NAME   rgba_32_to_yuy2_avx2
+#define IN_TYPE     uint8_t
+#define OUT_TYPE    uint8_t
+#define IN_ADVANCE  64
+#define OUT_ADVANCE 32
+#define NUM_PIXELS  16
+#define INIT        INIT_8
+#define CONVERT     \
+  load_rgb_avx2(src, &r, &g, &b, 4); \
+  rgb_to_yuv_avx2(r, g, b, &y, &u, &v); \
+  store_yuy2_avx2(dst, y, u, v, 0);
+
+#include "../csp_packed_packed.h"
+
+#define FUNC_NAME   rgba_32_to_uyvy_avx2
+#define IN_TYPE     uint8_t
+#define OUT_TYPE    uint8_t
+#define IN_ADVANCE  64
+#define OUT_ADVANCE 32
+#define NUM_PIXELS  16
+#define INIT        INIT_8
+#define CONVERT     \
+  load_rgb_avx2(src, &r, &g, &b, 4); \
+  rgb_to_yuv_avx2(r, g, b, &y, &u, &v); \
+  store_yuy2_avx2(dst, y, u, v, 1);
+
+#include "../csp_packed_packed.h"
+
+/* RGB48 -> 16 bit */
+
+#define INIT_16                                                 \
+  __m256 r, g, b;                                               \
+  __m256 y_off = _mm256_set1_ps(0x1000);                        \
+  __m256 c_off = _mm256_set1_ps(0x8000);                        \
+  __m256 r_y = _mm256_set1_ps(r_16_to_y / 65536.0);             \
+  __m256 g_y = _mm256_set1_ps(g_16_to_y / 65536.0);             \
+  __m256 b_y = _mm256_set1_ps(b_16_to_y / 65536.0);             \
+  __m256 r_u = _mm256_set1_ps(r_16_to_u / 65536.0);             \
+  __m256 g_u = _mm256_set1_ps(g_16_to_u / 65536.0);             \
+  __m256 b_u = _mm256_set1_ps(b_16_to_u / 65536.0);             \
+  __m256 r_v = _mm256_set1_ps(r_16_to_v / 65536.0);             \
+  __m256 g_v = _mm256_set1_ps(g_16_to_v / 65536.0);             \
+  __m256 b_v = _mm256_set1_ps(b_16_to_v / 65536.0);
+
+#define RGB_48_TO_16_AVX2(cr, cg, cb, off) \
+  pack_16_avx2(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(r, cr),           \
+                                           _mm256_mul_ps(g, cg)),          \
+                             _mm256_add_ps(_mm256_mul_ps(b, cb), off)))
+
+#define RGB_48_TO_YUV_16_AVX2(sub_h) \
+  load_rgb_48_avx2(src, &r, &g, &b); \
+  _mm_storeu_si128((__m128i*)dst_y, RGB_48_TO_16_AVX2(r_y, g_y, b_y, y_off)); \
+  if(sub_h == 2) \
+    { \
+    __m128i mask = _mm_loadu_si128((const __m128i*)shuffle_even_16); \
+    _mm_storel_epi64((__m128i*)dst_u, \
+                     _mm_shuffle_epi8(RGB_48_TO_16_AVX2(r_u, g_u, b_u, c_off), mask)); \
+    _mm_storel_epi64((__m128i*)dst_v, \
+                     _mm_shuffle_epi8(RGB_48_TO_16_AVX2(r_v, g_v, b_v, c_off), mask)); \
+    } \
+  else \
+    { \
+    _mm_storeu_si128((__m128i*)dst_u, RGB_48_TO_16_AVX2(r_u, g_u, b_u, c_off)); \
+    _mm_storeu_si128((__m128i*)dst_v, RGB_48_TO_16_AVX2(r_v, g_v, b_v, c_off)); \
+    }
+
+#define FUNC_NAME      rgb_48_to_yuv_422_p_16_avx2
+#define IN_TYPE        uint16_t
+#define OUT_TYPE       uint16_t
+#define IN_ADVANCE     24
+#define OUT_ADVANCE_Y  8
+#define OUT_ADVANCE_UV 4
+#define NUM_PIXELS     8
+#define CHROMA_SUB     1
+#define INIT           INIT_16
+#define CONVERT_YUV    RGB_48_TO_YUV_16_AVX2(2)
+
+#include "../csp_packed_planar.h"
+
+#define FUNC_NAME      rgb_48_to_yuv_444_p_16_avx2
+#define IN_TYPE        uint16_t
+#define OUT_TYPE       uint16_t
+#define IN_ADVANCE     24
+#define OUT_ADVANCE_Y  8
+#define OUT_ADVANCE_UV 8
+#define NUM_PIXELS     8
+#define CHROMA_SUB     1
+#define INIT           INIT_16
+#define CONVERT_YUV    RGB_48_TO_YUV_16_AVX2(1)
+
+#include "../csp_packed_planar.h"
+
+void gavl_init_rgb_yuv_funcs_avx2(gavl_pixelformat_function_table_t * tab,
+                                  int width, const gavl_video_options_t * opt)
+  {
+  if(width % 16)
+    return;
+
+  if(opt->quality && (opt->quality >= 3))
+    return;
+
+  tab->rgb_24_to_yuv_420_p = rgb_24_to_yuv_420_p_avx2;
+  tab->rgb_24_to_yuv_422_p = rgb_24_to_yuv_422_p_avx2;
+  tab->rgb_24_to_yuv_444_p = rgb_24_to_yuv_444_p_avx2;
+  tab->rgb_24_to_yuy2 = rgb_24_to_yuy2_avx2;
+  tab->rgb_24_to_uyvy = rgb_24_to_uyvy_avx2;
+
+  tab->bgr_24_to_yuv_420_p = bgr_24_to_yuv_420_p_avx2;
+  tab->bgr_24_to_yuv_422_p = bgr_24_to_yuv_422_p_avx2;
+  tab->bgr_24_to_yuv_444_p = bgr_24_to_yuv_444_p_avx2;
+  tab->bgr_24_to_yuy2 = bgr_24_to_yuy2_avx2;
+  tab->bgr_24_to_uyvy = bgr_24_to_uyvy_avx2;
+
+  tab->rgb_32_to_yuv_420_p = rgb_32_to_yuv_420_p_avx2;
+  tab->rgb_32_to_yuv_422_p = rgb_32_to_yuv_422_p_avx2;
+  tab->rgb_32_to_yuv_444_p = rgb_32_to_yuv_444_p_avx2;
+  tab->rgb_32_to_yuy2 = rgb_32_to_yuy2_avx2;
+  tab->rgb_32_to_uyvy = rgb_32_to_uyvy_avx2;
+
+  tab->bgr_32_to_yuv_420_p = bgr_32_to_yuv_420_p_avx2;
+  tab->bgr_32_to_yuv_422_p = bgr_32_to_yuv_422_p_avx2;
+  tab->bgr_32_to_yuv_444_p = bgr_32_to_yuv_444_p_avx2;
+  tab->bgr_32_to_yuy2 = bgr_32_to_yuy2_avx2;
+  tab->bgr_32_to_uyvy = bgr_32_to_uyvy_avx2;
+
+  /* The RGBA versions ignore the alpha channel */
+  if(opt->alpha_mode == GAVL_ALPHA_IGNORE)
+    {
+    tab->rgba_32_to_yuv_420_p = rgba_32_to_yuv_420_p_avx2;
+    tab->rgba_32_to_yuv_422_p = rgba_32_to_yuv_422_p_avx2;
+    tab->rgba_32_to_yuv_444_p = rgba_32_to_yuv_444_p_avx2;
+    tab->rgba_32_to_yuy2 = rgba_32_to_yuy2_avx2;
+    tab->rgba_32_to_uyvy = rgba_32_to_uyvy_avx2;
+    }
+
+  tab->rgb_48_to_yuv_422_p_16 = rgb_48_to_yuv_422_p_16_avx2;
+  tab->rgb_48_to_yuv_444_p_16 = rgb_48_to_yuv_444_p_16_avx2;
+  }
@@ -0,0 +1,248 @@
+/*****************************************************************
+ * gavl - a general purpose audio/video processing library
+ *
+ * Copyright (c) 2001 - 2012 Members of the Gmerlin project
+ * gmerlin-general@lists.sourceforge.net
+ * http://gmerlin.sourceforge.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * *****************************************************************/
+
+/*
+ *  AVX2 optimized scaling (y)
+ *
+ *  The scanline is treated as an array of bytes (or 16 bit words),
+ *  so the same functions work for all packed formats. Two source lines
+ *  are interleaved and multiplied with two factors in one step
+ *  (vpmaddwd), the sums are 32 bit. As in the x direction, 16 bit
+ *  pixels are shifted down by one bit.
+ */
+
+#include <config.h>
+#include <attributes.h>
+
+#include <gavl/gavl.h>
+#include <video.h>
+#include <scale.h>
+
+#include <immintrin.h>
+
+static inline __m256i factor_pair(const int32_t * f, int num)
+  {
+  if(num > 1)
+    return _mm256_set1_epi32((f[0] & 0xFFFF) | (f[1] << 16));
+  else
+    return _mm256_set1_epi32(f[0] & 0xFFFF);
+  }
+
+static inline void
+scale_uint8_y(gavl_video_scale_context_t * ctx, int scanline,
+              uint8_t * dst, const int num_taps)
+  {
+  int i, j, imax, num;
+  int tmp;
+  const uint8_t * src, * src_start;
+  const int32_t * factors;
+  __m256i zero = _mm256_setzero_si256();
+  __m256i acc0, acc1, acc2, acc3, fac, a, b, lo, hi;
+
+  src_start = ctx->src + ctx->table_v.pixels[scanline].index * ctx->src_stride;
+  factors = ctx->table_v.pixels[scanline].factor_i;
+
+  num = ctx->dst_size * ctx->offset->dst_advance;
+  imax = num / 32;
+
+  for(i = 0; i < imax; i++)
+    {
+    acc0 = acc1 = acc2 = acc3 = zero;
+    src = src_start;
+
+    for(j = 0; j < num_taps; j += 2)
+      {
+      fac = factor_pair(factors + j, num_taps - j);
+      a = _mm256_loadu_si256((const __m256i*)src);
+      b = (num_taps - j > 1) ?
+        _mm256_loadu_si256((const __m256i*)(src + ctx->src_stride)) : zero;
+
+      lo = _mm256_unpacklo_epi8(a, b);
+      hi = _mm256_unpackhi_epi8(a, b);
+
+      acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(_mm256_unpacklo_epi8(lo, zero), fac));
+      acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(_mm256_unpackhi_epi8(lo, zero), fac));
+      acc2 = _mm256_add_epi32(acc2, _mm256_madd_epi16(_mm256_unpacklo_epi8(hi, zero), fac));
+      acc3 = _mm256_add_epi32(acc3, _mm256_madd_epi16(_mm256_unpackhi_epi8(hi, zero), fac));
+
+      src += 2 * ctx->src_stride;
+      }
+
+    acc0 = _mm256_packs_epi32(_mm256_srai_epi32(acc0, 14), _mm256_srai_epi32(acc1, 14));
+    acc2 = _mm256_packs_epi32(_mm256_srai_epi32(acc2, 14), _mm256_srai_epi32(acc3, 14));
+    _mm256_storeu_si256((__m256i*)dst, _mm256_packus_epi16(acc0, acc2));
+
+    src_start += 32;
+    dst += 32;
+    }
+
+  for(i = imax * 32; i < num; i++)
+    {
+    src = src_start;
+    tmp = 0;
+    for(j = 0; j < num_taps; j++)
+      {
+      tmp += factors[j] * *src;
+      src += ctx->src_stride;
+      }
+    tmp >>= 14;
+    *(dst++) = (uint8_t)((tmp & ~0xFF)?((-tmp) >> 31) : tmp);
+    src_start++;
+    }
+  }
+
+static inline void
+scale_uint16_y(gavl_video_scale_context_t * ctx, int scanline,
+               uint8_t * dest_start, const int num_taps)
+  {
+  int i, j, imax, num;
+  int tmp;
+  const uint8_t * src, * src_start;
+  uint16_t * dst;
+  const int32_t * factors;
+  __m256i zero = _mm256_setzero_si256();
+  __m256i bias_32 = _mm256_set1_epi32(0x8000);
+  __m256i bias_16 = _mm256_set1_epi16(0x8000);
+  __m256i acc0, acc1, fac, a, b;
+
+  src_start = ctx->src + ctx->table_v.pixels[scanline].index * ctx->src_stride;
+  factors = ctx->table_v.pixels[scanline].factor_i;
+  dst = (uint16_t*)dest_start;
+
+  num = ctx->dst_size * ctx->offset->dst_advance / 2;
+  imax = num / 16;
+
+  for(i = 0; i < imax; i++)
+    {
+    acc0 = acc1 = zero;
+    src = src_start;
+
+    for(j = 0; j < num_taps; j += 2)
+      {
+      fac = factor_pair(factors + j, num_taps - j);
+      a = _mm256_srli_epi16(_mm256_loadu_si256((const __m256i*)src), 1);
+      b = (num_taps - j > 1) ?
+        _mm256_srli_epi16(_mm256_loadu_si256((const __m256i*)(src + ctx->src_stride)), 1) :
+        zero;
+
+      acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(_mm256_unpacklo_epi16(a, b), fac));
+      acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(_mm256_unpackhi_epi16(a, b), fac));
+
+      src += 2 * ctx->src_stride;
+      }
+
+    /* Clip to 0..65535 by packing with signed saturation */
+    acc0 = _mm256_sub_epi32(_mm256_srai_epi32(acc0, 13), bias_32);
+    acc1 = _mm256_sub_epi32(_mm256_srai_epi32(acc1, 13), bias_32);
+    _mm256_storeu_si256((__m256i*)dst,
+                        _mm256_xor_si256(_mm256_packs_epi32(acc0, acc1), bias_16));
+
+    src_start += 32;
+    dst += 16;
+    }
+
+  for(i = imax * 16; i < num; i++)
+    {
+    src = src_start;
+    tmp = 0;
+    for(j = 0; j < num_taps; j++)
+      {
+      tmp += factors[j] * (*(const uint16_t*)src >> 1);
+      src += ctx->src_stride;
+      }
+    tmp >>= 13;
+    *(dst++) = (uint16_t)((tmp & ~0xFFFF)?((-tmp) >> 31) : tmp);
+    src_start += 2;
+    }
+  }
+
+#define SCALE_FUNCS(name, num_taps)                                     \
+static void scale_uint8_y_##name(gavl_video_scale_context_t * ctx,     \
+                                 int scanline, uint8_t * dst)         \
+  { scale_uint8_y(ctx, scanline, dst, num_taps); }                    \
+static void scale_uint16_y_##name(gavl_video_scale_context_t * ctx,    \
+                                  int scanline, uint8_t * dst)        \
+  { scale_uint16_y(ctx, scanline, dst, num_taps); }
+
+SCALE_FUNCS(bilinear, 2)
+SCALE_FUNCS(quadratic, 3)
+SCALE_FUNCS(bicubic, 4)
+SCALE_FUNCS(generic, ctx->table_v.factors_per_pixel)
+
+/* Since the whole scanline is processed, only src_advance == dst_advance
+   is needed. YUY2 and UYVY (where it isn't) stay with the other versions */
+
+#define INIT_FUNCS(name)                                        \
+  if(src_advance != dst_advance)                                \
+    return;                                                     \
+  switch(src_advance)                                           \
+    {                                                           \
+    case 1:                                                     \
+      tab->funcs_y.scale_uint8_x_1_noadvance = scale_uint8_y_##name; \
+      tab->funcs_y.bits_uint8_noadvance = 14;                   \
+      break;                                                    \
+    case 2:                                                     \
+      tab->funcs_y.scale_uint8_x_2 = scale_uint8_y_##name;      \
+      tab->funcs_y.scale_uint16_x_1 = scale_uint16_y_##name;    \
+      tab->funcs_y.bits_uint8_noadvance = 14;                   \
+      tab->funcs_y.bits_uint16 = 14;                            \
+      break;                                                    \
+    case 3:                                                     \
+    case 4:                                                     \
+      tab->funcs_y.scale_uint8_x_3 = scale_uint8_y_##name;      \
+      tab->funcs_y.scale_uint8_x_4 = scale_uint8_y_##name;      \
+      tab->funcs_y.scale_uint16_x_2 = scale_uint16_y_##name;    \
+      tab->funcs_y.bits_uint8_noadvance = 14;                   \
+      tab->funcs_y.bits_uint16 = 14;                            \
+      break;                                                    \
+    case 6:                                                     \
+      tab->funcs_y.scale_uint16_x_3 = scale_uint16_y_##name;    \
+      tab->funcs_y.bits_uint16 = 14;                            \
+      break;                                                    \
+    case 8:                                                     \
+      tab->funcs_y.scale_uint16_x_4 = scale_uint16_y_##name;    \
+      tab->funcs_y.bits_uint16 = 14;                            \
+      break;                                                    \
+    }
+
+void gavl_init_scale_funcs_bilinear_y_avx2(gavl_scale_funcs_t * tab,
+                                           int src_advance, int dst_advance)
+  {
+  INIT_FUNCS(bilinear);
+  }
+
+void gavl_init_scale_funcs_quadratic_y_avx2(gavl_scale_funcs_t * tab,
+                                            int src_advance, int dst_advance)
+  {
+  INIT_FUNCS(quadratic);
+  }
+
+void gavl_init_scale_funcs_bicubic_y_avx2(gavl_scale_funcs_t * tab,
+                                          int src_advance, int dst_advance)
+  {
+  INIT_FUNCS(bicubic);
+  }
+
+void gavl_init_scale_funcs_generic_y_avx2(gavl_scale_funcs_t * tab,
+                                          int src_advance, int dst_advance)
+  {
+  INIT_FUNCS(generic);
+  }
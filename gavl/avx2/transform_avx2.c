@@ -0,0 +1,200 @@
+/*****************************************************************
+ * gavl - a general purpose audio/video processing library
+ *
+ * Copyright (c) 2001 - 2012 Members of the Gmerlin project
+ * gmerlin-general@lists.sourceforge.net
+ * http://gmerlin.sourceforge.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * *****************************************************************/
+
+/*
+ *  AVX2 optimized image transform for 8 bit planes
+ *
+ *  8 destination pixels are processed at once. The coefficients are
+ *  fetched from the tables with vpgatherdd, the source pixels with one
+ *  gather per filter line (4 bytes per pixel). Pixels near the right
+ *  border are fetched from further left, so we never read beyond the end
+ *  of a line. Groups containing pixels, which were cut at the image border,
+ *  are done in C.
+ *  The results are the same as the C versions.
+ */
+
+#include <config.h>
+#include <attributes.h>
+
+#include <gavl/gavl.h>
+#include <video.h>
+#include <transform.h>
+
+#include <immintrin.h>
+
+#define GATHER(base, offsets, scale)                            \
+  _mm256_i32gather_epi32((const int*)(base), offsets, scale)
+
+static inline __m128i pack_8(__m256i v, int sat_signed)
+  {
+  v = _mm256_packs_epi32(v, v);
+  v = sat_signed ? _mm256_packs_epi16(v, v) : _mm256_packus_epi16(v, v);
+  return _mm_unpacklo_epi32(_mm256_castsi256_si128(v),
+                            _mm256_extracti128_si256(v, 1));
+  }
+
+/* Load 8 entries and split them into the 32 bit halves */
+
+static inline void load_entries(const gavl_transform_entry_t * e,
+                                __m256i * lo, __m256i * hi)
+  {
+  __m256 a = _mm256_castsi256_ps(_mm256_loadu_si256((const __m256i*)e));
+  __m256 b = _mm256_castsi256_ps(_mm256_loadu_si256((const __m256i*)(e + 4)));
+
+  *lo = _mm256_permute4x64_epi64(_mm256_castps_si256(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0))),
+                                 _MM_SHUFFLE(3, 1, 2, 0));
+  *hi = _mm256_permute4x64_epi64(_mm256_castps_si256(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1))),
+                                 _MM_SHUFFLE(3, 1, 2, 0));
+  }
+
+static void transform_pixels(gavl_transform_context_t * ctx,
+                             const gavl_transform_entry_t * entries,
+                             const gavl_transform_pixel_t * border,
+                             uint8_t * dst, int num, int num_taps)
+  {
+  int i, j, k, tmp;
+  const uint8_t * src;
+  gavl_transform_pixel_t pixels[8];
+
+  gavl_transform_table_expand(&ctx->tab, entries, border, pixels, num);
+
+  for(i = 0; i < num; i++)
+    {
+    if(pixels[i].outside)
+      continue;
+    
+    src = ctx->src + pixels[i].index_y * ctx->src_stride + pixels[i].index_x;
+    tmp = 0;
+    for(j = 0; j < num_taps; j++)
+      {
+      for(k = 0; k < num_taps; k++)
+        tmp += pixels[i].factors_i[j][k] * src[k];
+      src += ctx->src_stride;
+      }
+    tmp >>= ctx->tab.bits;
+    dst[i] = (uint8_t)((tmp & ~0xFF)?((-tmp) >> 31) : tmp);
+    }
+  }
+
+static inline void
+transform_uint8_x_1(gavl_transform_context_t * ctx,
+                    const gavl_transform_entry_t * entries,
+                    const gavl_transform_pixel_t * border,
+                    uint8_t * dst, int width, const int num_taps)
+  {
+  int i = 0, j, k;
+  __m256i lo, hi, index_x, index_y, type, phase_x, phase_y;
+  __m256i src_offsets, shift, line, acc, sum, factor;
+  __m256i factors_x[MAX_TRANSFORM_FILTER];
+  __m128i result, mask;
+
+  const __m256i stride = _mm256_set1_epi32(ctx->src_stride);
+  const __m256i last = _mm256_set1_epi32(ctx->dst_width - 4);
+  const __m256i overlap = _mm256_set1_epi32(4 - num_taps);
+  const __m256i byte_mask = _mm256_set1_epi32(0xff);
+  const __m256i word_mask = _mm256_set1_epi32(0xffff);
+  const __m256i border_type = _mm256_set1_epi32(TRANSFORM_ENTRY_BORDER);
+  const __m256i outside_type = _mm256_set1_epi32(TRANSFORM_ENTRY_OUTSIDE);
+
+  if(ctx->dst_width >= 8)
+    {
+    for(i = 0; i + 8 <= width; i += 8)
+      {
+      load_entries(entries + i, &lo, &hi);
+      type = _mm256_and_si256(_mm256_srli_epi32(hi, 16), byte_mask);
+
+      if(_mm256_movemask_epi8(_mm256_cmpeq_epi32(type, border_type)))
+        {
+        transform_pixels(ctx, entries + i, border, dst + i, 8, num_taps);
+        continue;
+        }
+      
+      index_x = _mm256_and_si256(lo, word_mask);
+      index_y = _mm256_srli_epi32(lo, 16);
+      phase_x = _mm256_slli_epi32(_mm256_and_si256(hi, byte_mask), 2);
+      phase_y = _mm256_slli_epi32(_mm256_and_si256(_mm256_srli_epi32(hi, 8), byte_mask), 2);
+      
+      shift = _mm256_and_si256(_mm256_cmpgt_epi32(index_x, last), overlap);
+      src_offsets = _mm256_add_epi32(_mm256_mullo_epi32(index_y, stride),
+                                     _mm256_sub_epi32(index_x, shift));
+      shift = _mm256_slli_epi32(shift, 3);
+
+      for(k = 0; k < num_taps; k++)
+        factors_x[k] = GATHER(&ctx->tab.lut_i_x[0][k], phase_x, 4);
+      
+      acc = _mm256_setzero_si256();
+      
+      for(j = 0; j < num_taps; j++)
+        {
+        line = _mm256_srlv_epi32(GATHER(ctx->src, src_offsets, 1), shift);
+        sum = _mm256_setzero_si256();
+        
+        for(k = 0; k < num_taps; k++)
+          {
+          sum = _mm256_add_epi32(sum,
+                                 _mm256_mullo_epi32(_mm256_and_si256(line, byte_mask),
+                                                    factors_x[k]));
+          line = _mm256_srli_epi32(line, 8);
+          }
+        factor = GATHER(&ctx->tab.lut_i_y[0][j], phase_y, 4);
+        acc = _mm256_add_epi32(acc, _mm256_mullo_epi32(sum, factor));
+        src_offsets = _mm256_add_epi32(src_offsets, stride);
+        }
+
+      /* Leave the destination alone for pixels outside the source */
+      result = pack_8(_mm256_srai_epi32(acc, 16), 0);
+      mask = pack_8(_mm256_cmpeq_epi32(type, outside_type), 1);
+
+      result = _mm_or_si128(_mm_andnot_si128(mask, result),
+                            _mm_and_si128(mask, _mm_loadl_epi64((const __m128i*)(dst + i))));
+      _mm_storel_epi64((__m128i*)(dst + i), result);
+      }
+    }
+
+  while(i < width)
+    {
+    k = width - i;
+    if(k > 8)
+      k = 8;
+    transform_pixels(ctx, entries + i, border, dst + i, k, num_taps);
+    i += k;
+    }
+  }
+
+#define TRANSFORM_FUNCS(name, num_taps)                                 \
+static void transform_uint8_x_1_##name##_avx2(gavl_transform_context_t * ctx, \
+                                              const gavl_transform_entry_t * entries, \
+                                              const gavl_transform_pixel_t * border, \
+                                              uint8_t * dst, int width) \
+  { transform_uint8_x_1(ctx, entries, border, dst, width, num_taps); }  \
+                                                                        \
+void gavl_init_transform_funcs_##name##_avx2(gavl_transform_funcs_t * tab, \
+                                             int advance)               \
+  {                                                                     \
+  if(advance != 1)                                                      \
+    return;                                                             \
+  tab->transform_uint8_x_1_noadvance = transform_uint8_x_1_##name##_avx2; \
+  tab->bits_uint8_noadvance = 16;                                       \
+  }
+
+TRANSFORM_FUNCS(bilinear, 2)
+TRANSFORM_FUNCS(quadratic, 3)
+TRANSFORM_FUNCS(bicubic, 4)
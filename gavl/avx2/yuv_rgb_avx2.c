@@ -0,0 +1,773 @@
+/*****************************************************************
+ * gavl - a general purpose audio/video processing library
+ *
+ * Copyright (c) 2001 - 2012 Members of the Gmerlin project
+ * gmerlin-general@lists.sourceforge.net
+ * http://gmerlin.sourceforge.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * *****************************************************************/
+
+#include "colorspace_avx2.h"
+#include "../c/colorspace_macros.h"
+
+/* YUV -> RGB conversions */
+
+#define INIT_8 __m256i y, u, v, r, g, b;
+
+/* YUY2 -> RGB */
+
+#define FUNC_NAME   yuy2_to_rgb_24_avx2
+#define IN_TYPE     uint8_t
+#define OUT_TYPE    uint8_t
+#define IN_ADVANCE  32
+#define OUT_ADVANCE 48
+#define NUM_PIXELS  16
+#define INIT        INIT_8
+#define CONVERT     \
+  load_yuy2_avx2(src, &y, &u, &v, 0); \
+  yuv_to_rgb_avx2(y, u, v, &r, &g, &b, 0); \
+  store_rgb_avx2(dst, r, g, b, 3);
+
+#include "../csp_packed_packed.h"
+
+#define FUNC_NAME   yuy2_to_bgr_24_avx2
+#define IN_TYPE     uint8_t
+#define OUT_TYPE    uint8_t
+#define IN_ADVANCE  32
+#define OUT_ADVANCE 48
+#define NUM_PIXELS  16
+#define INIT        INIT_8
+#define CONVERT     \
+  load_yuy2_avx2(src, &y, &u, &v, 0); \
+  yuv_to_rgb_avx2(y, u, v, &r, &g, &b, 0); \
+  store_rgb_avx2(dst, b, g, r, 3);
+
+#include "../csp_packed_packed.h"
+
+#define FUNC_NAME   yuy2_to_rgb_32_avx2
+#define IN_TYPE     uint8_t
+#define OUT_TYPE    uint8_t
+#define IN_ADVANCE  32
+#define OUT_ADVANCE 64
+#define NUM_PIXELS  16
+#define INIT        INIT_8
+#define CONVERT     \
+  load_yuy2_avx2(src, &y, &u, &v, 0); \
+  yuv_to_rgb_avx2(y, u, v, &r, &g, &b, 0); \
+  store_rgb_avx2(dst, r, g, b, 4);
+
+#include "../csp_packed_packed.h"
+
+#define FUNC_NAME   yuy2_to_bgr_32_avx2
+#define IN_TYPE     uint8_t
+#define OUT_TYPE    uint8_t
+#define IN_ADVANCE  32
+#define OUT_ADVANCE 64
+#define NUM_PIXELS  16
+#define INIT        INIT_8
+#define CONVERT     \
+  load_yuy2_avx2(src, &y, &u, &v, 0); \
+  yuv_to_rgb_avx2(y, u, v, &r, &g, &b, 0); \
+  store_rgb_avx2(dst, b, g, r, 4);
+
+#include "../csp_packed_packed.h"
+
+#define FUNC_NAME   yuy2_to_rgba_32_avx2
+#define IN_TYPE     uint8_t
+#define OUT_TYPE    uint8_t
+#define IN_ADVANCE  32
+#define OUT_ADVANCE 64
+#define NUM_PIXELS  16
+#define INIT        INIT_8
+#define CONVERT     \
+  load_yuy2_avx2(src, &y, &u, &v, 0); \
+  yuv_to_rgb_avx2(y, u, v, &r, &g, &b, 0); \
+  store_rgb_avx2(dst, r, g, b, 4);
+
+#include "../csp_packed_packed.h"
+
+/* UYVY -> RGB */
+
+#define FUNC_NAME   uyvy_to_rgb_24_avx2
+#define IN_TYPE     uint8_t
+#define OUT_TYPE    uint8_t
+#define IN_ADVANCE  32
+#define OUT_ADVANCE 48
+#define NUM_PIXELS  16
+#define INIT        INIT_8
+#define CONVERT     \
+  load_yuy2_avx2(src, &y, &u, &v, 1); \
+  yuv_to_rgb_avx2(y, u, v, &r, &g, &b, 0); \
+  store_rgb_avx2(dst, r, g, b, 3);
+
+#include "../csp_packed_packed.h"
+
+#define FUNC_NAME   uyvy_to_bgr_24_avx2
+#define IN_TYPE     uint8_t
+#define OUT_TYPE    uint8_t
+#define IN_ADVANCE  32
+#define OUT_ADVANCE 48
+#define NUM_PIXELS  16
+#define INIT        INIT_8
+#define CONVERT     \
+  load_yuy2_avx2(src, &y, &u, &v, 1); \
+  yuv_to_rgb_avx2(y, u, v, &r, &g, &b, 0); \
+  store_rgb_avx2(dst, b, g, r, 3);
+
+#include "../csp_packed_packed.h"
+
+#define FUNC_NAME   uyvy_to_rgb_32_avx2
+#define IN_TYPE     uint8_t
+#define OUT_TYPE    uint8_t
+#define IN_ADVANCE  32
+#define OUT_ADVANCE 64
+#define NUM_PIXELS  16
+#define INIT        INIT_8
+#define CONVERT     \
+  load_yuy2_avx2(src, &y, &u, &v, 1); \
+  yuv_to_rgb_avx2(y, u, v, &r, &g, &b, 0); \
+  store_rgb_avx2(dst, r, g, b, 4);
+
+#include "../csp_packed_packed.h"
+
+#define FUNC_NAME   uyvy_to_bgr_32_avx2
+#define IN_TYPE     uint8_t
+#define OUT_TYPE    uint8_t
+#define IN_ADVANCE  32
+#define OUT_ADVANCE 64
+#define NUM_PIXELS  16
+#define INIT        INIT_8
+#define CONVERT     \
+  load_yuy2_avx2(src, &y, &u, &v, 1); \
+  yuv_to_rgb_avx2(y, u, v, &r, &g, &b, 0); \
+  store_rgb_avx2(dst, b, g, r, 4);
+
+#include "../csp_packed_packed.h"
+
+#define FUNC_NAME   uyvy_to_rgba_32_avx2
+#define IN_TYPE     uint8_t
+#define OUT_TYPE    uint8_t
+#define IN_ADVANCE  32
+#define OUT_ADVANCE 64
+#define NUM_PIXELS  16
+#define INIT        INIT_8
+#define CONVERT     \
+  load_yuy2_avx2(src, &y, &u, &v, 1); \
+  yuv_to_rgb_avx2(y, u, v, &r, &g, &b, 0); \
+  store_rgb_avx2(dst, r, g, b, 4);
+
+#include "../csp_packed_packed.h"
+
+/* YUV420P -> RGB */
+
+#define FUNC_NAME     yuv_420_p_to_rgb_24_avx2
+#define IN_TYPE       uint8_t
+#define OUT_TYPE      uint8_t
+#define IN_ADVANCE_Y  16
+#define IN_ADVANCE_UV 8
+#define OUT_ADVANCE   48
+#define NUM_PIXELS    16
+#define INIT          INIT_8
+#define CHROMA_SUB    2
+#define CONVERT       \
+  load_yuv_planar_avx2(src_y, src_u, src_v, &y, &u, &v, 2); \
+  yuv_to_rgb_avx2(y, u, v, &r, &g, &b, 0); \
+  store_rgb_avx2(dst, r, g, b, 3);
+
+#include "../csp_planar_packed.h"
+
+#define FUNC_NAME     yuv_420_p_to_bgr_24_avx2
+#define IN_TYPE       uint8_t
+#define OUT_TYPE      uint8_t
+#define IN_ADVANCE_Y  16
+#define IN_ADVANCE_UV 8
+#define OUT_ADVANCE   48
+#define NUM_PIXELS    16
+#define INIT          INIT_8
+#define CHROMA_SUB    2
+#define CONVERT       \
+  load_yuv_planar_avx2(src_y, src_u, src_v, &y, &u, &v, 2); \
+  yuv_to_rgb_avx2(y, u, v, &r, &g, &b, 0); \
+  store_rgb_avx2(dst, b, g, r, 3);
+
+#include "../csp_planar_packed.h"
+
+#define FUNC_NAME     yuv_420_p_to_rgb_32_avx2
+#define IN_TYPE       uint8_t
+#define OUT_TYPE      uint8_t
+#define IN_ADVANCE_Y  16
+#define IN_ADVANCE_UV 8
+#define OUT_ADVANCE   64
+#define NUM_PIXELS    16
+#define INIT          INIT_8
+#define CHROMA_SUB    2
+#define CONVERT       \
+  load_yuv_planar_avx2(src_y, src_u, src_v, &y, &u, &v, 2); \
+  yuv_to_rgb_avx2(y, u, v, &r, &g, &b, 0); \
+  store_rgb_avx2(dst, r, g, b, 4);
+
+#include "../csp_planar_packed.h"
+
+#define FUNC_NAME     yuv_420_p_to_bgr_32_avx2
+#define IN_TYPE       uint8_t
+#define OUT_TYPE      uint8_t
+#define IN_ADVANCE_Y  16
+#define IN_ADVANCE_UV 8
+#define OUT_ADVANCE   64
+#define NUM_PIXELS    16
+#define INIT          INIT_8
+#define CHROMA_SUB    2
+#define CONVERT       \
+  load_yuv_planar_avx2(src_y, src_u, src_v, &y, &u, &v, 2); \
+  yuv_to_rgb_avx2(y, u, v, &r, &g, &b, 0); \
+  store_rgb_avx2(dst, b, g, r, 4);
+
+#include "../csp_planar_packed.h"
+
+#define FUNC_NAME     yuv_420_p_to_rgba_32_avx2
+#define IN_TYPE       uint8_t
+#define OUT_TYPE      uint8_t
+#define IN_ADVANCE_Y  16
+#define IN_ADVANCE_UV 8
+#define OUT_ADVANCE   64
+#define NUM_PIXELS    16
+#define INIT          INIT_8
+#define CHROMA_SUB    2
+#define CONVERT       \
+  load_yuv_planar_avx2(src_y, src_u, src_v, &y, &u, &v, 2); \
+  yuv_to_rgb_avx2(y, u, v, &r, &g, &b, 0); \
+  store_rgb_avx2(dst, r, g, b, 4);
+
+#include "../csp_planar_packed.h"
+
+/* YUV422P -> RGB */
+
+#define FUNC_NAME     yuv_422_p_to_rgb_24_avx2
+#define IN_TYPE       uint8_t
+#define OUT_TYPE      uint8_t
+#define IN_ADVANCE_Y  16
+#define IN_ADVANCE_UV 8
+#define OUT_ADVANCE   48
+#define NUM_PIXELS    16
+#define INIT          INIT_8
+#define CHROMA_SUB    1
+#define CONVERT       \
+  load_yuv_planar_avx2(src_y, src_u, src_v, &y, &u, &v, 2); \
+  yuv_to_rgb_avx2(y, u, v, &r, &g, &b, 0); \
+  store_rgb_avx2(dst, r, g, b, 3);
+
+#include "../csp_planar_packed.h"
+
+#define FUNC_NAME     yuv_422_p_to_bgr_24_avx2
+#define IN_TYPE       uint8_t
+#define OUT_TYPE      uint8_t
+#define IN_ADVANCE_Y  16
+#define IN_ADVANCE_UV 8
+#define OUT_ADVANCE   48
+#define NUM_PIXELS    16
+#define INIT          INIT_8
+#define CHROMA_SUB    1
+#define CONVERT       \
+  load_yuv_planar_avx2(src_y, src_u, src_v, &y, &u, &v, 2); \
+  yuv_to_rgb_avx2(y, u, v, &r, &g, &b, 0); \
+  store_rgb_avx2(dst, b, g, r, 3);
+
+#include "../csp_planar_packed.h"
+
+#define FUNC_NAME     yuv_422_p_to_rgb_32_avx2
+#define IN_TYPE       uint8_t
+#define OUT_TYPE      uint8_t
+#define IN_ADVANCE_Y  16
+#define IN_ADVANCE_UV 8
+#define OUT_ADVANCE   64
+#define NUM_PIXELS    16
+#define INIT          INIT_8
+#define CHROMA_SUB    1
+#define CONVERT       \
+  load_yuv_planar_avx2(src_y, src_u, src_v, &y, &u, &v, 2); \
+  yuv_to_rgb_avx2(y, u, v, &r, &g, &b, 0); \
+  store_rgb_avx2(dst, r, g, b, 4);
+
+#include "../csp_planar_packed.h"
+
+#define FUNC_NAME     yuv_422_p_to_bgr_32_avx2
+#define IN_TYPE       uint8_t
+#define OUT_TYPE      uint8_t
+#define IN_ADVANCE_Y  16
+#define IN_ADVANCE_UV 8
+#define OUT_ADVANCE   64
+#define NUM_PIXELS    16
+#define INIT          INIT_8
+#define CHROMA_SUB    1
+#define CONVERT       \
+  load_yuv_planar_avx2(src_y, src_u, src_v, &y, &u, &v, 2); \
+  yuv_to_rgb_avx2(y, u, v, &r, &g, &b, 0); \
+  store_rgb_avx2(dst, b, g, r, 4);
+
+#include "../csp_planar_packed.h"
+
+#define FUNC_NAME     yuv_422_p_to_rgba_32_avx2
+#define IN_TYPE       uint8_t
+#define OUT_TYPE      uint8_t
+#define IN_ADVANCE_Y  16
+#define IN_ADVANCE_UV 8
+#define OUT_ADVANCE   64
+#define NUM_PIXELS    16
+#define INIT          INIT_8
+#define CHROMA_SUB    1
+#define CONVERT       \
+  load_yuv_planar_avx2(src_y, src_u, src_v, &y, &u, &v, 2); \
+  yuv_to_rgb_avx2(y, u, v, &r, &g, &b, 0); \
+  store_rgb_avx2(dst, r, g, b, 4);
+
+#include "../csp_planar_packed.h"
+
+/* YUV444P -> RGB */
+
+#define FUNC_NAME     yuv_444_p_to_rgb_24_avx2
+#define IN_TYPE       uint8_t
+#define OUT_TYPE      uint8_t
+#define IN_ADVANCE_Y  16
+#define IN_ADVANCE_UV 16
+#define OUT_ADVANCE   48
+#define NUM_PIXELS    16
+#define INIT          INIT_8
+#define CHROMA_SUB    1
+#define CONVERT       \
+  load_yuv_planar_avx2(src_y, src_u, src_v, &y, &u, &v, 1); \
+  yuv_to_rgb_avx2(y, u, v, &r, &g, &b, 0); \
+  store_rgb_avx2(dst, r, g, b, 3);
+
+#include "../csp_planar_packed.h"
+
+#define FUNC_NAME     yuv_444_p_to_bgr_24_avx2
+#define IN_TYPE       uint8_t
+#define OUT_TYPE      uint8_t
+#define IN_ADVANCE_Y  16
+#define IN_ADVANCE_UV 16
+#define OUT_ADVANCE   48
+#define NUM_PIXELS    16
+#define INIT          INIT_8
+#define CHROMA_SUB    1
+#define CONVERT       \
+  load_yuv_planar_avx2(src_y, src_u, src_v, &y, &u, &v, 1); \
+  yuv_to_rgb_avx2(y, u, v, &r, &g, &b, 0); \
+  store_rgb_avx2(dst, b, g, r, 3);
+
+#include "../csp_planar_packed.h"
+
+#define FUNC_NAME     yuv_444_p_to_rgb_32_avx2
+#define IN_TYPE       uint8_t
+#define OUT_TYPE      uint8_t
+#define IN_ADVANCE_Y  16
+#define IN_ADVANCE_UV 16
+#define OUT_ADVANCE   64
+#define NUM_PIXELS    16
+#define INIT          INIT_8
+#define CHROMA_SUB    1
+#define CONVERT       \
+  load_yuv_planar_avx2(src_y, src_u, src_v, &y, &u, &v, 1); \
+  yuv_to_rgb_avx2(y, u, v, &r, &g, &b, 0); \
+  store_rgb_avx2(dst, r, g, b, 4);
+
+#include "../csp_planar_packed.h"
+
+#define FUNC_NAME     yuv_444_p_to_bgr_32_avx2
+#define IN_TYPE       uint8_t
+#define OUT_TYPE      uint8_t
+#define IN_ADVANCE_Y  16
+#define IN_ADVANCE_UV 16
+#define OUT_ADVANCE   64
+#define NUM_PIXELS    16
+#define INIT          INIT_8
+#define CHROMA_SUB    1
+#define CONVERT       \
+  load_yuv_planar_avx2(src_y, src_u, src_v, &y, &u, &v, 1); \
+  yuv_to_rgb_avx2(y, u, v, &r, &g, &b, 0); \
+  store_rgb_avx2(dst, b, g, r, 4);
+
+#include "../csp_planar_packed.h"
+
+#define FUNC_NAME     yuv_444_p_to_rgba_32_avx2
+#define IN_TYPE       uint8_t
+#define OUT_TYPE      uint8_t
+#define IN_ADVANCE_Y  16
+#define IN_ADVANCE_UV 16
+#define OUT_ADVANCE   64
+#define NUM_PIXELS    16
+#define INIT          INIT_8
+#define CHROMA_SUB    1
+#define CONVERT       \
+  load_yuv_planar_avx2(src_y, src_u, src_v, &y, &u, &v, 1); \
+  yuv_to_rgb_avx2(y, u, v, &r, &g, &b, 0); \
+  store_rgb_avx2(dst, r, g, b, 4);
+
+#include "../csp_planar_packed.h"
+
+/* YUVJ420P -> RGB */
+
+#define FUNC_NAME     yuvj_420_p_to_rgb_24_avx2
+#define IN_TYPE       uint8_t
+#define OUT_TYPE      uint8_t
+#define IN_ADVANCE_Y  16
+#define IN_ADVANCE_UV 8
+#define OUT_ADVANCE   48
+#define NUM_PIXELS    16
+#define INIT          INIT_8
+#define CHROMA_SUB    2
+#define CONVERT       \
+  load_yuv_planar_avx2(src_y, src_u, src_v, &y, &u, &v, 2); \
+  yuv_to_rgb_avx2(y, u, v, &r, &g, &b, 1); \
+  store_rgb_avx2(dst, r, g, b, 3);
+
+#include "../csp_planar_packed.h"
+
+#define FUNC_NAME     yuvj_420_p_to_bgr_24_avx2
+#define IN_TYPE       uint8_t
+#define OUT_TYPE      uint8_t
+#define IN_ADVANCE_Y  16
+#define IN_ADVANCE_UV 8
+#define OUT_ADVANCE   48
+#define NUM_PIXELS    16
+#define INIT          INIT_8
+#define CHROMA_SUB    2
+#define CONVERT       \
+  load_yuv_planar_avx2(src_y, src_u, src_v, &y, &u, &v, 2); \
+  yuv_to_rgb_avx2(y, u, v, &r, &g, &b, 1); \
+  store_rgb_avx2(dst, b, g, r, 3);
+
+#include "../csp_planar_packed.h"
+
+#define FUNC_NAME     yuvj_420_p_to_rgb_32_avx2
+#define IN_TYPE       uint8_t
+#define OUT_TYPE      uint8_t
+#define IN_ADVANCE_Y  16
+#define IN_ADVANCE_UV 8
+#define OUT_ADVANCE   64
+#define NUM_PIXELS    16
+#define INIT          INIT_8
+#define CHROMA_SUB    2
+#define CONVERT       \
+  load_yuv_planar_avx2(src_y, src_u, src_v, &y, &u, &v, 2); \
+  yuv_to_rgb_avx2(y, u, v, &r, &g, &b, 1); \
+  store_rgb_avx2(dst, r, g, b, 4);
+
+#include "../csp_planar_packed.h"
+
+#define FUNC_NAME     yuvj_420_p_to_bgr_32_avx2
+#define IN_TYPE       uint8_t
+#define OUT_TYPE      uint8_t
+#define IN_ADVANCE_Y  16
+#define IN_ADVANCE_UV 8
+#define OUT_ADVANCE   64
+#define NUM_PIXELS    16
+#define INIT          INIT_8
+#define CHROMA_SUB    2
+#define CONVERT       \
+  load_yuv_planar_avx2(src_y, src_u, src_v, &y, &u, &v, 2); \
+  yuv_to_rgb_avx2(y, u, v, &r, &g, &b, 1); \
+  store_rgb_avx2(dst, b, g, r, 4);
+
+#include "../csp_planar_packed.h"
+
+#define FUNC_NAME     yuvj_420_p_to_rgba_32_avx2
+#define IN_TYPE       uint8_t
+#define OUT_TYPE      uint8_t
+#define IN_ADVANCE_Y  16
+#define IN_ADVANCE_UV 8
+#define OUT_ADVANCE   64
+#define NUM_PIXELS    16
+#define INIT          INIT_8
+#define CHROMA_SUB    2
+#define CONVERT       \
+  load_yuv_planar_avx2(src_y, src_u, src_v, &y, &u, &v, 2); \
+  yuv_to_rgb_avx2(y, u, v, &r, &g, &b, 1); \
+  store_rgb_avx2(dst, r, g, b, 4);
+
+#include "../csp_planar_packed.h"
+
+/* YUVJ422P -> RGB */
+
+#define FUNC_NAME     yuvj_422_p_to_rgb_24_avx2
+#define IN_TYPE       uint8_t
+#define OUT_TYPE      uint8_t
+#define IN_ADVANCE_Y  16
+#define IN_ADVANCE_UV 8
+#define OUT_ADVANCE   48
+#define NUM_PIXELS    16
+#define INIT          INIT_8
+#define CHROMA_SUB    1
+#define CONVERT       \
+  load_yuv_planar_avx2(src_y, src_u, src_v, &y, &u, &v, 2); \
+  yuv_to_rgb_avx2(y, u, v, &r, &g, &b, 1); \
+  store_rgb_avx2(dst, r, g, b, 3);
+
+#include "../csp_planar_packed.h"
+
+#define FUNC_NAME     yuvj_422_p_to_bgr_24_avx2
+#define IN_TYPE       uint8_t
+#define OUT_TYPE      uint8_t
+#define IN_ADVANCE_Y  16
+#define IN_ADVANCE_UV 8
+#define OUT_ADVANCE   48
+#define NUM_PIXELS    16
+#define INIT          INIT_8
+#define CHROMA_SUB    1
+#define CONVERT       \
+  load_yuv_planar_avx2(src_y, src_u, src_v, &y, &u, &v, 2); \
+  yuv_to_rgb_avx2(y, u, v, &r, &g, &b, 1); \
+  store_rgb_avx2(dst, b, g, r, 3);
+
+#include "../csp_planar_packed.h"
+
+#define FUNC_NAME     yuvj_422_p_to_rgb_32_avx2
+#define IN_TYPE       uint8_t
+#define OUT_TYPE      uint8_t
+#define IN_ADVANCE_Y  16
+#define IN_ADVANCE_UV 8
+#define OUT_ADVANCE   64
+#define NUM_PIXELS    16
+#define INIT          INIT_8
+#define CHROMA_SUB    1
+#define CONVERT       \
+  load_yuv_planar_avx2(src_y, src_u, src_v, &y, &u, &v, 2); \
+  yuv_to_rgb_avx2(y, u, v, &r, &g, &b, 1); \
+  store_rgb_avx2(dst, r, g, b, 4);
+
+#include "../csp_planar_packed.h"
+
+#define FUNC_NAME     yuvj_422_p_to_bgr_32_avx2
+#define IN_TYPE       uint8_t
+#define OUT_TYPE      uint8_t
+#define IN_ADVANCE_Y  16
+#define IN_ADVANCE_UV 8
+#define OUT_ADVANCE   64
+#define NUM_PIXELS    16
+#define INIT          INIT_8
+#define CHROMA_SUB    1
+#define CONVERT       \
+  load_yuv_planar_avx2(src_y, src_u, src_v, &y, &u, &v, 2); \
+  yuv_to_rgb_avx2(y, u, v, &r, &g, &b, 1); \
+  store_rgb_avx2(dst, b, g, r, 4);
+
+#include "../csp_planar_packed.h"
+
+#define FUNC_NAME     yuvj_422_p_to_rgba_32_avx2
+#define IN_TYPE       uint8_t
+#define OUT_TYPE      uint8_t
+#define IN_ADVANCE_Y  16
+#define IN_ADVANCE_UV 8
+#define OUT_ADVANCE   64
+#define NUM_PIXELS    16
+#define INIT          INIT_8
+#define CHROMA_SUB    1
+#define CONVERT       \
+  load_yuv_planar_avx2(src_y, src_u, src_v, &y, &u, &v, 2); \
+  yuv_to_rgb_avx2(y, u, v, &r, &g, &b, 1); \
+  store_rgb_avx2(dst, r, g, b, 4);
+
+#include "../csp_planar_packed.h"
+
+/* YUVJ444P -> RGB */
+
+#define FUNC_NAME     yuvj_444_p_to_rgb_24_avx2
+#define IN_TYPE       uint8_t
+#define OUT_TYPE      uint8_t
+#define IN_ADVANCE_Y  16
+#define IN_ADVANCE_UV 16
+#define OUT_ADVANCE   48
+#define NUM_PIXELS    16
+#define INIT          INIT_8
+#define CHROMA_SUB    1
+#define CONVERT       \
+  load_yuv_planar_avx2(src_y, src_u, src_v, &y, &u, &v, 1); \
+  yuv_to_rgb_avx2(y, u, v, &r, &g, &b, 1); \
+  store_rgb_avx2(dst, r, g, b, 3);
+
+#include "../csp_planar_packed.h"
+
+#define FUNC_NAME     yuvj_444_p_to_bgr_24_avx2
+#define IN_TYPE       uint8_t
+#define OUT_TYPE      uint8_t
+#define IN_ADVANCE_Y  16
+#define IN_ADVANCE_UV 16
+#define OUT_ADVANCE   48
+#define NUM_PIXELS    16
+#define INIT          INIT_8
+#define CHROMA_SUB    1
+#define CONVERT       \
+  load_yuv_planar_avx2(src_y, src_u, src_v, &y, &u, &v, 1); \
+  yuv_to_rgb_avx2(y, u, v, &r, &g, &b, 1); \
+  store_rgb_avx2(dst, b, g, r, 3);
+
+#include "../csp_planar_packed.h"
+
+#define FUNC_NAME     yuvj_444_p_to_rgb_32_avx2
+#define IN_TYPE       uint8_t
+#define OUT_TYPE      uint8_t
+#define IN_ADVANCE_Y  16
+#define IN_ADVANCE_UV 16
+#define OUT_ADVANCE   64
+#define NUM_PIXELS    16
+#define INIT          INIT_8
+#define CHROMA_SUB    1
+#define CONVERT       \
+  load_yuv_planar_avx2(src_y, src_u, src_v, &y, &u, &v, 1); \
+  yuv_to_rgb_avx2(y, u, v, &r, &g, &b, 1); \
+  store_rgb_avx2(dst, r, g, b, 4);
+
+#include "../csp_planar_packed.h"
+
+#define FUNC_NAME     yuvj_444_p_to_bgr_32_avx2
+#define IN_TYPE       uint8_t
+#define OUT_TYPE      uint8_t
+#define IN_ADVANCE_Y  16
+#define IN_ADVANCE_UV 16
+#define OUT_ADVANCE   64
+#define NUM_PIXELS    16
+#define INIT          INIT_8
+#define CHROMA_SUB    1
+#define CONVERT       \
+  load_yuv_planar_avx2(src_y, src_u, src_v, &y, &u, &v, 1); \
+  yuv_to_rgb_avx2(y, u, v, &r, &g, &b, 1); \
+  store_rgb_avx2(dst, b, g, r, 4);
+
+#include "../csp_planar_packed.h"
+
+#define FUNC_NAME     yuvj_444_p_to_rgba_32_avx2
+#define IN_TYPE       uint8_t
+#define OUT_TYPE      uint8_t
+#define IN_ADVANCE_Y  16
+#define IN_ADVANCE_UV 16
+#define OUT_ADVANCE   64
+#define NUM_PIXELS    16
+#define INIT          INIT_8
+#define CHROMA_SUB    1
+#define CONVERT       \
+  load_yuv_planar_avx2(src_y, src_u, src_v, &y, &u, &v, 1); \
+  yuv_to_rgb_avx2(y, u, v, &r, &g, &b, 1); \
+  store_rgb_avx2(dst, r, g, b, 4);
+
+#include "../csp_planar_packed.h"
+
+/* 16 bit -> RGB48 */
+
+#define INIT_16                                                 \
+  __m256 y, u, v;                                               \
+  __m256 y_off = _mm256_set1_ps(0x1000);                        \
+  __m256 c_off = _mm256_set1_ps(0x8000);                        \
+  __m256 y_fac = _mm256_set1_ps(y_16_to_rgb / 65536.0);         \
+  __m256 v_r   = _mm256_set1_ps(v_16_to_r / 65536.0);           \
+  __m256 u_g   = _mm256_set1_ps(u_16_to_g / 65536.0);           \
+  __m256 v_g   = _mm256_set1_ps(v_16_to_g / 65536.0);           \
+  __m256 u_b   = _mm256_set1_ps(u_16_to_b / 65536.0);
+
+#define YUV_16_TO_RGB_48_AVX2(sub_h)                            \
+  y = _mm256_mul_ps(_mm256_sub_ps(load_16_avx2(src_y, 1), y_off), y_fac); \
+  u = _mm256_sub_ps(load_16_avx2(src_u, sub_h), c_off);         \
+  v = _mm256_sub_ps(load_16_avx2(src_v, sub_h), c_off);         \
+  store_rgb_48_avx2(dst,                                        \
+                    pack_16_avx2(_mm256_add_ps(y, _mm256_mul_ps(v, v_r))), \
+                    pack_16_avx2(_mm256_add_ps(y, _mm256_add_ps(_mm256_mul_ps(u, u_g), \
+                                                                _mm256_mul_ps(v, v_g)))), \
+                    pack_16_avx2(_mm256_add_ps(y, _mm256_mul_ps(u, u_b))));
+
+#define FUNC_NAME     yuv_422_p_16_to_rgb_48_avx2
+#define IN_TYPE       uint16_t
+#define OUT_TYPE      uint16_t
+#define IN_ADVANCE_Y  8
+#define IN_ADVANCE_UV 4
+#define OUT_ADVANCE   24
+#define NUM_PIXELS    8
+#define CHROMA_SUB    1
+#define INIT          INIT_16
+#define CONVERT       YUV_16_TO_RGB_48_AVX2(2)
+
+#include "../csp_planar_packed.h"
+
+#define FUNC_NAME     yuv_444_p_16_to_rgb_48_avx2
+#define IN_TYPE       uint16_t
+#define OUT_TYPE      uint16_t
+#define IN_ADVANCE_Y  8
+#define IN_ADVANCE_UV 8
+#define OUT_ADVANCE   24
+#define NUM_PIXELS    8
+#define CHROMA_SUB    1
+#define INIT          INIT_16
+#define CONVERT       YUV_16_TO_RGB_48_AVX2(1)
+
+#include "../csp_planar_packed.h"
+
+void gavl_init_yuv_rgb_funcs_avx2(gavl_pixelformat_function_table_t * tab,
+                                  int width, const gavl_video_options_t * opt)
+  {
+  if(width % 16)
+    return;
+
+  if(opt->quality && (opt->quality >= 3))
+    return;
+
+  tab->yuy2_to_rgb_24 = yuy2_to_rgb_24_avx2;
+  tab->yuy2_to_bgr_24 = yuy2_to_bgr_24_avx2;
+  tab->yuy2_to_rgb_32 = yuy2_to_rgb_32_avx2;
+  tab->yuy2_to_bgr_32 = yuy2_to_bgr_32_avx2;
+  tab->yuy2_to_rgba_32 = yuy2_to_rgba_32_avx2;
+
+  tab->uyvy_to_rgb_24 = uyvy_to_rgb_24_avx2;
+  tab->uyvy_to_bgr_24 = uyvy_to_bgr_24_avx2;
+  tab->uyvy_to_rgb_32 = uyvy_to_rgb_32_avx2;
+  tab->uyvy_to_bgr_32 = uyvy_to_bgr_32_avx2;
+  tab->uyvy_to_rgba_32 = uyvy_to_rgba_32_avx2;
+
+  tab->yuv_420_p_to_rgb_24 = yuv_420_p_to_rgb_24_avx2;
+  tab->yuv_420_p_to_bgr_24 = yuv_420_p_to_bgr_24_avx2;
+  tab->yuv_420_p_to_rgb_32 = yuv_420_p_to_rgb_32_avx2;
+  tab->yuv_420_p_to_bgr_32 = yuv_420_p_to_bgr_32_avx2;
+  tab->yuv_420_p_to_rgba_32 = yuv_420_p_to_rgba_32_avx2;
+
+  tab->yuv_422_p_to_rgb_24 = yuv_422_p_to_rgb_24_avx2;
+  tab->yuv_422_p_to_bgr_24 = yuv_422_p_to_bgr_24_avx2;
+  tab->yuv_422_p_to_rgb_32 = yuv_422_p_to_rgb_32_avx2;
+  tab->yuv_422_p_to_bgr_32 = yuv_422_p_to_bgr_32_avx2;
+  tab->yuv_422_p_to_rgba_32 = yuv_422_p_to_rgba_32_avx2;
+
+  tab->yuv_444_p_to_rgb_24 = yuv_444_p_to_rgb_24_avx2;
+  tab->yuv_444_p_to_bgr_24 = yuv_444_p_to_bgr_24_avx2;
+  tab->yuv_444_p_to_rgb_32 = yuv_444_p_to_rgb_32_avx2;
+  tab->yuv_444_p_to_bgr_32 = yuv_444_p_to_bgr_32_avx2;
+  tab->yuv_444_p_to_rgba_32 = yuv_444_p_to_rgba_32_avx2;
+
+  tab->yuvj_420_p_to_rgb_24 = yuvj_420_p_to_rgb_24_avx2;
+  tab->yuvj_420_p_to_bgr_24 = yuvj_420_p_to_bgr_24_avx2;
+  tab->yuvj_420_p_to_rgb_32 = yuvj_420_p_to_rgb_32_avx2;
+  tab->yuvj_420_p_to_bgr_32 = yuvj_420_p_to_bgr_32_avx2;
+  tab->yuvj_420_p_to_rgba_32 = yuvj_420_p_to_rgba_32_avx2;
+
+  tab->yuvj_422_p_to_rgb_24 = yuvj_422_p_to_rgb_24_avx2;
+  tab->yuvj_422_p_to_bgr_24 = yuvj_422_p_to_bgr_24_avx2;
+  tab->yuvj_422_p_to_rgb_32 = yuvj_422_p_to_rgb_32_avx2;
+  tab->yuvj_422_p_to_bgr_32 = yuvj_422_p_to_bgr_32_avx2;
+  tab->yuvj_422_p_to_rgba_32 = yuvj_422_p_to_rgba_32_avx2;
+
+  tab->yuvj_444_p_to_rgb_24 = yuvj_444_p_to_rgb_24_avx2;
+  tab->yuvj_444_p_to_bgr_24 = yuvj_444_p_to_bgr_24_avx2;
+  tab->yuvj_444_p_to_rgb_32 = yuvj_444_p_to_rgb_32_avx2;
+  tab->yuvj_444_p_to_bgr_32 = yuvj_444_p_to_bgr_32_avx2;
+  tab->yuvj_444_p_to_rgba_32 = yuvj_444_p_to_rgba_32_avx2;
+
+  tab->yuv_422_p_16_to_rgb_48 = yuv_422_p_16_to_rgb_48_avx2;
+
+  tab->yuv_444_p_16_to_rgb_48 = yuv_444_p_16_to_rgb_48_avx2;
+  }
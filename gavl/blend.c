@@ -23,6 +23,8 @@
 #include <stdio.h>
 #include <string.h>
 
+#include <config.h>
+
 #include <gavl/gavl.h>
 #include <video.h>
 #include <blend.h>
@@ -50,6 +52,9 @@ void gavl_overlay_blend_context_destroy(gavl_overlay_blend_context_t * ctx)
 
   if(ctx->sink)
     gavl_video_sink_destroy(ctx->sink);
+
+  if(ctx->ovl_premultiplied)
+    gavl_video_frame_destroy(ctx->ovl_premultiplied);
   
   free(ctx);
   }
@@ -60,6 +65,54 @@ gavl_overlay_blend_context_get_options(gavl_overlay_blend_context_t * ctx)
   return &ctx->opt;
   }
 
+/* Formats, which are blended with the line functions from an
+   8 bit overlay */
+
+static int can_premultiply(gavl_pixelformat_t pfmt)
+  {
+  switch(pfmt)
+    {
+    case GAVL_RGB_32:
+    case GAVL_YUV_420_P:
+    case GAVL_YUV_422_P:
+    case GAVL_YUV_444_P:
+    case GAVL_YUV_411_P:
+    case GAVL_YUV_410_P:
+      return 1;
+    default:
+      return 0;
+    }
+  }
+
+/* Premultiply the visible part of the overlay (RGBA_32 or YUVA_32) */
+
+static void premultiply(gavl_overlay_blend_context_t * ctx)
+  {
+  int i, j, a;
+  const uint8_t * src;
+  uint8_t * dst;
+  const gavl_rectangle_i_t * r = &ctx->ovl->src_rect;
+  
+  for(i = r->y; i < r->y + r->h; i++)
+    {
+    src = ctx->ovl->planes[0] + i * ctx->ovl->strides[0] + 4 * r->x;
+    dst = ctx->ovl_premultiplied->planes[0] +
+      i * ctx->ovl_premultiplied->strides[0] + 4 * r->x;
+
+    for(j = 0; j < r->w; j++)
+      {
+      /* Scale alpha to 0..256 like in the blend functions */
+      a = src[3] + (src[3] >> 7);
+      dst[0] = (src[0] * a + 0x80) >> 8;
+      dst[1] = (src[1] * a + 0x80) >> 8;
+      dst[2] = (src[2] * a + 0x80) >> 8;
+      dst[3] = src[3];
+      src += 4;
+      dst += 4;
+      }
+    }
+  }
+
 static gavl_sink_status_t
 put_frame(void * priv,
           gavl_overlay_t * ovl)
@@ -137,9 +190,17 @@ put_frame(void * priv,
 
   ctx->dst_rect.w = ctx->ovl->src_rect.w;
   ctx->dst_rect.h = ctx->ovl->src_rect.h;
-    
+
+  if(ctx->premultiply)
+    {
+    premultiply(ctx);
+    ctx->ovl_frame = ctx->ovl_premultiplied;
+    }
+  else
+    ctx->ovl_frame = ovl;
+  
   gavl_video_frame_get_subframe(ctx->ovl_format.pixelformat,
-                                ovl,
+                                ctx->ovl_frame,
                                 ctx->ovl_win,
                                 &ctx->ovl->src_rect);
   return GAVL_SINK_OK;
@@ -164,6 +225,12 @@ gavl_overlay_blend_context_init(gavl_overlay_blend_context_t * ctx,
 
   if(ctx->sink)
     gavl_video_sink_destroy(ctx->sink);
+
+  if(ctx->ovl_premultiplied)
+    {
+    gavl_video_frame_destroy(ctx->ovl_premultiplied);
+    ctx->ovl_premultiplied = NULL;
+    }
   
   /* Check for non alpha capable overlay format */
 
@@ -178,12 +245,31 @@ gavl_overlay_blend_context_init(gavl_overlay_blend_context_t * ctx,
   gavl_pixelformat_chroma_sub(dst_format->pixelformat,
                               &ctx->dst_sub_h, &ctx->dst_sub_v);
 
+  ctx->premultiply =
+    (ctx->opt.conversion_flags & GAVL_PREMULTIPLY_OVERLAYS) &&
+    can_premultiply(dst_format->pixelformat);
+  
+  /* Get line functions */
+
+  gavl_init_blend_funcs_c(&ctx->funcs, ctx->premultiply);
+#ifdef HAVE_SSE2
+  if(ctx->opt.accel_flags & GAVL_ACCEL_SSE2)
+    gavl_init_blend_funcs_sse2(&ctx->funcs, ctx->premultiply);
+#endif
+#ifdef HAVE_AVX2
+  if(ctx->opt.accel_flags & GAVL_ACCEL_AVX2)
+    gavl_init_blend_funcs_avx2(&ctx->funcs, ctx->premultiply);
+#endif
+  
   /* Get blend function */
 
   ctx->func = 
     gavl_find_blend_func_c(ctx,
                            dst_format->pixelformat,
                            &ctx->ovl_format.pixelformat);
+
+  if(ctx->premultiply)
+    ctx->ovl_premultiplied = gavl_video_frame_create(&ctx->ovl_format);
   
   gavl_video_format_copy(ovl_format, &ctx->ovl_format);
   
@@ -212,6 +298,7 @@ void gavl_overlay_blend(gavl_overlay_blend_context_t * ctx,
                                 &ctx->dst_rect);
   /* Fire up blender */
 
-  ctx->func(ctx, ctx->dst_win, ctx->ovl_win);
+  ctx->func(ctx, ctx->dst_win, ctx->ovl_win,
+            ctx->ovl->src_rect.w, ctx->ovl->src_rect.h);
   }
 
@@ -26,7 +26,16 @@
 #include "scale_macros.h"
 
 #define TMP_TYPE_8 int
-#define TMP_TYPE_16 uint32_t
+#define TMP_TYPE_16 int64_t
+
+/* Clip the overshoots of the bicubic filters */
+
+#define CLIP_8(a) \
+  if(GAVL_UNLIKELY((a) & ~0xff)) a = ((a) < 0) ? 0 : 0xff
+
+#define CLIP_16(a) \
+  if(GAVL_UNLIKELY((a) & ~0xffff)) a = ((a) < 0) ? 0 : 0xffff
+
 /* transform_rgb_15_c */
 
 #define FUNC_NAME transform_rgb_15_c
@@ -287,6 +296,7 @@
         (TMP_TYPE_8)pixel->factors_i[1][0] * src_1[0] +  \
         (TMP_TYPE_8)pixel->factors_i[1][1] * src_1[1];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_8(tmp);\
   dst[0] = tmp;
 #elif NUM_TAPS == 3
 #define TRANSFORM                                               \
@@ -300,6 +310,7 @@
         (TMP_TYPE_8)pixel->factors_i[2][1] * src_2[1] +  \
         (TMP_TYPE_8)pixel->factors_i[2][2] * src_2[2]; \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_8(tmp);\
   dst[0] = tmp;
 
 #elif NUM_TAPS == 4
@@ -321,6 +332,7 @@
         (TMP_TYPE_8)pixel->factors_i[3][2] * src_3[2] +  \
         (TMP_TYPE_8)pixel->factors_i[3][3] * src_3[3];  \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_8(tmp);\
   dst[0] = tmp;
 
 
@@ -341,6 +353,7 @@
         (TMP_TYPE_8)pixel->factors_i[1][0] * src_1[0] +  \
         (TMP_TYPE_8)pixel->factors_i[1][1] * src_1[ctx->advance];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_8(tmp);\
   dst[0] = tmp;
 #elif NUM_TAPS == 3
 #define TRANSFORM                                               \
@@ -354,6 +367,7 @@
         (TMP_TYPE_8)pixel->factors_i[2][1] * src_2[ctx->advance] +  \
         (TMP_TYPE_8)pixel->factors_i[2][2] * src_2[2*ctx->advance]; \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_8(tmp);\
   dst[0] = tmp;
 
 #elif NUM_TAPS == 4
@@ -375,6 +389,7 @@
         (TMP_TYPE_8)pixel->factors_i[3][2] * src_3[2*ctx->advance] +  \
         (TMP_TYPE_8)pixel->factors_i[3][3] * src_3[3*ctx->advance];  \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_8(tmp);\
   dst[0] = tmp;
 
 #endif
@@ -395,12 +410,14 @@
         (TMP_TYPE_8)pixel->factors_i[1][0] * src_1[0] +  \
         (TMP_TYPE_8)pixel->factors_i[1][1] * src_1[2];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_8(tmp);\
   dst[0] = tmp;                                                 \
   tmp = (TMP_TYPE_8)pixel->factors_i[0][0] * src_0[1] +  \
         (TMP_TYPE_8)pixel->factors_i[0][1] * src_0[3] +  \
         (TMP_TYPE_8)pixel->factors_i[1][0] * src_1[1] +  \
         (TMP_TYPE_8)pixel->factors_i[1][1] * src_1[3];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_8(tmp);\
   dst[1] = tmp;
 #elif NUM_TAPS == 3
 #define TRANSFORM                                               \
@@ -414,6 +431,7 @@
         (TMP_TYPE_8)pixel->factors_i[2][1] * src_2[2] +   \
         (TMP_TYPE_8)pixel->factors_i[2][2] * src_2[4];  \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_8(tmp);\
   dst[0] = tmp;                                                 \
   tmp = (TMP_TYPE_8)pixel->factors_i[0][0] * src_0[1] +  \
         (TMP_TYPE_8)pixel->factors_i[0][1] * src_0[3] +  \
@@ -425,6 +443,7 @@
         (TMP_TYPE_8)pixel->factors_i[2][1] * src_2[3] +   \
         (TMP_TYPE_8)pixel->factors_i[2][2] * src_2[5];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_8(tmp);\
   dst[1] = tmp;
 #elif NUM_TAPS == 4
 #define TRANSFORM \
@@ -445,6 +464,7 @@
         (TMP_TYPE_8)pixel->factors_i[3][2] * src_3[4] +  \
         (TMP_TYPE_8)pixel->factors_i[3][3] * src_3[6];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_8(tmp);\
   dst[0] = tmp;                                                 \
   tmp = (TMP_TYPE_8)pixel->factors_i[0][0] * src_0[1] +  \
         (TMP_TYPE_8)pixel->factors_i[0][1] * src_0[3] +  \
@@ -463,6 +483,7 @@
         (TMP_TYPE_8)pixel->factors_i[3][2] * src_3[5] +  \
         (TMP_TYPE_8)pixel->factors_i[3][3] * src_3[7];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_8(tmp);\
   dst[1] = tmp;
 #endif
 
@@ -481,18 +502,21 @@
         (TMP_TYPE_8)pixel->factors_i[1][0] * src_1[0] +  \
         (TMP_TYPE_8)pixel->factors_i[1][1] * src_1[3];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_8(tmp);\
   dst[0] = tmp;                                                 \
   tmp = (TMP_TYPE_8)pixel->factors_i[0][0] * src_0[1] +  \
         (TMP_TYPE_8)pixel->factors_i[0][1] * src_0[4] +  \
         (TMP_TYPE_8)pixel->factors_i[1][0] * src_1[1] +  \
         (TMP_TYPE_8)pixel->factors_i[1][1] * src_1[4];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_8(tmp);\
   dst[1] = tmp; \
   tmp = (TMP_TYPE_8)pixel->factors_i[0][0] * src_0[2] +  \
         (TMP_TYPE_8)pixel->factors_i[0][1] * src_0[5] +  \
         (TMP_TYPE_8)pixel->factors_i[1][0] * src_1[2] +  \
         (TMP_TYPE_8)pixel->factors_i[1][1] * src_1[5];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_8(tmp);\
   dst[2] = tmp;
 #elif NUM_TAPS == 3
 #define TRANSFORM                                               \
@@ -506,6 +530,7 @@
         (TMP_TYPE_8)pixel->factors_i[2][1] * src_2[3] +   \
         (TMP_TYPE_8)pixel->factors_i[2][2] * src_2[6];  \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_8(tmp);\
   dst[0] = tmp;                                                 \
   tmp = (TMP_TYPE_8)pixel->factors_i[0][0] * src_0[1] +  \
         (TMP_TYPE_8)pixel->factors_i[0][1] * src_0[4] +  \
@@ -517,6 +542,7 @@
         (TMP_TYPE_8)pixel->factors_i[2][1] * src_2[4] +   \
         (TMP_TYPE_8)pixel->factors_i[2][2] * src_2[7];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_8(tmp);\
   dst[1] = tmp; \
   tmp = (TMP_TYPE_8)pixel->factors_i[0][0] * src_0[2] +  \
         (TMP_TYPE_8)pixel->factors_i[0][1] * src_0[5] +  \
@@ -528,6 +554,7 @@
         (TMP_TYPE_8)pixel->factors_i[2][1] * src_2[5] +   \
         (TMP_TYPE_8)pixel->factors_i[2][2] * src_2[8];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_8(tmp);\
   dst[2] = tmp;
 #elif NUM_TAPS == 4
 #define TRANSFORM \
@@ -548,6 +575,7 @@
         (TMP_TYPE_8)pixel->factors_i[3][2] * src_3[6] +  \
         (TMP_TYPE_8)pixel->factors_i[3][3] * src_3[9];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_8(tmp);\
   dst[0] = tmp;                                                 \
   tmp = (TMP_TYPE_8)pixel->factors_i[0][0] * src_0[1] +  \
         (TMP_TYPE_8)pixel->factors_i[0][1] * src_0[4] +  \
@@ -566,6 +594,7 @@
         (TMP_TYPE_8)pixel->factors_i[3][2] * src_3[7] +  \
         (TMP_TYPE_8)pixel->factors_i[3][3] * src_3[10];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_8(tmp);\
   dst[1] = tmp; \
   tmp = (TMP_TYPE_8)pixel->factors_i[0][0] * src_0[2] +  \
         (TMP_TYPE_8)pixel->factors_i[0][1] * src_0[5] +  \
@@ -584,6 +613,7 @@
         (TMP_TYPE_8)pixel->factors_i[3][2] * src_3[8] +  \
         (TMP_TYPE_8)pixel->factors_i[3][3] * src_3[11];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_8(tmp);\
   dst[2] = tmp;
 
 #endif
@@ -603,18 +633,21 @@
         (TMP_TYPE_8)pixel->factors_i[1][0] * src_1[0] +  \
         (TMP_TYPE_8)pixel->factors_i[1][1] * src_1[4];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_8(tmp);\
   dst[0] = tmp;                                                 \
   tmp = (TMP_TYPE_8)pixel->factors_i[0][0] * src_0[1] +  \
         (TMP_TYPE_8)pixel->factors_i[0][1] * src_0[5] +  \
         (TMP_TYPE_8)pixel->factors_i[1][0] * src_1[1] +  \
         (TMP_TYPE_8)pixel->factors_i[1][1] * src_1[5];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_8(tmp);\
   dst[1] = tmp; \
   tmp = (TMP_TYPE_8)pixel->factors_i[0][0] * src_0[2] +  \
         (TMP_TYPE_8)pixel->factors_i[0][1] * src_0[6] +  \
         (TMP_TYPE_8)pixel->factors_i[1][0] * src_1[2] +  \
         (TMP_TYPE_8)pixel->factors_i[1][1] * src_1[6];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_8(tmp);\
   dst[2] = tmp;
 #elif NUM_TAPS == 3
 #define TRANSFORM                                               \
@@ -628,6 +661,7 @@
         (TMP_TYPE_8)pixel->factors_i[2][1] * src_2[4] +   \
         (TMP_TYPE_8)pixel->factors_i[2][2] * src_2[8];  \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_8(tmp);\
   dst[0] = tmp;                                                 \
   tmp = (TMP_TYPE_8)pixel->factors_i[0][0] * src_0[1] +  \
         (TMP_TYPE_8)pixel->factors_i[0][1] * src_0[5] +  \
@@ -639,6 +673,7 @@
         (TMP_TYPE_8)pixel->factors_i[2][1] * src_2[5] +   \
         (TMP_TYPE_8)pixel->factors_i[2][2] * src_2[9];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_8(tmp);\
   dst[1] = tmp; \
   tmp = (TMP_TYPE_8)pixel->factors_i[0][0] * src_0[2] +  \
         (TMP_TYPE_8)pixel->factors_i[0][1] * src_0[6] +  \
@@ -650,6 +685,7 @@
         (TMP_TYPE_8)pixel->factors_i[2][1] * src_2[6] +   \
         (TMP_TYPE_8)pixel->factors_i[2][2] * src_2[10];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_8(tmp);\
   dst[2] = tmp;
 #elif NUM_TAPS == 4
 #define TRANSFORM \
@@ -670,6 +706,7 @@
         (TMP_TYPE_8)pixel->factors_i[3][2] * src_3[8] +  \
         (TMP_TYPE_8)pixel->factors_i[3][3] * src_3[12];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_8(tmp);\
   dst[0] = tmp;                                                 \
   tmp = (TMP_TYPE_8)pixel->factors_i[0][0] * src_0[1] +  \
         (TMP_TYPE_8)pixel->factors_i[0][1] * src_0[5] +  \
@@ -688,6 +725,7 @@
         (TMP_TYPE_8)pixel->factors_i[3][2] * src_3[9] +  \
         (TMP_TYPE_8)pixel->factors_i[3][3] * src_3[13];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_8(tmp);\
   dst[1] = tmp; \
   tmp = (TMP_TYPE_8)pixel->factors_i[0][0] * src_0[2] +  \
         (TMP_TYPE_8)pixel->factors_i[0][1] * src_0[6] +  \
@@ -706,6 +744,7 @@
         (TMP_TYPE_8)pixel->factors_i[3][2] * src_3[10] +  \
         (TMP_TYPE_8)pixel->factors_i[3][3] * src_3[14];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_8(tmp);\
   dst[2] = tmp;
 
 #endif
@@ -725,24 +764,28 @@
         (TMP_TYPE_8)pixel->factors_i[1][0] * src_1[0] +  \
         (TMP_TYPE_8)pixel->factors_i[1][1] * src_1[4];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_8(tmp);\
   dst[0] = tmp;                                                 \
   tmp = (TMP_TYPE_8)pixel->factors_i[0][0] * src_0[1] +  \
         (TMP_TYPE_8)pixel->factors_i[0][1] * src_0[5] +  \
         (TMP_TYPE_8)pixel->factors_i[1][0] * src_1[1] +  \
         (TMP_TYPE_8)pixel->factors_i[1][1] * src_1[5];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_8(tmp);\
   dst[1] = tmp; \
   tmp = (TMP_TYPE_8)pixel->factors_i[0][0] * src_0[2] +  \
         (TMP_TYPE_8)pixel->factors_i[0][1] * src_0[6] +  \
         (TMP_TYPE_8)pixel->factors_i[1][0] * src_1[2] +  \
         (TMP_TYPE_8)pixel->factors_i[1][1] * src_1[6];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_8(tmp);\
   dst[2] = tmp; \
   tmp = (TMP_TYPE_8)pixel->factors_i[0][0] * src_0[3] +  \
         (TMP_TYPE_8)pixel->factors_i[0][1] * src_0[7] +  \
         (TMP_TYPE_8)pixel->factors_i[1][0] * src_1[2] +  \
         (TMP_TYPE_8)pixel->factors_i[1][1] * src_1[7];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_8(tmp);\
   dst[3] = tmp;
 #elif NUM_TAPS == 3
 #define TRANSFORM                                               \
@@ -756,6 +799,7 @@
         (TMP_TYPE_8)pixel->factors_i[2][1] * src_2[4] +   \
         (TMP_TYPE_8)pixel->factors_i[2][2] * src_2[8];  \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_8(tmp);\
   dst[0] = tmp;                                                 \
   tmp = (TMP_TYPE_8)pixel->factors_i[0][0] * src_0[1] +  \
         (TMP_TYPE_8)pixel->factors_i[0][1] * src_0[5] +  \
@@ -767,6 +811,7 @@
         (TMP_TYPE_8)pixel->factors_i[2][1] * src_2[5] +   \
         (TMP_TYPE_8)pixel->factors_i[2][2] * src_2[9];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_8(tmp);\
   dst[1] = tmp; \
   tmp = (TMP_TYPE_8)pixel->factors_i[0][0] * src_0[2] +  \
         (TMP_TYPE_8)pixel->factors_i[0][1] * src_0[6] +  \
@@ -778,6 +823,7 @@
         (TMP_TYPE_8)pixel->factors_i[2][1] * src_2[6] +   \
         (TMP_TYPE_8)pixel->factors_i[2][2] * src_2[10];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_8(tmp);\
   dst[2] = tmp; \
   tmp = (TMP_TYPE_8)pixel->factors_i[0][0] * src_0[3] +  \
         (TMP_TYPE_8)pixel->factors_i[0][1] * src_0[7] +  \
@@ -789,6 +835,7 @@
         (TMP_TYPE_8)pixel->factors_i[2][1] * src_2[7] +   \
         (TMP_TYPE_8)pixel->factors_i[2][2] * src_2[11];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_8(tmp);\
   dst[3] = tmp;
 #elif NUM_TAPS == 4
 #define TRANSFORM \
@@ -809,6 +856,7 @@
         (TMP_TYPE_8)pixel->factors_i[3][2] * src_3[8] +  \
         (TMP_TYPE_8)pixel->factors_i[3][3] * src_3[12];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_8(tmp);\
   dst[0] = tmp;                                                 \
   tmp = (TMP_TYPE_8)pixel->factors_i[0][0] * src_0[1] +  \
         (TMP_TYPE_8)pixel->factors_i[0][1] * src_0[5] +  \
@@ -827,6 +875,7 @@
         (TMP_TYPE_8)pixel->factors_i[3][2] * src_3[9] +  \
         (TMP_TYPE_8)pixel->factors_i[3][3] * src_3[13];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_8(tmp);\
   dst[1] = tmp; \
   tmp = (TMP_TYPE_8)pixel->factors_i[0][0] * src_0[2] +  \
         (TMP_TYPE_8)pixel->factors_i[0][1] * src_0[6] +  \
@@ -845,6 +894,7 @@
         (TMP_TYPE_8)pixel->factors_i[3][2] * src_3[10] +  \
         (TMP_TYPE_8)pixel->factors_i[3][3] * src_3[14];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_8(tmp);\
   dst[2] = tmp;\
   tmp = (TMP_TYPE_8)pixel->factors_i[0][0] * src_0[3] +  \
         (TMP_TYPE_8)pixel->factors_i[0][1] * src_0[7] +  \
@@ -863,6 +913,7 @@
         (TMP_TYPE_8)pixel->factors_i[3][2] * src_3[11] +  \
         (TMP_TYPE_8)pixel->factors_i[3][3] * src_3[15];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_8(tmp);\
   dst[3] = tmp;
 
 
@@ -884,6 +935,7 @@
         (TMP_TYPE_16)pixel->factors_i[1][0] * src_1[0] +  \
         (TMP_TYPE_16)pixel->factors_i[1][1] * src_1[1];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_16(tmp);\
   dst[0] = tmp;
 #elif NUM_TAPS == 3
 #define TRANSFORM                                               \
@@ -897,6 +949,7 @@
         (TMP_TYPE_16)pixel->factors_i[2][1] * src_2[1] +  \
         (TMP_TYPE_16)pixel->factors_i[2][2] * src_2[2]; \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_16(tmp);\
   dst[0] = tmp;
 
 #elif NUM_TAPS == 4
@@ -918,6 +971,7 @@
         (TMP_TYPE_16)pixel->factors_i[3][2] * src_3[2] +  \
         (TMP_TYPE_16)pixel->factors_i[3][3] * src_3[3];  \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_16(tmp);\
   dst[0] = tmp;
 
 
@@ -939,12 +993,14 @@
         (TMP_TYPE_16)pixel->factors_i[1][0] * src_1[0] +  \
         (TMP_TYPE_16)pixel->factors_i[1][1] * src_1[2];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_16(tmp);\
   dst[0] = tmp;                                                 \
   tmp = (TMP_TYPE_16)pixel->factors_i[0][0] * src_0[1] +  \
         (TMP_TYPE_16)pixel->factors_i[0][1] * src_0[3] +  \
         (TMP_TYPE_16)pixel->factors_i[1][0] * src_1[1] +  \
         (TMP_TYPE_16)pixel->factors_i[1][1] * src_1[3];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_16(tmp);\
   dst[1] = tmp;
 #elif NUM_TAPS == 3
 #define TRANSFORM                                               \
@@ -958,6 +1014,7 @@
         (TMP_TYPE_16)pixel->factors_i[2][1] * src_2[2] +   \
         (TMP_TYPE_16)pixel->factors_i[2][2] * src_2[4];  \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_16(tmp);\
   dst[0] = tmp;                                                 \
   tmp = (TMP_TYPE_16)pixel->factors_i[0][0] * src_0[1] +  \
         (TMP_TYPE_16)pixel->factors_i[0][1] * src_0[3] +  \
@@ -969,6 +1026,7 @@
         (TMP_TYPE_16)pixel->factors_i[2][1] * src_2[3] +   \
         (TMP_TYPE_16)pixel->factors_i[2][2] * src_2[5];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_16(tmp);\
   dst[1] = tmp;
 #elif NUM_TAPS == 4
 #define TRANSFORM \
@@ -989,6 +1047,7 @@
         (TMP_TYPE_16)pixel->factors_i[3][2] * src_3[4] +  \
         (TMP_TYPE_16)pixel->factors_i[3][3] * src_3[6];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_16(tmp);\
   dst[0] = tmp;                                                 \
   tmp = (TMP_TYPE_16)pixel->factors_i[0][0] * src_0[1] +  \
         (TMP_TYPE_16)pixel->factors_i[0][1] * src_0[3] +  \
@@ -1007,6 +1066,7 @@
         (TMP_TYPE_16)pixel->factors_i[3][2] * src_3[5] +  \
         (TMP_TYPE_16)pixel->factors_i[3][3] * src_3[7];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_16(tmp);\
   dst[1] = tmp;
 #endif
 
@@ -1025,18 +1085,21 @@
         (TMP_TYPE_16)pixel->factors_i[1][0] * src_1[0] +  \
         (TMP_TYPE_16)pixel->factors_i[1][1] * src_1[3];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_16(tmp);\
   dst[0] = tmp;                                                 \
   tmp = (TMP_TYPE_16)pixel->factors_i[0][0] * src_0[1] +  \
         (TMP_TYPE_16)pixel->factors_i[0][1] * src_0[4] +  \
         (TMP_TYPE_16)pixel->factors_i[1][0] * src_1[1] +  \
         (TMP_TYPE_16)pixel->factors_i[1][1] * src_1[4];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_16(tmp);\
   dst[1] = tmp; \
   tmp = (TMP_TYPE_16)pixel->factors_i[0][0] * src_0[2] +  \
         (TMP_TYPE_16)pixel->factors_i[0][1] * src_0[5] +  \
         (TMP_TYPE_16)pixel->factors_i[1][0] * src_1[2] +  \
         (TMP_TYPE_16)pixel->factors_i[1][1] * src_1[5];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_16(tmp);\
   dst[2] = tmp;
 #elif NUM_TAPS == 3
 #define TRANSFORM                                               \
@@ -1050,6 +1113,7 @@
         (TMP_TYPE_16)pixel->factors_i[2][1] * src_2[3] +   \
         (TMP_TYPE_16)pixel->factors_i[2][2] * src_2[6];  \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_16(tmp);\
   dst[0] = tmp;                                                 \
   tmp = (TMP_TYPE_16)pixel->factors_i[0][0] * src_0[1] +  \
         (TMP_TYPE_16)pixel->factors_i[0][1] * src_0[4] +  \
@@ -1061,6 +1125,7 @@
         (TMP_TYPE_16)pixel->factors_i[2][1] * src_2[4] +   \
         (TMP_TYPE_16)pixel->factors_i[2][2] * src_2[7];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_16(tmp);\
   dst[1] = tmp; \
   tmp = (TMP_TYPE_16)pixel->factors_i[0][0] * src_0[2] +  \
         (TMP_TYPE_16)pixel->factors_i[0][1] * src_0[5] +  \
@@ -1072,6 +1137,7 @@
         (TMP_TYPE_16)pixel->factors_i[2][1] * src_2[5] +   \
         (TMP_TYPE_16)pixel->factors_i[2][2] * src_2[8];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_16(tmp);\
   dst[2] = tmp;
 #elif NUM_TAPS == 4
 #define TRANSFORM \
@@ -1092,6 +1158,7 @@
         (TMP_TYPE_16)pixel->factors_i[3][2] * src_3[6] +  \
         (TMP_TYPE_16)pixel->factors_i[3][3] * src_3[9];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_16(tmp);\
   dst[0] = tmp;                                                 \
   tmp = (TMP_TYPE_16)pixel->factors_i[0][0] * src_0[1] +  \
         (TMP_TYPE_16)pixel->factors_i[0][1] * src_0[4] +  \
@@ -1110,6 +1177,7 @@
         (TMP_TYPE_16)pixel->factors_i[3][2] * src_3[7] +  \
         (TMP_TYPE_16)pixel->factors_i[3][3] * src_3[10];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_16(tmp);\
   dst[1] = tmp; \
   tmp = (TMP_TYPE_16)pixel->factors_i[0][0] * src_0[2] +  \
         (TMP_TYPE_16)pixel->factors_i[0][1] * src_0[5] +  \
@@ -1128,6 +1196,7 @@
         (TMP_TYPE_16)pixel->factors_i[3][2] * src_3[8] +  \
         (TMP_TYPE_16)pixel->factors_i[3][3] * src_3[11];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_16(tmp);\
   dst[2] = tmp;
 
 #endif
@@ -1147,24 +1216,28 @@
         (TMP_TYPE_16)pixel->factors_i[1][0] * src_1[0] +  \
         (TMP_TYPE_16)pixel->factors_i[1][1] * src_1[4];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_16(tmp);\
   dst[0] = tmp;                                                 \
   tmp = (TMP_TYPE_16)pixel->factors_i[0][0] * src_0[1] +  \
         (TMP_TYPE_16)pixel->factors_i[0][1] * src_0[5] +  \
         (TMP_TYPE_16)pixel->factors_i[1][0] * src_1[1] +  \
         (TMP_TYPE_16)pixel->factors_i[1][1] * src_1[5];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_16(tmp);\
   dst[1] = tmp; \
   tmp = (TMP_TYPE_16)pixel->factors_i[0][0] * src_0[2] +  \
         (TMP_TYPE_16)pixel->factors_i[0][1] * src_0[6] +  \
         (TMP_TYPE_16)pixel->factors_i[1][0] * src_1[2] +  \
         (TMP_TYPE_16)pixel->factors_i[1][1] * src_1[6];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_16(tmp);\
   dst[2] = tmp; \
   tmp = (TMP_TYPE_16)pixel->factors_i[0][0] * src_0[3] +  \
         (TMP_TYPE_16)pixel->factors_i[0][1] * src_0[7] +  \
         (TMP_TYPE_16)pixel->factors_i[1][0] * src_1[2] +  \
         (TMP_TYPE_16)pixel->factors_i[1][1] * src_1[7];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_16(tmp);\
   dst[3] = tmp;
 #elif NUM_TAPS == 3
 #define TRANSFORM                                               \
@@ -1178,6 +1251,7 @@
         (TMP_TYPE_16)pixel->factors_i[2][1] * src_2[4] +   \
         (TMP_TYPE_16)pixel->factors_i[2][2] * src_2[8];  \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_16(tmp);\
   dst[0] = tmp;                                                 \
   tmp = (TMP_TYPE_16)pixel->factors_i[0][0] * src_0[1] +  \
         (TMP_TYPE_16)pixel->factors_i[0][1] * src_0[5] +  \
@@ -1189,6 +1263,7 @@
         (TMP_TYPE_16)pixel->factors_i[2][1] * src_2[5] +   \
         (TMP_TYPE_16)pixel->factors_i[2][2] * src_2[9];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_16(tmp);\
   dst[1] = tmp; \
   tmp = (TMP_TYPE_16)pixel->factors_i[0][0] * src_0[2] +  \
         (TMP_TYPE_16)pixel->factors_i[0][1] * src_0[6] +  \
@@ -1200,6 +1275,7 @@
         (TMP_TYPE_16)pixel->factors_i[2][1] * src_2[6] +   \
         (TMP_TYPE_16)pixel->factors_i[2][2] * src_2[10];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_16(tmp);\
   dst[2] = tmp; \
   tmp = (TMP_TYPE_16)pixel->factors_i[0][0] * src_0[3] +  \
         (TMP_TYPE_16)pixel->factors_i[0][1] * src_0[7] +  \
@@ -1211,6 +1287,7 @@
         (TMP_TYPE_16)pixel->factors_i[2][1] * src_2[7] +   \
         (TMP_TYPE_16)pixel->factors_i[2][2] * src_2[11];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_16(tmp);\
   dst[2] = tmp;
 #elif NUM_TAPS == 4
 #define TRANSFORM \
@@ -1231,6 +1308,7 @@
         (TMP_TYPE_16)pixel->factors_i[3][2] * src_3[8] +  \
         (TMP_TYPE_16)pixel->factors_i[3][3] * src_3[12];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_16(tmp);\
   dst[0] = tmp;                                                 \
   tmp = (TMP_TYPE_16)pixel->factors_i[0][0] * src_0[1] +  \
         (TMP_TYPE_16)pixel->factors_i[0][1] * src_0[5] +  \
@@ -1249,6 +1327,7 @@
         (TMP_TYPE_16)pixel->factors_i[3][2] * src_3[9] +  \
         (TMP_TYPE_16)pixel->factors_i[3][3] * src_3[13];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_16(tmp);\
   dst[1] = tmp; \
   tmp = (TMP_TYPE_16)pixel->factors_i[0][0] * src_0[2] +  \
         (TMP_TYPE_16)pixel->factors_i[0][1] * src_0[6] +  \
@@ -1267,6 +1346,7 @@
         (TMP_TYPE_16)pixel->factors_i[3][2] * src_3[10] +  \
         (TMP_TYPE_16)pixel->factors_i[3][3] * src_3[14];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_16(tmp);\
   dst[2] = tmp;\
   tmp = (TMP_TYPE_16)pixel->factors_i[0][0] * src_0[3] +  \
         (TMP_TYPE_16)pixel->factors_i[0][1] * src_0[7] +  \
@@ -1285,6 +1365,7 @@
         (TMP_TYPE_16)pixel->factors_i[3][2] * src_3[11] +  \
         (TMP_TYPE_16)pixel->factors_i[3][3] * src_3[15];   \
   tmp=DOWNSHIFT(tmp,16);\
+  CLIP_16(tmp);\
   dst[3] = tmp;
 #endif
 
@@ -24,6 +24,7 @@
 
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
 
 /* Switch on individual items in the colorspace tables / macros */
 #define HAVE_YUVJ_TO_YUV_8
@@ -43,10 +44,17 @@
  * d = (s - d) * a + d
  *
  * but intermediate results can be negative!
+ *
+ * For 8 bit, a is scaled to 0..256, so fully opaque pixels are copied.
  */
 
 #define BLEND_8(s, d, a) \
-  d = (((s - d) * a)>>8) + d;
+  d = (((s - d) * ((a) + ((a) >> 7)))>>8) + d;
+
+/* Premultiplied overlays: d = s + (1-a) * d */
+
+#define BLEND_8_P(s, d, a) \
+  d = s + ((d * (256 - ((a) + ((a) >> 7))))>>8);
 
 #define BLEND_16(s, d, a)                        \
   d = (((s - d) * a)>>16) + d;
@@ -54,11 +62,102 @@
 #define BLEND_FLOAT(s, d, a)                       \
   d = (s - d) * a + d;
 
+/*
+ *  Overlays (subtitles, logos) are mostly fully transparent or fully
+ *  opaque. For the common 8 bit formats, we split each line into runs
+ *  of transparent (skipped), opaque (copied) and partially transparent
+ *  (blended) pixels. Only the latter are passed to the (possibly SIMD)
+ *  line functions. Runs are made of chunks of RUN_CHUNK pixels, since
+ *  the blend equation above is exact for transparent and opaque pixels,
+ *  partially transparent runs can contain some of them as well.
+ */
+
+#define RUN_TRANSPARENT 0
+#define RUN_OPAQUE      1
+#define RUN_MIXED       2
+
+#define RUN_CHUNK       8
+
+/* ovl: 4 bytes per pixel, alpha last */
+
+static inline int get_chunk_type(const uint8_t * ovl)
+  {
+  static const uint8_t alpha_bytes[8] = { 0, 0, 0, 0xff, 0, 0, 0, 0xff };
+  uint64_t alpha_mask;
+  uint64_t p[RUN_CHUNK / 2];
+  
+  memcpy(&alpha_mask, alpha_bytes, 8);
+  memcpy(p, ovl, 4 * RUN_CHUNK);
+
+  if(!((p[0] | p[1] | p[2] | p[3]) & alpha_mask))
+    return RUN_TRANSPARENT;
+  if((p[0] & p[1] & p[2] & p[3] & alpha_mask) == alpha_mask)
+    return RUN_OPAQUE;
+  return RUN_MIXED;
+  }
+
+static int get_run(const uint8_t * ovl, int num, int * type)
+  {
+  int ret = RUN_CHUNK;
+
+  if(num < RUN_CHUNK)
+    {
+    *type = RUN_MIXED;
+    return num;
+    }
+  
+  *type = get_chunk_type(ovl);
+  
+  while((ret + RUN_CHUNK <= num) &&
+        (get_chunk_type(ovl + 4 * ret) == *type))
+    ret += RUN_CHUNK;
+
+  /* Append the last pixels to partially transparent runs */
+  if((*type == RUN_MIXED) && (num - ret < RUN_CHUNK))
+    ret = num;
+  
+  return ret;
+  }
+
+/* Line functions */
+
+#define BLEND_RGB_32 blend_rgb_32_c
+#define BLEND_Y_8    blend_y_8_c
+#define BLEND_UV_8   blend_uv_8_c
+#define BLEND        BLEND_8
+#include "blend_lines_c.h"
+
+#define BLEND_RGB_32 blend_rgb_32_premultiplied_c
+#define BLEND_Y_8    blend_y_8_premultiplied_c
+#define BLEND_UV_8   blend_uv_8_premultiplied_c
+#define BLEND        BLEND_8_P
+#include "blend_lines_c.h"
+
+static void copy_y_8(uint8_t * dst, const uint8_t * ovl, int num)
+  {
+  int i;
+  for(i = 0; i < num; i++)
+    dst[i] = ovl[4*i];
+  }
+
+static void copy_uv_8(uint8_t * dst_u, uint8_t * dst_v,
+                      const uint8_t * ovl, int num, int sub_h)
+  {
+  int i;
+  for(i = 0; i < num; i++)
+    {
+    dst_u[i] = ovl[1];
+    dst_v[i] = ovl[2];
+    ovl += 4 * sub_h;
+    }
+  }
+
 /* ovl: GAVL_GRAYA_16 */
 
 static void blend_gray_8(gavl_overlay_blend_context_t * ctx,
                          gavl_video_frame_t * frame,
-                         gavl_video_frame_t * overlay)
+                         gavl_video_frame_t * overlay,
+                         int width, int height)
   {
   int i, j;
   uint8_t * ovl_ptr;
@@ -72,12 +171,12 @@ static void blend_gray_8(gavl_overlay_blend_context_t * ctx,
   ovl_ptr_start = overlay->planes[0];
   dst_ptr_start = frame->planes[0];
   
-  for(i = 0; i < ctx->ovl->src_rect.h; i++)
+  for(i = 0; i < height; i++)
     {
     ovl_ptr = ovl_ptr_start;
     dst_ptr = dst_ptr_start;
     
-    for(j = 0; j < ctx->ovl->src_rect.w; j++)
+    for(j = 0; j < width; j++)
       {
       tmp = *dst_ptr;
       BLEND_8(ovl_ptr[0], tmp, ovl_ptr[1]);
@@ -96,7 +195,8 @@ static void blend_gray_8(gavl_overlay_blend_context_t * ctx,
 
 static void blend_gray_16(gavl_overlay_blend_context_t * ctx,
                           gavl_video_frame_t * frame,
-                          gavl_video_frame_t * overlay)
+                          gavl_video_frame_t * overlay,
+                          int width, int height)
   {
   int i, j;
   uint16_t * ovl_ptr;
@@ -110,12 +210,12 @@ static void blend_gray_16(gavl_overlay_blend_context_t * ctx,
   ovl_ptr_start = overlay->planes[0];
   dst_ptr_start = frame->planes[0];
   
-  for(i = 0; i < ctx->ovl->src_rect.h; i++)
+  for(i = 0; i < height; i++)
     {
     ovl_ptr = (uint16_t*)ovl_ptr_start;
     dst_ptr = (uint16_t*)dst_ptr_start;
     
-    for(j = 0; j < ctx->ovl->src_rect.w; j++)
+    for(j = 0; j < width; j++)
       {
       tmp = *dst_ptr;
       BLEND_16(ovl_ptr[0], tmp, ovl_ptr[1]);
@@ -134,7 +234,8 @@ static void blend_gray_16(gavl_overlay_blend_context_t * ctx,
 
 static void blend_gray_float(gavl_overlay_blend_context_t * ctx,
                              gavl_video_frame_t * frame,
-                             gavl_video_frame_t * overlay)
+                             gavl_video_frame_t * overlay,
+                             int width, int height)
   {
   int i, j;
   float * ovl_ptr;
@@ -146,12 +247,12 @@ static void blend_gray_float(gavl_overlay_blend_context_t * ctx,
   ovl_ptr_start = overlay->planes[0];
   dst_ptr_start = frame->planes[0];
   
-  for(i = 0; i < ctx->ovl->src_rect.h; i++)
+  for(i = 0; i < height; i++)
     {
     ovl_ptr = (float*)ovl_ptr_start;
     dst_ptr = (float*)dst_ptr_start;
     
-    for(j = 0; j < ctx->ovl->src_rect.w; j++)
+    for(j = 0; j < width; j++)
       {
       BLEND_FLOAT(ovl_ptr[0], *dst_ptr, ovl_ptr[1]);
       dst_ptr++;
@@ -168,7 +269,8 @@ static void blend_gray_float(gavl_overlay_blend_context_t * ctx,
 
 static void blend_graya_16(gavl_overlay_blend_context_t * ctx,
                            gavl_video_frame_t * frame,
-                           gavl_video_frame_t * overlay)
+                           gavl_video_frame_t * overlay,
+                           int width, int height)
   {
   int i, j;
   uint8_t * ovl_ptr;
@@ -182,12 +284,12 @@ static void blend_graya_16(gavl_overlay_blend_context_t * ctx,
   ovl_ptr_start = overlay->planes[0];
   dst_ptr_start = frame->planes[0];
   
-  for(i = 0; i < ctx->ovl->src_rect.h; i++)
+  for(i = 0; i < height; i++)
     {
     ovl_ptr = ovl_ptr_start;
     dst_ptr = dst_ptr_start;
     
-    for(j = 0; j < ctx->ovl->src_rect.w; j++)
+    for(j = 0; j < width; j++)
       {
       /* Transparent frame -> Copy overlay */
       if(!dst_ptr[1])
@@ -227,7 +329,8 @@ static void blend_graya_16(gavl_overlay_blend_context_t * ctx,
 
 static void blend_graya_32(gavl_overlay_blend_context_t * ctx,
                            gavl_video_frame_t * frame,
-                           gavl_video_frame_t * overlay)
+                           gavl_video_frame_t * overlay,
+                           int width, int height)
   {
   int i, j;
   uint16_t * ovl_ptr;
@@ -241,12 +344,12 @@ static void blend_graya_32(gavl_overlay_blend_context_t * ctx,
   ovl_ptr_start = overlay->planes[0];
   dst_ptr_start = frame->planes[0];
   
-  for(i = 0; i < ctx->ovl->src_rect.h; i++)
+  for(i = 0; i < height; i++)
     {
     ovl_ptr = (uint16_t*)ovl_ptr_start;
     dst_ptr = (uint16_t*)dst_ptr_start;
     
-    for(j = 0; j < ctx->ovl->src_rect.w; j++)
+    for(j = 0; j < width; j++)
       {
       /* Transparent frame -> Copy overlay */
       if(!dst_ptr[1])
@@ -288,7 +391,8 @@ static void blend_graya_32(gavl_overlay_blend_context_t * ctx,
 
 static void blend_graya_float(gavl_overlay_blend_context_t * ctx,
                            gavl_video_frame_t * frame,
-                           gavl_video_frame_t * overlay)
+                           gavl_video_frame_t * overlay,
+                           int width, int height)
   {
   int i, j;
   float * ovl_ptr;
@@ -302,12 +406,12 @@ static void blend_graya_float(gavl_overlay_blend_context_t * ctx,
   ovl_ptr_start = overlay->planes[0];
   dst_ptr_start = frame->planes[0];
   
-  for(i = 0; i < ctx->ovl->src_rect.h; i++)
+  for(i = 0; i < height; i++)
     {
     ovl_ptr = (float*)ovl_ptr_start;
     dst_ptr = (float*)dst_ptr_start;
     
-    for(j = 0; j < ctx->ovl->src_rect.w; j++)
+    for(j = 0; j < width; j++)
       {
       /* Transparent frame -> Copy overlay */
       if(dst_ptr[3] == 0.0)
@@ -348,7 +452,8 @@ static void blend_graya_float(gavl_overlay_blend_context_t * ctx,
 
 static void blend_rgb_15(gavl_overlay_blend_context_t * ctx,
                          gavl_video_frame_t * frame,
-                         gavl_video_frame_t * overlay)
+                         gavl_video_frame_t * overlay,
+                         int width, int height)
   {
   int i, j;
   uint8_t * ovl_ptr;
@@ -362,12 +467,12 @@ static void blend_rgb_15(gavl_overlay_blend_context_t * ctx,
   ovl_ptr_start = overlay->planes[0];
   dst_ptr_start = frame->planes[0];
   
-  for(i = 0; i < ctx->ovl->src_rect.h; i++)
+  for(i = 0; i < height; i++)
     {
     ovl_ptr = ovl_ptr_start;
     dst_ptr = (uint16_t*)dst_ptr_start;
     
-    for(j = 0; j < ctx->ovl->src_rect.w; j++)
+    for(j = 0; j < width; j++)
       {
       r_tmp = RGB15_TO_R_8(*dst_ptr);
       g_tmp = RGB15_TO_G_8(*dst_ptr);
@@ -394,7 +499,8 @@ static void blend_rgb_15(gavl_overlay_blend_context_t * ctx,
 
 static void blend_bgr_15(gavl_overlay_blend_context_t * ctx,
                          gavl_video_frame_t * frame,
-                         gavl_video_frame_t * overlay)
+                         gavl_video_frame_t * overlay,
+                         int width, int height)
   {
   int i, j;
   uint8_t * ovl_ptr;
@@ -408,12 +514,12 @@ static void blend_bgr_15(gavl_overlay_blend_context_t * ctx,
   ovl_ptr_start = overlay->planes[0];
   dst_ptr_start = frame->planes[0];
   
-  for(i = 0; i < ctx->ovl->src_rect.h; i++)
+  for(i = 0; i < height; i++)
     {
     ovl_ptr = ovl_ptr_start;
     dst_ptr = (uint16_t*)dst_ptr_start;
     
-    for(j = 0; j < ctx->ovl->src_rect.w; j++)
+    for(j = 0; j < width; j++)
       {
       r_tmp = BGR15_TO_R_8(*dst_ptr);
       g_tmp = BGR15_TO_G_8(*dst_ptr);
@@ -439,7 +545,8 @@ static void blend_bgr_15(gavl_overlay_blend_context_t * ctx,
 
 static void blend_rgb_16(gavl_overlay_blend_context_t * ctx,
                          gavl_video_frame_t * frame,
-                         gavl_video_frame_t * overlay)
+                         gavl_video_frame_t * overlay,
+                         int width, int height)
   {
   int i, j;
   uint8_t * ovl_ptr;
@@ -453,12 +560,12 @@ static void blend_rgb_16(gavl_overlay_blend_context_t * ctx,
   ovl_ptr_start = overlay->planes[0];
   dst_ptr_start = frame->planes[0];
   
-  for(i = 0; i < ctx->ovl->src_rect.h; i++)
+  for(i = 0; i < height; i++)
     {
     ovl_ptr = ovl_ptr_start;
     dst_ptr = (uint16_t*)dst_ptr_start;
     
-    for(j = 0; j < ctx->ovl->src_rect.w; j++)
+    for(j = 0; j < width; j++)
       {
       r_tmp = RGB16_TO_R_8(*dst_ptr);
       g_tmp = RGB16_TO_G_8(*dst_ptr);
@@ -484,7 +591,8 @@ static void blend_rgb_16(gavl_overlay_blend_context_t * ctx,
 
 static void blend_bgr_16(gavl_overlay_blend_context_t * ctx,
                          gavl_video_frame_t * frame,
-                         gavl_video_frame_t * overlay)
+                         gavl_video_frame_t * overlay,
+                         int width, int height)
   {
   int i, j;
   uint8_t * ovl_ptr;
@@ -498,12 +606,12 @@ static void blend_bgr_16(gavl_overlay_blend_context_t * ctx,
   ovl_ptr_start = overlay->planes[0];
   dst_ptr_start = frame->planes[0];
   
-  for(i = 0; i < ctx->ovl->src_rect.h; i++)
+  for(i = 0; i < height; i++)
     {
     ovl_ptr = ovl_ptr_start;
     dst_ptr = (uint16_t*)dst_ptr_start;
     
-    for(j = 0; j < ctx->ovl->src_rect.w; j++)
+    for(j = 0; j < width; j++)
       {
       r_tmp = BGR16_TO_R_8(*dst_ptr);
       g_tmp = BGR16_TO_G_8(*dst_ptr);
@@ -529,7 +637,8 @@ static void blend_bgr_16(gavl_overlay_blend_context_t * ctx,
 
 static void blend_rgb_24(gavl_overlay_blend_context_t * ctx,
                          gavl_video_frame_t * frame,
-                         gavl_video_frame_t * overlay)
+                         gavl_video_frame_t * overlay,
+                         int width, int height)
   {
   int i, j;
   uint8_t * ovl_ptr;
@@ -543,12 +652,12 @@ static void blend_rgb_24(gavl_overlay_blend_context_t * ctx,
   ovl_ptr_start = overlay->planes[0];
   dst_ptr_start = frame->planes[0];
   
-  for(i = 0; i < ctx->ovl->src_rect.h; i++)
+  for(i = 0; i < height; i++)
     {
     ovl_ptr = ovl_ptr_start;
     dst_ptr = dst_ptr_start;
     
-    for(j = 0; j < ctx->ovl->src_rect.w; j++)
+    for(j = 0; j < width; j++)
       {
       r_tmp = dst_ptr[0];
       g_tmp = dst_ptr[1];
@@ -576,7 +685,8 @@ static void blend_rgb_24(gavl_overlay_blend_context_t * ctx,
 
 static void blend_bgr_24(gavl_overlay_blend_context_t * ctx,
                          gavl_video_frame_t * frame,
-                         gavl_video_frame_t * overlay)
+                         gavl_video_frame_t * overlay,
+                         int width, int height)
   {
   int i, j;
   uint8_t * ovl_ptr;
@@ -590,12 +700,12 @@ static void blend_bgr_24(gavl_overlay_blend_context_t * ctx,
   ovl_ptr_start = overlay->planes[0];
   dst_ptr_start = frame->planes[0];
   
-  for(i = 0; i < ctx->ovl->src_rect.h; i++)
+  for(i = 0; i < height; i++)
     {
     ovl_ptr = ovl_ptr_start;
     dst_ptr = dst_ptr_start;
     
-    for(j = 0; j < ctx->ovl->src_rect.w; j++)
+    for(j = 0; j < width; j++)
       {
       r_tmp = dst_ptr[2];
       g_tmp = dst_ptr[1];
@@ -623,54 +733,36 @@ static void blend_bgr_24(gavl_overlay_blend_context_t * ctx,
 
 static void blend_rgb_32(gavl_overlay_blend_context_t * ctx,
                          gavl_video_frame_t * frame,
-                         gavl_video_frame_t * overlay)
+                         gavl_video_frame_t * overlay,
+                         int width, int height)
   {
-  int i, j;
-  uint8_t * ovl_ptr;
+  int i, j, num, type;
+  const uint8_t * ovl_ptr;
   uint8_t * dst_ptr;
   
-  uint8_t * ovl_ptr_start;
-  uint8_t * dst_ptr_start;
-
-  int r_tmp, g_tmp, b_tmp;
-  
-  ovl_ptr_start = overlay->planes[0];
-  dst_ptr_start = frame->planes[0];
-  
-  for(i = 0; i < ctx->ovl->src_rect.h; i++)
+  for(i = 0; i < height; i++)
     {
-    ovl_ptr = ovl_ptr_start;
-    dst_ptr = dst_ptr_start;
+    ovl_ptr = overlay->planes[0] + i * overlay->strides[0];
+    dst_ptr = frame->planes[0] + i * frame->strides[0];
     
-    for(j = 0; j < ctx->ovl->src_rect.w; j++)
+    for(j = 0; j < width; j += num)
       {
-      r_tmp = dst_ptr[0];
-      g_tmp = dst_ptr[1];
-      b_tmp = dst_ptr[2];
+      num = get_run(ovl_ptr + 4 * j, width - j, &type);
 
-      BLEND_8(ovl_ptr[0], r_tmp, ovl_ptr[3]);
-      BLEND_8(ovl_ptr[1], g_tmp, ovl_ptr[3]);
-      BLEND_8(ovl_ptr[2], b_tmp, ovl_ptr[3]);
-      
-      dst_ptr[0] = r_tmp;
-      dst_ptr[1] = g_tmp;
-      dst_ptr[2] = b_tmp;
-      
-      ovl_ptr+=4;
-      dst_ptr+=4;
-      
+      if(type == RUN_OPAQUE)
+        memcpy(dst_ptr + 4 * j, ovl_ptr + 4 * j, 4 * num);
+      else if(type == RUN_MIXED)
+        ctx->funcs.blend_rgb_32(dst_ptr + 4 * j, ovl_ptr + 4 * j, num);
       }
-    ovl_ptr_start += overlay->strides[0];
-    dst_ptr_start += frame->strides[0];
     }
-  
   }
 
 /* ovl: GAVL_RGBA_32 */
 
 static void blend_bgr_32(gavl_overlay_blend_context_t * ctx,
                          gavl_video_frame_t * frame,
-                         gavl_video_frame_t * overlay)
+                         gavl_video_frame_t * overlay,
+                         int width, int height)
   {
   int i, j;
   uint8_t * ovl_ptr;
@@ -684,12 +776,12 @@ static void blend_bgr_32(gavl_overlay_blend_context_t * ctx,
   ovl_ptr_start = overlay->planes[0];
   dst_ptr_start = frame->planes[0];
   
-  for(i = 0; i < ctx->ovl->src_rect.h; i++)
+  for(i = 0; i < height; i++)
     {
     ovl_ptr = ovl_ptr_start;
     dst_ptr = dst_ptr_start;
     
-    for(j = 0; j < ctx->ovl->src_rect.w; j++)
+    for(j = 0; j < width; j++)
       {
       r_tmp = dst_ptr[2];
       g_tmp = dst_ptr[1];
@@ -715,83 +807,91 @@ static void blend_bgr_32(gavl_overlay_blend_context_t * ctx,
 
 /* ovl: GAVL_RGBA_32 */
 
+static void blend_rgba_32_line(uint8_t * dst_ptr, const uint8_t * ovl_ptr,
+                               int num)
+  {
+  int j;
+  float c_a, c_b, c_dst, a_a, o_a, a_b, a_dst;
+
+  for(j = 0; j < num; j++)
+    {
+    /* Transparent frame or opaque overlay -> Copy overlay */
+    if(!dst_ptr[3] || (ovl_ptr[3] == 0xff))
+      {
+      dst_ptr[0] = ovl_ptr[0];
+      dst_ptr[1] = ovl_ptr[1];
+      dst_ptr[2] = ovl_ptr[2];
+      dst_ptr[3] = ovl_ptr[3];
+      }
+    else if(ovl_ptr[3])
+      {
+      /* rgba -> rgba blending */
+      /* Due to the complicated arithmetics, this is
+         done in floating point. High speed integer versions
+         are welcome */
+
+      a_a = RGB_8_TO_FLOAT(ovl_ptr[3]);
+      a_b = RGB_8_TO_FLOAT(dst_ptr[3]);
+      o_a = 1.0 - a_a;
+              
+      a_dst = a_a + a_b - a_a * a_b;
+
+      c_a = RGB_8_TO_FLOAT(ovl_ptr[0]);
+      c_b = RGB_8_TO_FLOAT(dst_ptr[0]);
+      c_dst = (c_a * a_a + c_b * a_b * o_a) / a_dst;
+      RGB_FLOAT_TO_8(c_dst, dst_ptr[0]);
+
+      c_a = RGB_8_TO_FLOAT(ovl_ptr[1]);
+      c_b = RGB_8_TO_FLOAT(dst_ptr[1]);
+      c_dst = (c_a * a_a + c_b * a_b * o_a) / a_dst;
+      RGB_FLOAT_TO_8(c_dst, dst_ptr[1]);
+
+      c_a = RGB_8_TO_FLOAT(ovl_ptr[2]);
+      c_b = RGB_8_TO_FLOAT(dst_ptr[2]);
+      c_dst = (c_a * a_a + c_b * a_b * o_a) / a_dst;
+      RGB_FLOAT_TO_8(c_dst, dst_ptr[2]);
+      
+      RGB_FLOAT_TO_8(a_dst, dst_ptr[3]);
+      }
+    
+    ovl_ptr+=4;
+    dst_ptr+=4;
+    
+    }
+  }
+
 static void blend_rgba_32(gavl_overlay_blend_context_t * ctx,
                           gavl_video_frame_t * frame,
-                          gavl_video_frame_t * overlay)
+                          gavl_video_frame_t * overlay,
+                          int width, int height)
   {
-  int i, j;
-  uint8_t * ovl_ptr;
+  int i, j, num, type;
+  const uint8_t * ovl_ptr;
   uint8_t * dst_ptr;
   
-  uint8_t * ovl_ptr_start;
-  uint8_t * dst_ptr_start;
-
-  float c_a, c_b, c_dst, a_a, o_a, a_b, a_dst;
-  
-  ovl_ptr_start = overlay->planes[0];
-  dst_ptr_start = frame->planes[0];
-  
-  for(i = 0; i < ctx->ovl->src_rect.h; i++)
+  for(i = 0; i < height; i++)
     {
-    ovl_ptr = ovl_ptr_start;
-    dst_ptr = dst_ptr_start;
+    ovl_ptr = overlay->planes[0] + i * overlay->strides[0];
+    dst_ptr = frame->planes[0] + i * frame->strides[0];
     
-    for(j = 0; j < ctx->ovl->src_rect.w; j++)
+    for(j = 0; j < width; j += num)
       {
-      /* Transparent frame -> Copy overlay */
-      if(!dst_ptr[3])
-        {
-        dst_ptr[0] = ovl_ptr[0];
-        dst_ptr[1] = ovl_ptr[1];
-        dst_ptr[2] = ovl_ptr[2];
-        dst_ptr[3] = ovl_ptr[3];
-        }
-      else if(ovl_ptr[3])
-        {
-        /* rgba -> rgba blending */
-        /* Due to the complicated arithmetics, this is
-           done in floating point. High speed integer versions
-           are welcome */
-
-        a_a = RGB_8_TO_FLOAT(ovl_ptr[3]);
-        a_b = RGB_8_TO_FLOAT(dst_ptr[3]);
-        o_a = 1.0 - a_a;
-                
-        a_dst = a_a + a_b - a_a * a_b;
-
-        c_a = RGB_8_TO_FLOAT(ovl_ptr[0]);
-        c_b = RGB_8_TO_FLOAT(dst_ptr[0]);
-        c_dst = (c_a * a_a + c_b * a_b * o_a) / a_dst;
-        RGB_FLOAT_TO_8(c_dst, dst_ptr[0]);
+      num = get_run(ovl_ptr + 4 * j, width - j, &type);
 
-        c_a = RGB_8_TO_FLOAT(ovl_ptr[1]);
-        c_b = RGB_8_TO_FLOAT(dst_ptr[1]);
-        c_dst = (c_a * a_a + c_b * a_b * o_a) / a_dst;
-        RGB_FLOAT_TO_8(c_dst, dst_ptr[1]);
-
-        c_a = RGB_8_TO_FLOAT(ovl_ptr[2]);
-        c_b = RGB_8_TO_FLOAT(dst_ptr[2]);
-        c_dst = (c_a * a_a + c_b * a_b * o_a) / a_dst;
-        RGB_FLOAT_TO_8(c_dst, dst_ptr[2]);
-        
-        RGB_FLOAT_TO_8(a_dst, dst_ptr[3]);
-        }
-      
-      ovl_ptr+=4;
-      dst_ptr+=4;
-      
+      if(type == RUN_OPAQUE)
+        memcpy(dst_ptr + 4 * j, ovl_ptr + 4 * j, 4 * num);
+      else if(type == RUN_MIXED)
+        blend_rgba_32_line(dst_ptr + 4 * j, ovl_ptr + 4 * j, num);
       }
-    ovl_ptr_start += overlay->strides[0];
-    dst_ptr_start += frame->strides[0];
     }
-  
   }
 
 /* ovl: GAVL_RGBA_64 */
 
 static void blend_rgb_48(gavl_overlay_blend_context_t * ctx,
                          gavl_video_frame_t * frame,
-                         gavl_video_frame_t * overlay)
+                         gavl_video_frame_t * overlay,
+                         int width, int height)
   {
   int i, j;
   uint16_t * ovl_ptr;
@@ -805,12 +905,12 @@ static void blend_rgb_48(gavl_overlay_blend_context_t * ctx,
   ovl_ptr_start = overlay->planes[0];
   dst_ptr_start = frame->planes[0];
   
-  for(i = 0; i < ctx->ovl->src_rect.h; i++)
+  for(i = 0; i < height; i++)
     {
     ovl_ptr = (uint16_t*)ovl_ptr_start;
     dst_ptr = (uint16_t*)dst_ptr_start;
     
-    for(j = 0; j < ctx->ovl->src_rect.w; j++)
+    for(j = 0; j < width; j++)
       {
       r_tmp = dst_ptr[0];
       g_tmp = dst_ptr[1];
@@ -838,7 +938,8 @@ static void blend_rgb_48(gavl_overlay_blend_context_t * ctx,
 
 static void blend_rgba_64(gavl_overlay_blend_context_t * ctx,
                          gavl_video_frame_t * frame,
-                         gavl_video_frame_t * overlay)
+                         gavl_video_frame_t * overlay,
+                         int width, int height)
   {
   int i, j;
   uint16_t * ovl_ptr;
@@ -852,12 +953,12 @@ static void blend_rgba_64(gavl_overlay_blend_context_t * ctx,
   ovl_ptr_start = overlay->planes[0];
   dst_ptr_start = frame->planes[0];
   
-  for(i = 0; i < ctx->ovl->src_rect.h; i++)
+  for(i = 0; i < height; i++)
     {
     ovl_ptr = (uint16_t*)ovl_ptr_start;
     dst_ptr = (uint16_t*)dst_ptr_start;
     
-    for(j = 0; j < ctx->ovl->src_rect.w; j++)
+    for(j = 0; j < width; j++)
       {
       /* Transparent frame -> Copy overlay */
       if(!dst_ptr[3])
@@ -912,7 +1013,8 @@ static void blend_rgba_64(gavl_overlay_blend_context_t * ctx,
 
 static void blend_rgb_float(gavl_overlay_blend_context_t * ctx,
                             gavl_video_frame_t * frame,
-                            gavl_video_frame_t * overlay)
+                            gavl_video_frame_t * overlay,
+                            int width, int height)
   {
   int i, j;
   float * ovl_ptr;
@@ -925,12 +1027,12 @@ static void blend_rgb_float(gavl_overlay_blend_context_t * ctx,
   ovl_ptr_start = overlay->planes[0];
   dst_ptr_start = frame->planes[0];
   
-  for(i = 0; i < ctx->ovl->src_rect.h; i++)
+  for(i = 0; i < height; i++)
     {
     ovl_ptr = (float*)ovl_ptr_start;
     dst_ptr = (float*)dst_ptr_start;
     
-    for(j = 0; j < ctx->ovl->src_rect.w; j++)
+    for(j = 0; j < width; j++)
       {
       BLEND_FLOAT(ovl_ptr[0], dst_ptr[0], ovl_ptr[3]);
       BLEND_FLOAT(ovl_ptr[1], dst_ptr[1], ovl_ptr[3]);
@@ -949,7 +1051,8 @@ static void blend_rgb_float(gavl_overlay_blend_context_t * ctx,
 
 static void blend_rgba_float(gavl_overlay_blend_context_t * ctx,
                              gavl_video_frame_t * frame,
-                             gavl_video_frame_t * overlay)
+                             gavl_video_frame_t * overlay,
+                             int width, int height)
   {
   int i, j;
   float * ovl_ptr;
@@ -962,12 +1065,12 @@ static void blend_rgba_float(gavl_overlay_blend_context_t * ctx,
   ovl_ptr_start = overlay->planes[0];
   dst_ptr_start = frame->planes[0];
   
-  for(i = 0; i < ctx->ovl->src_rect.h; i++)
+  for(i = 0; i < height; i++)
     {
     ovl_ptr = (float*)ovl_ptr_start;
     dst_ptr = (float*)dst_ptr_start;
     
-    for(j = 0; j < ctx->ovl->src_rect.w; j++)
+    for(j = 0; j < width; j++)
       {
       a_dst = dst_ptr[3] + ovl_ptr[3] - dst_ptr[3]*ovl_ptr[3];
 
@@ -997,7 +1100,8 @@ static void blend_rgba_float(gavl_overlay_blend_context_t * ctx,
 
 static void blend_yuy2(gavl_overlay_blend_context_t * ctx,
                        gavl_video_frame_t * frame,
-                       gavl_video_frame_t * overlay)
+                       gavl_video_frame_t * overlay,
+                       int width, int height)
   {
   int i, j, jmax;
   uint8_t * ovl_ptr;
@@ -1011,9 +1115,9 @@ static void blend_yuy2(gavl_overlay_blend_context_t * ctx,
   ovl_ptr_start = overlay->planes[0];
   dst_ptr_start = frame->planes[0];
 
-  jmax = ctx->ovl->src_rect.w / 2;
+  jmax = width / 2;
   
-  for(i = 0; i < ctx->ovl->src_rect.h; i++)
+  for(i = 0; i < height; i++)
     {
     ovl_ptr = ovl_ptr_start;
     dst_ptr = dst_ptr_start;
@@ -1056,7 +1160,8 @@ static void blend_yuy2(gavl_overlay_blend_context_t * ctx,
 
 static void blend_uyvy(gavl_overlay_blend_context_t * ctx,
                        gavl_video_frame_t * frame,
-                       gavl_video_frame_t * overlay)
+                       gavl_video_frame_t * overlay,
+                       int width, int height)
   {
   int i, j, jmax;
   uint8_t * ovl_ptr;
@@ -1070,9 +1175,9 @@ static void blend_uyvy(gavl_overlay_blend_context_t * ctx,
   ovl_ptr_start = overlay->planes[0];
   dst_ptr_start = frame->planes[0];
 
-  jmax = ctx->ovl->src_rect.w / 2;
+  jmax = width / 2;
   
-  for(i = 0; i < ctx->ovl->src_rect.h; i++)
+  for(i = 0; i < height; i++)
     {
     ovl_ptr = ovl_ptr_start;
     dst_ptr = dst_ptr_start;
@@ -1113,7 +1218,8 @@ static void blend_uyvy(gavl_overlay_blend_context_t * ctx,
 
 static void blend_yuva_32(gavl_overlay_blend_context_t * ctx,
                           gavl_video_frame_t * frame,
-                          gavl_video_frame_t * overlay)
+                          gavl_video_frame_t * overlay,
+                          int width, int height)
   {
   int i, j;
   uint8_t * ovl_ptr;
@@ -1127,12 +1233,12 @@ static void blend_yuva_32(gavl_overlay_blend_context_t * ctx,
   ovl_ptr_start = overlay->planes[0];
   dst_ptr_start = frame->planes[0];
   
-  for(i = 0; i < ctx->ovl->src_rect.h; i++)
+  for(i = 0; i < height; i++)
     {
     ovl_ptr = ovl_ptr_start;
     dst_ptr = dst_ptr_start;
     
-    for(j = 0; j < ctx->ovl->src_rect.w; j++)
+    for(j = 0; j < width; j++)
       {
       /* Transparent frame -> Copy overlay */
       if(!dst_ptr[3])
@@ -1185,9 +1291,63 @@ static void blend_yuva_32(gavl_overlay_blend_context_t * ctx,
 
 /* ovl: GAVL_YUVA_32 */
 
-static void blend_yuv_420_p(gavl_overlay_blend_context_t * ctx,
+static void blend_yuv_planar(gavl_overlay_blend_context_t * ctx,
+                             gavl_video_frame_t * frame,
+                             gavl_video_frame_t * overlay,
+                             int width, int height)
+  {
+  int i, j, num, type;
+  const uint8_t * ovl_ptr;
+  uint8_t * dst_ptr_y;
+  uint8_t * dst_ptr_u;
+  uint8_t * dst_ptr_v;
+  int sub_h = ctx->dst_sub_h;
+
+  for(i = 0; i < height; i++)
+    {
+    ovl_ptr = overlay->planes[0] + i * overlay->strides[0];
+    dst_ptr_y = frame->planes[0] + i * frame->strides[0];
+
+    /* Chroma is blended from the first line of each chroma line */
+    if(i % ctx->dst_sub_v)
+      {
+      dst_ptr_u = NULL;
+      dst_ptr_v = NULL;
+      }
+    else
+      {
+      dst_ptr_u = frame->planes[1] + (i / ctx->dst_sub_v) * frame->strides[1];
+      dst_ptr_v = frame->planes[2] + (i / ctx->dst_sub_v) * frame->strides[2];
+      }
+    
+    for(j = 0; j < width; j += num)
+      {
+      num = get_run(ovl_ptr + 4 * j, width - j, &type);
+
+      if(type == RUN_OPAQUE)
+        {
+        copy_y_8(dst_ptr_y + j, ovl_ptr + 4 * j, num);
+        if(dst_ptr_u)
+          copy_uv_8(dst_ptr_u + j / sub_h, dst_ptr_v + j / sub_h,
+                    ovl_ptr + 4 * j, num / sub_h, sub_h);
+        }
+      else if(type == RUN_MIXED)
+        {
+        ctx->funcs.blend_y_8(dst_ptr_y + j, ovl_ptr + 4 * j, num);
+        if(dst_ptr_u)
+          ctx->funcs.blend_uv_8(dst_ptr_u + j / sub_h, dst_ptr_v + j / sub_h,
+                                ovl_ptr + 4 * j, num / sub_h, sub_h);
+        }
+      }
+    }
+  }
+
+/* ovl: GAVL_YUVA_32 */
+
+static void blend_yuvj_420_p(gavl_overlay_blend_context_t * ctx,
                             gavl_video_frame_t * frame,
-                            gavl_video_frame_t * overlay)
+                            gavl_video_frame_t * overlay,
+                            int width, int height)
   {
   int i, j, imax, jmax;
   uint8_t * ovl_ptr;
@@ -1201,14 +1361,14 @@ static void blend_yuv_420_p(gavl_overlay_blend_context_t * ctx,
   uint8_t * dst_ptr_v_start;
   
   int tmp;
+
+  imax = height/2;
+  jmax = width/2;
   
   ovl_ptr_start = overlay->planes[0];
   dst_ptr_y_start = frame->planes[0];
   dst_ptr_u_start = frame->planes[1];
   dst_ptr_v_start = frame->planes[2];
-
-  imax = ctx->ovl->src_rect.h / 2;
-  jmax = ctx->ovl->src_rect.w / 2;
   
   for(i = 0; i < imax; i++)
     {
@@ -1221,27 +1381,28 @@ static void blend_yuv_420_p(gavl_overlay_blend_context_t * ctx,
       {
       /* Y0 */
       tmp = *dst_ptr_y;
-      BLEND_8(ovl_ptr[0], tmp, ovl_ptr[3]);
+      BLEND_8(Y_8_TO_YJ_8(ovl_ptr[0]), tmp, ovl_ptr[3]);
       *(dst_ptr_y++) = tmp;
 
       /* U0 */
       tmp = *dst_ptr_u;
-      BLEND_8(ovl_ptr[1], tmp, ovl_ptr[3]);
+      BLEND_8(UV_8_TO_UVJ_8(ovl_ptr[1]), tmp, ovl_ptr[3]);
       *(dst_ptr_u++) = tmp;
 
       /* V0 */
       tmp = *dst_ptr_v;
-      BLEND_8(ovl_ptr[2], tmp, ovl_ptr[3]);
+      BLEND_8(UV_8_TO_UVJ_8(ovl_ptr[2]), tmp, ovl_ptr[3]);
       *(dst_ptr_v++) = tmp;
 
       /* Y1 */
       tmp = *dst_ptr_y;
-      BLEND_8(ovl_ptr[4], tmp, ovl_ptr[7]);
+      BLEND_8(Y_8_TO_YJ_8(ovl_ptr[4]), tmp, ovl_ptr[7]);
       *(dst_ptr_y++) = tmp;
-      
+
       ovl_ptr+=8;
       }
     ovl_ptr_start += overlay->strides[0];
+
     dst_ptr_y_start += frame->strides[0];
     dst_ptr_u_start += frame->strides[1];
     dst_ptr_v_start += frame->strides[2];
@@ -1249,34 +1410,36 @@ static void blend_yuv_420_p(gavl_overlay_blend_context_t * ctx,
 
     ovl_ptr = ovl_ptr_start;
     dst_ptr_y = dst_ptr_y_start;
-    dst_ptr_u = dst_ptr_u_start;
-    dst_ptr_v = dst_ptr_v_start;
     
     for(j = 0; j < jmax; j++)
       {
       /* Y0 */
       tmp = *dst_ptr_y;
-      BLEND_8(ovl_ptr[0], tmp, ovl_ptr[3]);
+      BLEND_8(Y_8_TO_YJ_8(ovl_ptr[0]), tmp, ovl_ptr[3]);
       *(dst_ptr_y++) = tmp;
       
       /* Y1 */
       tmp = *dst_ptr_y;
-      BLEND_8(ovl_ptr[4], tmp, ovl_ptr[7]);
+      BLEND_8(Y_8_TO_YJ_8(ovl_ptr[4]), tmp, ovl_ptr[7]);
       *(dst_ptr_y++) = tmp;
       
       ovl_ptr+=8;
       }
     ovl_ptr_start += overlay->strides[0];
+
     dst_ptr_y_start += frame->strides[0];
+
+
     }
   
   }
 
 /* ovl: GAVL_YUVA_32 */
 
-static void blend_yuv_422_p(gavl_overlay_blend_context_t * ctx,
+static void blend_yuvj_422_p(gavl_overlay_blend_context_t * ctx,
                             gavl_video_frame_t * frame,
-                            gavl_video_frame_t * overlay)
+                            gavl_video_frame_t * overlay,
+                            int width, int height)
   {
   int i, j, jmax;
   uint8_t * ovl_ptr;
@@ -1290,15 +1453,15 @@ static void blend_yuv_422_p(gavl_overlay_blend_context_t * ctx,
   uint8_t * dst_ptr_v_start;
   
   int tmp;
+
+  jmax = width/2;
   
   ovl_ptr_start = overlay->planes[0];
   dst_ptr_y_start = frame->planes[0];
   dst_ptr_u_start = frame->planes[1];
   dst_ptr_v_start = frame->planes[2];
-
-  jmax = ctx->ovl->src_rect.w / 2;
   
-  for(i = 0; i < ctx->ovl->src_rect.h; i++)
+  for(i = 0; i < height; i++)
     {
     ovl_ptr = ovl_ptr_start;
     dst_ptr_y = dst_ptr_y_start;
@@ -1309,23 +1472,24 @@ static void blend_yuv_422_p(gavl_overlay_blend_context_t * ctx,
       {
       /* Y0 */
       tmp = *dst_ptr_y;
-      BLEND_8(ovl_ptr[0], tmp, ovl_ptr[3]);
+      BLEND_8(Y_8_TO_YJ_8(ovl_ptr[0]), tmp, ovl_ptr[3]);
       *(dst_ptr_y++) = tmp;
 
       /* U0 */
       tmp = *dst_ptr_u;
-      BLEND_8(ovl_ptr[1], tmp, ovl_ptr[3]);
+      BLEND_8(UV_8_TO_UVJ_8(ovl_ptr[1]), tmp, ovl_ptr[3]);
       *(dst_ptr_u++) = tmp;
 
       /* V0 */
       tmp = *dst_ptr_v;
-      BLEND_8(ovl_ptr[2], tmp, ovl_ptr[3]);
+      BLEND_8(UV_8_TO_UVJ_8(ovl_ptr[2]), tmp, ovl_ptr[3]);
       *(dst_ptr_v++) = tmp;
 
       /* Y1 */
       tmp = *dst_ptr_y;
-      BLEND_8(ovl_ptr[4], tmp, ovl_ptr[7]);
+      BLEND_8(Y_8_TO_YJ_8(ovl_ptr[4]), tmp, ovl_ptr[7]);
       *(dst_ptr_y++) = tmp;
+
       
       ovl_ptr+=8;
       }
@@ -1340,9 +1504,10 @@ static void blend_yuv_422_p(gavl_overlay_blend_context_t * ctx,
 
 /* ovl: GAVL_YUVA_32 */
 
-static void blend_yuv_444_p(gavl_overlay_blend_context_t * ctx,
+static void blend_yuvj_444_p(gavl_overlay_blend_context_t * ctx,
                             gavl_video_frame_t * frame,
-                            gavl_video_frame_t * overlay)
+                            gavl_video_frame_t * overlay,
+                            int width, int height)
   {
   int i, j;
   uint8_t * ovl_ptr;
@@ -1362,28 +1527,28 @@ static void blend_yuv_444_p(gavl_overlay_blend_context_t * ctx,
   dst_ptr_u_start = frame->planes[1];
   dst_ptr_v_start = frame->planes[2];
   
-  for(i = 0; i < ctx->ovl->src_rect.h; i++)
+  for(i = 0; i < height; i++)
     {
     ovl_ptr = ovl_ptr_start;
     dst_ptr_y = dst_ptr_y_start;
     dst_ptr_u = dst_ptr_u_start;
     dst_ptr_v = dst_ptr_v_start;
     
-    for(j = 0; j < ctx->ovl->src_rect.w; j++)
+    for(j = 0; j < width; j++)
       {
       /* Y0 */
       tmp = *dst_ptr_y;
-      BLEND_8(ovl_ptr[0], tmp, ovl_ptr[3]);
+      BLEND_8(Y_8_TO_YJ_8(ovl_ptr[0]), tmp, ovl_ptr[3]);
       *(dst_ptr_y++) = tmp;
 
       /* U0 */
       tmp = *dst_ptr_u;
-      BLEND_8(ovl_ptr[1], tmp, ovl_ptr[3]);
+      BLEND_8(UV_8_TO_UVJ_8(ovl_ptr[1]), tmp, ovl_ptr[3]);
       *(dst_ptr_u++) = tmp;
 
       /* V0 */
       tmp = *dst_ptr_v;
-      BLEND_8(ovl_ptr[2], tmp, ovl_ptr[3]);
+      BLEND_8(UV_8_TO_UVJ_8(ovl_ptr[2]), tmp, ovl_ptr[3]);
       *(dst_ptr_v++) = tmp;
       
       ovl_ptr+=4;
@@ -1397,72 +1562,66 @@ static void blend_yuv_444_p(gavl_overlay_blend_context_t * ctx,
   
   }
 
-/* ovl: GAVL_YUVA_32 */
+/* ovl: GAVL_YUVA_64 */
 
-static void blend_yuv_411_p(gavl_overlay_blend_context_t * ctx,
-                            gavl_video_frame_t * frame,
-                            gavl_video_frame_t * overlay)
+static void blend_yuv_422_p_16(gavl_overlay_blend_context_t * ctx,
+                               gavl_video_frame_t * frame,
+                               gavl_video_frame_t * overlay,
+                               int width, int height)
   {
   int i, j, jmax;
-  uint8_t * ovl_ptr;
-  uint8_t * dst_ptr_y;
-  uint8_t * dst_ptr_u;
-  uint8_t * dst_ptr_v;
+  uint16_t * ovl_ptr;
+  uint16_t * dst_ptr_y;
+  uint16_t * dst_ptr_u;
+  uint16_t * dst_ptr_v;
   
   uint8_t * ovl_ptr_start;
   uint8_t * dst_ptr_y_start;
   uint8_t * dst_ptr_u_start;
   uint8_t * dst_ptr_v_start;
   
-  int tmp;
+  int64_t tmp, alpha;
   
   ovl_ptr_start = overlay->planes[0];
   dst_ptr_y_start = frame->planes[0];
   dst_ptr_u_start = frame->planes[1];
   dst_ptr_v_start = frame->planes[2];
 
-  jmax = ctx->ovl->src_rect.w / 4;
+  jmax = width / 2;
   
-  for(i = 0; i < ctx->ovl->src_rect.h; i++)
+  for(i = 0; i < height; i++)
     {
-    ovl_ptr = ovl_ptr_start;
-    dst_ptr_y = dst_ptr_y_start;
-    dst_ptr_u = dst_ptr_u_start;
-    dst_ptr_v = dst_ptr_v_start;
+    ovl_ptr = (uint16_t*)ovl_ptr_start;
+    dst_ptr_y = (uint16_t*)dst_ptr_y_start;
+    dst_ptr_u = (uint16_t*)dst_ptr_u_start;
+    dst_ptr_v = (uint16_t*)dst_ptr_v_start;
     
     for(j = 0; j < jmax; j++)
       {
+      alpha = ovl_ptr[3];
       /* Y0 */
       tmp = *dst_ptr_y;
-      BLEND_8(ovl_ptr[0], tmp, ovl_ptr[3]);
+      BLEND_16(ovl_ptr[0], tmp, alpha);
       *(dst_ptr_y++) = tmp;
 
       /* U0 */
       tmp = *dst_ptr_u;
-      BLEND_8(ovl_ptr[1], tmp, ovl_ptr[3]);
+      BLEND_16(ovl_ptr[1], tmp, alpha);
       *(dst_ptr_u++) = tmp;
 
       /* V0 */
       tmp = *dst_ptr_v;
-      BLEND_8(ovl_ptr[2], tmp, ovl_ptr[3]);
+      BLEND_16(ovl_ptr[2], tmp, alpha);
       *(dst_ptr_v++) = tmp;
 
-      /* Y1 */
-      tmp = *dst_ptr_y;
-      BLEND_8(ovl_ptr[4], tmp, ovl_ptr[7]);
-      *(dst_ptr_y++) = tmp;
-
-      /* Y2 */
-      tmp = *dst_ptr_y;
-      BLEND_8(ovl_ptr[8], tmp, ovl_ptr[11]);
-      *(dst_ptr_y++) = tmp;
+      alpha = ovl_ptr[7];
 
-      /* Y3 */
+      /* Y1 */
       tmp = *dst_ptr_y;
-      BLEND_8(ovl_ptr[12], tmp, ovl_ptr[15]);
+      BLEND_16(ovl_ptr[0], tmp, alpha);
       *(dst_ptr_y++) = tmp;
       
-      ovl_ptr+=16;
+      ovl_ptr+=8;
       }
     ovl_ptr_start += overlay->strides[0];
 
@@ -1470,482 +1629,21 @@ static void blend_yuv_411_p(gavl_overlay_blend_context_t * ctx,
     dst_ptr_u_start += frame->strides[1];
     dst_ptr_v_start += frame->strides[2];
     }
+  
   }
 
-/* ovl: GAVL_YUVA_32 */
+/* ovl: GAVL_YUVA_64 */
 
-static void blend_yuv_410_p(gavl_overlay_blend_context_t * ctx,
-                            gavl_video_frame_t * frame,
-                            gavl_video_frame_t * overlay)
+static void blend_yuv_444_p_16(gavl_overlay_blend_context_t * ctx,
+                               gavl_video_frame_t * frame,
+                               gavl_video_frame_t * overlay,
+                               int width, int height)
   {
-  int i, j, imax, jmax;
-  uint8_t * ovl_ptr;
-  uint8_t * dst_ptr_y;
-  uint8_t * dst_ptr_u;
-  uint8_t * dst_ptr_v;
-  
-  uint8_t * ovl_ptr_start;
-  uint8_t * dst_ptr_y_start;
-  uint8_t * dst_ptr_u_start;
-  uint8_t * dst_ptr_v_start;
-  
-  int tmp;
-  
-  ovl_ptr_start = overlay->planes[0];
-
-  dst_ptr_y_start = frame->planes[0];
-  dst_ptr_u_start = frame->planes[1];
-  dst_ptr_v_start = frame->planes[2];
-
-  imax = ctx->ovl->src_rect.h / 4;
-  jmax = ctx->ovl->src_rect.w / 4;
-  
-  for(i = 0; i < imax; i++)
-    {
-    /* Line 0 */
-
-    ovl_ptr = ovl_ptr_start;
-    dst_ptr_y = dst_ptr_y_start;
-    dst_ptr_u = dst_ptr_u_start;
-    dst_ptr_v = dst_ptr_v_start;
-    
-    for(j = 0; j < jmax; j++)
-      {
-      /* Y0 */
-      tmp = *dst_ptr_y;
-      BLEND_8(ovl_ptr[0], tmp, ovl_ptr[3]);
-      *(dst_ptr_y++) = tmp;
-
-      /* U0 */
-      tmp = *dst_ptr_u;
-      BLEND_8(ovl_ptr[1], tmp, ovl_ptr[3]);
-      *(dst_ptr_u++) = tmp;
-
-      /* V0 */
-      tmp = *dst_ptr_v;
-      BLEND_8(ovl_ptr[2], tmp, ovl_ptr[3]);
-      *(dst_ptr_v++) = tmp;
-      
-      /* Y1 */
-      tmp = *dst_ptr_y;
-      BLEND_8(ovl_ptr[4], tmp, ovl_ptr[7]);
-      *(dst_ptr_y++) = tmp;
-      
-      /* Y2 */
-      tmp = *dst_ptr_y;
-      BLEND_8(ovl_ptr[8], tmp, ovl_ptr[11]);
-      *(dst_ptr_y++) = tmp;
-      
-      /* Y3 */
-      tmp = *dst_ptr_y;
-      BLEND_8(ovl_ptr[12], tmp, ovl_ptr[15]);
-      *(dst_ptr_y++) = tmp;
-      
-      ovl_ptr+=16;
-      }
-    ovl_ptr_start += overlay->strides[0];
-    dst_ptr_y_start += frame->strides[0];
-    dst_ptr_u_start += frame->strides[1];
-    dst_ptr_v_start += frame->strides[2];
-
-    /* Line 1 */
-    
-    ovl_ptr = ovl_ptr_start;
-    dst_ptr_y = dst_ptr_y_start;
-    
-    for(j = 0; j < jmax; j++)
-      {
-      /* Y0 */
-      tmp = *dst_ptr_y;
-      BLEND_8(ovl_ptr[0], tmp, ovl_ptr[3]);
-      *(dst_ptr_y++) = tmp;
-      
-      /* Y1 */
-      tmp = *dst_ptr_y;
-      BLEND_8(ovl_ptr[4], tmp, ovl_ptr[7]);
-      *(dst_ptr_y++) = tmp;
-      
-      /* Y2 */
-      tmp = *dst_ptr_y;
-      BLEND_8(ovl_ptr[8], tmp, ovl_ptr[11]);
-      *(dst_ptr_y++) = tmp;
-
-      /* Y3 */
-      tmp = *dst_ptr_y;
-      BLEND_8(ovl_ptr[12], tmp, ovl_ptr[15]);
-      *(dst_ptr_y++) = tmp;
-            
-      ovl_ptr+=16;
-      }
-    ovl_ptr_start += overlay->strides[0];
-    dst_ptr_y_start += frame->strides[0];
-
-    /* Line 2 */
-    
-    ovl_ptr = ovl_ptr_start;
-    dst_ptr_y = dst_ptr_y_start;
-    
-    for(j = 0; j < jmax; j++)
-      {
-      /* Y0 */
-      tmp = *dst_ptr_y;
-      BLEND_8(ovl_ptr[0], tmp, ovl_ptr[3]);
-      *(dst_ptr_y++) = tmp;
-      
-      /* Y1 */
-      tmp = *dst_ptr_y;
-      BLEND_8(ovl_ptr[4], tmp, ovl_ptr[7]);
-      *(dst_ptr_y++) = tmp;
-            
-      /* Y2 */
-      tmp = *dst_ptr_y;
-      BLEND_8(ovl_ptr[8], tmp, ovl_ptr[11]);
-      *(dst_ptr_y++) = tmp;
-
-      /* Y3 */
-      tmp = *dst_ptr_y;
-      BLEND_8(ovl_ptr[12], tmp, ovl_ptr[15]);
-      *(dst_ptr_y++) = tmp;
-            
-      ovl_ptr+=16;
-      }
-    ovl_ptr_start += overlay->strides[0];
-    dst_ptr_y_start += frame->strides[0];
-
-    /* Line 3 */
-    
-    ovl_ptr = ovl_ptr_start;
-    dst_ptr_y = dst_ptr_y_start;
-    
-    for(j = 0; j < jmax; j++)
-      {
-      /* Y0 */
-      tmp = *dst_ptr_y;
-      BLEND_8(ovl_ptr[0], tmp, ovl_ptr[3]);
-      *(dst_ptr_y++) = tmp;
-      
-      /* Y1 */
-      tmp = *dst_ptr_y;
-      BLEND_8(ovl_ptr[4], tmp, ovl_ptr[7]);
-      *(dst_ptr_y++) = tmp;
-            
-      /* Y2 */
-      tmp = *dst_ptr_y;
-      BLEND_8(ovl_ptr[8], tmp, ovl_ptr[11]);
-      *(dst_ptr_y++) = tmp;
-
-      /* Y3 */
-      tmp = *dst_ptr_y;
-      BLEND_8(ovl_ptr[12], tmp, ovl_ptr[15]);
-      *(dst_ptr_y++) = tmp;
-            
-      ovl_ptr+=16;
-      }
-    ovl_ptr_start += overlay->strides[0];
-    dst_ptr_y_start += frame->strides[0];
-
-    
-    }
-
-  }
-
-/* ovl: GAVL_YUVA_32 */
-
-static void blend_yuvj_420_p(gavl_overlay_blend_context_t * ctx,
-                            gavl_video_frame_t * frame,
-                            gavl_video_frame_t * overlay)
-  {
-  int i, j, imax, jmax;
-  uint8_t * ovl_ptr;
-  uint8_t * dst_ptr_y;
-  uint8_t * dst_ptr_u;
-  uint8_t * dst_ptr_v;
-  
-  uint8_t * ovl_ptr_start;
-  uint8_t * dst_ptr_y_start;
-  uint8_t * dst_ptr_u_start;
-  uint8_t * dst_ptr_v_start;
-  
-  int tmp;
-
-  imax = ctx->ovl->src_rect.h/2;
-  jmax = ctx->ovl->src_rect.w/2;
-  
-  ovl_ptr_start = overlay->planes[0];
-  dst_ptr_y_start = frame->planes[0];
-  dst_ptr_u_start = frame->planes[1];
-  dst_ptr_v_start = frame->planes[2];
-  
-  for(i = 0; i < imax; i++)
-    {
-    ovl_ptr = ovl_ptr_start;
-    dst_ptr_y = dst_ptr_y_start;
-    dst_ptr_u = dst_ptr_u_start;
-    dst_ptr_v = dst_ptr_v_start;
-    
-    for(j = 0; j < jmax; j++)
-      {
-      /* Y0 */
-      tmp = *dst_ptr_y;
-      BLEND_8(Y_8_TO_YJ_8(ovl_ptr[0]), tmp, ovl_ptr[3]);
-      *(dst_ptr_y++) = tmp;
-
-      /* U0 */
-      tmp = *dst_ptr_u;
-      BLEND_8(UV_8_TO_UVJ_8(ovl_ptr[1]), tmp, ovl_ptr[3]);
-      *(dst_ptr_u++) = tmp;
-
-      /* V0 */
-      tmp = *dst_ptr_v;
-      BLEND_8(UV_8_TO_UVJ_8(ovl_ptr[2]), tmp, ovl_ptr[3]);
-      *(dst_ptr_v++) = tmp;
-
-      /* Y1 */
-      tmp = *dst_ptr_y;
-      BLEND_8(Y_8_TO_YJ_8(ovl_ptr[4]), tmp, ovl_ptr[7]);
-      *(dst_ptr_y++) = tmp;
-
-      ovl_ptr+=8;
-      }
-    ovl_ptr_start += overlay->strides[0];
-
-    dst_ptr_y_start += frame->strides[0];
-    dst_ptr_u_start += frame->strides[1];
-    dst_ptr_v_start += frame->strides[2];
-
-
-    ovl_ptr = ovl_ptr_start;
-    dst_ptr_y = dst_ptr_y_start;
-    
-    for(j = 0; j < jmax; j++)
-      {
-      /* Y0 */
-      tmp = *dst_ptr_y;
-      BLEND_8(Y_8_TO_YJ_8(ovl_ptr[0]), tmp, ovl_ptr[3]);
-      *(dst_ptr_y++) = tmp;
-      
-      /* Y1 */
-      tmp = *dst_ptr_y;
-      BLEND_8(Y_8_TO_YJ_8(ovl_ptr[4]), tmp, ovl_ptr[7]);
-      *(dst_ptr_y++) = tmp;
-      
-      ovl_ptr+=8;
-      }
-    ovl_ptr_start += overlay->strides[0];
-
-    dst_ptr_y_start += frame->strides[0];
-
-
-    }
-  
-  }
-
-/* ovl: GAVL_YUVA_32 */
-
-static void blend_yuvj_422_p(gavl_overlay_blend_context_t * ctx,
-                            gavl_video_frame_t * frame,
-                            gavl_video_frame_t * overlay)
-  {
-  int i, j, jmax;
-  uint8_t * ovl_ptr;
-  uint8_t * dst_ptr_y;
-  uint8_t * dst_ptr_u;
-  uint8_t * dst_ptr_v;
-  
-  uint8_t * ovl_ptr_start;
-  uint8_t * dst_ptr_y_start;
-  uint8_t * dst_ptr_u_start;
-  uint8_t * dst_ptr_v_start;
-  
-  int tmp;
-
-  jmax = ctx->ovl->src_rect.w/2;
-  
-  ovl_ptr_start = overlay->planes[0];
-  dst_ptr_y_start = frame->planes[0];
-  dst_ptr_u_start = frame->planes[1];
-  dst_ptr_v_start = frame->planes[2];
-  
-  for(i = 0; i < ctx->ovl->src_rect.h; i++)
-    {
-    ovl_ptr = ovl_ptr_start;
-    dst_ptr_y = dst_ptr_y_start;
-    dst_ptr_u = dst_ptr_u_start;
-    dst_ptr_v = dst_ptr_v_start;
-    
-    for(j = 0; j < jmax; j++)
-      {
-      /* Y0 */
-      tmp = *dst_ptr_y;
-      BLEND_8(Y_8_TO_YJ_8(ovl_ptr[0]), tmp, ovl_ptr[3]);
-      *(dst_ptr_y++) = tmp;
-
-      /* U0 */
-      tmp = *dst_ptr_u;
-      BLEND_8(UV_8_TO_UVJ_8(ovl_ptr[1]), tmp, ovl_ptr[3]);
-      *(dst_ptr_u++) = tmp;
-
-      /* V0 */
-      tmp = *dst_ptr_v;
-      BLEND_8(UV_8_TO_UVJ_8(ovl_ptr[2]), tmp, ovl_ptr[3]);
-      *(dst_ptr_v++) = tmp;
-
-      /* Y1 */
-      tmp = *dst_ptr_y;
-      BLEND_8(Y_8_TO_YJ_8(ovl_ptr[4]), tmp, ovl_ptr[7]);
-      *(dst_ptr_y++) = tmp;
-
-      
-      ovl_ptr+=8;
-      }
-    ovl_ptr_start += overlay->strides[0];
-
-    dst_ptr_y_start += frame->strides[0];
-    dst_ptr_u_start += frame->strides[1];
-    dst_ptr_v_start += frame->strides[2];
-    }
-  
-  }
-
-/* ovl: GAVL_YUVA_32 */
-
-static void blend_yuvj_444_p(gavl_overlay_blend_context_t * ctx,
-                            gavl_video_frame_t * frame,
-                            gavl_video_frame_t * overlay)
-  {
-  int i, j;
-  uint8_t * ovl_ptr;
-  uint8_t * dst_ptr_y;
-  uint8_t * dst_ptr_u;
-  uint8_t * dst_ptr_v;
-  
-  uint8_t * ovl_ptr_start;
-  uint8_t * dst_ptr_y_start;
-  uint8_t * dst_ptr_u_start;
-  uint8_t * dst_ptr_v_start;
-  
-  int tmp;
-  
-  ovl_ptr_start = overlay->planes[0];
-  dst_ptr_y_start = frame->planes[0];
-  dst_ptr_u_start = frame->planes[1];
-  dst_ptr_v_start = frame->planes[2];
-  
-  for(i = 0; i < ctx->ovl->src_rect.h; i++)
-    {
-    ovl_ptr = ovl_ptr_start;
-    dst_ptr_y = dst_ptr_y_start;
-    dst_ptr_u = dst_ptr_u_start;
-    dst_ptr_v = dst_ptr_v_start;
-    
-    for(j = 0; j < ctx->ovl->src_rect.w; j++)
-      {
-      /* Y0 */
-      tmp = *dst_ptr_y;
-      BLEND_8(Y_8_TO_YJ_8(ovl_ptr[0]), tmp, ovl_ptr[3]);
-      *(dst_ptr_y++) = tmp;
-
-      /* U0 */
-      tmp = *dst_ptr_u;
-      BLEND_8(UV_8_TO_UVJ_8(ovl_ptr[1]), tmp, ovl_ptr[3]);
-      *(dst_ptr_u++) = tmp;
-
-      /* V0 */
-      tmp = *dst_ptr_v;
-      BLEND_8(UV_8_TO_UVJ_8(ovl_ptr[2]), tmp, ovl_ptr[3]);
-      *(dst_ptr_v++) = tmp;
-      
-      ovl_ptr+=4;
-      }
-    ovl_ptr_start += overlay->strides[0];
-
-    dst_ptr_y_start += frame->strides[0];
-    dst_ptr_u_start += frame->strides[1];
-    dst_ptr_v_start += frame->strides[2];
-    }
-  
-  }
-
-/* ovl: GAVL_YUVA_64 */
-
-static void blend_yuv_422_p_16(gavl_overlay_blend_context_t * ctx,
-                               gavl_video_frame_t * frame,
-                               gavl_video_frame_t * overlay)
-  {
-  int i, j, jmax;
-  uint16_t * ovl_ptr;
-  uint16_t * dst_ptr_y;
-  uint16_t * dst_ptr_u;
-  uint16_t * dst_ptr_v;
-  
-  uint8_t * ovl_ptr_start;
-  uint8_t * dst_ptr_y_start;
-  uint8_t * dst_ptr_u_start;
-  uint8_t * dst_ptr_v_start;
-  
-  int64_t tmp, alpha;
-  
-  ovl_ptr_start = overlay->planes[0];
-  dst_ptr_y_start = frame->planes[0];
-  dst_ptr_u_start = frame->planes[1];
-  dst_ptr_v_start = frame->planes[2];
-
-  jmax = ctx->ovl->src_rect.w / 2;
-  
-  for(i = 0; i < ctx->ovl->src_rect.h; i++)
-    {
-    ovl_ptr = (uint16_t*)ovl_ptr_start;
-    dst_ptr_y = (uint16_t*)dst_ptr_y_start;
-    dst_ptr_u = (uint16_t*)dst_ptr_u_start;
-    dst_ptr_v = (uint16_t*)dst_ptr_v_start;
-    
-    for(j = 0; j < jmax; j++)
-      {
-      alpha = ovl_ptr[3];
-      /* Y0 */
-      tmp = *dst_ptr_y;
-      BLEND_16(ovl_ptr[0], tmp, alpha);
-      *(dst_ptr_y++) = tmp;
-
-      /* U0 */
-      tmp = *dst_ptr_u;
-      BLEND_16(ovl_ptr[1], tmp, alpha);
-      *(dst_ptr_u++) = tmp;
-
-      /* V0 */
-      tmp = *dst_ptr_v;
-      BLEND_16(ovl_ptr[2], tmp, alpha);
-      *(dst_ptr_v++) = tmp;
-
-      alpha = ovl_ptr[7];
-
-      /* Y1 */
-      tmp = *dst_ptr_y;
-      BLEND_16(ovl_ptr[0], tmp, alpha);
-      *(dst_ptr_y++) = tmp;
-      
-      ovl_ptr+=8;
-      }
-    ovl_ptr_start += overlay->strides[0];
-
-    dst_ptr_y_start += frame->strides[0];
-    dst_ptr_u_start += frame->strides[1];
-    dst_ptr_v_start += frame->strides[2];
-    }
-  
-  }
-
-/* ovl: GAVL_YUVA_64 */
-
-static void blend_yuv_444_p_16(gavl_overlay_blend_context_t * ctx,
-                               gavl_video_frame_t * frame,
-                               gavl_video_frame_t * overlay)
-  {
-  int i, j;
-  uint16_t * ovl_ptr;
-  uint16_t * dst_ptr_y;
-  uint16_t * dst_ptr_u;
-  uint16_t * dst_ptr_v;
+  int i, j;
+  uint16_t * ovl_ptr;
+  uint16_t * dst_ptr_y;
+  uint16_t * dst_ptr_u;
+  uint16_t * dst_ptr_v;
   
   uint8_t * ovl_ptr_start;
   uint8_t * dst_ptr_y_start;
@@ -1959,14 +1657,14 @@ static void blend_yuv_444_p_16(gavl_overlay_blend_context_t * ctx,
   dst_ptr_u_start = frame->planes[1];
   dst_ptr_v_start = frame->planes[2];
   
-  for(i = 0; i < ctx->ovl->src_rect.h; i++)
+  for(i = 0; i < height; i++)
     {
     ovl_ptr = (uint16_t*)ovl_ptr_start;
     dst_ptr_y = (uint16_t*)dst_ptr_y_start;
     dst_ptr_u = (uint16_t*)dst_ptr_u_start;
     dst_ptr_v = (uint16_t*)dst_ptr_v_start;
     
-    for(j = 0; j < ctx->ovl->src_rect.w; j++)
+    for(j = 0; j < width; j++)
       {
       alpha = ovl_ptr[3];
       /* Y0 */
@@ -2076,23 +1774,23 @@ gavl_find_blend_func_c(gavl_overlay_blend_context_t * ctx,
       break;
     case GAVL_YUV_420_P:
       *overlay_format = GAVL_YUVA_32;
-      return blend_yuv_420_p;
+      return blend_yuv_planar;
       break;
     case GAVL_YUV_422_P:
       *overlay_format = GAVL_YUVA_32;
-      return blend_yuv_422_p;
+      return blend_yuv_planar;
       break;
     case GAVL_YUV_444_P:
       *overlay_format = GAVL_YUVA_32;
-      return blend_yuv_444_p;
+      return blend_yuv_planar;
       break;
     case GAVL_YUV_411_P:
       *overlay_format = GAVL_YUVA_32;
-      return blend_yuv_411_p;
+      return blend_yuv_planar;
       break;
     case GAVL_YUV_410_P:
       *overlay_format = GAVL_YUVA_32;
-      return blend_yuv_410_p;
+      return blend_yuv_planar;
       break;
     case GAVL_YUVJ_420_P:
       *overlay_format = GAVL_YUVA_32;
@@ -2147,3 +1845,19 @@ gavl_find_blend_func_c(gavl_overlay_blend_context_t * ctx,
     }
   return NULL;
   }
+
+void gavl_init_blend_funcs_c(gavl_blend_funcs_t * funcs, int premultiplied)
+  {
+  if(premultiplied)
+    {
+    funcs->blend_rgb_32 = blend_rgb_32_premultiplied_c;
+    funcs->blend_y_8    = blend_y_8_premultiplied_c;
+    funcs->blend_uv_8   = blend_uv_8_premultiplied_c;
+    }
+  else
+    {
+    funcs->blend_rgb_32 = blend_rgb_32_c;
+    funcs->blend_y_8    = blend_y_8_c;
+    funcs->blend_uv_8   = blend_uv_8_c;
+    }
+  }
@@ -0,0 +1,86 @@
+/*****************************************************************
+ * gavl - a general purpose audio/video processing library
+ *
+ * Copyright (c) 2001 - 2012 Members of the Gmerlin project
+ * gmerlin-general@lists.sourceforge.net
+ * http://gmerlin.sourceforge.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * *****************************************************************/
+
+/*
+ *  Line functions for blending 8 bit overlays (4 bytes per pixel, alpha
+ *  last). Included from blend_c.c with BLEND_RGB_32, BLEND_Y_8,
+ *  BLEND_UV_8 (function names) and BLEND (blend macro) defined.
+ */
+
+static void (BLEND_RGB_32)(uint8_t * dst, const uint8_t * ovl, int num)
+  {
+  int i, tmp;
+
+  for(i = 0; i < num; i++)
+    {
+    tmp = dst[0];
+    BLEND(ovl[0], tmp, ovl[3]);
+    dst[0] = tmp;
+
+    tmp = dst[1];
+    BLEND(ovl[1], tmp, ovl[3]);
+    dst[1] = tmp;
+
+    tmp = dst[2];
+    BLEND(ovl[2], tmp, ovl[3]);
+    dst[2] = tmp;
+    
+    ovl+=4;
+    dst+=4;
+    }
+  }
+
+static void (BLEND_Y_8)(uint8_t * dst, const uint8_t * ovl, int num)
+  {
+  int i, tmp;
+
+  for(i = 0; i < num; i++)
+    {
+    tmp = dst[i];
+    BLEND(ovl[0], tmp, ovl[3]);
+    dst[i] = tmp;
+    ovl+=4;
+    }
+  }
+
+static void (BLEND_UV_8)(uint8_t * dst_u, uint8_t * dst_v,
+                         const uint8_t * ovl, int num, int sub_h)
+  {
+  int i, tmp;
+
+  for(i = 0; i < num; i++)
+    {
+    tmp = dst_u[i];
+    BLEND(ovl[1], tmp, ovl[3]);
+    dst_u[i] = tmp;
+
+    tmp = dst_v[i];
+    BLEND(ovl[2], tmp, ovl[3]);
+    dst_v[i] = tmp;
+    
+    ovl += 4 * sub_h;
+    }
+  }
+
+#undef BLEND_RGB_32
+#undef BLEND_Y_8
+#undef BLEND_UV_8
+#undef BLEND
@@ -152,6 +152,16 @@ static float sad_f_c(const uint8_t * src_1, const uint8_t * src_2,
   return ret;
   }
 
+static void sad_candidates_8_c(const uint8_t * block, int block_stride,
+                               const uint8_t * ref, int ref_stride,
+                               int w, int h,
+                               const int * offsets, int num, int * costs)
+  {
+  int i;
+  for(i = 0; i < num; i++)
+    costs[i] = sad_8_c(block, ref + offsets[i], block_stride, ref_stride, w, h);
+  }
+
 /* Averaging */
 static void average_rgb15_c(const uint8_t * src_1, const uint8_t * src_2, 
                         uint8_t * dst, int num)
@@ -538,7 +548,7 @@ static void add_s32_c(const void * _src1, const void * _src2,
 
   while(--i)
     {
-    tmp = *(src1++) + *(src2++);
+    tmp = (int64_t)*(src1++) + *(src2++);
     *(dst++) = GENERIC_CLIP(tmp,-2147483648LL,2147483647LL);
     }
   }
@@ -666,7 +676,7 @@ static void sub_u16_s_c(const void * _src1, const void * _src2,
 
   while(--i)
     {
-    tmp = *(src1++) + *(src2++);
+    tmp = *(src1++) - *(src2++);
     *(dst++) = GENERIC_CLIP(tmp,-32768,32767) + 32768;
     }
   }
@@ -682,7 +692,7 @@ static void sub_s32_c(const void * _src1, const void * _src2,
 
   while(--i)
     {
-    tmp = *(src1++) - *(src2++);
+    tmp = (int64_t)*(src1++) - *(src2++);
     *(dst++) = GENERIC_CLIP(tmp,-2147483648LL,2147483647LL);
     }
   }
@@ -824,5 +834,7 @@ void gavl_dsp_init_c(gavl_dsp_funcs_t * funcs,
   funcs->shift_down_16     = shift_down_16_c;
 
   funcs->shuffle_8_4       = shuffle_8_4_c;
+
+  funcs->sad_candidates_8  = sad_candidates_8_c;
   
   }
@@ -19,9 +19,13 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  * *****************************************************************/
 
-static void (FUNC_NAME)(gavl_transform_context_t * ctx, gavl_transform_pixel_t * pixels, uint8_t * dest_start)
+static void (FUNC_NAME)(gavl_transform_context_t * ctx,
+                        const gavl_transform_entry_t * entries,
+                        const gavl_transform_pixel_t * border,
+                        uint8_t * dest_start, int width)
   {
   int i;
+  gavl_transform_pixel_t pixels[TRANSFORM_TILE_WIDTH];
 
   TYPE * src_0,
 #if NUM_TAPS > 1
@@ -41,9 +45,10 @@ static void (FUNC_NAME)(gavl_transform_context_t * ctx, gavl_transform_pixel_t *
   INIT
 #endif
 
+  gavl_transform_table_expand(&ctx->tab, entries, border, pixels, width);
   pixel = pixels;    
 
-  i = ctx->dst_width+1;
+  i = width+1;
   
   while(--i)
     {
@@ -25,7 +25,8 @@
 #include <transform.h>
 
 #define TRANSFORM_FUNC_HEAD \
-  for(i = 0; i < ctx->dst_width; i++)       \
+  gavl_transform_table_expand(&ctx->tab, entries, border, pixels, width); \
+  for(i = 0; i < width; i++)                \
     {
 
 #define TRANSFORM_FUNC_TAIL \
@@ -33,10 +34,13 @@
     }
 
 static void transform_rgb_16_nearest_c(gavl_transform_context_t * ctx,
-                                       gavl_transform_pixel_t * pixels, uint8_t * dest_start)
+                                       const gavl_transform_entry_t * entries,
+                                       const gavl_transform_pixel_t * border,
+                                       uint8_t * dest_start, int width)
   {
   int i;
   uint16_t * src, *dst;
+  gavl_transform_pixel_t pixels[TRANSFORM_TILE_WIDTH];
   gavl_transform_pixel_t * pixel = pixels;
   dst = (uint16_t*)(dest_start);
   TRANSFORM_FUNC_HEAD
@@ -52,10 +56,13 @@ static void transform_rgb_16_nearest_c(gavl_transform_context_t * ctx,
   }
 
 static void transform_uint8_x_1_nearest_c(gavl_transform_context_t * ctx,
-                                          gavl_transform_pixel_t * pixels, uint8_t * dest_start)
+                                          const gavl_transform_entry_t * entries,
+                                          const gavl_transform_pixel_t * border,
+                                          uint8_t * dest_start, int width)
   {
   int i;
   uint8_t * src, *dst;
+  gavl_transform_pixel_t pixels[TRANSFORM_TILE_WIDTH];
   gavl_transform_pixel_t * pixel = pixels;
   dst = (uint8_t*)(dest_start);
   TRANSFORM_FUNC_HEAD
@@ -71,10 +78,13 @@ static void transform_uint8_x_1_nearest_c(gavl_transform_context_t * ctx,
   }
 
 static void transform_uint8_x_3_nearest_c(gavl_transform_context_t * ctx,
-                                          gavl_transform_pixel_t * pixels, uint8_t * dest_start)
+                                          const gavl_transform_entry_t * entries,
+                                          const gavl_transform_pixel_t * border,
+                                          uint8_t * dest_start, int width)
   {
   int i;
   uint8_t * src, *dst;
+  gavl_transform_pixel_t pixels[TRANSFORM_TILE_WIDTH];
   gavl_transform_pixel_t * pixel = pixels;
   dst = (uint8_t*)(dest_start);
   TRANSFORM_FUNC_HEAD
@@ -92,10 +102,13 @@ static void transform_uint8_x_3_nearest_c(gavl_transform_context_t * ctx,
   }
 
 static void transform_uint8_x_4_nearest_c(gavl_transform_context_t * ctx,
-                                          gavl_transform_pixel_t * pixels, uint8_t * dest_start)
+                                          const gavl_transform_entry_t * entries,
+                                          const gavl_transform_pixel_t * border,
+                                          uint8_t * dest_start, int width)
   {
   int i;
   uint32_t * src, *dst;
+  gavl_transform_pixel_t pixels[TRANSFORM_TILE_WIDTH];
   gavl_transform_pixel_t * pixel = pixels;
   dst = (uint32_t*)(dest_start);
   TRANSFORM_FUNC_HEAD
@@ -111,10 +124,13 @@ static void transform_uint8_x_4_nearest_c(gavl_transform_context_t * ctx,
   }
 
 static void transform_uint16_x_3_nearest_c(gavl_transform_context_t * ctx,
-                                           gavl_transform_pixel_t * pixels, uint8_t * dest_start)
+                                           const gavl_transform_entry_t * entries,
+                                           const gavl_transform_pixel_t * border,
+                                           uint8_t * dest_start, int width)
   {
   int i;
   uint16_t * src, *dst;
+  gavl_transform_pixel_t pixels[TRANSFORM_TILE_WIDTH];
   gavl_transform_pixel_t * pixel = pixels;
   dst = (uint16_t*)(dest_start);
   TRANSFORM_FUNC_HEAD
@@ -132,10 +148,13 @@ static void transform_uint16_x_3_nearest_c(gavl_transform_context_t * ctx,
   }
 
 static void transform_uint16_x_4_nearest_c(gavl_transform_context_t * ctx,
-                                           gavl_transform_pixel_t * pixels, uint8_t * dest_start)
+                                           const gavl_transform_entry_t * entries,
+                                           const gavl_transform_pixel_t * border,
+                                           uint8_t * dest_start, int width)
   {
   int i;
   uint64_t * src, *dst;
+  gavl_transform_pixel_t pixels[TRANSFORM_TILE_WIDTH];
   gavl_transform_pixel_t * pixel = pixels;
   dst = (uint64_t*)(dest_start);
   TRANSFORM_FUNC_HEAD
@@ -151,11 +170,14 @@ static void transform_uint16_x_4_nearest_c(gavl_transform_context_t * ctx,
   }
 
 static void
-transform_float_x_1_nearest_c(gavl_transform_context_t *
-                              ctx, gavl_transform_pixel_t * pixels, uint8_t * dest_start)
+transform_float_x_1_nearest_c(gavl_transform_context_t * ctx,
+                              const gavl_transform_entry_t * entries,
+                              const gavl_transform_pixel_t * border,
+                              uint8_t * dest_start, int width)
   {
   int i;
   float * src, *dst;
+  gavl_transform_pixel_t pixels[TRANSFORM_TILE_WIDTH];
   gavl_transform_pixel_t * pixel = pixels;
   dst = (float*)(dest_start);
   TRANSFORM_FUNC_HEAD
@@ -172,10 +194,13 @@ transform_float_x_1_nearest_c(gavl_transform_context_t *
 
 static void
 transform_float_x_2_nearest_c(gavl_transform_context_t * ctx,
-                              gavl_transform_pixel_t * pixels, uint8_t * dest_start)
+                              const gavl_transform_entry_t * entries,
+                              const gavl_transform_pixel_t * border,
+                              uint8_t * dest_start, int width)
   {
   int i;
   float * src, *dst;
+  gavl_transform_pixel_t pixels[TRANSFORM_TILE_WIDTH];
   gavl_transform_pixel_t * pixel = pixels;
   dst = (float*)(dest_start);
   TRANSFORM_FUNC_HEAD
@@ -193,10 +218,13 @@ transform_float_x_2_nearest_c(gavl_transform_context_t * ctx,
 
 static void
 transform_float_x_3_nearest_c(gavl_transform_context_t * ctx,
-                              gavl_transform_pixel_t * pixels, uint8_t * dest_start)
+                              const gavl_transform_entry_t * entries,
+                              const gavl_transform_pixel_t * border,
+                              uint8_t * dest_start, int width)
   {
   int i;
   float * src, *dst;
+  gavl_transform_pixel_t pixels[TRANSFORM_TILE_WIDTH];
   gavl_transform_pixel_t * pixel = pixels;
   dst = (float*)(dest_start);
   TRANSFORM_FUNC_HEAD
@@ -215,10 +243,13 @@ transform_float_x_3_nearest_c(gavl_transform_context_t * ctx,
 
 static void
 transform_float_x_4_nearest_c(gavl_transform_context_t * ctx,
-                              gavl_transform_pixel_t * pixels, uint8_t * dest_start)
+                              const gavl_transform_entry_t * entries,
+                              const gavl_transform_pixel_t * border,
+                              uint8_t * dest_start, int width)
   {
   int i;
   float * src, *dst;
+  gavl_transform_pixel_t pixels[TRANSFORM_TILE_WIDTH];
   gavl_transform_pixel_t * pixel = pixels;
   dst = (float*)(dest_start);
   TRANSFORM_FUNC_HEAD
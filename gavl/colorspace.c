@@ -27,6 +27,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <pthread.h>
 
 #ifdef WORDS_BIGENDIAN
 static const uint32_t rgb32_masks[4]  = { 0xff000000, 0x00ff0000, 0x0000ff00, 0x00000000 };
@@ -339,6 +340,13 @@ create_pixelformat_function_table(const gavl_video_options_t * opt,
     //    gavl_init_yuv_yuv_funcs_sse(csp_tab, opt);
     //    gavl_init_yuv_rgb_funcs_sse(csp_tab, opt);
     }
+#endif
+#ifdef HAVE_AVX2
+  if(opt->accel_flags & GAVL_ACCEL_AVX2)
+    {
+    gavl_init_rgb_yuv_funcs_avx2(csp_tab, width, opt);
+    gavl_init_yuv_rgb_funcs_avx2(csp_tab, width, opt);
+    }
 #endif
   /* High quality */
   
@@ -356,6 +364,76 @@ create_pixelformat_function_table(const gavl_video_options_t * opt,
   return csp_tab;
   }
 
+/*
+ *  Function tables are cached process wide. A table depends only on the
+ *  quality, the accel flags, the alpha mode and the alignment of the
+ *  image width (SIMD routines need multiples of 4, 8 or 16 pixels).
+ *  Tables are never modified after they are created.
+ */
+
+typedef struct table_cache_s
+  {
+  int quality;
+  int accel_flags;
+  int alpha_blend;
+  int width_align;
+  gavl_pixelformat_function_table_t * tab;
+  struct table_cache_s * next;
+  } table_cache_t;
+
+static table_cache_t * table_cache = NULL;
+static pthread_mutex_t table_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static gavl_pixelformat_function_table_t *
+get_pixelformat_function_table(const gavl_video_options_t * opt,
+                               int width, int height)
+  {
+  table_cache_t * c;
+  int alpha_blend;
+  int width_align;
+  gavl_pixelformat_function_table_t * ret;
+
+  alpha_blend = (opt->alpha_mode == GAVL_ALPHA_BLEND_COLOR);
+  
+  if(!(width % 16))
+    width_align = 16;
+  else if(!(width % 8))
+    width_align = 8;
+  else if(!(width % 4))
+    width_align = 4;
+  else
+    width_align = 1;
+  
+  pthread_mutex_lock(&table_cache_mutex);
+
+  c = table_cache;
+  while(c)
+    {
+    if((c->quality == opt->quality) &&
+       (c->accel_flags == opt->accel_flags) &&
+       (c->alpha_blend == alpha_blend) &&
+       (c->width_align == width_align))
+      break;
+    c = c->next;
+    }
+
+  if(!c)
+    {
+    c = calloc(1, sizeof(*c));
+    c->quality = opt->quality;
+    c->accel_flags = opt->accel_flags;
+    c->alpha_blend = alpha_blend;
+    c->width_align = width_align;
+    c->tab = create_pixelformat_function_table(opt, width_align, height);
+    c->next = table_cache;
+    table_cache = c;
+    }
+  ret = c->tab;
+  
+  pthread_mutex_unlock(&table_cache_mutex);
+  return ret;
+  }
+
 gavl_video_func_t
 gavl_find_pixelformat_converter(const gavl_video_options_t * opt,
                                gavl_pixelformat_t input_pixelformat,
@@ -364,8 +442,8 @@ gavl_find_pixelformat_converter(const gavl_video_options_t * opt,
                                int height)
   {
   gavl_video_func_t ret = NULL;
-  gavl_pixelformat_function_table_t * tab =
-    create_pixelformat_function_table(opt, width, height);
+  const gavl_pixelformat_function_table_t * tab =
+    get_pixelformat_function_table(opt, width, height);
 
   switch(input_pixelformat)
     {
@@ -4157,7 +4235,6 @@ gavl_find_pixelformat_converter(const gavl_video_options_t * opt,
     case GAVL_PIXELFORMAT_NONE:
       break;
     }
-  free(tab);  
   return ret;
   }
 
@@ -0,0 +1,225 @@
+/*****************************************************************
+ * gavl - a general purpose audio/video processing library
+ *
+ * Copyright (c) 2001 - 2012 Members of the Gmerlin project
+ * gmerlin-general@lists.sourceforge.net
+ * http://gmerlin.sourceforge.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * *****************************************************************/
+
+/*
+ *  Blend several overlays onto one frame. Each layer has its own blend
+ *  context, which does the cropping and has the blend function.
+ *  The union of all destination rectangles is processed in bands of
+ *  COMPOSITOR_BAND_HEIGHT lines. Within a band, all layers are blended
+ *  bottom to top while the destination lines are still in the cache.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <config.h>
+
+#include <gavl/gavl.h>
+#include <video.h>
+#include <blend.h>
+
+gavl_overlay_compositor_t * gavl_overlay_compositor_create()
+  {
+  gavl_overlay_compositor_t * ret;
+  ret = calloc(1, sizeof(*ret));
+  gavl_video_options_set_defaults(&ret->opt);
+  return ret;
+  }
+
+static void free_layers(gavl_overlay_compositor_t * c)
+  {
+  int i;
+
+  for(i = 0; i < c->num_layers; i++)
+    gavl_overlay_blend_context_destroy(c->layers[i]);
+
+  if(c->layers)
+    free(c->layers);
+
+  c->layers = NULL;
+  c->num_layers = 0;
+  }
+
+void gavl_overlay_compositor_destroy(gavl_overlay_compositor_t * c)
+  {
+  free_layers(c);
+  free(c);
+  }
+
+gavl_video_options_t *
+gavl_overlay_compositor_get_options(gavl_overlay_compositor_t * c)
+  {
+  return &c->opt;
+  }
+
+int gavl_overlay_compositor_init(gavl_overlay_compositor_t * c,
+                                 const gavl_video_format_t * frame_format,
+                                 gavl_video_format_t * overlay_format,
+                                 int num_layers)
+  {
+  int i;
+  gavl_video_format_t fmt;
+  
+  free_layers(c);
+
+  if(num_layers < 1)
+    return 0;
+
+  gavl_video_format_copy(&c->dst_format, frame_format);
+  
+  c->layers = calloc(num_layers, sizeof(*c->layers));
+  c->num_layers = num_layers;
+
+  for(i = 0; i < num_layers; i++)
+    {
+    c->layers[i] = gavl_overlay_blend_context_create();
+    gavl_video_options_copy(gavl_overlay_blend_context_get_options(c->layers[i]),
+                            &c->opt);
+    
+    gavl_video_format_copy(&fmt, overlay_format);
+    if(!gavl_overlay_blend_context_init(c->layers[i], frame_format, &fmt))
+      return 0;
+    }
+
+  /* All layers have the same overlay format */
+  gavl_video_format_copy(&c->ovl_format, &fmt);
+  gavl_video_format_copy(overlay_format, &fmt);
+  return 1;
+  }
+
+void gavl_overlay_compositor_set_overlay(gavl_overlay_compositor_t * c,
+                                         int layer,
+                                         gavl_overlay_t * ovl)
+  {
+  if((layer < 0) || (layer >= c->num_layers))
+    return;
+  gavl_overlay_blend_context_set_overlay(c->layers[layer], ovl);
+  }
+
+/* Blend all layers into the bands start..end-1 */
+
+static void blend_bands(void * priv, int start, int end)
+  {
+  int i;
+  int y_start, y_end, y1, y2;
+  gavl_overlay_blend_context_t * ctx;
+  gavl_overlay_compositor_t * c = priv;
+  gavl_rectangle_i_t rect;
+  gavl_video_frame_t dst_win;
+  gavl_video_frame_t ovl_win;
+
+  y_start = c->dirty.y + start * COMPOSITOR_BAND_HEIGHT;
+  y_end   = c->dirty.y + end * COMPOSITOR_BAND_HEIGHT;
+  if(y_end > c->dirty.y + c->dirty.h)
+    y_end = c->dirty.y + c->dirty.h;
+
+  for(y1 = y_start; y1 < y_end; y1 += COMPOSITOR_BAND_HEIGHT)
+    {
+    y2 = y1 + COMPOSITOR_BAND_HEIGHT;
+    if(y2 > y_end)
+      y2 = y_end;
+
+    for(i = 0; i < c->num_layers; i++)
+      {
+      ctx = c->layers[i];
+      if(!ctx->ovl)
+        continue;
+
+      /* Lines of this layer within the band */
+      rect.y = ctx->dst_rect.y > y1 ? ctx->dst_rect.y : y1;
+      rect.h = (ctx->dst_rect.y + ctx->dst_rect.h < y2 ?
+                ctx->dst_rect.y + ctx->dst_rect.h : y2) - rect.y;
+      if(rect.h <= 0)
+        continue;
+
+      rect.x = ctx->dst_rect.x;
+      rect.w = ctx->dst_rect.w;
+      gavl_video_frame_get_subframe(c->dst_format.pixelformat,
+                                    c->dst_frame, &dst_win, &rect);
+
+      rect.y = ctx->ovl->src_rect.y + rect.y - ctx->dst_rect.y;
+      rect.x = ctx->ovl->src_rect.x;
+      gavl_video_frame_get_subframe(c->ovl_format.pixelformat,
+                                    ctx->ovl_frame, &ovl_win, &rect);
+
+      ctx->func(ctx, &dst_win, &ovl_win, rect.w, rect.h);
+      }
+    }
+  }
+
+void gavl_overlay_compositor_blend(gavl_overlay_compositor_t * c,
+                                   gavl_video_frame_t * dst_frame)
+  {
+  int i;
+  int x2, y2;
+  int num_bands;
+  const gavl_rectangle_i_t * r;
+
+  /* Get the union of the destination rectangles */
+
+  c->dirty.w = 0;
+  c->dirty.h = 0;
+  x2 = 0;
+  y2 = 0;
+
+  for(i = 0; i < c->num_layers; i++)
+    {
+    if(!c->layers[i]->ovl)
+      continue;
+
+    r = &c->layers[i]->dst_rect;
+    if((r->w <= 0) || (r->h <= 0))
+      continue;
+
+    if(!c->dirty.w)
+      {
+      c->dirty.x = r->x;
+      c->dirty.y = r->y;
+      x2 = r->x + r->w;
+      y2 = r->y + r->h;
+      }
+    else
+      {
+      if(r->x < c->dirty.x)
+        c->dirty.x = r->x;
+      if(r->y < c->dirty.y)
+        c->dirty.y = r->y;
+      if(r->x + r->w > x2)
+        x2 = r->x + r->w;
+      if(r->y + r->h > y2)
+        y2 = r->y + r->h;
+      }
+    c->dirty.w = x2 - c->dirty.x;
+    c->dirty.h = y2 - c->dirty.y;
+    }
+
+  if(!c->dirty.w)
+    return;
+
+  c->dst_frame = dst_frame;
+
+  num_bands = (c->dirty.h + COMPOSITOR_BAND_HEIGHT - 1) / COMPOSITOR_BAND_HEIGHT;
+
+  if(c->opt.num_threads > 1)
+    gavl_video_run_slices(&c->opt, blend_bands, c, num_bands);
+  else
+    blend_bands(c, 0, num_bands);
+  }
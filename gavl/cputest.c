@@ -40,6 +40,14 @@
 #define MM_SSE2     GAVL_ACCEL_SSE2
 #define MM_SSE3     GAVL_ACCEL_SSE3
 #define MM_SSSE3    GAVL_ACCEL_SSSE3
+#define MM_AVX      GAVL_ACCEL_AVX
+#define MM_AVX2     GAVL_ACCEL_AVX2
+#define MM_FMA      GAVL_ACCEL_FMA
+#define MM_F16C     GAVL_ACCEL_F16C
+#define MM_BMI2     GAVL_ACCEL_BMI2
+#define MM_AVX512F  GAVL_ACCEL_AVX512F
+#define MM_AVX512BW GAVL_ACCEL_AVX512BW
+#define MM_AVX512VL GAVL_ACCEL_AVX512VL
 #define MM_3DNOW    GAVL_ACCEL_3DNOW
 #define MM_3DNOWEXT GAVL_ACCEL_3DNOWEXT
 
@@ -61,6 +69,27 @@
            "=c" (ecx), "=d" (edx)\
          : "0" (index));
 
+#define cpuid_count(index,count,eax,ebx,ecx,edx)\
+    __asm __volatile\
+        ("mov %%"REG_b", %%"REG_S"\n\t"\
+         "cpuid\n\t"\
+         "xchg %%"REG_b", %%"REG_S\
+         : "=a" (eax), "=S" (ebx),\
+           "=c" (ecx), "=d" (edx)\
+         : "0" (index), "2" (count));
+
+#ifdef ARCH_X86
+/* Get the register state enabled by the OS */
+
+static int xgetbv(int index)
+  {
+  int eax, edx;
+  __asm__ __volatile__ (".byte 0x0f, 0x01, 0xd0" /* xgetbv */
+                        : "=a" (eax), "=d" (edx) : "c" (index));
+  return eax;
+  }
+#endif
+
 /* Function to test if multimedia instructions are supported...  */
 
 int gavl_accel_supported()
@@ -69,6 +98,7 @@ int gavl_accel_supported()
      int rval = 0;
     int eax, ebx, ecx, edx;
     int max_std_level, max_ext_level, std_caps=0, ext_caps=0;
+    int avx_os = 0, avx512_os = 0, xcr0;
 
 #ifndef ARCH_X86_64
     long a, c;
@@ -113,6 +143,39 @@ int gavl_accel_supported()
         if (ecx & 0x00000200 )
           rval |= MM_SSSE3;
 
+        /* AVX: The OS must save the ymm registers (OSXSAVE and XCR0).
+           AVX-512 additionally needs the opmask and zmm state */
+        if((ecx & (1<<27)) && (ecx & (1<<28)))
+          {
+          xcr0 = xgetbv(0);
+          if((xcr0 & 0x06) == 0x06)
+            avx_os = 1;
+          if(avx_os && ((xcr0 & 0xe0) == 0xe0))
+            avx512_os = 1;
+          }
+
+        if(avx_os){
+            rval |= MM_AVX;
+            if (ecx & (1<<12))
+                rval |= MM_FMA;
+            if (ecx & (1<<29))
+                rval |= MM_F16C;
+        }
+    }
+
+    if(max_std_level >= 7){
+        cpuid_count(7, 0, eax, ebx, ecx, edx);
+        if (ebx & (1<<8))
+            rval |= MM_BMI2;
+        if (avx_os && (ebx & (1<<5)))
+            rval |= MM_AVX2;
+        if (avx512_os && (ebx & (1<<16))){
+            rval |= MM_AVX512F;
+            if (ebx & (1<<30))
+                rval |= MM_AVX512BW;
+            if (ebx & (1U<<31))
+                rval |= MM_AVX512VL;
+        }
     }
 
     cpuid(0x80000000, max_ext_level, ebx, ecx, edx);
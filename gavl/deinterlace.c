@@ -48,6 +48,8 @@ void gavl_video_deinterlacer_destroy(gavl_video_deinterlacer_t * d)
 
   if(d->scaler)
     gavl_video_scaler_destroy(d->scaler);
+
+  gavl_deinterlacer_cleanup_adaptive(d);
   
   free(d);
   }
@@ -59,6 +61,100 @@ gavl_video_deinterlacer_get_options(gavl_video_deinterlacer_t * d)
   }
 
 
+/* Copy and blend: Each output scanline depends only on the input, so
+   we can split the frame into bands of scanlines */
+
+static void deinterlace_band(gavl_video_deinterlacer_t * d,
+                             const gavl_video_frame_t * in,
+                             gavl_video_frame_t * out,
+                             int start, int end)
+  {
+  int i;
+  
+  d->band_func(d, in, out, 0, start, end);
+  
+  if(d->num_planes < 2)
+    return;
+
+  /* Chroma planes */
+  if(end == d->format.image_height)
+    end = d->format.image_height / d->sub_v;
+  else
+    end /= d->sub_v;
+  start /= d->sub_v;
+  
+  for(i = 1; i < d->num_planes; i++)
+    d->band_func(d, in, out, i, start, end);
+  }
+
+static void deinterlace_slice(void * data, int start, int end)
+  {
+  gavl_video_deinterlacer_t * d = data;
+
+  start *= d->sub_v;
+  end *= d->sub_v;
+  if(end > d->format.image_height)
+    end = d->format.image_height;
+  
+  deinterlace_band(d, d->input_frame, d->output_frame, start, end);
+  }
+
+static void deinterlace_sliced(gavl_video_deinterlacer_t * d,
+                               const gavl_video_frame_t * in,
+                               gavl_video_frame_t * out)
+  {
+  d->input_frame = in;
+  d->output_frame = out;
+  gavl_video_run_slices(&d->opt, deinterlace_slice, d,
+                        (d->format.image_height + d->sub_v - 1) / d->sub_v);
+  }
+
+/* The adaptive deinterlacer must know when a frame is complete */
+
+int gavl_video_deinterlacer_can_deinterlace_band(gavl_video_deinterlacer_t * d)
+  {
+  return d->band_func && (d->opt.deinterlace_mode != GAVL_DEINTERLACE_ADAPTIVE);
+  }
+
+void gavl_video_deinterlacer_deinterlace_band(gavl_video_deinterlacer_t * d,
+                                              const gavl_video_frame_t * in,
+                                              gavl_video_frame_t * band,
+                                              int y, int h)
+  {
+  int i;
+  gavl_video_frame_t out;
+  gavl_video_format_t band_format;
+  gavl_rectangle_i_t rect;
+  
+  if(d->mixed &&
+     (in->interlace_mode == GAVL_INTERLACE_NONE) &&
+     !(d->opt.conversion_flags & GAVL_FORCE_DEINTERLACE))
+    {
+    /* Progressive frame: Just copy the band */
+    memset(&out, 0, sizeof(out));
+    rect.x = 0;
+    rect.y = y;
+    rect.w = d->format.image_width;
+    rect.h = h;
+    gavl_video_frame_get_subframe(d->format.pixelformat, in, &out, &rect);
+
+    gavl_video_format_copy(&band_format, &d->format);
+    band_format.image_height = h;
+    gavl_video_frame_copy(&band_format, band, &out);
+    return;
+    }
+
+  /* Let the output frame start at scanline 0 of the image */
+  memset(&out, 0, sizeof(out));
+  for(i = 0; i < d->num_planes; i++)
+    {
+    out.strides[i] = band->strides[i];
+    out.planes[i] = band->planes[i] -
+      (i ? y / d->sub_v : y) * band->strides[i];
+    }
+  deinterlace_band(d, in, &out, y, y + h);
+  }
+
 int gavl_video_deinterlacer_init(gavl_video_deinterlacer_t * d,
                                  const gavl_video_format_t * src_format)
   {
@@ -78,6 +174,9 @@ int gavl_video_deinterlacer_init(gavl_video_deinterlacer_t * d,
 
   d->num_planes = gavl_pixelformat_num_planes(d->format.pixelformat);
   gavl_pixelformat_chroma_sub(d->format.pixelformat, &d->sub_h, &d->sub_v);
+
+  d->band_func = NULL;
+  gavl_deinterlacer_cleanup_adaptive(d);
   
   switch(d->opt.deinterlace_mode)
     {
@@ -93,7 +192,14 @@ int gavl_video_deinterlacer_init(gavl_video_deinterlacer_t * d,
       if(!gavl_deinterlacer_init_blend(d))
         return 0;
       break;
+    case GAVL_DEINTERLACE_ADAPTIVE:
+      if(!gavl_deinterlacer_init_adaptive(d))
+        return 0;
+      break;
     }
+
+  if(d->band_func)
+    d->func = deinterlace_sliced;
   return 1;
   }
 
@@ -101,15 +207,23 @@ void gavl_video_deinterlacer_deinterlace(gavl_video_deinterlacer_t * d,
                                          const gavl_video_frame_t * input_frame,
                                          gavl_video_frame_t * output_frame)
   {
-  if(d->mixed)
+  int interlaced = 1;
+  
+  if(d->mixed &&
+     (input_frame->interlace_mode == GAVL_INTERLACE_NONE) &&
+     !(d->opt.conversion_flags & GAVL_FORCE_DEINTERLACE))
     {
-    if((input_frame->interlace_mode != GAVL_INTERLACE_NONE) ||
-       (d->opt.conversion_flags & GAVL_FORCE_DEINTERLACE))
-      d->func(d, input_frame, output_frame);
-    else
-      gavl_video_frame_copy(&d->format, output_frame, input_frame);
+    gavl_video_frame_copy(&d->format, output_frame, input_frame);
+    interlaced = 0;
     }
   else
     d->func(d, input_frame, output_frame);
+
+  if(d->opt.deinterlace_mode == GAVL_DEINTERLACE_ADAPTIVE)
+    gavl_deinterlacer_finish_adaptive(d, interlaced);
   }
 
+void gavl_video_deinterlacer_reset(gavl_video_deinterlacer_t * d)
+  {
+  d->have_history = 0;
+  }
@@ -0,0 +1,378 @@
+/*****************************************************************
+ * gavl - a general purpose audio/video processing library
+ *
+ * Copyright (c) 2001 - 2012 Members of the Gmerlin project
+ * gmerlin-general@lists.sourceforge.net
+ * http://gmerlin.sourceforge.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * *****************************************************************/
+
+/*
+ *  Motion adaptive deinterlacing (similar to yadif, but without
+ *  looking at the next frame so we need no delay).
+ *
+ *  The lines of the dropped field are interpolated spatially along the
+ *  best of 3 edge directions. The result is limited to the temporal
+ *  prediction (average of the missing line in the previous and the
+ *  current frame) +- the amount of motion. Without motion, this
+ *  reproduces the original line, with motion we get the spatial
+ *  interpolation.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <config.h>
+
+#include <gavl/gavl.h>
+#include <video.h>
+#include <deinterlace.h>
+#include <accel.h>
+
+#define AVG_I(a, b)  (((a) + (b) + 1) >> 1)
+#define HALF_I(a)    ((a) >> 1)
+#define ABS_I(a)     abs(a)
+
+#define AVG_F(a, b)  (((a) + (b)) * 0.5f)
+#define HALF_F(a)    ((a) * 0.5f)
+#define ABS_F(a)     fabsf(a)
+
+/* Neighbours at the left and right borders are clamped */
+
+#define FILTER_FUNCS(name, TYPE, TMP, AVG, HALF, ABS)                   \
+static void filter_line_##name(const gavl_video_deinterlace_lines_t * l, \
+                               int start, int end, int num, int a)      \
+  {                                                                     \
+  int x, xm1, xm2, xp1, xp2;                                            \
+  TMP c, e, d, diff, tmp, score, best, pred;                            \
+  const TYPE * prev       = (const TYPE *)l->prev;                      \
+  const TYPE * prev_above = (const TYPE *)l->prev_above;                \
+  const TYPE * prev_below = (const TYPE *)l->prev_below;                \
+  const TYPE * cur        = (const TYPE *)l->cur;                       \
+  const TYPE * above      = (const TYPE *)l->above;                     \
+  const TYPE * below      = (const TYPE *)l->below;                     \
+  TYPE * dst              = (TYPE *)l->dst;                             \
+                                                                        \
+  for(x = start; x < end; x++)                                          \
+    {                                                                   \
+    xm1 = (x >= a) ? x - a : x;                                         \
+    xm2 = (xm1 >= a) ? xm1 - a : xm1;                                   \
+    xp1 = (x + a < num) ? x + a : x;                                    \
+    xp2 = (xp1 + a < num) ? xp1 + a : xp1;                              \
+                                                                        \
+    c = above[x];                                                       \
+    e = below[x];                                                       \
+                                                                        \
+    /* Temporal prediction and motion */                                \
+    d = AVG((TMP)prev[x], (TMP)cur[x]);                                 \
+    diff = HALF(ABS((TMP)prev[x] - (TMP)cur[x]));                       \
+    tmp = HALF(ABS((TMP)prev_above[x] - c) + ABS((TMP)prev_below[x] - e)); \
+    if(tmp > diff)                                                      \
+      diff = tmp;                                                       \
+                                                                        \
+    /* Edge directed spatial prediction */                              \
+    best = ABS((TMP)above[xm1] - (TMP)below[xm1]) + ABS(c - e) +        \
+      ABS((TMP)above[xp1] - (TMP)below[xp1]);                           \
+    pred = AVG(c, e);                                                   \
+                                                                        \
+    score = ABS((TMP)above[xm2] - e) +                                  \
+      ABS((TMP)above[xm1] - (TMP)below[xp1]) + ABS(c - (TMP)below[xp2]); \
+    if(score < best)                                                    \
+      {                                                                 \
+      best = score;                                                     \
+      pred = AVG((TMP)above[xm1], (TMP)below[xp1]);                     \
+      }                                                                 \
+    score = ABS(c - (TMP)below[xm2]) +                                  \
+      ABS((TMP)above[xp1] - (TMP)below[xm1]) + ABS((TMP)above[xp2] - e); \
+    if(score < best)                                                    \
+      pred = AVG((TMP)above[xp1], (TMP)below[xm1]);                     \
+                                                                        \
+    if(pred > d + diff)                                                 \
+      pred = d + diff;                                                  \
+    if(pred < d - diff)                                                 \
+      pred = d - diff;                                                  \
+    dst[x] = pred;                                                      \
+    }                                                                   \
+  }                                                                     \
+                                                                        \
+static void interpolate_line_##name(const gavl_video_deinterlace_lines_t * l, \
+                                    int num)                            \
+  {                                                                     \
+  int x;                                                                \
+  const TYPE * above = (const TYPE *)l->above;                          \
+  const TYPE * below = (const TYPE *)l->below;                          \
+  TYPE * dst         = (TYPE *)l->dst;                                  \
+  for(x = 0; x < num; x++)                                              \
+    dst[x] = AVG((TMP)above[x], (TMP)below[x]);                         \
+  }
+
+FILTER_FUNCS(8, uint8_t, int, AVG_I, HALF_I, ABS_I)
+FILTER_FUNCS(16, uint16_t, int, AVG_I, HALF_I, ABS_I)
+FILTER_FUNCS(float, float, float, AVG_F, HALF_F, ABS_F)
+
+static void filter_line(gavl_video_deinterlacer_t * d,
+                        const gavl_video_deinterlace_lines_t * l, int num)
+  {
+  int x = 0;
+  int a = d->advance;
+
+  switch(d->bytes_per_sample)
+    {
+    case 1:
+      if(d->adaptive_func && (num > 4 * a))
+        {
+        filter_line_8(l, 0, 2 * a, num, a);
+        x = 2 * a + d->adaptive_func(l, 2 * a, num - 2 * a, a);
+        }
+      filter_line_8(l, x, num, num, a);
+      break;
+    case 2:
+      filter_line_16(l, 0, num, num, a);
+      break;
+    case 4:
+      filter_line_float(l, 0, num, num, a);
+      break;
+    }
+  }
+
+static void interpolate_line(gavl_video_deinterlacer_t * d,
+                             const gavl_video_deinterlace_lines_t * l, int num)
+  {
+  switch(d->bytes_per_sample)
+    {
+    case 1:
+      interpolate_line_8(l, num);
+      break;
+    case 2:
+      interpolate_line_16(l, num);
+      break;
+    case 4:
+      interpolate_line_float(l, num);
+      break;
+    }
+  }
+
+#define LINE(f, l) ((f)->planes[plane] + (l) * (f)->strides[plane])
+
+static void deinterlace_adaptive(gavl_video_deinterlacer_t * d,
+                                 const gavl_video_frame_t * input_frame,
+                                 gavl_video_frame_t * output_frame,
+                                 int plane, int start, int end)
+  {
+  int j, keep;
+  int width, height, bytes;
+  int above, below;
+  gavl_video_deinterlace_lines_t l;
+  gavl_video_frame_t * save = d->history[d->history_index];
+  gavl_video_frame_t * prev = d->history[!d->history_index];
+
+  /* Parity of the lines we keep */
+  keep = (d->opt.deinterlace_drop_mode == GAVL_DEINTERLACE_DROP_TOP) ? 1 : 0;
+
+  width = d->line_width;
+  height = d->format.image_height;
+
+  if(plane)
+    {
+    width  /= d->sub_h;
+    height /= d->sub_v;
+    }
+  bytes = width * d->bytes_per_sample;
+
+  for(j = start; j < end; j++)
+    {
+    /* Save the input for the next frame */
+    gavl_memcpy(LINE(save, j), LINE(input_frame, j), bytes);
+
+    if(((j & 1) == keep) || (height < 2))
+      {
+      gavl_memcpy(LINE(output_frame, j), LINE(input_frame, j), bytes);
+      continue;
+      }
+
+    above = (j > 0)          ? j - 1 : j + 1;
+    below = (j < height - 1) ? j + 1 : j - 1;
+
+    l.cur   = LINE(input_frame, j);
+    l.above = LINE(input_frame, above);
+    l.below = LINE(input_frame, below);
+    l.dst   = LINE(output_frame, j);
+
+    if(!d->have_history)
+      {
+      interpolate_line(d, &l, width);
+      continue;
+      }
+
+    l.prev       = LINE(prev, j);
+    l.prev_above = LINE(prev, above);
+    l.prev_below = LINE(prev, below);
+    filter_line(d, &l, width);
+    }
+  }
+
+void gavl_deinterlacer_finish_adaptive(gavl_video_deinterlacer_t * d,
+                                       int interlaced)
+  {
+  if(interlaced)
+    {
+    d->history_index = !d->history_index;
+    d->have_history = 1;
+    }
+  else
+    d->have_history = 0;
+  }
+
+void gavl_deinterlacer_cleanup_adaptive(gavl_video_deinterlacer_t * d)
+  {
+  int i;
+  for(i = 0; i < 2; i++)
+    {
+    if(d->history[i])
+      {
+      gavl_video_frame_destroy(d->history[i]);
+      d->history[i] = NULL;
+      }
+    }
+  d->have_history = 0;
+  }
+
+int gavl_deinterlacer_init_adaptive(gavl_video_deinterlacer_t * d)
+  {
+  int i;
+  gavl_video_deinterlace_adaptive_func_table_t tab;
+  memset(&tab, 0, sizeof(tab));
+
+#ifdef HAVE_SSE2
+  if(d->opt.accel_flags & GAVL_ACCEL_SSE2)
+    gavl_find_deinterlacer_adaptive_funcs_sse2(&tab, &d->opt, &d->format);
+#endif
+#ifdef HAVE_AVX2
+  if(d->opt.accel_flags & GAVL_ACCEL_AVX2)
+    gavl_find_deinterlacer_adaptive_funcs_avx2(&tab, &d->opt, &d->format);
+#endif
+
+  d->advance = 1;
+
+  switch(d->format.pixelformat)
+    {
+    case GAVL_GRAY_8:
+      d->line_width = d->format.image_width;
+      d->bytes_per_sample = 1;
+      break;
+    case GAVL_GRAY_16:
+      d->line_width = d->format.image_width;
+      d->bytes_per_sample = 2;
+      break;
+    case GAVL_GRAY_FLOAT:
+      d->line_width = d->format.image_width;
+      d->bytes_per_sample = 4;
+      break;
+    case GAVL_GRAYA_16:
+      d->line_width = 2 * d->format.image_width;
+      d->bytes_per_sample = 1;
+      d->advance = 2;
+      break;
+    case GAVL_GRAYA_32:
+      d->line_width = 2 * d->format.image_width;
+      d->bytes_per_sample = 2;
+      d->advance = 2;
+      break;
+    case GAVL_GRAYA_FLOAT:
+      d->line_width = 2 * d->format.image_width;
+      d->bytes_per_sample = 4;
+      d->advance = 2;
+      break;
+    case GAVL_RGB_24:
+    case GAVL_BGR_24:
+      d->line_width = d->format.image_width * 3;
+      d->bytes_per_sample = 1;
+      d->advance = 3;
+      break;
+    case GAVL_RGB_32:
+    case GAVL_BGR_32:
+    case GAVL_RGBA_32:
+    case GAVL_YUVA_32:
+      d->line_width = d->format.image_width * 4;
+      d->bytes_per_sample = 1;
+      d->advance = 4;
+      break;
+    case GAVL_RGB_48:
+      d->line_width = d->format.image_width * 3;
+      d->bytes_per_sample = 2;
+      d->advance = 3;
+      break;
+    case GAVL_RGB_FLOAT:
+    case GAVL_YUV_FLOAT:
+      d->line_width = d->format.image_width * 3;
+      d->bytes_per_sample = 4;
+      d->advance = 3;
+      break;
+    case GAVL_RGBA_64:
+    case GAVL_YUVA_64:
+      d->line_width = d->format.image_width * 4;
+      d->bytes_per_sample = 2;
+      d->advance = 4;
+      break;
+    case GAVL_RGBA_FLOAT:
+    case GAVL_YUVA_FLOAT:
+      d->line_width = d->format.image_width * 4;
+      d->bytes_per_sample = 4;
+      d->advance = 4;
+      break;
+    case GAVL_YUY2:
+    case GAVL_UYVY:
+      /* Chroma samples are 4 bytes apart */
+      d->line_width = d->format.image_width * 2;
+      d->bytes_per_sample = 1;
+      d->advance = 4;
+      break;
+    case GAVL_YUV_444_P_16:
+    case GAVL_YUV_422_P_16:
+      d->line_width = d->format.image_width;
+      d->bytes_per_sample = 2;
+      break;
+    case GAVL_YUV_420_P:
+    case GAVL_YUVJ_420_P:
+    case GAVL_YUV_410_P:
+    case GAVL_YUV_422_P:
+    case GAVL_YUV_411_P:
+    case GAVL_YUV_444_P:
+    case GAVL_YUVJ_422_P:
+    case GAVL_YUVJ_444_P:
+      d->line_width = d->format.image_width;
+      d->bytes_per_sample = 1;
+      break;
+    case GAVL_RGB_15:
+    case GAVL_BGR_15:
+    case GAVL_RGB_16:
+    case GAVL_BGR_16:
+    case GAVL_PIXELFORMAT_NONE:
+      return 0;
+    }
+
+  d->adaptive_func = (d->bytes_per_sample == 1) ? tab.func_8 : NULL;
+
+  for(i = 0; i < 2; i++)
+    d->history[i] = gavl_video_frame_create(&d->format);
+  d->history_index = 0;
+  d->have_history = 0;
+
+  gavl_init_memcpy();
+
+  d->band_func = deinterlace_adaptive;
+  return 1;
+  }
@@ -29,56 +29,41 @@
 #include <deinterlace.h>
 #include <accel.h>
 
+/* Each output line is (above + 2 * line + below) / 4 */
+
 static void deinterlace_blend(gavl_video_deinterlacer_t * d,
                               const gavl_video_frame_t * input_frame,
-                              gavl_video_frame_t * output_frame)
+                              gavl_video_frame_t * output_frame,
+                              int plane, int start, int end)
   {
-  int i, j;
+  int j;
   int width, height;
-  uint8_t * b, *m, *t, *dst;
+  const uint8_t * b, *m, *t;
+  uint8_t * dst;
   
   width = d->line_width;
   height = d->format.image_height;
   
-  for(i = 0; i < d->num_planes; i++)
+  if(plane)
     {
-    if(i == 1)
-      {
-      width  /= d->sub_h;
-      height /= d->sub_v;
-      }
+    width  /= d->sub_h;
+    height /= d->sub_v;
+    }
 
-    /* Top line */
+  m = input_frame->planes[plane] + start * input_frame->strides[plane];
+  dst = output_frame->planes[plane] + start * output_frame->strides[plane];
+  
+  for(j = start; j < end; j++)
+    {
+    /* The top and bottom lines have only one neighbour */
+    t = j ? m - input_frame->strides[plane] : m;
+    b = (j < height - 1) ? m + input_frame->strides[plane] : m;
     
-    t = input_frame->planes[i];
-    m = t;
-    b = m + input_frame->strides[i];
-    dst = output_frame->planes[i];
-
     d->blend_func(t, m, b, dst, width);
-
-    /* Middle lines */
-    
-    dst += output_frame->strides[i];
-
-    m += input_frame->strides[i];
-    b += input_frame->strides[i];
     
-    for(j = 1; j < height-1; j++)
-      {
-      d->blend_func(t, m, b, dst, width);
-
-      t += input_frame->strides[i];
-      m += input_frame->strides[i];
-      b += input_frame->strides[i];
-      
-      dst += output_frame->strides[i];
-      }
-    /* Bottom line */
-    b -= input_frame->strides[i];
-    d->blend_func(t, m, b, dst, width);
+    m += input_frame->strides[plane];
+    dst += output_frame->strides[plane];
     }
-  
   }
 
 int gavl_deinterlacer_init_blend(gavl_video_deinterlacer_t * d)
@@ -96,6 +81,14 @@ int gavl_deinterlacer_init_blend(gavl_video_deinterlacer_t * d)
     gavl_find_deinterlacer_blend_funcs_mmxext(&tab, &d->opt, &d->format);
 #endif
 
+#ifdef HAVE_SSE2
+  if(d->opt.accel_flags & GAVL_ACCEL_SSE2)
+    gavl_find_deinterlacer_blend_funcs_sse2(&tab, &d->opt, &d->format);
+#endif
+#ifdef HAVE_AVX2
+  if(d->opt.accel_flags & GAVL_ACCEL_AVX2)
+    gavl_find_deinterlacer_blend_funcs_avx2(&tab, &d->opt, &d->format);
+#endif
 
 #if 0 // TODO: Test 3dnow
   // #ifdef HAVE_3DNOW
@@ -202,6 +195,6 @@ int gavl_deinterlacer_init_blend(gavl_video_deinterlacer_t * d)
     return 0;
     }
   
-  d->func = deinterlace_blend;
+  d->band_func = deinterlace_blend;
   return 1;
   }
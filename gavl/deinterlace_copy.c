@@ -26,46 +26,43 @@
 #include <deinterlace.h>
 #include <accel.h>
 
+/* Each output line is copied from the line of the remaining field */
+
 static void deinterlace_copy(gavl_video_deinterlacer_t * d,
                              const gavl_video_frame_t * input_frame,
-                             gavl_video_frame_t * output_frame)
+                             gavl_video_frame_t * output_frame,
+                             int plane, int start, int end)
   {
-  int i, j, jmax;
-  int bytes;
-  uint8_t * src;
-  uint8_t * dst;
+  int j, src_line;
+  int bytes, height;
   int src_field =
     (d->opt.deinterlace_drop_mode == GAVL_DEINTERLACE_DROP_TOP) ? 1 : 0;
   
-  jmax = d->format.image_height / 2;
   bytes = d->line_width;
-
-    
-  for(i = 0; i < d->num_planes; i++)
+  height = d->format.image_height;
+  
+  if(plane)
+    {
+    bytes /= d->sub_h;
+    height /= d->sub_v;
+    }
+  
+  for(j = start; j < end; j++)
     {
-    src = input_frame->planes[i] + src_field * input_frame->strides[i];
-    dst = output_frame->planes[i];
+    src_line = (j & ~1) + src_field;
+    if(src_line >= height)
+      src_line -= 2;
     
-    if(i == 1)
-      {
-      jmax /= d->sub_v;
-      bytes /= d->sub_h;
-      }
-    for(j = 0; j < jmax; j++)
-      {
-      gavl_memcpy(dst, src, bytes);
-      dst += output_frame->strides[i];
-      gavl_memcpy(dst, src, bytes);
-      dst += output_frame->strides[i];
-      src += input_frame->strides[i] * 2;
-      }
+    gavl_memcpy(output_frame->planes[plane] + j * output_frame->strides[plane],
+                input_frame->planes[plane] + src_line * input_frame->strides[plane],
+                bytes);
     }
   }
 
 int
 gavl_deinterlacer_init_copy(gavl_video_deinterlacer_t* d)
   {
-  d->func = deinterlace_copy;
+  d->band_func = deinterlace_copy;
   d->line_width = gavl_pixelformat_is_planar(d->format.pixelformat) ?
     d->format.image_width *
     gavl_pixelformat_bytes_per_component(d->format.pixelformat) :
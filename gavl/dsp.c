@@ -49,6 +49,11 @@ static void init_table(gavl_dsp_context_t* ctx)
     gavl_dsp_init_ssse3(&ctx->funcs, ctx->quality);
 #endif       
 
+#ifdef HAVE_AVX2
+  if(ctx->accel_flags & GAVL_ACCEL_AVX2)
+    gavl_dsp_init_avx2(&ctx->funcs, ctx->quality);
+#endif       
+
   }
 
 gavl_dsp_context_t * gavl_dsp_context_create()
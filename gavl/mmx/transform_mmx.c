@@ -55,13 +55,18 @@ static mmx_t dump_tmp;
   movq_m2r(*(p), reg);    \
   psrlw_i2r(1, reg);
 
+/* Factors are saturated to 16 bit, a single factor can be 1<<15
+   if the source position is exactly on a pixel */
+
 #ifdef MMXEXT
 #define LOAD_FACTOR_X_1(f, reg) \
   movd_m2r(f, mm1); \
+  packssdw_r2r(mm1, mm1); \
   pshufw_r2r(mm1, reg, 0)
 #else
 #define LOAD_FACTOR_X_1(f, reg) \
   movd_m2r(f, mm1); \
+  packssdw_r2r(mm1, mm1); \
   movq_r2r(mm1, reg); \
   psllq_i2r(16, mm1); \
   por_r2r(mm1, reg);  \
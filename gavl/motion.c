@@ -0,0 +1,331 @@
+/*****************************************************************
+ * gavl - a general purpose audio/video processing library
+ *
+ * Copyright (c) 2001 - 2012 Members of the Gmerlin project
+ * gmerlin-general@lists.sourceforge.net
+ * http://gmerlin.sourceforge.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * *****************************************************************/
+
+/*
+ *  Block matching motion search. The candidates of one search step
+ *  (one line of the search window for the full search) are passed to
+ *  the sad_candidates_8 function at once.
+ */
+
+#include <limits.h>
+
+#include <config.h>
+
+#include <gavl/gavl.h>
+#include <gavl/gavldsp.h>
+#include <dsp.h>
+#include <video.h>
+
+/* Maximum number of candidates tested at once */
+#define MAX_CANDIDATES 64
+
+typedef struct
+  {
+  gavl_dsp_context_t * ctx;
+
+  const uint8_t * block;
+  int block_stride;
+
+  /* Reference plane at the position of the block */
+  const uint8_t * ref;
+  int ref_stride;
+
+  int w, h;
+
+  /* Range of the vectors, which keep the block inside the plane */
+  int min_x, max_x;
+  int min_y, max_y;
+
+  gavl_motion_vector_t best;
+  } search_t;
+
+static const int large_diamond[8][2] =
+  {
+    {  0, -2 }, { -1, -1 }, { 1, -1 }, { -2,  0 },
+    {  2,  0 }, { -1,  1 }, { 1,  1 }, {  0,  2 },
+  };
+
+static const int hexagon[6][2] =
+  {
+    { -2,  0 }, { -1, -2 }, { 1, -2 },
+    {  2,  0 }, {  1,  2 }, { -1, 2 },
+  };
+
+static const int small_diamond[4][2] =
+  {
+    { 0, -1 }, { -1, 0 }, { 1, 0 }, { 0, 1 },
+  };
+
+/* Test up to MAX_CANDIDATES vectors, returns 1 if a better one was found */
+
+static int test_vectors(search_t * s, const int * vx, const int * vy, int num)
+  {
+  int i, n = 0, ret = 0;
+  int offsets[MAX_CANDIDATES];
+  int index[MAX_CANDIDATES];
+  int costs[MAX_CANDIDATES];
+
+  for(i = 0; i < num; i++)
+    {
+    if((vx[i] < s->min_x) || (vx[i] > s->max_x) ||
+       (vy[i] < s->min_y) || (vy[i] > s->max_y))
+      continue;
+    offsets[n] = vy[i] * s->ref_stride + vx[i];
+    index[n] = i;
+    n++;
+    }
+
+  if(!n)
+    return 0;
+
+  s->ctx->funcs.sad_candidates_8(s->block, s->block_stride,
+                                 s->ref, s->ref_stride,
+                                 s->w, s->h, offsets, n, costs);
+
+  for(i = 0; i < n; i++)
+    {
+    if(costs[i] < s->best.cost)
+      {
+      s->best.x = vx[index[i]];
+      s->best.y = vy[index[i]];
+      s->best.cost = costs[i];
+      ret = 1;
+      }
+    }
+  return ret;
+  }
+
+static void search_full(search_t * s)
+  {
+  int x, y, n;
+  int vx[MAX_CANDIDATES];
+  int vy[MAX_CANDIDATES];
+
+  for(y = s->min_y; y <= s->max_y; y++)
+    {
+    x = s->min_x;
+    while(x <= s->max_x)
+      {
+      n = 0;
+      while((x <= s->max_x) && (n < MAX_CANDIDATES))
+        {
+        vx[n] = x++;
+        vy[n] = y;
+        n++;
+        }
+      test_vectors(s, vx, vy, n);
+      }
+    }
+  }
+
+/* Move the pattern to the best vector until the center is the best one.
+   The cost decreases with each step, so this terminates */
+
+static void search_pattern(search_t * s, const int (*pattern)[2], int num)
+  {
+  int i;
+  int vx[8];
+  int vy[8];
+
+  do
+    {
+    for(i = 0; i < num; i++)
+      {
+      vx[i] = s->best.x + pattern[i][0];
+      vy[i] = s->best.y + pattern[i][1];
+      }
+    } while(test_vectors(s, vx, vy, num));
+  }
+
+static int clip_vector(int v, int min, int max)
+  {
+  return v < min ? min : (v > max ? max : v);
+  }
+
+void gavl_dsp_sad_search(gavl_dsp_context_t * ctx,
+                         const uint8_t * cur, int cur_stride,
+                         const uint8_t * ref, int ref_stride,
+                         int width, int height,
+                         const gavl_rectangle_i_t * block,
+                         int range,
+                         gavl_motion_search_mode_t mode,
+                         gavl_motion_vector_t * mv)
+  {
+  search_t s;
+  int vx[2], vy[2];
+
+  s.ctx = ctx;
+  s.block = cur + block->y * cur_stride + block->x;
+  s.block_stride = cur_stride;
+  s.ref = ref + block->y * ref_stride + block->x;
+  s.ref_stride = ref_stride;
+  s.w = block->w;
+  s.h = block->h;
+
+  s.min_x = -range;
+  if(block->x + s.min_x < 0)
+    s.min_x = -block->x;
+  s.max_x = range;
+  if(block->x + block->w + s.max_x > width)
+    s.max_x = width - block->x - block->w;
+
+  s.min_y = -range;
+  if(block->y + s.min_y < 0)
+    s.min_y = -block->y;
+  s.max_y = range;
+  if(block->y + block->h + s.max_y > height)
+    s.max_y = height - block->y - block->h;
+
+  /* Start with the zero vector and the one passed by the caller */
+  s.best.x = 0;
+  s.best.y = 0;
+  s.best.cost = INT_MAX;
+
+  vx[0] = 0;
+  vy[0] = 0;
+  vx[1] = clip_vector(mv->x, s.min_x, s.max_x);
+  vy[1] = clip_vector(mv->y, s.min_y, s.max_y);
+  test_vectors(&s, vx, vy, (vx[1] || vy[1]) ? 2 : 1);
+
+  switch(mode)
+    {
+    case GAVL_MOTION_SEARCH_FULL:
+      search_full(&s);
+      break;
+    case GAVL_MOTION_SEARCH_DIAMOND:
+      search_pattern(&s, large_diamond, 8);
+      search_pattern(&s, small_diamond, 4);
+      break;
+    case GAVL_MOTION_SEARCH_HEXAGON:
+      search_pattern(&s, hexagon, 6);
+      search_pattern(&s, small_diamond, 4);
+      break;
+    }
+  *mv = s.best;
+  }
+
+/* Motion field */
+
+typedef struct
+  {
+  gavl_dsp_context_t * ctx;
+  const gavl_video_frame_t * cur;
+  const gavl_video_frame_t * ref;
+  int width;
+  int height;
+  int block_size;
+  int range;
+  gavl_motion_search_mode_t mode;
+
+  gavl_motion_vector_t * field;
+  int blocks_x;
+  } motion_field_t;
+
+static void motion_field_rows(void * priv, int start, int end)
+  {
+  int i, j;
+  gavl_rectangle_i_t block;
+  gavl_motion_vector_t * mv;
+  motion_field_t * m = priv;
+
+  block.w = m->block_size;
+  block.h = m->block_size;
+
+  for(i = start; i < end; i++)
+    {
+    mv = m->field + i * m->blocks_x;
+    block.y = i * m->block_size;
+
+    for(j = 0; j < m->blocks_x; j++)
+      {
+      block.x = j * m->block_size;
+
+      /* Start with the vector of the left neighbour */
+      if(j)
+        {
+        mv->x = mv[-1].x;
+        mv->y = mv[-1].y;
+        }
+      else
+        {
+        mv->x = 0;
+        mv->y = 0;
+        }
+
+      gavl_dsp_sad_search(m->ctx,
+                          m->cur->planes[0], m->cur->strides[0],
+                          m->ref->planes[0], m->ref->strides[0],
+                          m->width, m->height, &block,
+                          m->range, m->mode, mv);
+      mv++;
+      }
+    }
+  }
+
+int gavl_dsp_motion_field(gavl_dsp_context_t * ctx,
+                          const gavl_video_options_t * opt,
+                          const gavl_video_format_t * format,
+                          const gavl_video_frame_t * cur,
+                          const gavl_video_frame_t * ref,
+                          int block_size, int range,
+                          gavl_motion_search_mode_t mode,
+                          gavl_motion_vector_t * field)
+  {
+  motion_field_t m;
+  int blocks_y;
+
+  switch(format->pixelformat)
+    {
+    case GAVL_GRAY_8:
+    case GAVL_YUV_420_P:
+    case GAVL_YUV_422_P:
+    case GAVL_YUV_444_P:
+    case GAVL_YUV_411_P:
+    case GAVL_YUV_410_P:
+    case GAVL_YUVJ_420_P:
+    case GAVL_YUVJ_422_P:
+    case GAVL_YUVJ_444_P:
+      break;
+    default:
+      return 0;
+    }
+
+  if(block_size < 1)
+    return 0;
+
+  m.ctx = ctx;
+  m.cur = cur;
+  m.ref = ref;
+  m.width = format->image_width;
+  m.height = format->image_height;
+  m.block_size = block_size;
+  m.range = range;
+  m.mode = mode;
+  m.field = field;
+  m.blocks_x = format->image_width / block_size;
+  blocks_y = format->image_height / block_size;
+
+  if(opt && (opt->num_threads > 1))
+    gavl_video_run_slices(opt, motion_field_rows, &m, blocks_y);
+  else
+    motion_field_rows(&m, 0, blocks_y);
+  return 1;
+  }
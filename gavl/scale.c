@@ -48,6 +48,31 @@ void gavl_video_scaler_destroy(gavl_video_scaler_t * s)
   gavl_video_frame_destroy(s->src);
   gavl_video_frame_destroy(s->dst);
 
+  for(i = 0; i < 2; i++)
+    {
+    if(s->src_field[i])
+      {
+      gavl_video_frame_null(s->src_field[i]);
+      gavl_video_frame_destroy(s->src_field[i]);
+      }
+    if(s->dst_field[i])
+      {
+      gavl_video_frame_null(s->dst_field[i]);
+      gavl_video_frame_destroy(s->dst_field[i]);
+      }
+    }
+  if(s->threads)
+    free(s->threads);
+
+  for(i = 0; i < s->outputs_alloc; i++)
+    gavl_video_scaler_destroy(s->outputs[i]);
+  if(s->outputs)
+    {
+    free(s->outputs);
+    free(s->output_src);
+    free(s->output_order);
+    }
+
   for(i = 0; i < 3; i++)
     {
     for(j = 0; j < GAVL_MAX_PLANES; j++)
@@ -144,7 +169,14 @@ void gavl_init_scale_funcs(gavl_scale_funcs_t * tab,
       if((opt->quality < 3) && (opt->accel_flags & GAVL_ACCEL_SSE2))
         {
         gavl_init_scale_funcs_bilinear_y_sse2(tab, src_advance, dst_advance);
-        //        gavl_init_scale_funcs_bilinear_x_sse2(tab, src_advance, dst_advance);
+        gavl_init_scale_funcs_bilinear_x_sse2(tab, src_advance, dst_advance);
+        }
+#endif
+#ifdef HAVE_AVX2
+      if((opt->quality < 3) && (opt->accel_flags & GAVL_ACCEL_AVX2))
+        {
+        gavl_init_scale_funcs_bilinear_y_avx2(tab, src_advance, dst_advance);
+        gavl_init_scale_funcs_bilinear_x_avx2(tab, src_advance, dst_advance);
         }
 #endif
       break;
@@ -179,7 +211,14 @@ void gavl_init_scale_funcs(gavl_scale_funcs_t * tab,
       if((opt->quality < 3) && (opt->accel_flags & GAVL_ACCEL_SSE2))
         {
         gavl_init_scale_funcs_quadratic_y_sse2(tab, src_advance, dst_advance);
-        //        gavl_init_scale_funcs_quadratic_x_sse2(tab, src_advance, dst_advance);
+        gavl_init_scale_funcs_quadratic_x_sse2(tab, src_advance, dst_advance);
+        }
+#endif
+#ifdef HAVE_AVX2
+      if((opt->quality < 3) && (opt->accel_flags & GAVL_ACCEL_AVX2))
+        {
+        gavl_init_scale_funcs_quadratic_y_avx2(tab, src_advance, dst_advance);
+        gavl_init_scale_funcs_quadratic_x_avx2(tab, src_advance, dst_advance);
         }
 #endif
       break;
@@ -211,7 +250,7 @@ void gavl_init_scale_funcs(gavl_scale_funcs_t * tab,
         if((opt->quality < 3) && (opt->accel_flags & GAVL_ACCEL_SSE2))
           {
           gavl_init_scale_funcs_bicubic_y_noclip_sse2(tab, src_advance, dst_advance);
-          //        gavl_init_scale_funcs_bicubic_x_sse2(tab, src_advance, dst_advance);
+          gavl_init_scale_funcs_bicubic_x_sse2(tab, src_advance, dst_advance);
           }
 #endif
 #ifdef HAVE_SSE3
@@ -219,6 +258,13 @@ void gavl_init_scale_funcs(gavl_scale_funcs_t * tab,
           {
           gavl_init_scale_funcs_bicubic_x_noclip_sse3(tab);
           }
+#endif
+#ifdef HAVE_AVX2
+        if((opt->quality < 3) && (opt->accel_flags & GAVL_ACCEL_AVX2))
+          {
+          gavl_init_scale_funcs_bicubic_y_avx2(tab, src_advance, dst_advance);
+          gavl_init_scale_funcs_bicubic_x_avx2(tab, src_advance, dst_advance);
+          }
 #endif
         }
       else
@@ -248,7 +294,7 @@ void gavl_init_scale_funcs(gavl_scale_funcs_t * tab,
         if((opt->quality < 3) && (opt->accel_flags & GAVL_ACCEL_SSE2))
           {
           gavl_init_scale_funcs_bicubic_y_sse2(tab, src_advance, dst_advance);
-          //        gavl_init_scale_funcs_bicubic_x_sse2(tab, src_advance, dst_advance);
+          gavl_init_scale_funcs_bicubic_x_sse2(tab, src_advance, dst_advance);
           }
 #endif
 #ifdef HAVE_SSE3
@@ -256,6 +302,13 @@ void gavl_init_scale_funcs(gavl_scale_funcs_t * tab,
           {
           gavl_init_scale_funcs_bicubic_x_sse3(tab);
           }
+#endif
+#ifdef HAVE_AVX2
+        if((opt->quality < 3) && (opt->accel_flags & GAVL_ACCEL_AVX2))
+          {
+          gavl_init_scale_funcs_bicubic_y_avx2(tab, src_advance, dst_advance);
+          gavl_init_scale_funcs_bicubic_x_avx2(tab, src_advance, dst_advance);
+          }
 #endif
         }
       break;
@@ -285,7 +338,7 @@ void gavl_init_scale_funcs(gavl_scale_funcs_t * tab,
       if((opt->quality < 3) && (opt->accel_flags & GAVL_ACCEL_SSE2))
         {
         gavl_init_scale_funcs_generic_y_sse2(tab, src_advance, dst_advance);
-        //        gavl_init_scale_funcs_generic_x_sse2(tab, src_advance, dst_advance);
+        gavl_init_scale_funcs_generic_x_sse2(tab, src_advance, dst_advance);
         }
 #endif
 #ifdef HAVE_SSE3
@@ -293,6 +346,13 @@ void gavl_init_scale_funcs(gavl_scale_funcs_t * tab,
         {
         gavl_init_scale_funcs_generic_x_sse3(tab);
         }
+#endif
+#ifdef HAVE_AVX2
+      if((opt->quality < 3) && (opt->accel_flags & GAVL_ACCEL_AVX2))
+        {
+        gavl_init_scale_funcs_generic_y_avx2(tab, src_advance, dst_advance);
+        gavl_init_scale_funcs_generic_x_avx2(tab, src_advance, dst_advance);
+        }
 #endif
       break;
     }
@@ -409,11 +469,17 @@ int gavl_video_scaler_init(gavl_video_scaler_t * scaler,
   else
     scaler->num_planes = gavl_pixelformat_num_planes(scaler->src_format.pixelformat);
   
-  if((scaler->src_fields == 2) && (!scaler->src_field))
-    scaler->src_field = gavl_video_frame_create(NULL);
+  if((scaler->src_fields == 2) && (!scaler->src_field[0]))
+    {
+    scaler->src_field[0] = gavl_video_frame_create(NULL);
+    scaler->src_field[1] = gavl_video_frame_create(NULL);
+    }
   
-  if((scaler->dst_fields == 2) && (!scaler->dst_field))
-    scaler->dst_field = gavl_video_frame_create(NULL);
+  if((scaler->dst_fields == 2) && (!scaler->dst_field[0]))
+    {
+    scaler->dst_field[0] = gavl_video_frame_create(NULL);
+    scaler->dst_field[1] = gavl_video_frame_create(NULL);
+    }
   
   
 #if 0
@@ -538,11 +604,17 @@ int gavl_video_scaler_init_convolve(gavl_video_scaler_t * scaler,
     scaler->num_planes = 
       gavl_pixelformat_num_planes(scaler->src_format.pixelformat);
   
-  if((scaler->src_fields == 2) && (!scaler->src_field))
-    scaler->src_field = gavl_video_frame_create(NULL);
+  if((scaler->src_fields == 2) && (!scaler->src_field[0]))
+    {
+    scaler->src_field[0] = gavl_video_frame_create(NULL);
+    scaler->src_field[1] = gavl_video_frame_create(NULL);
+    }
   
-  if((scaler->dst_fields == 2) && (!scaler->dst_field))
-    scaler->dst_field = gavl_video_frame_create(NULL);
+  if((scaler->dst_fields == 2) && (!scaler->dst_field[0]))
+    {
+    scaler->dst_field[0] = gavl_video_frame_create(NULL);
+    scaler->dst_field[1] = gavl_video_frame_create(NULL);
+    }
   
   /* Now, initialize all fields and planes */
   
@@ -581,11 +653,134 @@ gavl_video_scaler_get_options(gavl_video_scaler_t * s)
   return &s->opt;
   }
 
+/*
+ *  Multithreaded scaling: All planes (and fields) of a frame are
+ *  collected as jobs and scaled in one parallel run. The destination
+ *  rows of all jobs are distributed among the threads according to
+ *  their width, so each thread gets roughly the same number of pixels.
+ */
+
+static void scale_thread_func(void * data, int start, int end)
+  {
+  int i, first, last, h;
+  gavl_video_scale_job_t * job;
+  gavl_video_scaler_thread_t * t = data;
+  gavl_video_scaler_t * s = t->s;
+
+  for(i = 0; i < s->num_jobs; i++)
+    {
+    job = &s->jobs[i];
+    h = job->ctx->dst_rect.h;
+    
+    /* A row belongs to the thread, whose range contains its start */
+    if(start <= job->offset)
+      first = 0;
+    else
+      first = (start - job->offset + job->row_cost - 1) / job->row_cost;
+
+    if(end <= job->offset)
+      last = 0;
+    else
+      last = (end - job->offset + job->row_cost - 1) / job->row_cost;
+
+    if(first > h)
+      first = h;
+    if(last > h)
+      last = h;
+    
+    if(first < last)
+      gavl_video_scale_context_scale_rows(job->ctx, job->dst,
+                                          first, last, t->thread);
+    }
+  }
+
+static void flush_jobs(gavl_video_scaler_t * s)
+  {
+  int i, nt, total;
+  
+  if(!s->num_jobs)
+    return;
+
+  total = s->jobs[s->num_jobs-1].offset +
+    s->jobs[s->num_jobs-1].row_cost * s->jobs[s->num_jobs-1].ctx->dst_rect.h;
+  
+  nt = s->opt.num_threads;
+  if(nt > total)
+    nt = total;
+  
+  if(s->num_threads < nt)
+    {
+    s->threads = realloc(s->threads, nt * sizeof(*s->threads));
+    s->num_threads = nt;
+    }
+  
+  for(i = 0; i < nt; i++)
+    {
+    s->threads[i].s = s;
+    s->threads[i].thread = i;
+    s->opt.run_func(scale_thread_func, &s->threads[i],
+                    (int)(((int64_t)total * i) / nt),
+                    (int)(((int64_t)total * (i+1)) / nt),
+                    s->opt.run_data, i);
+    }
+  for(i = 0; i < nt; i++)
+    s->opt.stop_func(s->opt.stop_data, i);
+  
+  s->num_jobs = 0;
+  }
+
+static void scale_planes(gavl_video_scaler_t * s,
+                         gavl_video_scale_context_t * contexts,
+                         const gavl_video_frame_t * src,
+                         gavl_video_frame_t * dst)
+  {
+  int i, j;
+  gavl_video_scale_job_t * job;
+  
+  if(s->opt.num_threads < 2)
+    {
+    for(i = 0; i < s->num_planes; i++)
+      gavl_video_scale_context_scale(&contexts[i], src, dst);
+    return;
+    }
+  
+  for(i = 0; i < s->num_planes; i++)
+    {
+    if(!contexts[i].dst_rect.w || !contexts[i].dst_rect.h)
+      continue;
+    
+    /* Contexts of packed formats write into the same plane, which
+       isn't done concurrently */
+    for(j = 0; j < s->num_jobs; j++)
+      {
+      if(s->jobs[j].dst->planes[s->jobs[j].ctx->dst_frame_plane] ==
+         dst->planes[contexts[i].dst_frame_plane])
+        {
+        flush_jobs(s);
+        break;
+        }
+      }
+    
+    gavl_video_scale_context_scale_init(&contexts[i], src);
+
+    job = &s->jobs[s->num_jobs];
+    job->ctx = &contexts[i];
+    job->dst = dst;
+    job->row_cost = contexts[i].dst_rect.w;
+    
+    if(s->num_jobs)
+      job->offset = job[-1].offset + job[-1].row_cost * job[-1].ctx->dst_rect.h;
+    else
+      job->offset = 0;
+    s->num_jobs++;
+    }
+  }
+
 void gavl_video_scaler_scale(gavl_video_scaler_t * s,
                              const gavl_video_frame_t * src,
                              gavl_video_frame_t * dst)
   {
-  int i, field;
+  int field;
   /* Set the destination subframe */
   gavl_video_frame_get_subframe(s->dst_format.pixelformat, dst, s->dst, 
                                 &s->dst_rect);
@@ -601,18 +796,14 @@ void gavl_video_scaler_scale(gavl_video_scaler_t * s,
        (src->interlace_mode == GAVL_INTERLACE_NONE) &&
        !(s->opt.conversion_flags & GAVL_FORCE_DEINTERLACE))
       {
-      for(i = 0; i < s->num_planes; i++)
-        gavl_video_scale_context_scale(&s->contexts[2][i], src, s->dst);
+      scale_planes(s, s->contexts[2], src, s->dst);
       }
     else /* Deinterlace mode */
       {
       field = (s->opt.deinterlace_drop_mode == GAVL_DEINTERLACE_DROP_BOTTOM) ? 0 : 1;
       gavl_video_frame_get_field(s->src_format.pixelformat, src, 
-                                 s->src_field, field);
-      
-      for(i = 0; i < s->num_planes; i++)
-        gavl_video_scale_context_scale(&s->contexts[field][i], 
-                                       s->src_field, s->dst);
+                                 s->src_field[0], field);
+      scale_planes(s, s->contexts[field], s->src_field[0], s->dst);
       }
     }
   else if(s->src_fields == 2)
@@ -622,37 +813,189 @@ void gavl_video_scaler_scale(gavl_video_scaler_t * s,
        (src->interlace_mode == GAVL_INTERLACE_NONE) &&
        !(s->opt.conversion_flags & GAVL_FORCE_DEINTERLACE))
       {
-      for(i = 0; i < s->num_planes; i++)
-        gavl_video_scale_context_scale(&s->contexts[2][i], src, s->dst);
+      scale_planes(s, s->contexts[2], src, s->dst);
       }
     else
       {
-      /* First field */
-      gavl_video_frame_get_field(s->src_format.pixelformat, src,    s->src_field, 0);
-      gavl_video_frame_get_field(s->dst_format.pixelformat, s->dst, s->dst_field, 0);
-      for(i = 0; i < s->num_planes; i++)
+      /* Both fields are independent */
+      for(field = 0; field < 2; field++)
         {
-        //      fprintf(stderr, "Field: 0, plane: %d\n", i);
-        gavl_video_scale_context_scale(&s->contexts[0][i], s->src_field, s->dst_field);
+        gavl_video_frame_get_field(s->src_format.pixelformat, src,
+                                   s->src_field[field], field);
+        gavl_video_frame_get_field(s->dst_format.pixelformat, s->dst,
+                                   s->dst_field[field], field);
+        scale_planes(s, s->contexts[field],
+                     s->src_field[field], s->dst_field[field]);
         }
-      
-      /* Second field */
-      gavl_video_frame_get_field(s->src_format.pixelformat, src,    s->src_field, 1);
-      gavl_video_frame_get_field(s->dst_format.pixelformat, s->dst, s->dst_field, 1);
-      for(i = 0; i < s->num_planes; i++)
+      }
+    }
+  else
+    scale_planes(s, s->contexts[0], src, s->dst);
+
+  flush_jobs(s);
+  }
+
+/*
+ *  Multiple outputs: Each output has its own scaler. The outputs are
+ *  processed from the largest to the smallest and if the quality allows
+ *  it, the smaller ones are scaled from the smallest already finished
+ *  output, which is at least as large. This reduces the filter sizes
+ *  and the number of reads from the large source image.
+ */
+
+int gavl_video_scaler_init_multi(gavl_video_scaler_t * s,
+                                 const gavl_video_format_t * src_format,
+                                 const gavl_video_format_t * dst_formats,
+                                 int num_outputs)
+  {
+  int i, j, k, tmp, cascade;
+  const gavl_video_format_t * p;
+  gavl_video_options_t * opt;
+
+  s->num_outputs = 0;
+
+  /* Outputs can be scaled from each other only with the
+     same pixelformat */
+  for(i = 0; i < num_outputs; i++)
+    {
+    if(dst_formats[i].pixelformat != src_format->pixelformat)
+      return 0;
+    }
+  
+  if(num_outputs > s->outputs_alloc)
+    {
+    s->outputs = realloc(s->outputs, num_outputs * sizeof(*s->outputs));
+    s->output_src = realloc(s->output_src, num_outputs * sizeof(*s->output_src));
+    s->output_order = realloc(s->output_order,
+                              num_outputs * sizeof(*s->output_order));
+    
+    for(i = s->outputs_alloc; i < num_outputs; i++)
+      s->outputs[i] = gavl_video_scaler_create();
+    s->outputs_alloc = num_outputs;
+    }
+
+  /* Sort by image size */
+  for(i = 0; i < num_outputs; i++)
+    {
+    s->output_order[i] = i;
+    for(j = i; j > 0; j--)
+      {
+      if(dst_formats[s->output_order[j]].image_width *
+         dst_formats[s->output_order[j]].image_height <=
+         dst_formats[s->output_order[j-1]].image_width *
+         dst_formats[s->output_order[j-1]].image_height)
+        break;
+      tmp = s->output_order[j];
+      s->output_order[j] = s->output_order[j-1];
+      s->output_order[j-1] = tmp;
+      }
+    }
+
+  /* Scaling twice is allowed unless the quality is high. Interlaced
+     outputs would need deinterlacing in between. */
+  cascade = (s->opt.quality <= GAVL_QUALITY_DEFAULT) &&
+    (src_format->interlace_mode == GAVL_INTERLACE_NONE);
+  
+  for(k = 0; k < num_outputs; k++)
+    {
+    i = s->output_order[k];
+    s->output_src[i] = -1;
+
+    if(cascade && (dst_formats[i].interlace_mode == GAVL_INTERLACE_NONE))
+      {
+      for(j = k - 1; j >= 0; j--)
         {
-        //      fprintf(stderr, "Field: 1, plane: %d\n", i);
-        gavl_video_scale_context_scale(&s->contexts[1][i], s->src_field, s->dst_field);
+        p = &dst_formats[s->output_order[j]];
+        if((p->image_width >= dst_formats[i].image_width) &&
+           (p->image_height >= dst_formats[i].image_height) &&
+           (p->interlace_mode == GAVL_INTERLACE_NONE))
+          {
+          s->output_src[i] = s->output_order[j];
+          break;
+          }
         }
       }
+
+    /* Outputs always cover the whole image */
+    opt = gavl_video_scaler_get_options(s->outputs[i]);
+    gavl_video_options_copy(opt, &s->opt);
+    gavl_video_options_set_rectangles(opt, NULL, NULL);
+    
+    if(!gavl_video_scaler_init(s->outputs[i],
+                               (s->output_src[i] < 0) ? src_format :
+                               &dst_formats[s->output_src[i]],
+                               &dst_formats[i]))
+      return 0;
     }
-  else
+  s->num_outputs = num_outputs;
+  return 1;
+  }
+
+void gavl_video_scaler_scale_multi(gavl_video_scaler_t * s,
+                                   const gavl_video_frame_t * src,
+                                   gavl_video_frame_t ** dst)
+  {
+  int i, k;
+  
+  for(k = 0; k < s->num_outputs; k++)
     {
-    for(i = 0; i < s->num_planes; i++)
+    i = s->output_order[k];
+    gavl_video_scaler_scale(s->outputs[i],
+                            (s->output_src[i] < 0) ? src :
+                            dst[s->output_src[i]], dst[i]);
+    }
+  }
+
+int gavl_video_scaler_can_scale_band(gavl_video_scaler_t * s)
+  {
+  /* We need progressive scaling and the whole destination
+     image must be written */
+  if((s->src_fields != 1) || (s->dst_fields != 1))
+    return 0;
+
+  if(s->dst_rect.x || s->dst_rect.y ||
+     (s->dst_rect.w != s->dst_format.image_width) ||
+     (s->dst_rect.h != s->dst_format.image_height))
+    return 0;
+  return 1;
+  }
+
+void gavl_video_scaler_scale_band_init(gavl_video_scaler_t * s,
+                                       const gavl_video_frame_t * src)
+  {
+  int i;
+  for(i = 0; i < s->num_planes; i++)
+    gavl_video_scale_context_scale_init(&s->contexts[0][i], src);
+  }
+
+void gavl_video_scaler_scale_band(gavl_video_scaler_t * s,
+                                  gavl_video_frame_t * dst,
+                                  int y, int h, int thread)
+  {
+  int i;
+  int start, end;
+  int sub_h, sub_v;
+  gavl_video_scale_context_t * ctx;
+  
+  gavl_pixelformat_chroma_sub(s->dst_format.pixelformat, &sub_h, &sub_v);
+  
+  for(i = 0; i < s->num_planes; i++)
+    {
+    ctx = &s->contexts[0][i];
+
+    if(i && gavl_pixelformat_is_planar(s->dst_format.pixelformat))
       {
-      //      fprintf(stderr, "Scale %d, %p\n", i, &s->contexts[0][i]);
-      //      fprintf(stderr, "Field: 0 (progressive), plane: %d\n", i);
-      gavl_video_scale_context_scale(&s->contexts[0][i], src, s->dst);
+      start = y / sub_v;
+      end = (y + h) / sub_v;
       }
+    else
+      {
+      start = y;
+      end = y + h;
+      }
+    if(end > ctx->dst_rect.h)
+      end = ctx->dst_rect.h;
+    
+    gavl_video_scale_context_scale_band(ctx, dst, start, end, thread);
     }
   }
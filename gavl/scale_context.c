@@ -300,9 +300,16 @@ static void get_minmax(gavl_pixelformat_t pixelformat,
     }
   }
 
-static void alloc_temp(gavl_video_scale_context_t * ctx, gavl_pixelformat_t pixelformat)
+/* Number of destination rows, which are processed at once in the
+   second pass */
+
+#define WINDOW_CHUNK 16
+
+static void init_temp(gavl_video_scale_context_t * ctx, gavl_pixelformat_t pixelformat)
   {
-  int size;
+  int i, last, rows;
+  const gavl_video_scale_pixel_t * pixels;
+  
   if((pixelformat == GAVL_YUY2) || (pixelformat == GAVL_UYVY))
     ctx->buffer_stride = ctx->buffer_width;
   else if(gavl_pixelformat_is_planar(pixelformat))
@@ -314,14 +321,63 @@ static void alloc_temp(gavl_video_scale_context_t * ctx, gavl_pixelformat_t pixe
   
   ALIGN(ctx->buffer_stride);
 
-  size = ctx->buffer_stride * ctx->buffer_height;
+  if(ctx->vertical_first)
+    {
+    /* The first pass produces exactly the rows of one chunk */
+    ctx->window_rows = WINDOW_CHUNK;
+    }
+  else
+    {
+    /* Maximum number of source rows needed for one chunk */
+    pixels = ctx->table_v.pixels;
+    ctx->window_rows = 0;
+    
+    for(i = 0; i < ctx->dst_rect.h; i++)
+      {
+      last = i + WINDOW_CHUNK - 1;
+      if(last >= ctx->dst_rect.h)
+        last = ctx->dst_rect.h - 1;
+      rows = pixels[last].index + ctx->table_v.factors_per_pixel -
+        pixels[i].index;
+      if(rows > ctx->window_rows)
+        ctx->window_rows = rows;
+      }
+    }
+  if(ctx->window_rows > ctx->buffer_height)
+    ctx->window_rows = ctx->buffer_height;
+  }
+
+/* Make sure, that we have num windows with buffers and reset them */
 
-  if(ctx->buffer_alloc < size)
+static void init_windows(gavl_video_scale_context_t * ctx, int num)
+  {
+  int i, size;
+  gavl_video_scale_window_t * win;
+  
+  if(num > ctx->num_windows)
     {
-    if(ctx->buffer)
-      free(ctx->buffer);
-    ctx->buffer_alloc = size + 8192;
-    ctx->buffer = gavl_memalign(ALIGNMENT_BYTES, ctx->buffer_alloc);
+    ctx->windows = realloc(ctx->windows, num * sizeof(*ctx->windows));
+    memset(ctx->windows + ctx->num_windows, 0,
+           (num - ctx->num_windows) * sizeof(*ctx->windows));
+    ctx->num_windows = num;
+    }
+
+  size = ctx->buffer_stride * ctx->window_rows;
+  
+  for(i = 0; i < num; i++)
+    {
+    win = &ctx->windows[i];
+    win->ctx = ctx;
+    win->first_row = 0;
+    win->last_row = 0;
+    
+    if(win->buffer_alloc < size)
+      {
+      if(win->buffer)
+        free(win->buffer);
+      win->buffer_alloc = size + 8192;
+      win->buffer = gavl_memalign(ALIGNMENT_BYTES, win->buffer_alloc);
+      }
     }
   }
 
@@ -700,6 +756,7 @@ int gavl_video_scale_context_init(gavl_video_scale_context_t*ctx,
 
         ctx->buffer_width  = ctx->dst_rect.w;
         ctx->buffer_height = src_rect_i.h;
+        ctx->vertical_first = 0;
         
         gavl_video_scale_table_shift_indices(&ctx->table_v, -src_rect_i.y);
         ctx->first_scanline = src_rect_i.y;
@@ -729,6 +786,7 @@ int gavl_video_scale_context_init(gavl_video_scale_context_t*ctx,
 
         ctx->buffer_width = src_rect_i.w;
         ctx->buffer_height = ctx->dst_rect.h;
+        ctx->vertical_first = 1;
         
         ctx->offset1.src_offset += src_rect_i.x * ctx->offset1.src_advance;
         
@@ -753,8 +811,8 @@ int gavl_video_scale_context_init(gavl_video_scale_context_t*ctx,
           gavl_video_scale_table_init_int(&ctx->table_h, bits_h);
         }
       
-      /* Allocate temporary buffer */
-      alloc_temp(ctx, src_format->pixelformat);
+      /* Initialize intermediate buffer */
+      init_temp(ctx, src_format->pixelformat);
       }
     }
   else if(scale_x)
@@ -1160,6 +1218,7 @@ gavl_video_scale_context_init_convolve(gavl_video_scale_context_t* ctx,
       
       ctx->buffer_width  = ctx->dst_rect.w;
       ctx->buffer_height = src_rect_i.h;
+      ctx->vertical_first = 0;
         
       gavl_video_scale_table_shift_indices(&ctx->table_v,
                                            -src_rect_i.y);
@@ -1180,8 +1239,8 @@ gavl_video_scale_context_init_convolve(gavl_video_scale_context_t* ctx,
 
       gavl_video_scale_table_init_int(&ctx->table_v, bits_v);
      
-      /* Allocate temporary buffer */
-      alloc_temp(ctx, format->pixelformat);
+      /* Initialize intermediate buffer */
+      init_temp(ctx, format->pixelformat);
       }
     }
   else if(scale_x)
@@ -1243,267 +1302,181 @@ gavl_video_scale_context_init_convolve(gavl_video_scale_context_t* ctx,
 
 void gavl_video_scale_context_cleanup(gavl_video_scale_context_t * ctx)
   {
+  int i;
   gavl_video_scale_table_cleanup(&ctx->table_h);
   gavl_video_scale_table_cleanup(&ctx->table_v);
-  if(ctx->buffer)
-    free(ctx->buffer);
-  }
-
-static void func_1(void* p, int start, int end)
-  {
-  int i;
-  uint8_t * dst_save;
-  
-  gavl_video_scale_context_t * ctx = p;
 
-  dst_save = ctx->dst_frame->planes[ctx->dst_frame_plane] + ctx->offset->dst_offset +
-    start * ctx->dst_frame->strides[ctx->dst_frame_plane];
-
-  for(i = start; i < end; i++)
+  for(i = 0; i < ctx->num_windows; i++)
     {
-    ctx->func1(ctx, i, dst_save);
-    dst_save += ctx->dst_frame->strides[ctx->dst_frame_plane];
+    if(ctx->windows[i].buffer)
+      free(ctx->windows[i].buffer);
     }
-#ifdef HAVE_MMX
-  __asm__ __volatile__ ("emms");
-#endif
-
+  if(ctx->windows)
+    free(ctx->windows);
   }
 
-static void func_1_of_2(void* p, int start, int end)
+/*
+ *  Scale the destination rows start...end-1 in 2 directions. The first
+ *  pass only produces the intermediate rows needed for the next
+ *  WINDOW_CHUNK destination rows. The scanline functions take their source
+ *  from the context, so we work on a private copy.
+ */
+
+static void scale_rows_2(gavl_video_scale_context_t * ctx,
+                         gavl_video_scale_window_t * win,
+                         uint8_t * dst, int dst_stride,
+                         int start, int end)
   {
-  int i;
-  uint8_t * dst_save;
-  gavl_video_scale_context_t * ctx = p;
+  int i, j, n;
+  int first, last;
+  gavl_video_scale_context_t c;
   
-  dst_save = ctx->buffer + start * ctx->buffer_stride;
-  for(i = start; i < end; i++)
-    {
-    ctx->func1(ctx, i, dst_save);
-    dst_save += ctx->buffer_stride;
-    }
-#ifdef HAVE_MMX
-  __asm__ __volatile__ ("emms");
-#endif
+  memcpy(&c, ctx, sizeof(c));
   
-  }
-
-static void func_2_of_2(void* p, int start, int end)
-  {
-  int i;
-  uint8_t * dst_save;
-  gavl_video_scale_context_t * ctx = p;
-  dst_save =
-    ctx->dst_frame->planes[ctx->dst_frame_plane] + ctx->offset->dst_offset +
-    start * ctx->dst_frame->strides[ctx->dst_frame_plane];
-
-  for(i = start; i < end; i++)
+  for(i = start; i < end; i += n)
     {
-    ctx->func2(ctx, i, dst_save);
-    dst_save += ctx->dst_frame->strides[ctx->dst_frame_plane];
-    }
-#ifdef HAVE_MMX
-  __asm__ __volatile__ ("emms");
-#endif
-  }
-
-
-static void scale_context_scale_mt(gavl_video_scale_context_t * ctx,
-                                   const gavl_video_frame_t * src,
-                                   gavl_video_frame_t * dst)
-  {
-  int delta;
-  int scanline;
-  int nt;
-  int i;
-  switch(ctx->num_directions)
-    {
-    case 1:
-      /* Only step */
-      ctx->src = src->planes[ctx->src_frame_plane] + ctx->offset->src_offset;
-      ctx->src_stride = src->strides[ctx->src_frame_plane];
-      ctx->dst_frame = dst;
-      
-      nt = ctx->opt->num_threads;
-      if(nt > ctx->dst_rect.h)
-        nt = ctx->dst_rect.h;
+    n = end - i;
+    if(n > WINDOW_CHUNK)
+      n = WINDOW_CHUNK;
+
+    /* First pass */
+    c.offset = &c.offset1;
+    c.src = ctx->src;
+    c.src_stride = ctx->src_stride;
+    c.dst_size = ctx->buffer_width;
+    
+    if(ctx->vertical_first)
+      {
+      for(j = 0; j < n; j++)
+        c.func1(&c, i + j, win->buffer + j * ctx->buffer_stride);
+      win->first_row = i;
+      }
+    else
+      {
+      first = ctx->table_v.pixels[i].index;
+      last = ctx->table_v.pixels[i + n - 1].index +
+        ctx->table_v.factors_per_pixel;
+      if(last > ctx->buffer_height)
+        last = ctx->buffer_height;
       
-      delta = ctx->dst_rect.h / nt;
-      scanline = 0;
-      for(i = 0; i < nt - 1; i++)
+      if((first < win->first_row) || (first > win->last_row))
         {
-        ctx->opt->run_func(func_1, ctx, scanline, scanline+delta, ctx->opt->run_data, i);
-        
-        //        fprintf(stderr, "scanline: %d (%d)\n", ctx->scanline, ctx->dst_rect.h);
-        scanline += delta;
+        /* Nothing to reuse */
+        win->first_row = first;
+        win->last_row = first;
         }
-      ctx->opt->run_func(func_1, ctx, scanline, ctx->dst_rect.h, ctx->opt->run_data, nt - 1);
-      
-      for(i = 0; i < nt; i++)
-        ctx->opt->stop_func(ctx->opt->stop_data, i);
-      break;
-    case 2:
-      /* First step */
-      ctx->offset = &ctx->offset1;
-      
-      ctx->src = src->planes[ctx->src_frame_plane] +
-        ctx->offset->src_offset +
-        src->strides[ctx->src_frame_plane] * ctx->first_scanline;
-      
-      ctx->src_stride = src->strides[ctx->src_frame_plane];
-      ctx->dst_size = ctx->buffer_width;
-
-#if 0
-      fprintf(stderr, "First direction\n");
-      dump_offset(ctx->offset);
-#endif
-
-      nt = ctx->opt->num_threads;
-      if(nt > ctx->buffer_height)
-        nt = ctx->buffer_height;
-
-      delta = ctx->buffer_height / nt;
-      scanline = 0;
-      for(i = 0; i < nt - 1; i++)
+      else if(last - win->first_row > ctx->window_rows)
         {
-        ctx->opt->run_func(func_1_of_2, ctx, scanline, scanline+delta, ctx->opt->run_data, i);
-        
-        //        fprintf(stderr, "scanline: %d (%d)\n", ctx->scanline, ctx->dst_rect.h);
-        scanline += delta;
+        /* Move the rows we still need to the start of the buffer */
+        memmove(win->buffer,
+                win->buffer + (first - win->first_row) * ctx->buffer_stride,
+                (win->last_row - first) * ctx->buffer_stride);
+        win->first_row = first;
         }
-      ctx->opt->run_func(func_1_of_2, ctx, scanline, ctx->buffer_height,
-                         ctx->opt->run_data, nt - 1);
       
-      for(i = 0; i < nt; i++)
-        ctx->opt->stop_func(ctx->opt->stop_data, i);
+      for(j = win->last_row; j < last; j++)
+        c.func1(&c, j, win->buffer +
+                (j - win->first_row) * ctx->buffer_stride);
       
-      //      fprintf(stderr, "done\n");
-
-      /* Second step */
-      ctx->offset = &ctx->offset2;
-#if 0
-      fprintf(stderr, "Second direction\n");
-      dump_offset(ctx->offset);
-#endif
-      ctx->src = ctx->buffer;
-      ctx->src_stride = ctx->buffer_stride;
-      ctx->dst_size = ctx->dst_rect.w;
-      ctx->dst_frame = dst;
-      
-      nt = ctx->opt->num_threads;
-      if(nt > ctx->dst_rect.h)
-        nt = ctx->dst_rect.h;
-      
-      delta = ctx->dst_rect.h / nt;
+      if(last > win->last_row)
+        win->last_row = last;
+      }
 
-      scanline = 0;
-      for(i = 0; i < nt - 1; i++)
-        {
-        ctx->opt->run_func(func_2_of_2, ctx, scanline, scanline+delta, ctx->opt->run_data, i);
-        
-        //        fprintf(stderr, "scanline: %d (%d)\n", ctx->scanline, ctx->dst_rect.h);
-        scanline += delta;
-        }
-      ctx->opt->run_func(func_2_of_2, ctx, scanline, ctx->dst_rect.h,
-                         ctx->opt->run_data, nt - 1);
-      
-      for(i = 0; i < nt; i++)
-        ctx->opt->stop_func(ctx->opt->stop_data, i);
-      //      fprintf(stderr, "done\n");
-      break;
+    /* Second pass */
+    c.offset = &c.offset2;
+    c.src = win->buffer - win->first_row * ctx->buffer_stride;
+    c.src_stride = ctx->buffer_stride;
+    c.dst_size = ctx->dst_rect.w;
+    
+    for(j = i; j < i + n; j++)
+      {
+      c.func2(&c, j, dst);
+      dst += dst_stride;
+      }
     }
-  }
-
+  
 #ifdef HAVE_MMX
-#define EMMS                       \
-  if(ctx->need_emms)               \
-    {                              \
-    __asm__ __volatile__ ("emms"); \
-    ctx->need_emms = 0;            \
-    }
-#else
-#define EMMS
+  if(c.need_emms)
+    __asm__ __volatile__ ("emms");
 #endif
+  }
 
+/* Source of the first pass for 2 directions */
 
-void gavl_video_scale_context_scale(gavl_video_scale_context_t * ctx,
-                                    const gavl_video_frame_t * src,
-                                    gavl_video_frame_t * dst)
+static void init_first_pass(gavl_video_scale_context_t * ctx,
+                            const gavl_video_frame_t * src)
+  {
+  ctx->offset = &ctx->offset1;
+  ctx->src = src->planes[ctx->src_frame_plane] +
+    ctx->offset->src_offset +
+    src->strides[ctx->src_frame_plane] * ctx->first_scanline;
+  ctx->src_stride = src->strides[ctx->src_frame_plane];
+  }
+
+static void scale_rows(gavl_video_scale_context_t * ctx,
+                       uint8_t * dst, int dst_stride,
+                       int start, int end, int thread)
   {
-  uint8_t * dst_save;
   int i;
   
-  if(ctx->opt->num_threads > 1)
+  if(ctx->num_directions == 2)
     {
-    scale_context_scale_mt(ctx, src, dst);
+    scale_rows_2(ctx, &ctx->windows[thread],
+                 dst + ctx->offset2.dst_offset, dst_stride, start, end);
     return;
     }
   
-  //  fprintf(stderr, "gavl_video_scale_context_scale, plane %d\n",
-  //          ctx->dst_frame_plane);
+  dst += ctx->offset->dst_offset;
+  
+  for(i = start; i < end; i++)
+    {
+    ctx->func1(ctx, i, dst);
+    dst += dst_stride;
+    }
+#ifdef HAVE_MMX
+  if(ctx->need_emms)
+    __asm__ __volatile__ ("emms");
+#endif
+  }
+
+void gavl_video_scale_context_scale(gavl_video_scale_context_t * ctx,
+                                    const gavl_video_frame_t * src,
+                                    gavl_video_frame_t * dst)
+  {
+  gavl_video_scale_context_scale_init(ctx, src);
+  gavl_video_scale_context_scale_rows(ctx, dst, 0, ctx->dst_rect.h, 0);
+  }
+
+void gavl_video_scale_context_scale_init(gavl_video_scale_context_t * ctx,
+                                         const gavl_video_frame_t * src)
+  {
   switch(ctx->num_directions)
     {
     case 1:
-      /* Only step */
       ctx->src = src->planes[ctx->src_frame_plane] + ctx->offset->src_offset;
       ctx->src_stride = src->strides[ctx->src_frame_plane];
-
-      dst_save = dst->planes[ctx->dst_frame_plane] + ctx->offset->dst_offset;
-            
-      for(i = 0; i < ctx->dst_rect.h; i++)
-        {
-        //        fprintf(stderr, "scanline: %d (%d)\n", ctx->scanline, ctx->dst_rect.h);
-        ctx->func1(ctx, i, dst_save);
-        dst_save += dst->strides[ctx->dst_frame_plane];
-        }
-      EMMS
       break;
     case 2:
-      /* First step */
-      ctx->offset = &ctx->offset1;
-      
-      ctx->src = src->planes[ctx->src_frame_plane] +
-        ctx->offset->src_offset +
-        src->strides[ctx->src_frame_plane] * ctx->first_scanline;
-      
-      ctx->src_stride = src->strides[ctx->src_frame_plane];
-      ctx->dst_size = ctx->buffer_width;
-
-      dst_save = ctx->buffer;
-#if 0
-      fprintf(stderr, "First direction\n");
-      dump_offset(ctx->offset);
-#endif
-      
-      for(i = 0; i < ctx->buffer_height; i++)
-        {
-        ctx->func1(ctx, i, dst_save);
-        dst_save += ctx->buffer_stride;
-        }
-      EMMS
-      //      fprintf(stderr, "done\n");
-
-      /* Second step */
-      ctx->offset = &ctx->offset2;
-#if 0
-      fprintf(stderr, "Second direction\n");
-      dump_offset(ctx->offset);
-#endif
-      ctx->src = ctx->buffer;
-      ctx->src_stride = ctx->buffer_stride;
-      ctx->dst_size = ctx->dst_rect.w;
-      dst_save =
-        dst->planes[ctx->dst_frame_plane] + ctx->offset->dst_offset;
-
-      for(i = 0; i < ctx->dst_rect.h; i++)
-        {
-        //        fprintf(stderr, "i: %d\n", ctx->scanline);
-        ctx->func2(ctx, i, dst_save);
-        dst_save += dst->strides[ctx->dst_frame_plane];
-        }
-      EMMS
-      //      fprintf(stderr, "done\n");
+      init_first_pass(ctx, src);
+      init_windows(ctx, (ctx->opt->num_threads > 1) ?
+                   ctx->opt->num_threads : 1);
       break;
     }
   }
 
+void gavl_video_scale_context_scale_rows(gavl_video_scale_context_t * ctx,
+                                         gavl_video_frame_t * dst,
+                                         int start, int end, int thread)
+  {
+  scale_rows(ctx, dst->planes[ctx->dst_frame_plane] +
+             start * dst->strides[ctx->dst_frame_plane],
+             dst->strides[ctx->dst_frame_plane], start, end, thread);
+  }
+
+void gavl_video_scale_context_scale_band(gavl_video_scale_context_t * ctx,
+                                         gavl_video_frame_t * dst,
+                                         int start, int end, int thread)
+  {
+  scale_rows(ctx, dst->planes[ctx->dst_frame_plane],
+             dst->strides[ctx->dst_frame_plane], start, end, thread);
+  }
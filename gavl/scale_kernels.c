@@ -127,6 +127,7 @@ gavl_video_scale_get_weight gavl_video_scale_get_weight_func(gavl_video_options_
   switch(opt->scale_mode)
     {
     case GAVL_SCALE_NEAREST:
+    case GAVL_SCALE_BOX: /* Point sampled box is nearest neighbor */
       *num_points = 1;
       return get_weight_nearest;
     case GAVL_SCALE_BILINEAR:
@@ -21,8 +21,10 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <float.h>
 #include <math.h>
+#include <pthread.h>
 
 #include <gavl/gavl.h>
 #include <scale.h>
@@ -55,6 +57,337 @@ static void convolve_preblur(float * src_1, int src_len_1,
                              float * src_2, int src_len_2,
                              float * dst);
 
+/*
+ *  Table cache: Calculating the coefficients is expensive (especially with
+ *  sinc kernels and preblur) and many contexts (planes, fields, scalers with
+ *  the same geometry) need the same tables. Therefore, the finished float
+ *  tables (and the integer versions for each requested accuracy) are
+ *  kept in a process wide cache. The tables are copied into the contexts,
+ *  since the contexts modify the indices afterwards. Tables keep a
+ *  reference to their entry, unused entries are evicted if the cache
+ *  is full.
+ */
+
+#define MAX_CACHED_TABLES  64
+#define MAX_INT_FACTORS     4
+
+typedef struct
+  {
+  int bits;
+  int32_t * factors;
+  } int_factors_t;
+
+typedef struct gavl_video_scale_table_entry_s
+  {
+  /* Key */
+  double src_off;
+  double src_size;
+  int dst_size;
+  int src_width;
+  gavl_scale_mode_t scale_mode;
+  int scale_order;
+  int quality;
+  gavl_downscale_filter_t downscale_filter;
+  float downscale_blur;
+
+  /* Scale mode after initialization (can be changed for small images) */
+  gavl_scale_mode_t real_scale_mode;
+  
+  /* Table */
+  int factors_per_pixel;
+  int do_clip;
+  int normalized;
+  int * indices;
+  float * factors_f;
+  
+  int_factors_t int_factors[MAX_INT_FACTORS];
+  int num_int_factors;
+  
+  int refcount;
+  int64_t last_used;
+  } table_entry_t;
+
+static table_entry_t * table_cache[MAX_CACHED_TABLES];
+static int table_cache_size = 0;
+static int64_t table_cache_counter = 0;
+static pthread_mutex_t table_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static int entry_matches(const table_entry_t * e,
+                         const gavl_video_options_t * opt,
+                         double src_off, double src_size,
+                         int dst_size, int src_width)
+  {
+  return (e->src_off == src_off) &&
+    (e->src_size == src_size) &&
+    (e->dst_size == dst_size) &&
+    (e->src_width == src_width) &&
+    (e->scale_mode == opt->scale_mode) &&
+    (e->scale_order == opt->scale_order) &&
+    (e->quality == opt->quality) &&
+    (e->downscale_filter == opt->downscale_filter) &&
+    (e->downscale_blur == opt->downscale_blur);
+  }
+
+static void entry_destroy(table_entry_t * e)
+  {
+  int i;
+  for(i = 0; i < e->num_int_factors; i++)
+    free(e->int_factors[i].factors);
+  free(e->indices);
+  free(e->factors_f);
+  free(e);
+  }
+
+static void table_release(gavl_video_scale_table_t * tab)
+  {
+  if(!tab->entry)
+    return;
+  pthread_mutex_lock(&table_cache_mutex);
+  tab->entry->refcount--;
+  pthread_mutex_unlock(&table_cache_mutex);
+  tab->entry = NULL;
+  }
+
+/* Find a table and copy it. Returns 1 on success */
+
+static int table_from_cache(gavl_video_scale_table_t * tab,
+                            gavl_video_options_t * opt,
+                            double src_off, double src_size,
+                            int dst_size, int src_width)
+  {
+  int i;
+  table_entry_t * e = NULL;
+  
+  pthread_mutex_lock(&table_cache_mutex);
+
+  for(i = 0; i < table_cache_size; i++)
+    {
+    if(entry_matches(table_cache[i], opt, src_off, src_size,
+                     dst_size, src_width))
+      {
+      e = table_cache[i];
+      e->refcount++;
+      e->last_used = ++table_cache_counter;
+      break;
+      }
+    }
+  pthread_mutex_unlock(&table_cache_mutex);
+
+  if(!e)
+    return 0;
+  
+  /* The entry is immutable as long as we hold a reference */
+  
+  tab->factors_per_pixel = e->factors_per_pixel;
+  alloc_table(tab, dst_size);
+  
+  for(i = 0; i < dst_size; i++)
+    tab->pixels[i].index = e->indices[i];
+  
+  memcpy(tab->factors_f, e->factors_f,
+         dst_size * e->factors_per_pixel * sizeof(*e->factors_f));
+
+  tab->do_clip = e->do_clip;
+  tab->normalized = e->normalized;
+  tab->entry = e;
+  opt->scale_mode = e->real_scale_mode;
+  return 1;
+  }
+
+static void table_to_cache(gavl_video_scale_table_t * tab,
+                           const gavl_video_options_t * opt,
+                           const gavl_video_options_t * orig_opt,
+                           double src_off, double src_size,
+                           int dst_size, int src_width)
+  {
+  int i, num;
+  int64_t min_used;
+  int min_index;
+  table_entry_t * e;
+
+  num = dst_size * tab->factors_per_pixel;
+  
+  e = calloc(1, sizeof(*e));
+  e->src_off          = src_off;
+  e->src_size         = src_size;
+  e->dst_size         = dst_size;
+  e->src_width        = src_width;
+  e->scale_mode       = orig_opt->scale_mode;
+  e->scale_order      = orig_opt->scale_order;
+  e->quality          = orig_opt->quality;
+  e->downscale_filter = orig_opt->downscale_filter;
+  e->downscale_blur   = orig_opt->downscale_blur;
+  e->real_scale_mode  = opt->scale_mode;
+  
+  e->factors_per_pixel = tab->factors_per_pixel;
+  e->do_clip = tab->do_clip;
+  e->normalized = tab->normalized;
+  
+  e->indices = malloc(dst_size * sizeof(*e->indices));
+  for(i = 0; i < dst_size; i++)
+    e->indices[i] = tab->pixels[i].index;
+
+  e->factors_f = malloc(num * sizeof(*e->factors_f));
+  memcpy(e->factors_f, tab->factors_f, num * sizeof(*e->factors_f));
+  e->refcount = 1;
+  
+  pthread_mutex_lock(&table_cache_mutex);
+
+  if(table_cache_size == MAX_CACHED_TABLES)
+    {
+    /* Evict the least recently used entry, which is not in use */
+    min_index = -1;
+    min_used = 0;
+    
+    for(i = 0; i < table_cache_size; i++)
+      {
+      if(!table_cache[i]->refcount &&
+         ((min_index < 0) || (table_cache[i]->last_used < min_used)))
+        {
+        min_index = i;
+        min_used = table_cache[i]->last_used;
+        }
+      }
+
+    if(min_index < 0)
+      {
+      /* Cache full, don't store */
+      pthread_mutex_unlock(&table_cache_mutex);
+      entry_destroy(e);
+      return;
+      }
+    
+    entry_destroy(table_cache[min_index]);
+    table_cache[min_index] = table_cache[table_cache_size-1];
+    table_cache_size--;
+    }
+
+  e->last_used = ++table_cache_counter;
+  table_cache[table_cache_size++] = e;
+  tab->entry = e;
+  pthread_mutex_unlock(&table_cache_mutex);
+  }
+
+/*
+ *  Area averaging (GAVL_SCALE_BOX): Each destination pixel covers an
+ *  interval of 1/scale_factor source pixels. The weight of a source pixel
+ *  is the length of its overlap with this interval. Taps, which are zero
+ *  for all pixels are removed afterwards. Thus, downscaling by an exact
+ *  integer factor N yields N taps, which use the same (SIMD) scanline
+ *  functions as the 2, 3 and 4 tap kernels.
+ */
+
+#define BOX_EPSILON 1.0e-4
+
+static void init_box(gavl_video_scale_table_t * tab,
+                     double src_off, double scale_factor,
+                     int dst_size, int src_width)
+  {
+  int i, j, first, num, trim_start, trim_end;
+  double width, start, end, pix_start, w, sum;
+  float * fac;
+  
+  width = 1.0 / scale_factor;
+  
+  tab->factors_per_pixel = (int)ceil(width - BOX_EPSILON) + 1;
+  if(tab->factors_per_pixel > src_width)
+    tab->factors_per_pixel = src_width;
+  
+  alloc_table(tab, dst_size);
+  
+  for(i = 0; i < dst_size; i++)
+    {
+    start = DST_TO_SRC((double)i) - 0.5 * width;
+    end = start + width;
+    
+    /* Source pixel containing the start of the interval */
+    first = (int)floor(start + 0.5 + BOX_EPSILON);
+    
+    fac = tab->pixels[i].factor_f;
+    sum = 0.0;
+    
+    for(j = 0; j < tab->factors_per_pixel; j++)
+      {
+      pix_start = first + j - 0.5;
+      w = ((end < pix_start + 1.0) ? end : pix_start + 1.0) -
+        ((start > pix_start) ? start : pix_start);
+      if(w < BOX_EPSILON)
+        w = 0.0;
+      fac[j] = w;
+      sum += w;
+      }
+    
+    /* Outside the image (can happen for 1 tap). Take the nearest
+       pixel and let shift_borders() move it to the image. */
+    if((sum == 0.0) || (first >= src_width) || (first + tab->factors_per_pixel <= 0))
+      {
+      first = (int)floor(start + 0.5 * width + 0.5);
+      if(first < 0)
+        first = 0;
+      if(first > src_width - 1)
+        first = src_width - 1;
+      fac[0] = 1.0;
+      for(j = 1; j < tab->factors_per_pixel; j++)
+        fac[j] = 0.0;
+      }
+    tab->pixels[i].index = first;
+    }
+
+  /* Remove taps, which are zero everywhere */
+  
+  for(trim_start = 0; trim_start < tab->factors_per_pixel - 1; trim_start++)
+    {
+    for(i = 0; i < dst_size; i++)
+      {
+      if(tab->pixels[i].factor_f[trim_start] != 0.0)
+        break;
+      }
+    if(i < dst_size)
+      break;
+    }
+
+  for(trim_end = 0; trim_end < tab->factors_per_pixel - trim_start - 1; trim_end++)
+    {
+    for(i = 0; i < dst_size; i++)
+      {
+      if(tab->pixels[i].factor_f[tab->factors_per_pixel - 1 - trim_end] != 0.0)
+        break;
+      }
+    if(i < dst_size)
+      break;
+    }
+
+  if(trim_start || trim_end)
+    {
+    num = tab->factors_per_pixel - trim_start - trim_end;
+    
+    for(i = 0; i < dst_size; i++)
+      {
+      memmove(tab->factors_f + i * num,
+              tab->factors_f + i * tab->factors_per_pixel + trim_start,
+              num * sizeof(*tab->factors_f));
+      tab->pixels[i].index += trim_start;
+      }
+    
+    tab->factors_per_pixel = num;
+    
+    /* Update the factor pointers */
+    alloc_table(tab, dst_size);
+    }
+  
+  /* 1 tap tables must be inside the image */
+  if(tab->factors_per_pixel == 1)
+    {
+    for(i = 0; i < dst_size; i++)
+      {
+      if(tab->pixels[i].index < 0)
+        tab->pixels[i].index = 0;
+      if(tab->pixels[i].index > src_width - 1)
+        tab->pixels[i].index = src_width - 1;
+      }
+    }
+  }
+
 /*
  * Creation of the scale tables, the most ugly part.
  * The tables are for one dimension only, for 2D scaling, we'll have 2 tables.
@@ -90,10 +423,10 @@ static void convolve_preblur(float * src_1, int src_len_1,
  *
  */
                     
-void gavl_video_scale_table_init(gavl_video_scale_table_t * tab,
-                                 gavl_video_options_t * opt,
-                                 double src_off, double src_size,
-                                 int dst_size, int src_width)
+static void table_init(gavl_video_scale_table_t * tab,
+                       gavl_video_options_t * opt,
+                       double src_off, double src_size,
+                       int dst_size, int src_width)
   {
   int widen;
 
@@ -115,6 +448,15 @@ void gavl_video_scale_table_init(gavl_video_scale_table_t * tab,
 
   if(!dst_size)
     return;
+
+  if(opt->scale_mode == GAVL_SCALE_BOX)
+    {
+    init_box(tab, src_off, scale_factor, dst_size, src_width);
+    shift_borders(tab, src_width);
+    normalize_table(tab);
+    check_clip(tab);
+    return;
+    }
   
   if(scale_factor < 1.0)
     {
@@ -302,6 +644,26 @@ void gavl_video_scale_table_init(gavl_video_scale_table_t * tab,
 #endif  
   }
 
+void gavl_video_scale_table_init(gavl_video_scale_table_t * tab,
+                                 gavl_video_options_t * opt,
+                                 double src_off, double src_size,
+                                 int dst_size, int src_width)
+  {
+  gavl_video_options_t orig_opt;
+  
+  table_release(tab);
+
+  if(!dst_size)
+    return;
+  
+  if(table_from_cache(tab, opt, src_off, src_size, dst_size, src_width))
+    return;
+
+  gavl_video_options_copy(&orig_opt, opt);
+  table_init(tab, opt, src_off, src_size, dst_size, src_width);
+  table_to_cache(tab, opt, &orig_opt, src_off, src_size, dst_size, src_width);
+  }
+
 void 
 gavl_video_scale_table_init_convolve(gavl_video_scale_table_t * tab,
                                      gavl_video_options_t * opt,
@@ -309,6 +671,8 @@ gavl_video_scale_table_init_convolve(gavl_video_scale_table_t * tab,
                                      int size)
   {
   int i, j;
+
+  table_release(tab);
   tab->factors_per_pixel = num_coeffs * 2 + 1;
   alloc_table(tab, size);
   
@@ -530,8 +894,8 @@ static void gavl_video_scale_table_dump_int(gavl_video_scale_table_t * tab)
   }
 #endif
 
-void gavl_video_scale_table_init_int(gavl_video_scale_table_t * tab,
-                                     int bits)
+static void table_init_int(gavl_video_scale_table_t * tab,
+                           int bits)
   {
   int fac_max_i, i, j;
   float fac_max_f, sum_f;
@@ -580,8 +944,58 @@ void gavl_video_scale_table_init_int(gavl_video_scale_table_t * tab,
   //  gavl_video_scale_table_dump_int(tab);
   }
 
+void gavl_video_scale_table_init_int(gavl_video_scale_table_t * tab,
+                                     int bits)
+  {
+  int i, num;
+  table_entry_t * e = tab->entry;
+  int_factors_t * f;
+
+  num = tab->num_pixels * tab->factors_per_pixel;
+  
+  if(e)
+    {
+    pthread_mutex_lock(&table_cache_mutex);
+    for(i = 0; i < e->num_int_factors; i++)
+      {
+      if(e->int_factors[i].bits == bits)
+        {
+        memcpy(tab->factors_i, e->int_factors[i].factors,
+               num * sizeof(*tab->factors_i));
+        pthread_mutex_unlock(&table_cache_mutex);
+        return;
+        }
+      }
+    pthread_mutex_unlock(&table_cache_mutex);
+    }
+  
+  table_init_int(tab, bits);
+
+  if(e)
+    {
+    pthread_mutex_lock(&table_cache_mutex);
+    
+    /* Another thread might have been faster */
+    for(i = 0; i < e->num_int_factors; i++)
+      {
+      if(e->int_factors[i].bits == bits)
+        break;
+      }
+    
+    if((i == e->num_int_factors) && (i < MAX_INT_FACTORS))
+      {
+      f = &e->int_factors[e->num_int_factors++];
+      f->bits = bits;
+      f->factors = malloc(num * sizeof(*f->factors));
+      memcpy(f->factors, tab->factors_i, num * sizeof(*f->factors));
+      }
+    pthread_mutex_unlock(&table_cache_mutex);
+    }
+  }
+
 void gavl_video_scale_table_cleanup(gavl_video_scale_table_t * tab)
   {
+  table_release(tab);
   if(tab->pixels)
     free(tab->pixels);
   if(tab->factors_f)
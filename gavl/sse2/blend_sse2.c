@@ -0,0 +1,289 @@
+/*****************************************************************
+ * gavl - a general purpose audio/video processing library
+ *
+ * Copyright (c) 2001 - 2012 Members of the Gmerlin project
+ * gmerlin-general@lists.sourceforge.net
+ * http://gmerlin.sourceforge.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * *****************************************************************/
+
+/*
+ *  Overlay blending line functions (see ../c/blend_c.c) with
+ *  128 bit (SSE2) or 256 bit (AVX2) registers.
+ *
+ *  d = (((s - d) * (a + (a >> 7))) >> 8) + d
+ *
+ *  is done in 16 bit as pmulhw((s - d) << 7, (a + (a >> 7)) << 1).
+ *  For premultiplied overlays, d = s + ((d * (256 - a)) >> 8) needs
+ *  just one pmullw. The results are identical to the C versions.
+ */
+
+#include <config.h>
+#include <attributes.h>
+
+#include <gavl/gavl.h>
+#include <video.h>
+#include <blend.h>
+
+#ifdef AVX2
+#include <immintrin.h>
+#define VEC                  __m256i
+#define LANES                8 /* 32 bit pixels per register */
+#define VEC_ZERO             _mm256_setzero_si256()
+#define VEC_SET1_32          _mm256_set1_epi32
+#define VEC_SET1_64          _mm256_set1_epi64x
+#define VEC_LOADU(p)         _mm256_loadu_si256((const __m256i*)(p))
+#define VEC_STOREU(p, v)     _mm256_storeu_si256((__m256i*)(p), v)
+#define VEC_AND              _mm256_and_si256
+#define VEC_SET1_16          _mm256_set1_epi16
+#define VEC_ADD_16           _mm256_add_epi16
+#define VEC_SUB_16           _mm256_sub_epi16
+#define VEC_MULHI_16         _mm256_mulhi_epi16
+#define VEC_MULLO_16         _mm256_mullo_epi16
+#define VEC_SLLI_16          _mm256_slli_epi16
+#define VEC_SRLI_16          _mm256_srli_epi16
+#define VEC_SRLI_32          _mm256_srli_epi32
+#define VEC_UNPACKLO_8       _mm256_unpacklo_epi8
+#define VEC_UNPACKHI_8       _mm256_unpackhi_epi8
+#define VEC_PACKUS_16        _mm256_packus_epi16
+#define VEC_SHUFFLELO_16     _mm256_shufflelo_epi16
+#define VEC_SHUFFLEHI_16     _mm256_shufflehi_epi16
+
+/* Load 8 pixels, which are sub_h (1 or 2) pixels apart */
+
+static inline VEC load_pixels(const uint8_t * ovl, int sub_h)
+  {
+  if(sub_h == 1)
+    return VEC_LOADU(ovl);
+
+  return _mm256_permute4x64_epi64(_mm256_castps_si256(_mm256_shuffle_ps(_mm256_castsi256_ps(VEC_LOADU(ovl)),
+                                                                        _mm256_castsi256_ps(VEC_LOADU(ovl + 32)),
+                                                                        _MM_SHUFFLE(2, 0, 2, 0))),
+                                  _MM_SHUFFLE(3, 1, 2, 0));
+  }
+
+/* Extract one channel of 2 x 8 pixels into 16 bit */
+
+static inline VEC get_channel(VEC p0, VEC p1, int shift)
+  {
+  const VEC mask = VEC_SET1_32(0xff);
+  return _mm256_permute4x64_epi64(_mm256_packs_epi32(VEC_AND(VEC_SRLI_32(p0, shift), mask),
+                                                     VEC_AND(VEC_SRLI_32(p1, shift), mask)),
+                                  _MM_SHUFFLE(3, 1, 2, 0));
+  }
+
+static inline VEC load_8(const uint8_t * p)
+  {
+  return _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)p));
+  }
+
+static inline void store_8(uint8_t * dst, VEC v)
+  {
+  v = _mm256_permute4x64_epi64(_mm256_packus_epi16(v, v), _MM_SHUFFLE(3, 1, 2, 0));
+  _mm_storeu_si128((__m128i*)dst, _mm256_castsi256_si128(v));
+  }
+
+#else
+#include <emmintrin.h>
+#define VEC                  __m128i
+#define LANES                4 /* 32 bit pixels per register */
+#define VEC_ZERO             _mm_setzero_si128()
+#define VEC_SET1_32          _mm_set1_epi32
+#define VEC_SET1_64          _mm_set1_epi64x
+#define VEC_LOADU(p)         _mm_loadu_si128((const __m128i*)(p))
+#define VEC_STOREU(p, v)     _mm_storeu_si128((__m128i*)(p), v)
+#define VEC_AND              _mm_and_si128
+#define VEC_SET1_16          _mm_set1_epi16
+#define VEC_ADD_16           _mm_add_epi16
+#define VEC_SUB_16           _mm_sub_epi16
+#define VEC_MULHI_16         _mm_mulhi_epi16
+#define VEC_MULLO_16         _mm_mullo_epi16
+#define VEC_SLLI_16          _mm_slli_epi16
+#define VEC_SRLI_16          _mm_srli_epi16
+#define VEC_SRLI_32          _mm_srli_epi32
+#define VEC_UNPACKLO_8       _mm_unpacklo_epi8
+#define VEC_UNPACKHI_8       _mm_unpackhi_epi8
+#define VEC_PACKUS_16        _mm_packus_epi16
+#define VEC_SHUFFLELO_16     _mm_shufflelo_epi16
+#define VEC_SHUFFLEHI_16     _mm_shufflehi_epi16
+
+/* Load 4 pixels, which are sub_h (1 or 2) pixels apart */
+
+static inline VEC load_pixels(const uint8_t * ovl, int sub_h)
+  {
+  if(sub_h == 1)
+    return VEC_LOADU(ovl);
+
+  return _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(VEC_LOADU(ovl)),
+                                         _mm_castsi128_ps(VEC_LOADU(ovl + 16)),
+                                         _MM_SHUFFLE(2, 0, 2, 0)));
+  }
+
+/* Extract one channel of 2 x 4 pixels into 16 bit */
+
+static inline VEC get_channel(VEC p0, VEC p1, int shift)
+  {
+  const VEC mask = VEC_SET1_32(0xff);
+  return _mm_packs_epi32(VEC_AND(VEC_SRLI_32(p0, shift), mask),
+                         VEC_AND(VEC_SRLI_32(p1, shift), mask));
+  }
+
+static inline VEC load_8(const uint8_t * p)
+  {
+  return _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)p), VEC_ZERO);
+  }
+
+static inline void store_8(uint8_t * dst, VEC v)
+  {
+  _mm_storel_epi64((__m128i*)dst, _mm_packus_epi16(v, v));
+  }
+#endif
+
+static inline VEC blend_16(VEC s, VEC d, VEC a, const int premultiplied)
+  {
+  a = VEC_ADD_16(a, VEC_SRLI_16(a, 7));
+  if(premultiplied)
+    return VEC_ADD_16(VEC_SRLI_16(VEC_MULLO_16(d, VEC_SUB_16(VEC_SET1_16(256), a)), 8), s);
+  return VEC_ADD_16(VEC_MULHI_16(VEC_SLLI_16(VEC_SUB_16(s, d), 7),
+                                 VEC_SLLI_16(a, 1)), d);
+  }
+
+static inline uint8_t blend_scalar(int s, int d, int a, const int premultiplied)
+  {
+  a += a >> 7;
+  if(premultiplied)
+    return s + ((d * (256 - a)) >> 8);
+  return (((s - d) * a) >> 8) + d;
+  }
+
+static inline void
+blend_rgb_32(uint8_t * dst, const uint8_t * ovl, int num, const int premultiplied)
+  {
+  int i;
+  VEC o, d, a, o_lo, o_hi;
+
+  /* Don't touch the 4th byte */
+  const VEC alpha_mask = VEC_SET1_64(0x0000ffffffffffffLL);
+
+  for(i = 0; i + LANES <= num; i += LANES)
+    {
+    o = VEC_LOADU(ovl + 4 * i);
+    d = VEC_LOADU(dst + 4 * i);
+
+    o_lo = VEC_UNPACKLO_8(o, VEC_ZERO);
+    o_hi = VEC_UNPACKHI_8(o, VEC_ZERO);
+
+    a = VEC_SHUFFLEHI_16(VEC_SHUFFLELO_16(o_lo, _MM_SHUFFLE(3, 3, 3, 3)),
+                         _MM_SHUFFLE(3, 3, 3, 3));
+    o_lo = blend_16(VEC_AND(o_lo, alpha_mask), VEC_UNPACKLO_8(d, VEC_ZERO),
+                    VEC_AND(a, alpha_mask), premultiplied);
+
+    a = VEC_SHUFFLEHI_16(VEC_SHUFFLELO_16(o_hi, _MM_SHUFFLE(3, 3, 3, 3)),
+                         _MM_SHUFFLE(3, 3, 3, 3));
+    o_hi = blend_16(VEC_AND(o_hi, alpha_mask), VEC_UNPACKHI_8(d, VEC_ZERO),
+                    VEC_AND(a, alpha_mask), premultiplied);
+
+    VEC_STOREU(dst + 4 * i, VEC_PACKUS_16(o_lo, o_hi));
+    }
+
+  for(; i < num; i++)
+    {
+    dst[4*i]   = blend_scalar(ovl[4*i],   dst[4*i],   ovl[4*i+3], premultiplied);
+    dst[4*i+1] = blend_scalar(ovl[4*i+1], dst[4*i+1], ovl[4*i+3], premultiplied);
+    dst[4*i+2] = blend_scalar(ovl[4*i+2], dst[4*i+2], ovl[4*i+3], premultiplied);
+    }
+  }
+
+static inline void
+blend_y_8(uint8_t * dst, const uint8_t * ovl, int num, const int premultiplied)
+  {
+  int i;
+  VEC p0, p1;
+
+  for(i = 0; i + 2 * LANES <= num; i += 2 * LANES)
+    {
+    p0 = load_pixels(ovl + 4 * i, 1);
+    p1 = load_pixels(ovl + 4 * (i + LANES), 1);
+
+    store_8(dst + i, blend_16(get_channel(p0, p1, 0), load_8(dst + i),
+                              get_channel(p0, p1, 24), premultiplied));
+    }
+
+  for(; i < num; i++)
+    dst[i] = blend_scalar(ovl[4*i], dst[i], ovl[4*i+3], premultiplied);
+  }
+
+static inline void
+blend_uv_8(uint8_t * dst_u, uint8_t * dst_v,
+           const uint8_t * ovl, int num, int sub_h, const int premultiplied)
+  {
+  int i = 0;
+  VEC p0, p1, a;
+
+  if(sub_h <= 2)
+    {
+    for(i = 0; i + 2 * LANES <= num; i += 2 * LANES)
+      {
+      p0 = load_pixels(ovl + 4 * sub_h * i, sub_h);
+      p1 = load_pixels(ovl + 4 * sub_h * (i + LANES), sub_h);
+      a = get_channel(p0, p1, 24);
+
+      store_8(dst_u + i, blend_16(get_channel(p0, p1, 8), load_8(dst_u + i),
+                                  a, premultiplied));
+      store_8(dst_v + i, blend_16(get_channel(p0, p1, 16), load_8(dst_v + i),
+                                  a, premultiplied));
+      }
+    }
+
+  for(; i < num; i++)
+    {
+    dst_u[i] = blend_scalar(ovl[4*sub_h*i+1], dst_u[i], ovl[4*sub_h*i+3], premultiplied);
+    dst_v[i] = blend_scalar(ovl[4*sub_h*i+2], dst_v[i], ovl[4*sub_h*i+3], premultiplied);
+    }
+  }
+
+#define LINE_FUNCS(suffix, premultiplied)                               \
+static void blend_rgb_32_##suffix(uint8_t * dst, const uint8_t * ovl, int num) \
+  { blend_rgb_32(dst, ovl, num, premultiplied); }                       \
+                                                                        \
+static void blend_y_8_##suffix(uint8_t * dst, const uint8_t * ovl, int num) \
+  { blend_y_8(dst, ovl, num, premultiplied); }                          \
+                                                                        \
+static void blend_uv_8_##suffix(uint8_t * dst_u, uint8_t * dst_v,       \
+                                const uint8_t * ovl, int num, int sub_h) \
+  { blend_uv_8(dst_u, dst_v, ovl, num, sub_h, premultiplied); }
+
+LINE_FUNCS(straight, 0)
+LINE_FUNCS(premultiplied, 1)
+
+#ifdef AVX2
+void gavl_init_blend_funcs_avx2(gavl_blend_funcs_t * funcs, int premultiplied)
+#else
+void gavl_init_blend_funcs_sse2(gavl_blend_funcs_t * funcs, int premultiplied)
+#endif
+  {
+  if(premultiplied)
+    {
+    funcs->blend_rgb_32 = blend_rgb_32_premultiplied;
+    funcs->blend_y_8    = blend_y_8_premultiplied;
+    funcs->blend_uv_8   = blend_uv_8_premultiplied;
+    }
+  else
+    {
+    funcs->blend_rgb_32 = blend_rgb_32_straight;
+    funcs->blend_y_8    = blend_y_8_straight;
+    funcs->blend_uv_8   = blend_uv_8_straight;
+    }
+  }
@@ -0,0 +1,145 @@
+/*****************************************************************
+ * gavl - a general purpose audio/video processing library
+ *
+ * Copyright (c) 2001 - 2012 Members of the Gmerlin project
+ * gmerlin-general@lists.sourceforge.net
+ * http://gmerlin.sourceforge.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * *****************************************************************/
+
+/*
+ *  Motion adaptive deinterlacing (see ../deinterlace_adaptive.c) with
+ *  128 bit (SSE2) or 256 bit (AVX2) registers. The 8 bit samples are
+ *  expanded to 16 bit so the scores don't overflow.
+ *  The results are identical to the C version.
+ */
+
+#include <config.h>
+#include <attributes.h>
+
+#include <gavl/gavl.h>
+#include <video.h>
+
+#include <deinterlace.h>
+
+#ifdef AVX2
+#include <immintrin.h>
+#define VEC                  __m256i
+#define LANES                16
+#define VEC_LOAD(p)          _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(p)))
+#define VEC_ADD_16           _mm256_add_epi16
+#define VEC_SUB_16           _mm256_sub_epi16
+#define VEC_MIN_16           _mm256_min_epi16
+#define VEC_MAX_16           _mm256_max_epi16
+#define VEC_AVG_16           _mm256_avg_epu16
+#define VEC_SRLI_16          _mm256_srli_epi16
+#define VEC_CMPGT_16         _mm256_cmpgt_epi16
+#define VEC_SELECT(m, a, b)  _mm256_blendv_epi8(b, a, m)
+
+static inline void store_8(uint8_t * dst, VEC v)
+  {
+  v = _mm256_permute4x64_epi64(_mm256_packus_epi16(v, v), _MM_SHUFFLE(3, 1, 2, 0));
+  _mm_storeu_si128((__m128i*)dst, _mm256_castsi256_si128(v));
+  }
+
+#else
+#include <emmintrin.h>
+#define VEC                  __m128i
+#define LANES                8
+#define VEC_LOAD(p)          _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(p)), \
+                                               _mm_setzero_si128())
+#define VEC_ADD_16           _mm_add_epi16
+#define VEC_SUB_16           _mm_sub_epi16
+#define VEC_MIN_16           _mm_min_epi16
+#define VEC_MAX_16           _mm_max_epi16
+#define VEC_AVG_16           _mm_avg_epu16
+#define VEC_SRLI_16          _mm_srli_epi16
+#define VEC_CMPGT_16         _mm_cmpgt_epi16
+#define VEC_SELECT(m, a, b)  _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b))
+
+static inline void store_8(uint8_t * dst, VEC v)
+  {
+  _mm_storel_epi64((__m128i*)dst, _mm_packus_epi16(v, v));
+  }
+#endif
+
+#define ABS_DIFF(a, b) VEC_MAX_16(VEC_SUB_16(a, b), VEC_SUB_16(b, a))
+
+static int filter_8(const gavl_video_deinterlace_lines_t * l,
+                    int start, int end, int a)
+  {
+  int x;
+  VEC c, e, p, n, d, diff, best, score, pred, mask;
+  VEC am1, ap1, bm1, bp1;
+
+  for(x = start; x + LANES <= end; x += LANES)
+    {
+    c = VEC_LOAD(l->above + x);
+    e = VEC_LOAD(l->below + x);
+    p = VEC_LOAD(l->prev + x);
+    n = VEC_LOAD(l->cur + x);
+
+    /* Temporal prediction and motion */
+    d = VEC_AVG_16(p, n);
+    diff = VEC_SRLI_16(ABS_DIFF(p, n), 1);
+    diff = VEC_MAX_16(diff,
+                      VEC_SRLI_16(VEC_ADD_16(ABS_DIFF(VEC_LOAD(l->prev_above + x), c),
+                                             ABS_DIFF(VEC_LOAD(l->prev_below + x), e)), 1));
+
+    /* Edge directed spatial prediction */
+    am1 = VEC_LOAD(l->above + x - a);
+    ap1 = VEC_LOAD(l->above + x + a);
+    bm1 = VEC_LOAD(l->below + x - a);
+    bp1 = VEC_LOAD(l->below + x + a);
+
+    best = VEC_ADD_16(VEC_ADD_16(ABS_DIFF(am1, bm1), ABS_DIFF(c, e)),
+                      ABS_DIFF(ap1, bp1));
+    pred = VEC_AVG_16(c, e);
+
+    score = VEC_ADD_16(VEC_ADD_16(ABS_DIFF(VEC_LOAD(l->above + x - 2 * a), e),
+                                  ABS_DIFF(am1, bp1)),
+                       ABS_DIFF(c, VEC_LOAD(l->below + x + 2 * a)));
+    mask = VEC_CMPGT_16(best, score);
+    best = VEC_SELECT(mask, score, best);
+    pred = VEC_SELECT(mask, VEC_AVG_16(am1, bp1), pred);
+
+    score = VEC_ADD_16(VEC_ADD_16(ABS_DIFF(c, VEC_LOAD(l->below + x - 2 * a)),
+                                  ABS_DIFF(ap1, bm1)),
+                       ABS_DIFF(VEC_LOAD(l->above + x + 2 * a), e));
+    mask = VEC_CMPGT_16(best, score);
+    pred = VEC_SELECT(mask, VEC_AVG_16(ap1, bm1), pred);
+
+    /* Limit */
+    pred = VEC_MAX_16(VEC_MIN_16(pred, VEC_ADD_16(d, diff)),
+                      VEC_SUB_16(d, diff));
+    store_8(l->dst + x, pred);
+    }
+  return x - start;
+  }
+
+#ifdef AVX2
+void
+gavl_find_deinterlacer_adaptive_funcs_avx2(gavl_video_deinterlace_adaptive_func_table_t * tab,
+                                           const gavl_video_options_t * opt,
+                                           const gavl_video_format_t * format)
+#else
+void
+gavl_find_deinterlacer_adaptive_funcs_sse2(gavl_video_deinterlace_adaptive_func_table_t * tab,
+                                           const gavl_video_options_t * opt,
+                                           const gavl_video_format_t * format)
+#endif
+  {
+  tab->func_8 = filter_8;
+  }
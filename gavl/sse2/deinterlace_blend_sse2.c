@@ -0,0 +1,198 @@
+/*****************************************************************
+ * gavl - a general purpose audio/video processing library
+ *
+ * Copyright (c) 2001 - 2012 Members of the Gmerlin project
+ * gmerlin-general@lists.sourceforge.net
+ * http://gmerlin.sourceforge.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * *****************************************************************/
+
+/*
+ *  (t + 2*m + b) / 4 with 128 bit (SSE2) or 256 bit (AVX2) registers.
+ *  The results are identical to the C version.
+ */
+
+#include <config.h>
+#include <attributes.h>
+
+#include <gavl/gavl.h>
+#include <video.h>
+
+#include <deinterlace.h>
+
+#ifdef AVX2
+#include <immintrin.h>
+#define VEC                  __m256i
+#define VEC_BYTES            32
+#define VEC_LOAD(p)          _mm256_loadu_si256((const __m256i*)(p))
+#define VEC_STORE(p, v)      _mm256_storeu_si256((__m256i*)(p), v)
+#define VEC_ZERO             _mm256_setzero_si256()
+#define VEC_SET1_32(v)       _mm256_set1_epi32(v)
+#define VEC_UNPACKLO_8       _mm256_unpacklo_epi8
+#define VEC_UNPACKHI_8       _mm256_unpackhi_epi8
+#define VEC_UNPACKLO_16      _mm256_unpacklo_epi16
+#define VEC_UNPACKHI_16      _mm256_unpackhi_epi16
+#define VEC_ADD_16           _mm256_add_epi16
+#define VEC_ADD_32           _mm256_add_epi32
+#define VEC_SLLI_16          _mm256_slli_epi16
+#define VEC_SRLI_16          _mm256_srli_epi16
+#define VEC_SLLI_32          _mm256_slli_epi32
+#define VEC_SRLI_32          _mm256_srli_epi32
+#define VEC_PACKUS_16        _mm256_packus_epi16
+#define VEC_PACKS_32         _mm256_packs_epi32
+#define VEC_XOR              _mm256_xor_si256
+#define VEC_SUB_32           _mm256_sub_epi32
+#else
+#include <emmintrin.h>
+#define VEC                  __m128i
+#define VEC_BYTES            16
+#define VEC_LOAD(p)          _mm_loadu_si128((const __m128i*)(p))
+#define VEC_STORE(p, v)      _mm_storeu_si128((__m128i*)(p), v)
+#define VEC_ZERO             _mm_setzero_si128()
+#define VEC_SET1_32(v)       _mm_set1_epi32(v)
+#define VEC_UNPACKLO_8       _mm_unpacklo_epi8
+#define VEC_UNPACKHI_8       _mm_unpackhi_epi8
+#define VEC_UNPACKLO_16      _mm_unpacklo_epi16
+#define VEC_UNPACKHI_16      _mm_unpackhi_epi16
+#define VEC_ADD_16           _mm_add_epi16
+#define VEC_ADD_32           _mm_add_epi32
+#define VEC_SLLI_16          _mm_slli_epi16
+#define VEC_SRLI_16          _mm_srli_epi16
+#define VEC_SLLI_32          _mm_slli_epi32
+#define VEC_SRLI_32          _mm_srli_epi32
+#define VEC_PACKUS_16        _mm_packus_epi16
+#define VEC_PACKS_32         _mm_packs_epi32
+#define VEC_XOR              _mm_xor_si128
+#define VEC_SUB_32           _mm_sub_epi32
+#endif
+
+/* Unpacking and packing happen within 128 bit lanes, so the
+   byte order is preserved for AVX2 as well */
+
+static void blend_func_8(const uint8_t * t,
+                         const uint8_t * m,
+                         const uint8_t * b,
+                         uint8_t * dst,
+                         int num)
+  {
+  int i;
+  int imax;
+  VEC zero = VEC_ZERO;
+  VEC t_lo, t_hi, m_lo, m_hi, b_lo, b_hi, tmp;
+
+  imax = num / VEC_BYTES;
+
+  for(i = 0; i < imax; i++)
+    {
+    tmp = VEC_LOAD(t);
+    t_lo = VEC_UNPACKLO_8(tmp, zero);
+    t_hi = VEC_UNPACKHI_8(tmp, zero);
+
+    tmp = VEC_LOAD(m);
+    m_lo = VEC_UNPACKLO_8(tmp, zero);
+    m_hi = VEC_UNPACKHI_8(tmp, zero);
+
+    tmp = VEC_LOAD(b);
+    b_lo = VEC_UNPACKLO_8(tmp, zero);
+    b_hi = VEC_UNPACKHI_8(tmp, zero);
+
+    m_lo = VEC_ADD_16(VEC_ADD_16(VEC_SLLI_16(m_lo, 1), t_lo), b_lo);
+    m_hi = VEC_ADD_16(VEC_ADD_16(VEC_SLLI_16(m_hi, 1), t_hi), b_hi);
+
+    VEC_STORE(dst, VEC_PACKUS_16(VEC_SRLI_16(m_lo, 2),
+                                 VEC_SRLI_16(m_hi, 2)));
+
+    t += VEC_BYTES;
+    m += VEC_BYTES;
+    b += VEC_BYTES;
+    dst += VEC_BYTES;
+    }
+
+  imax = num % VEC_BYTES;
+  for(i = 0; i < imax; i++)
+    *(dst++) = (*(t++) + (*(m++) << 1) + *(b++)) >> 2;
+  }
+
+/* The 16 bit sums need 18 bits, so we go to 32 bit. packs_epi32 is
+   signed, so we bias the values by 0x8000 for packing */
+
+static void blend_func_16(const uint8_t * t1,
+                          const uint8_t * m1,
+                          const uint8_t * b1,
+                          uint8_t * dst1,
+                          int num)
+  {
+  int i;
+  int imax;
+  VEC zero = VEC_ZERO;
+  VEC bias_32 = VEC_SET1_32(0x8000);
+  VEC bias_16 = VEC_SET1_32(0x80008000);
+  VEC t_lo, t_hi, m_lo, m_hi, b_lo, b_hi, tmp;
+
+  const uint16_t * t   = (const uint16_t*)t1;
+  const uint16_t * m   = (const uint16_t*)m1;
+  const uint16_t * b   = (const uint16_t*)b1;
+  uint16_t * dst = (uint16_t*)dst1;
+
+  imax = num / (VEC_BYTES/2);
+
+  for(i = 0; i < imax; i++)
+    {
+    tmp = VEC_LOAD(t);
+    t_lo = VEC_UNPACKLO_16(tmp, zero);
+    t_hi = VEC_UNPACKHI_16(tmp, zero);
+
+    tmp = VEC_LOAD(m);
+    m_lo = VEC_UNPACKLO_16(tmp, zero);
+    m_hi = VEC_UNPACKHI_16(tmp, zero);
+
+    tmp = VEC_LOAD(b);
+    b_lo = VEC_UNPACKLO_16(tmp, zero);
+    b_hi = VEC_UNPACKHI_16(tmp, zero);
+
+    m_lo = VEC_ADD_32(VEC_ADD_32(VEC_SLLI_32(m_lo, 1), t_lo), b_lo);
+    m_hi = VEC_ADD_32(VEC_ADD_32(VEC_SLLI_32(m_hi, 1), t_hi), b_hi);
+
+    m_lo = VEC_SUB_32(VEC_SRLI_32(m_lo, 2), bias_32);
+    m_hi = VEC_SUB_32(VEC_SRLI_32(m_hi, 2), bias_32);
+
+    VEC_STORE(dst, VEC_XOR(VEC_PACKS_32(m_lo, m_hi), bias_16));
+
+    t += VEC_BYTES/2;
+    m += VEC_BYTES/2;
+    b += VEC_BYTES/2;
+    dst += VEC_BYTES/2;
+    }
+
+  imax = num % (VEC_BYTES/2);
+  for(i = 0; i < imax; i++)
+    *(dst++) = (*(t++) + (*(m++) << 1) + *(b++)) >> 2;
+  }
+
+#ifdef AVX2
+void
+gavl_find_deinterlacer_blend_funcs_avx2(gavl_video_deinterlace_blend_func_table_t * tab,
+                                        const gavl_video_options_t * opt,
+                                        const gavl_video_format_t * format)
+#else
+void
+gavl_find_deinterlacer_blend_funcs_sse2(gavl_video_deinterlace_blend_func_table_t * tab,
+                                        const gavl_video_options_t * opt,
+                                        const gavl_video_format_t * format)
+#endif
+  {
+  tab->func_8 = blend_func_8;
+  tab->func_16 = blend_func_16;
+  }
@@ -0,0 +1,700 @@
+/*****************************************************************
+ * gavl - a general purpose audio/video processing library
+ *
+ * Copyright (c) 2001 - 2012 Members of the Gmerlin project
+ * gmerlin-general@lists.sourceforge.net
+ * http://gmerlin.sourceforge.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * *****************************************************************/
+
+/*
+ *  SSE2 (and AVX2, see ../avx2/scale_x_avx2.c) optimized scaling (x)
+ *
+ *  Each 32 bit lane accumulates one component of one destination pixel.
+ *  Two neighbouring filter taps are multiplied and added in one step
+ *  with pmaddwd, so we need 14 bit factors. 16 bit pixels are shifted
+ *  down by one bit to fit into signed words (like the MMX code does).
+ */
+
+#include <config.h>
+#include <attributes.h>
+
+#include <string.h>
+
+#include <gavl/gavl.h>
+#include <video.h>
+#include <scale.h>
+
+#ifdef AVX2
+#include <immintrin.h>
+#define VEC                 __m256i
+#define LANES               8
+#define VEC_ZERO            _mm256_setzero_si256()
+#define VEC_SET1_32(v)      _mm256_set1_epi32(v)
+#define VEC_ADD_32          _mm256_add_epi32
+#define VEC_SUB_32          _mm256_sub_epi32
+#define VEC_MADD_16         _mm256_madd_epi16
+#define VEC_SRAI_32         _mm256_srai_epi32
+#define VEC_PACKS_32        _mm256_packs_epi32
+#define VEC_PACKUS_16       _mm256_packus_epi16
+#define VEC_MIN_16          _mm256_min_epi16
+#define VEC_MAX_16          _mm256_max_epi16
+#define VEC_XOR             _mm256_xor_si256
+#define VEC_COMBINE(lo, hi) _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1)
+#else
+#include <emmintrin.h>
+#define VEC                 __m128i
+#define LANES               4
+#define VEC_ZERO            _mm_setzero_si128()
+#define VEC_SET1_32(v)      _mm_set1_epi32(v)
+#define VEC_ADD_32          _mm_add_epi32
+#define VEC_SUB_32          _mm_sub_epi32
+#define VEC_MADD_16         _mm_madd_epi16
+#define VEC_SRAI_32         _mm_srai_epi32
+#define VEC_PACKS_32        _mm_packs_epi32
+#define VEC_PACKUS_16       _mm_packus_epi16
+#define VEC_MIN_16          _mm_min_epi16
+#define VEC_MAX_16          _mm_max_epi16
+#define VEC_XOR             _mm_xor_si128
+#endif
+
+#define RECLIP(a,idx) \
+  if(a < min_values[idx]) a = min_values[idx];    \
+  if(a > max_values[idx]) a = max_values[idx]
+
+/* Tables without negative factors aren't clipped to the
+   limits (like the noclip C versions), only to the range of the type */
+
+static const int noclip_min[4] = { 0, 0, 0, 0 };
+static const int noclip_max_8[4] = { 0xff, 0xff, 0xff, 0xff };
+static const int noclip_max_16[4] = { 0xffff, 0xffff, 0xffff, 0xffff };
+
+#define INIT_LIMITS(bits, num_components)                               \
+  min_values = ctx->table_h.do_clip ? ctx->min_values_h : noclip_min;   \
+  max_values = ctx->table_h.do_clip ? ctx->max_values_h : noclip_max_##bits; \
+  min = get_limits_##bits(min_values, ctx->plane, num_components);      \
+  max = get_limits_##bits(max_values, ctx->plane, num_components)
+
+/* Two 14 bit factors in one 32 bit lane. For odd numbers of taps,
+   the last factor is paired with 0 */
+
+static inline int32_t factor_pair(const int32_t * f, int num)
+  {
+  if(num > 1)
+    return (f[0] & 0xFFFF) | (f[1] << 16);
+  else
+    return f[0] & 0xFFFF;
+  }
+
+/* Vectors with one value per lane */
+
+static inline VEC set_lanes(const int32_t * v)
+  {
+#ifdef AVX2
+  return _mm256_loadu_si256((const __m256i*)v);
+#else
+  return _mm_loadu_si128((const __m128i*)v);
+#endif
+  }
+
+/* Convert the accumulators (LANES 32 bit integers) and store them */
+
+static inline void store_8(uint8_t * dst, VEC acc, VEC min, VEC max)
+  {
+  acc = VEC_SRAI_32(acc, 14);
+  acc = VEC_PACKS_32(acc, acc);
+  acc = VEC_MIN_16(VEC_MAX_16(acc, min), max);
+  acc = VEC_PACKUS_16(acc, acc);
+#ifdef AVX2
+  _mm_storel_epi64((__m128i*)dst,
+                   _mm_unpacklo_epi32(_mm256_castsi256_si128(acc),
+                                      _mm256_extracti128_si256(acc, 1)));
+#else
+  {
+  int32_t tmp = _mm_cvtsi128_si32(acc);
+  memcpy(dst, &tmp, 4);
+  }
+#endif
+  }
+
+/* min and max must be biased by -0x8000 */
+
+static inline VEC pack_16(VEC acc, VEC min, VEC max)
+  {
+  acc = VEC_SUB_32(VEC_SRAI_32(acc, 13), VEC_SET1_32(0x8000));
+  acc = VEC_PACKS_32(acc, acc);
+  acc = VEC_MIN_16(VEC_MAX_16(acc, min), max);
+  return VEC_XOR(acc, VEC_SET1_32(0x80008000));
+  }
+
+static inline void store_16(uint8_t * dst, VEC acc, VEC min, VEC max)
+  {
+  acc = pack_16(acc, min, max);
+#ifdef AVX2
+  _mm_storeu_si128((__m128i*)dst,
+                   _mm_unpacklo_epi64(_mm256_castsi256_si128(acc),
+                                      _mm256_extracti128_si256(acc, 1)));
+#else
+  _mm_storel_epi64((__m128i*)dst, acc);
+#endif
+  }
+
+/* Clipping limits as packed words */
+
+static inline VEC get_limits_8(const int * limits, int plane, int num_components)
+  {
+  int i;
+  int32_t tmp[LANES];
+  for(i = 0; i < LANES; i++)
+    tmp[i] = limits[(num_components == 1) ? plane : i % num_components];
+  return VEC_PACKS_32(set_lanes(tmp), set_lanes(tmp));
+  }
+
+static inline VEC get_limits_16(const int * limits, int plane, int num_components)
+  {
+  int i;
+  int32_t tmp[LANES];
+  for(i = 0; i < LANES; i++)
+    tmp[i] = limits[(num_components == 1) ? plane : i % num_components] - 0x8000;
+  return VEC_PACKS_32(set_lanes(tmp), set_lanes(tmp));
+  }
+
+/* Single components: One pixel per lane */
+
+static inline void
+scale_uint8_x_1(gavl_video_scale_context_t * ctx, int scanline,
+                uint8_t * dst, const int num_taps)
+  {
+  int i, j, k, imax;
+  const uint8_t * src, * src_start;
+  const int32_t * factors;
+  int32_t pixels[LANES];
+  int32_t facs[LANES];
+  int tmp;
+  VEC acc, min, max;
+  const int * min_values, * max_values;
+
+  src_start = ctx->src + scanline * ctx->src_stride;
+
+  INIT_LIMITS(8, 1);
+
+  imax = ctx->dst_size / LANES;
+
+  for(i = 0; i < imax; i++)
+    {
+    acc = VEC_ZERO;
+    for(j = 0; j < num_taps; j += 2)
+      {
+      for(k = 0; k < LANES; k++)
+        {
+        src = src_start + ctx->table_h.pixels[i*LANES+k].index + j;
+        factors = ctx->table_h.pixels[i*LANES+k].factor_i + j;
+        pixels[k] = (num_taps - j > 1) ? (src[0] | (src[1] << 16)) : src[0];
+        facs[k] = factor_pair(factors, num_taps - j);
+        }
+      acc = VEC_ADD_32(acc, VEC_MADD_16(set_lanes(pixels), set_lanes(facs)));
+      }
+    store_8(dst, acc, min, max);
+    dst += LANES;
+    }
+
+  for(i = imax * LANES; i < ctx->dst_size; i++)
+    {
+    src = src_start + ctx->table_h.pixels[i].index;
+    factors = ctx->table_h.pixels[i].factor_i;
+    tmp = 0;
+    for(j = 0; j < num_taps; j++)
+      tmp += factors[j] * src[j];
+    tmp >>= 14;
+    RECLIP(tmp, ctx->plane);
+    *(dst++) = tmp;
+    }
+  }
+
+static inline void
+scale_uint16_x_1(gavl_video_scale_context_t * ctx, int scanline,
+                 uint8_t * dest_start, const int num_taps)
+  {
+  int i, j, k, imax;
+  const uint16_t * src;
+  const uint8_t * src_start;
+  uint16_t * dst;
+  const int32_t * factors;
+  int32_t pixels[LANES];
+  int32_t facs[LANES];
+  int tmp;
+  VEC acc, min, max;
+  const int * min_values, * max_values;
+
+  src_start = ctx->src + scanline * ctx->src_stride;
+  dst = (uint16_t*)dest_start;
+
+  INIT_LIMITS(16, 1);
+
+  imax = ctx->dst_size / LANES;
+
+  for(i = 0; i < imax; i++)
+    {
+    acc = VEC_ZERO;
+    for(j = 0; j < num_taps; j += 2)
+      {
+      for(k = 0; k < LANES; k++)
+        {
+        src = (const uint16_t*)src_start + ctx->table_h.pixels[i*LANES+k].index + j;
+        factors = ctx->table_h.pixels[i*LANES+k].factor_i + j;
+        pixels[k] = (num_taps - j > 1) ?
+          ((src[0] >> 1) | ((src[1] >> 1) << 16)) : (src[0] >> 1);
+        facs[k] = factor_pair(factors, num_taps - j);
+        }
+      acc = VEC_ADD_32(acc, VEC_MADD_16(set_lanes(pixels), set_lanes(facs)));
+      }
+    store_16((uint8_t*)dst, acc, min, max);
+    dst += LANES;
+    }
+
+  for(i = imax * LANES; i < ctx->dst_size; i++)
+    {
+    src = (const uint16_t*)src_start + ctx->table_h.pixels[i].index;
+    factors = ctx->table_h.pixels[i].factor_i;
+    tmp = 0;
+    for(j = 0; j < num_taps; j++)
+      tmp += factors[j] * (src[j] >> 1);
+    tmp >>= 13;
+    RECLIP(tmp, ctx->plane);
+    *(dst++) = tmp;
+    }
+  }
+
+/*
+ *  2 components: Load 2 taps of one pixel and interleave them:
+ *  a0 a1 b0 b1
+ */
+
+static inline __m128i load_2_16(const uint8_t * src, int num)
+  {
+  __m128i ret;
+  int32_t tmp;
+
+  if(num > 1)
+    ret = _mm_srli_epi16(_mm_loadl_epi64((const __m128i*)src), 1);
+  else
+    {
+    memcpy(&tmp, src, 4);
+    ret = _mm_srli_epi16(_mm_cvtsi32_si128(tmp), 1);
+    }
+  return _mm_shufflelo_epi16(ret, _MM_SHUFFLE(3, 1, 2, 0));
+  }
+
+#define PIXELS_2 (LANES/2)
+
+#ifdef AVX2
+#define LOAD_2(src, idx, j, num)                                        \
+  VEC_COMBINE(_mm_unpacklo_epi64(load_2_16(src + (ctx->table_h.pixels[idx].index + j) * 4, num), \
+                                 load_2_16(src + (ctx->table_h.pixels[idx+1].index + j) * 4, num)), \
+              _mm_unpacklo_epi64(load_2_16(src + (ctx->table_h.pixels[idx+2].index + j) * 4, num), \
+                                 load_2_16(src + (ctx->table_h.pixels[idx+3].index + j) * 4, num)))
+#else
+#define LOAD_2(src, idx, j, num)                                        \
+  _mm_unpacklo_epi64(load_2_16(src + (ctx->table_h.pixels[idx].index + j) * 4, num), \
+                     load_2_16(src + (ctx->table_h.pixels[idx+1].index + j) * 4, num))
+#endif
+
+static inline void
+scale_uint16_x_2(gavl_video_scale_context_t * ctx, int scanline,
+                 uint8_t * dest_start, const int num_taps)
+  {
+  int i, j, k, imax;
+  const uint16_t * src;
+  const uint8_t * src_start;
+  uint16_t * dst;
+  const int32_t * factors;
+  int32_t facs[LANES];
+  int tmp[2];
+  VEC acc, min, max;
+  const int * min_values, * max_values;
+
+  src_start = ctx->src + scanline * ctx->src_stride;
+  dst = (uint16_t*)dest_start;
+
+  INIT_LIMITS(16, 2);
+
+  imax = ctx->dst_size / PIXELS_2;
+
+  for(i = 0; i < imax; i++)
+    {
+    acc = VEC_ZERO;
+    for(j = 0; j < num_taps; j += 2)
+      {
+      for(k = 0; k < PIXELS_2; k++)
+        facs[2*k] = facs[2*k+1] =
+          factor_pair(ctx->table_h.pixels[i*PIXELS_2+k].factor_i + j, num_taps - j);
+      acc = VEC_ADD_32(acc,
+                       VEC_MADD_16(LOAD_2(src_start, i*PIXELS_2, j, num_taps - j),
+                                   set_lanes(facs)));
+      }
+    store_16((uint8_t*)dst, acc, min, max);
+    dst += 2 * PIXELS_2;
+    }
+
+  for(i = imax * PIXELS_2; i < ctx->dst_size; i++)
+    {
+    src = (const uint16_t*)src_start + 2 * ctx->table_h.pixels[i].index;
+    factors = ctx->table_h.pixels[i].factor_i;
+    tmp[0] = tmp[1] = 0;
+    for(j = 0; j < num_taps; j++)
+      {
+      for(k = 0; k < 2; k++)
+        tmp[k] += factors[j] * (src[k] >> 1);
+      src += 2;
+      }
+    for(k = 0; k < 2; k++)
+      {
+      tmp[k] >>= 13;
+      RECLIP(tmp[k], k);
+      *(dst++) = tmp[k];
+      }
+    }
+  }
+
+/*
+ *  3 components: Like 4 components with garbage in the last lane.
+ *  The loads read one word beyond the last tap, so the caller must make
+ *  sure that this doesn't go beyond the end of the scanline.
+ */
+
+static inline __m128i load_3_16(const uint16_t * src, int num)
+  {
+  __m128i ret;
+  ret = _mm_srli_epi16(_mm_loadl_epi64((const __m128i*)src), 1);
+  if(num > 1)
+    return _mm_unpacklo_epi16(ret,
+                              _mm_srli_epi16(_mm_loadl_epi64((const __m128i*)(src + 3)), 1));
+  else
+    return _mm_unpacklo_epi16(ret, _mm_setzero_si128());
+  }
+
+/*
+ *  4 components: Load 2 taps of one pixel and interleave them:
+ *  a0 b0 a1 b1 a2 b2 a3 b3
+ */
+
+static inline __m128i load_4_8(const uint8_t * src, int num)
+  {
+  __m128i zero = _mm_setzero_si128();
+  __m128i ret;
+  int32_t tmp;
+
+  if(num > 1)
+    {
+    ret = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)src), zero);
+    return _mm_unpacklo_epi16(ret, _mm_srli_si128(ret, 8));
+    }
+  memcpy(&tmp, src, 4);
+  ret = _mm_unpacklo_epi8(_mm_cvtsi32_si128(tmp), zero);
+  return _mm_unpacklo_epi16(ret, zero);
+  }
+
+static inline __m128i load_4_16(const uint8_t * src, int num)
+  {
+  __m128i ret;
+
+  if(num > 1)
+    {
+    ret = _mm_srli_epi16(_mm_loadu_si128((const __m128i*)src), 1);
+    return _mm_unpacklo_epi16(ret, _mm_srli_si128(ret, 8));
+    }
+  ret = _mm_srli_epi16(_mm_loadl_epi64((const __m128i*)src), 1);
+  return _mm_unpacklo_epi16(ret, _mm_setzero_si128());
+  }
+
+#ifdef AVX2
+#define PIXELS_4 2
+#define LOAD_4(func, src, idx, adv, j, num)                             \
+  VEC_COMBINE(func(src + (ctx->table_h.pixels[idx].index + j) * adv, num), \
+              func(src + (ctx->table_h.pixels[idx+1].index + j) * adv, num))
+#define FACTOR_4(idx, j, num)                                              \
+  _mm256_setr_epi32(fac0, fac0, fac0, fac0,                                \
+                    factor_pair(ctx->table_h.pixels[idx+1].factor_i + j, num), \
+                    factor_pair(ctx->table_h.pixels[idx+1].factor_i + j, num), \
+                    factor_pair(ctx->table_h.pixels[idx+1].factor_i + j, num), \
+                    factor_pair(ctx->table_h.pixels[idx+1].factor_i + j, num))
+#else
+#define PIXELS_4 1
+#define LOAD_4(func, src, idx, adv, j, num)                    \
+  func(src + (ctx->table_h.pixels[idx].index + j) * adv, num)
+#define FACTOR_4(idx, j, num) VEC_SET1_32(fac0)
+#endif
+
+static inline void
+scale_uint8_x_4(gavl_video_scale_context_t * ctx, int scanline,
+                uint8_t * dst, const int num_taps)
+  {
+  int i, j, k, imax;
+  const uint8_t * src, * src_start;
+  const int32_t * factors;
+  int32_t fac0;
+  int tmp[4];
+  VEC acc, min, max;
+  const int * min_values, * max_values;
+
+  src_start = ctx->src + scanline * ctx->src_stride;
+
+  INIT_LIMITS(8, 4);
+
+  imax = ctx->dst_size / PIXELS_4;
+
+  for(i = 0; i < imax; i++)
+    {
+    acc = VEC_ZERO;
+    for(j = 0; j < num_taps; j += 2)
+      {
+      fac0 = factor_pair(ctx->table_h.pixels[i*PIXELS_4].factor_i + j, num_taps - j);
+      acc = VEC_ADD_32(acc,
+                       VEC_MADD_16(LOAD_4(load_4_8, src_start, i*PIXELS_4, 4, j, num_taps - j),
+                                   FACTOR_4(i*PIXELS_4, j, num_taps - j)));
+      }
+    store_8(dst, acc, min, max);
+    dst += 4 * PIXELS_4;
+    }
+
+  for(i = imax * PIXELS_4; i < ctx->dst_size; i++)
+    {
+    src = src_start + 4 * ctx->table_h.pixels[i].index;
+    factors = ctx->table_h.pixels[i].factor_i;
+    tmp[0] = tmp[1] = tmp[2] = tmp[3] = 0;
+    for(j = 0; j < num_taps; j++)
+      {
+      for(k = 0; k < 4; k++)
+        tmp[k] += factors[j] * src[k];
+      src += 4;
+      }
+    for(k = 0; k < 4; k++)
+      {
+      tmp[k] >>= 14;
+      RECLIP(tmp[k], k);
+      *(dst++) = tmp[k];
+      }
+    }
+  }
+
+static inline void
+scale_uint16_x_4(gavl_video_scale_context_t * ctx, int scanline,
+                 uint8_t * dest_start, const int num_taps)
+  {
+  int i, j, k, imax;
+  const uint16_t * src;
+  const uint8_t * src_start;
+  uint16_t * dst;
+  const int32_t * factors;
+  int32_t fac0;
+  int tmp[4];
+  VEC acc, min, max;
+  const int * min_values, * max_values;
+
+  src_start = ctx->src + scanline * ctx->src_stride;
+  dst = (uint16_t*)dest_start;
+
+  INIT_LIMITS(16, 4);
+
+  imax = ctx->dst_size / PIXELS_4;
+
+  for(i = 0; i < imax; i++)
+    {
+    acc = VEC_ZERO;
+    for(j = 0; j < num_taps; j += 2)
+      {
+      fac0 = factor_pair(ctx->table_h.pixels[i*PIXELS_4].factor_i + j, num_taps - j);
+      acc = VEC_ADD_32(acc,
+                       VEC_MADD_16(LOAD_4(load_4_16, src_start, i*PIXELS_4, 8, j, num_taps - j),
+                                   FACTOR_4(i*PIXELS_4, j, num_taps - j)));
+      }
+    store_16((uint8_t*)dst, acc, min, max);
+    dst += 4 * PIXELS_4;
+    }
+
+  for(i = imax * PIXELS_4; i < ctx->dst_size; i++)
+    {
+    src = (const uint16_t*)src_start + 4 * ctx->table_h.pixels[i].index;
+    factors = ctx->table_h.pixels[i].factor_i;
+    tmp[0] = tmp[1] = tmp[2] = tmp[3] = 0;
+    for(j = 0; j < num_taps; j++)
+      {
+      for(k = 0; k < 4; k++)
+        tmp[k] += factors[j] * (src[k] >> 1);
+      src += 4;
+      }
+    for(k = 0; k < 4; k++)
+      {
+      tmp[k] >>= 13;
+      RECLIP(tmp[k], k);
+      *(dst++) = tmp[k];
+      }
+    }
+  }
+
+static inline void
+scale_uint16_x_3(gavl_video_scale_context_t * ctx, int scanline,
+                 uint8_t * dest_start, const int num_taps)
+  {
+  int i, j, k, imax, last;
+  const uint16_t * src, * src_start;
+  uint16_t * dst;
+  const int32_t * factors;
+  int32_t fac0;
+  int tmp[3];
+  VEC acc, min, max;
+  const int * min_values, * max_values;
+
+  src_start = (const uint16_t*)(ctx->src + scanline * ctx->src_stride);
+  dst = (uint16_t*)dest_start;
+
+  INIT_LIMITS(16, 4);
+
+  /* The 4th word of each pixel is garbage, which is overwritten
+     by the next pixel. So the last pixel is always done in C. Pixels,
+     which need the last source pixel, are also done in C because
+     load_3_16() reads beyond it. */
+  last = ctx->table_h.pixels[ctx->dst_size-1].index + num_taps - 1;
+  imax = ctx->dst_size - 1;
+  while((imax > 0) && (ctx->table_h.pixels[imax-1].index + num_taps - 1 >= last))
+    imax--;
+  imax /= PIXELS_4;
+
+  for(i = 0; i < imax; i++)
+    {
+    acc = VEC_ZERO;
+    for(j = 0; j < num_taps; j += 2)
+      {
+      fac0 = factor_pair(ctx->table_h.pixels[i*PIXELS_4].factor_i + j, num_taps - j);
+      acc = VEC_ADD_32(acc,
+                       VEC_MADD_16(LOAD_4(load_3_16, src_start, i*PIXELS_4, 3, j, num_taps - j),
+                                   FACTOR_4(i*PIXELS_4, j, num_taps - j)));
+      }
+    acc = pack_16(acc, min, max);
+#ifdef AVX2
+    _mm_storel_epi64((__m128i*)dst, _mm256_castsi256_si128(acc));
+    _mm_storel_epi64((__m128i*)(dst + 3), _mm256_extracti128_si256(acc, 1));
+#else
+    _mm_storel_epi64((__m128i*)dst, acc);
+#endif
+    dst += 3 * PIXELS_4;
+    }
+
+  for(i = imax * PIXELS_4; i < ctx->dst_size; i++)
+    {
+    src = src_start + 3 * ctx->table_h.pixels[i].index;
+    factors = ctx->table_h.pixels[i].factor_i;
+    tmp[0] = tmp[1] = tmp[2] = 0;
+    for(j = 0; j < num_taps; j++)
+      {
+      for(k = 0; k < 3; k++)
+        tmp[k] += factors[j] * (src[k] >> 1);
+      src += 3;
+      }
+    for(k = 0; k < 3; k++)
+      {
+      tmp[k] >>= 13;
+      RECLIP(tmp[k], k);
+      *(dst++) = tmp[k];
+      }
+    }
+  }
+
+/* Instantiate for fixed numbers of taps so the inner loops get unrolled */
+
+#define SCALE_FUNCS(name, num_taps)                                     \
+static void scale_uint8_x_1_x_##name(gavl_video_scale_context_t * ctx, \
+                                     int scanline, uint8_t * dst)     \
+  { scale_uint8_x_1(ctx, scanline, dst, num_taps); }                  \
+static void scale_uint8_x_4_x_##name(gavl_video_scale_context_t * ctx, \
+                                     int scanline, uint8_t * dst)     \
+  { scale_uint8_x_4(ctx, scanline, dst, num_taps); }                  \
+static void scale_uint16_x_1_x_##name(gavl_video_scale_context_t * ctx, \
+                                      int scanline, uint8_t * dst)    \
+  { scale_uint16_x_1(ctx, scanline, dst, num_taps); }                 \
+static void scale_uint16_x_2_x_##name(gavl_video_scale_context_t * ctx, \
+                                      int scanline, uint8_t * dst)    \
+  { scale_uint16_x_2(ctx, scanline, dst, num_taps); }                 \
+static void scale_uint16_x_3_x_##name(gavl_video_scale_context_t * ctx, \
+                                      int scanline, uint8_t * dst)    \
+  { scale_uint16_x_3(ctx, scanline, dst, num_taps); }                 \
+static void scale_uint16_x_4_x_##name(gavl_video_scale_context_t * ctx, \
+                                      int scanline, uint8_t * dst)    \
+  { scale_uint16_x_4(ctx, scanline, dst, num_taps); }
+
+SCALE_FUNCS(bilinear, 2)
+SCALE_FUNCS(quadratic, 3)
+SCALE_FUNCS(bicubic, 4)
+SCALE_FUNCS(generic, ctx->table_h.factors_per_pixel)
+
+#define INIT_FUNCS(name)                                        \
+  if((src_advance == 1) && (dst_advance == 1))                  \
+    {                                                           \
+    tab->funcs_x.scale_uint8_x_1_noadvance = scale_uint8_x_1_x_##name; \
+    tab->funcs_x.bits_uint8_noadvance = 14;                     \
+    }                                                           \
+  else if((src_advance == 2) && (dst_advance == 2))             \
+    {                                                           \
+    tab->funcs_x.scale_uint16_x_1 = scale_uint16_x_1_x_##name;  \
+    tab->funcs_x.bits_uint16 = 14;                              \
+    }                                                           \
+  else if((src_advance == 4) && (dst_advance == 4))             \
+    {                                                           \
+    tab->funcs_x.scale_uint8_x_3 = scale_uint8_x_4_x_##name;    \
+    tab->funcs_x.scale_uint8_x_4 = scale_uint8_x_4_x_##name;    \
+    tab->funcs_x.bits_uint8_noadvance = 14;                     \
+    tab->funcs_x.scale_uint16_x_2 = scale_uint16_x_2_x_##name;  \
+    tab->funcs_x.bits_uint16 = 14;                              \
+    }                                                           \
+  else if((src_advance == 6) && (dst_advance == 6))             \
+    {                                                           \
+    tab->funcs_x.scale_uint16_x_3 = scale_uint16_x_3_x_##name;  \
+    tab->funcs_x.bits_uint16 = 14;                              \
+    }                                                           \
+  else if((src_advance == 8) && (dst_advance == 8))             \
+    {                                                           \
+    tab->funcs_x.scale_uint16_x_4 = scale_uint16_x_4_x_##name;  \
+    tab->funcs_x.bits_uint16 = 14;                              \
+    }
+
+#ifdef AVX2
+#define INIT_NAME(name) gavl_init_scale_funcs_##name##_x_avx2
+#else
+#define INIT_NAME(name) gavl_init_scale_funcs_##name##_x_sse2
+#endif
+
+void INIT_NAME(bilinear)(gavl_scale_funcs_t * tab,
+                         int src_advance, int dst_advance)
+  {
+  INIT_FUNCS(bilinear);
+  }
+
+void INIT_NAME(quadratic)(gavl_scale_funcs_t * tab,
+                          int src_advance, int dst_advance)
+  {
+  INIT_FUNCS(quadratic);
+  }
+
+void INIT_NAME(bicubic)(gavl_scale_funcs_t * tab,
+                        int src_advance, int dst_advance)
+  {
+  INIT_FUNCS(bicubic);
+  }
+
+void INIT_NAME(generic)(gavl_scale_funcs_t * tab,
+                        int src_advance, int dst_advance)
+  {
+  INIT_FUNCS(generic);
+  }
@@ -0,0 +1,383 @@
+/*****************************************************************
+ * gavl - a general purpose audio/video processing library
+ *
+ * Copyright (c) 2001 - 2012 Members of the Gmerlin project
+ * gmerlin-general@lists.sourceforge.net
+ * http://gmerlin.sourceforge.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * *****************************************************************/
+
+/* Work stealing thread pool */
+
+#include <config.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include <gavl.h>
+
+/*
+ *  Each submitting thread has its own batch, which counts the
+ *  unfinished tasks. gavl_thread_pool_stop() waits until it becomes zero.
+ */
+
+typedef struct
+  {
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  int pending;
+  } batch_t;
+
+typedef struct
+  {
+  gavl_video_process_func func;
+  void * data;
+  int start;
+  int end;
+  batch_t * batch;
+  } task_t;
+
+typedef struct
+  {
+  pthread_mutex_t mutex;
+
+  /* Ring buffer of queued tasks */
+  task_t * tasks;
+  int tasks_alloc;
+  int head;
+  int num;
+
+  pthread_t thread;
+  int index;
+  gavl_thread_pool_t * pool;
+  } worker_t;
+
+struct gavl_thread_pool_s
+  {
+  int num_threads;
+  worker_t * workers;
+
+  /* Protects the members below */
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+
+  int num_queued;
+  int do_stop;
+  int started;
+
+  /* Number of workers, which could actually be started */
+  int num_started;
+  };
+
+static pthread_key_t batch_key;
+static pthread_once_t batch_key_once = PTHREAD_ONCE_INIT;
+
+static void batch_destroy(void * data)
+  {
+  batch_t * b = data;
+  pthread_mutex_destroy(&b->mutex);
+  pthread_cond_destroy(&b->cond);
+  free(b);
+  }
+
+static void batch_key_create(void)
+  {
+  pthread_key_create(&batch_key, batch_destroy);
+  }
+
+static batch_t * get_batch(void)
+  {
+  batch_t * b;
+  pthread_once(&batch_key_once, batch_key_create);
+
+  b = pthread_getspecific(batch_key);
+  if(!b)
+    {
+    b = calloc(1, sizeof(*b));
+    pthread_mutex_init(&b->mutex, NULL);
+    pthread_cond_init(&b->cond, NULL);
+    pthread_setspecific(batch_key, b);
+    }
+  return b;
+  }
+
+/* Queue handling */
+
+static void worker_push(worker_t * w, const task_t * t)
+  {
+  pthread_mutex_lock(&w->mutex);
+
+  if(w->num == w->tasks_alloc)
+    {
+    task_t * tasks;
+    int i;
+    int alloc = w->tasks_alloc ? w->tasks_alloc * 2 : 16;
+
+    tasks = malloc(alloc * sizeof(*tasks));
+    for(i = 0; i < w->num; i++)
+      tasks[i] = w->tasks[(w->head + i) % w->tasks_alloc];
+    free(w->tasks);
+    w->tasks = tasks;
+    w->tasks_alloc = alloc;
+    w->head = 0;
+    }
+
+  w->tasks[(w->head + w->num) % w->tasks_alloc] = *t;
+  w->num++;
+
+  pthread_mutex_unlock(&w->mutex);
+  }
+
+/* The owner takes the most recent task, thieves take the oldest one */
+
+static int worker_pop(worker_t * w, task_t * t, int steal)
+  {
+  int ret = 0;
+  pthread_mutex_lock(&w->mutex);
+
+  if(w->num)
+    {
+    if(steal)
+      {
+      *t = w->tasks[w->head];
+      w->head = (w->head + 1) % w->tasks_alloc;
+      }
+    else
+      *t = w->tasks[(w->head + w->num - 1) % w->tasks_alloc];
+    w->num--;
+    ret = 1;
+    }
+
+  pthread_mutex_unlock(&w->mutex);
+  return ret;
+  }
+
+/* self < 0 means we are no worker of this pool */
+
+static int get_task(gavl_thread_pool_t * p, int self, task_t * t)
+  {
+  int i;
+  int start;
+
+  if((self >= 0) && worker_pop(&p->workers[self], t, 0))
+    goto found;
+
+  start = (self >= 0) ? self + 1 : 0;
+
+  for(i = 0; i < p->num_threads; i++)
+    {
+    if(worker_pop(&p->workers[(start + i) % p->num_threads], t, 1))
+      goto found;
+    }
+  return 0;
+
+  found:
+  pthread_mutex_lock(&p->mutex);
+  p->num_queued--;
+  pthread_mutex_unlock(&p->mutex);
+  return 1;
+  }
+
+static void run_task(task_t * t)
+  {
+  batch_t * b = t->batch;
+
+  t->func(t->data, t->start, t->end);
+
+  pthread_mutex_lock(&b->mutex);
+  b->pending--;
+  if(!b->pending)
+    pthread_cond_broadcast(&b->cond);
+  pthread_mutex_unlock(&b->mutex);
+  }
+
+static void * worker_thread(void * data)
+  {
+  task_t t;
+  worker_t * w = data;
+  gavl_thread_pool_t * p = w->pool;
+
+  while(1)
+    {
+    if(get_task(p, w->index, &t))
+      {
+      run_task(&t);
+      continue;
+      }
+
+    pthread_mutex_lock(&p->mutex);
+    while((p->num_queued <= 0) && !p->do_stop)
+      pthread_cond_wait(&p->cond, &p->mutex);
+
+    if(p->do_stop && (p->num_queued <= 0))
+      {
+      pthread_mutex_unlock(&p->mutex);
+      break;
+      }
+    pthread_mutex_unlock(&p->mutex);
+    }
+  return NULL;
+  }
+
+/*
+ *  Workers are started in index order, so the first num_started
+ *  ones are running. If a thread cannot be created, we continue with
+ *  the ones we have.
+ */
+
+static void start_threads(gavl_thread_pool_t * p)
+  {
+  int i;
+  for(i = 0; i < p->num_threads; i++)
+    {
+    if(pthread_create(&p->workers[i].thread, NULL,
+                      worker_thread, &p->workers[i]))
+      break;
+    }
+  p->num_started = i;
+  p->started = 1;
+  }
+
+/* Public functions */
+
+gavl_thread_pool_t * gavl_thread_pool_create(int num_threads)
+  {
+  int i;
+  gavl_thread_pool_t * ret;
+
+  if(num_threads <= 0)
+    {
+#ifdef _SC_NPROCESSORS_ONLN
+    num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    if(num_threads <= 0)
+      num_threads = 1;
+    }
+
+  ret = calloc(1, sizeof(*ret));
+  ret->num_threads = num_threads;
+  ret->workers = calloc(num_threads, sizeof(*ret->workers));
+
+  pthread_mutex_init(&ret->mutex, NULL);
+  pthread_cond_init(&ret->cond, NULL);
+
+  for(i = 0; i < num_threads; i++)
+    {
+    pthread_mutex_init(&ret->workers[i].mutex, NULL);
+    ret->workers[i].index = i;
+    ret->workers[i].pool = ret;
+    }
+  return ret;
+  }
+
+void gavl_thread_pool_destroy(gavl_thread_pool_t * p)
+  {
+  int i;
+
+  pthread_mutex_lock(&p->mutex);
+  p->do_stop = 1;
+  pthread_cond_broadcast(&p->cond);
+  pthread_mutex_unlock(&p->mutex);
+
+  for(i = 0; i < p->num_threads; i++)
+    {
+    if(i < p->num_started)
+      pthread_join(p->workers[i].thread, NULL);
+    pthread_mutex_destroy(&p->workers[i].mutex);
+    if(p->workers[i].tasks)
+      free(p->workers[i].tasks);
+    }
+
+  pthread_mutex_destroy(&p->mutex);
+  pthread_cond_destroy(&p->cond);
+  free(p->workers);
+  free(p);
+  }
+
+int gavl_thread_pool_get_num_threads(gavl_thread_pool_t * p)
+  {
+  return p->num_threads;
+  }
+
+void gavl_thread_pool_run(gavl_video_process_func func,
+                          void * gavl_data,
+                          int start, int end,
+                          void * client_data, int thread)
+  {
+  task_t t;
+  gavl_thread_pool_t * p = client_data;
+
+  t.func  = func;
+  t.data  = gavl_data;
+  t.start = start;
+  t.end   = end;
+  t.batch = get_batch();
+
+  pthread_mutex_lock(&t.batch->mutex);
+  t.batch->pending++;
+  pthread_mutex_unlock(&t.batch->mutex);
+
+  if(thread < 0)
+    thread = 0;
+
+  pthread_mutex_lock(&p->mutex);
+  if(!p->started)
+    start_threads(p);
+
+  /* No workers at all: Run the task in the calling thread */
+  if(!p->num_started)
+    {
+    pthread_mutex_unlock(&p->mutex);
+    run_task(&t);
+    return;
+    }
+
+  worker_push(&p->workers[thread % p->num_started], &t);
+  p->num_queued++;
+  pthread_cond_signal(&p->cond);
+  pthread_mutex_unlock(&p->mutex);
+  }
+
+void gavl_thread_pool_stop(void * client_data, int thread)
+  {
+  task_t t;
+  gavl_thread_pool_t * p = client_data;
+  batch_t * b = get_batch();
+
+  while(1)
+    {
+    pthread_mutex_lock(&b->mutex);
+    if(!b->pending)
+      {
+      pthread_mutex_unlock(&b->mutex);
+      return;
+      }
+    pthread_mutex_unlock(&b->mutex);
+
+    /* Help out instead of sleeping */
+    if(get_task(p, -1, &t))
+      run_task(&t);
+    else
+      break;
+    }
+
+  /* Remaining tasks are running in the workers */
+  pthread_mutex_lock(&b->mutex);
+  while(b->pending)
+    pthread_cond_wait(&b->cond, &b->mutex);
+  pthread_mutex_unlock(&b->mutex);
+  }
@@ -55,16 +55,10 @@ void gavl_image_transform_destroy(gavl_image_transform_t * t)
   free(t);
   }
 
-/** \brief Destroy a transformation engine
- *  \param A transformation engine
- *  \param Format (can be changed)
- *  \param func Coordinate transform function
- *  \param priv The priv argument for func
- */
-
-int gavl_image_transform_init(gavl_image_transform_t * t,
-                               gavl_video_format_t * format,
-                               gavl_image_transform_func func, void * priv)
+static int init_transform(gavl_image_transform_t * t,
+                          gavl_video_format_t * format,
+                          gavl_image_transform_func func, void * priv,
+                          const double (*matrix)[3])
   {
   int i, j;
   gavl_video_options_t opt;
@@ -119,12 +113,39 @@ int gavl_image_transform_init(gavl_image_transform_t * t,
   for(i = 0; i < t->num_fields; i++)
     for(j = 0; j < t->num_planes; j++)
       {
-      if(!gavl_transform_context_init(t, &opt, i, j, func, priv))
+      if(!gavl_transform_context_init(t, &opt, i, j, func, priv, matrix))
         return 0;
       }
   return 1;
   }
 
+/** \brief Initialize a transformation engine
+ *  \param A transformation engine
+ *  \param Format (can be changed)
+ *  \param func Coordinate transform function
+ *  \param priv The priv argument for func
+ */
+
+int gavl_image_transform_init(gavl_image_transform_t * t,
+                               gavl_video_format_t * format,
+                               gavl_image_transform_func func, void * priv)
+  {
+  return init_transform(t, format, func, priv, NULL);
+  }
+
+/** \brief Initialize a transformation engine for a perspective transform
+ *  \param A transformation engine
+ *  \param Format (can be changed)
+ *  \param matrix Maps destination to source coordinates
+ */
+
+int gavl_image_transform_init_matrix(gavl_image_transform_t * t,
+                                     gavl_video_format_t * format,
+                                     const double matrix[3][3])
+  {
+  return init_transform(t, format, NULL, NULL, matrix);
+  }
+
 /** \brief Transform an image
  *  \param A transformation engine
  *  \param Input frame
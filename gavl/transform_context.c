@@ -150,6 +150,10 @@ static void init_func_tab(gavl_video_options_t * opt,
       if((opt->quality < 3) && (opt->accel_flags & GAVL_ACCEL_MMXEXT))
         gavl_init_transform_funcs_bilinear_mmxext(func_tab, ctx->advance);
       
+#endif
+#ifdef HAVE_AVX2
+      if(opt->accel_flags & GAVL_ACCEL_AVX2)
+        gavl_init_transform_funcs_bilinear_avx2(func_tab, ctx->advance);
 #endif
       break;
     case 3:
@@ -160,6 +164,10 @@ static void init_func_tab(gavl_video_options_t * opt,
         gavl_init_transform_funcs_quadratic_mmx(func_tab, ctx->advance);
       if((opt->quality < 3) && (opt->accel_flags & GAVL_ACCEL_MMXEXT))
         gavl_init_transform_funcs_quadratic_mmxext(func_tab, ctx->advance);
+#endif
+#ifdef HAVE_AVX2
+      if(opt->accel_flags & GAVL_ACCEL_AVX2)
+        gavl_init_transform_funcs_quadratic_avx2(func_tab, ctx->advance);
 #endif
       break;
     case 4:
@@ -170,6 +178,10 @@ static void init_func_tab(gavl_video_options_t * opt,
         gavl_init_transform_funcs_bicubic_mmx(func_tab, ctx->advance);
       if((opt->quality < 3) && (opt->accel_flags & GAVL_ACCEL_MMXEXT))
         gavl_init_transform_funcs_bicubic_mmxext(func_tab, ctx->advance);
+#endif
+#ifdef HAVE_AVX2
+      if(opt->accel_flags & GAVL_ACCEL_AVX2)
+        gavl_init_transform_funcs_bicubic_avx2(func_tab, ctx->advance);
 #endif
       break;
     default:
@@ -182,7 +194,8 @@ int
 gavl_transform_context_init(gavl_image_transform_t * t,
                             gavl_video_options_t * opt,
                             int field_index, int plane_index,
-                            gavl_image_transform_func func, void * priv)
+                            gavl_image_transform_func func, void * priv,
+                            const double (*matrix)[3])
   {
   gavl_transform_funcs_t func_tab;
   int bits = 0;
@@ -266,7 +279,7 @@ gavl_transform_context_init(gavl_image_transform_t * t,
     }
 
   gavl_transform_table_init(&ctx->tab, opt,
-                            func, priv,
+                            func, priv, matrix,
                             off_x, off_y, scale_x,
                             scale_y,
                             ctx->dst_width, ctx->dst_height);
@@ -284,30 +297,54 @@ gavl_transform_context_init(gavl_image_transform_t * t,
   
   /* Now we know the bits, convert to int */
   if(bits)
-    gavl_transform_table_init_int(&ctx->tab,
-                                  bits, ctx->dst_width, ctx->dst_height);
+    gavl_transform_table_init_int(&ctx->tab, bits);
   return 1;
   }
 
+/* Transform the scanlines start..end tile by tile */
+
 static void func_1(void* p, int start, int end)
   {
-  int i;
-  uint8_t * dst_save;
+  int i, x, y, w, h;
+  uint8_t * dst_start;
   int dst_stride;
+  gavl_transform_entry_t entries[TRANSFORM_TILE_WIDTH];
+  gavl_transform_pixel_t border[TRANSFORM_TILE_WIDTH];
   
   gavl_transform_context_t * ctx = p;
   dst_stride =
     ctx->dst_frame->strides[ctx->plane] *
     ctx->num_fields;
   
-  dst_save = ctx->dst_frame->planes[ctx->plane] +
-    ctx->offset + ctx->field * ctx->dst_frame->strides[ctx->plane] +
-    start * dst_stride;
+  dst_start = ctx->dst_frame->planes[ctx->plane] +
+    ctx->offset + ctx->field * ctx->dst_frame->strides[ctx->plane];
   
-  for(i = start; i < end; i++)
+  for(y = start; y < end; y += TRANSFORM_TILE_HEIGHT)
     {
-    ctx->func(ctx, ctx->tab.pixels[i], dst_save);
-    dst_save += dst_stride;
+    h = end - y;
+    if(h > TRANSFORM_TILE_HEIGHT)
+      h = TRANSFORM_TILE_HEIGHT;
+
+    for(x = 0; x < ctx->dst_width; x += TRANSFORM_TILE_WIDTH)
+      {
+      w = ctx->dst_width - x;
+      if(w > TRANSFORM_TILE_WIDTH)
+        w = TRANSFORM_TILE_WIDTH;
+      
+      for(i = y; i < y + h; i++)
+        {
+        if(ctx->tab.parametric)
+          {
+          gavl_transform_table_get_entries(&ctx->tab, i, x, w,
+                                           entries, border);
+          ctx->func(ctx, entries, border,
+                    dst_start + i * dst_stride + x * ctx->advance, w);
+          }
+        else
+          ctx->func(ctx, ctx->tab.entries[i] + x, ctx->tab.border[i],
+                    dst_start + i * dst_stride + x * ctx->advance, w);
+        }
+      }
     }
 #ifdef HAVE_MMX
   if(ctx->need_emms)
@@ -322,67 +359,16 @@ void gavl_transform_context_transform(gavl_transform_context_t * ctx,
                                  const gavl_video_frame_t * src,
                                  gavl_video_frame_t * dst)
   {
-  int i;
-  /* Things set while transforming */
-  //  uint8_t * src; /* Beginning of plane */
-  //  int src_stride;
-  
-  //  uint8_t * dst; /* Current scanline */
-  //  int dst_stride;
-  
   ctx->src = src->planes[ctx->plane] +
     ctx->offset + ctx->field * src->strides[ctx->plane];
   
   ctx->src_stride = src->strides[ctx->plane] * ctx->num_fields;
+  ctx->dst_frame = dst;
   
   if(ctx->opt->num_threads > 1)
-    {
-    int delta;
-    int scanline;
-    int nt;
-    
-    ctx->dst_frame = dst;
-    nt = ctx->opt->num_threads;
-    if(nt > ctx->dst_height)
-      nt = ctx->dst_height;
-    
-    delta = ctx->dst_height / nt;
-    scanline = 0;
-    for(i = 0; i < nt - 1; i++)
-      {
-      ctx->opt->run_func(func_1, ctx, scanline,
-                         scanline+delta, ctx->opt->run_data, i);
-      scanline += delta;
-      }
-    ctx->opt->run_func(func_1, ctx, scanline, ctx->dst_height,
-                       ctx->opt->run_data, nt - 1);
-    
-    for(i = 0; i < nt; i++)
-      ctx->opt->stop_func(ctx->opt->stop_data, i);
-    }
+    gavl_video_run_slices(ctx->opt, func_1, ctx, ctx->dst_height);
   else
-    {
-    int dst_stride;
-    uint8_t * dst_save;
-
-    dst_save = dst->planes[ctx->plane] +
-      ctx->offset + ctx->field * dst->strides[ctx->plane];
-    
-    dst_stride = dst->strides[ctx->plane] * ctx->num_fields;
-    for(i = 0; i < ctx->dst_height; i++)
-      {
-      ctx->func(ctx, ctx->tab.pixels[i], dst_save);
-      dst_save += dst_stride;
-      }
-#ifdef HAVE_MMX
-    if(ctx->need_emms)
-      {
-      __asm__ __volatile__ ("emms");
-      // fprintf(stderr, "emms");
-      }
-#endif
-    }
-  
+    func_1(ctx, 0, ctx->dst_height);
   }
 
 void
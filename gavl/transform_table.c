@@ -21,6 +21,7 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 #include <gavl/gavl.h>
 #include <video.h>
@@ -118,200 +119,315 @@ static void shift_up(gavl_transform_pixel_t * p, int factors_per_pixel,
   p->index_y -= delta;
   }
 
-static void shift_borders(gavl_transform_table_t * tab,
-                          int width, int i, int height)
+static void shift_borders(gavl_transform_pixel_t * p, int factors_per_pixel,
+                          int width, int height)
   {
-  int j;
-
-  for(j = 0; j < width; j++)
-    {
-    /* Check left overshot */
-    if(tab->pixels[i][j].index_x < 0)
-      shift_right(&tab->pixels[i][j], tab->factors_per_pixel,
-                  -tab->pixels[i][j].index_x);
+  /* Check left overshot */
+  if(p->index_x < 0)
+    shift_right(p, factors_per_pixel, -p->index_x);
       
-    /* Check right overshot */
-    if(tab->pixels[i][j].index_x + tab->factors_per_pixel > width)
-      shift_left(&tab->pixels[i][j], tab->factors_per_pixel,
-                 tab->pixels[i][j].index_x +
-                 tab->factors_per_pixel - width);
+  /* Check right overshot */
+  if(p->index_x + factors_per_pixel > width)
+    shift_left(p, factors_per_pixel,
+               p->index_x + factors_per_pixel - width);
       
-    /* Check top overshot */
-    if(tab->pixels[i][j].index_y < 0)
-      shift_down(&tab->pixels[i][j], tab->factors_per_pixel,
-                 -tab->pixels[i][j].index_y);
+  /* Check top overshot */
+  if(p->index_y < 0)
+    shift_down(p, factors_per_pixel, -p->index_y);
       
-    /* Check bottom overshot */
-    if(tab->pixels[i][j].index_y + tab->factors_per_pixel > height)
-      shift_up(&tab->pixels[i][j], tab->factors_per_pixel,
-               tab->pixels[i][j].index_y +
-               tab->factors_per_pixel - height);
-    }
+  /* Check bottom overshot */
+  if(p->index_y + factors_per_pixel > height)
+    shift_up(p, factors_per_pixel,
+             p->index_y + factors_per_pixel - height);
   }
 
-static void normalize(gavl_transform_table_t * tab,
-                      int width, int i)
+static void normalize(gavl_transform_pixel_t * p, int factors_per_pixel)
   {
-  int j, k, l;
+  int k, l;
   float sum;
   
-  for(j = 0; j < width; j++)
+  sum = 0.0;
+  for(k = 0; k < factors_per_pixel; k++)
+    {
+    for(l = 0; l < factors_per_pixel; l++)
+      {
+      sum += p->factors[k][l];
+      }
+    }
+  for(k = 0; k < factors_per_pixel; k++)
+    {
+    for(l = 0; l < factors_per_pixel; l++)
+      p->factors[k][l] /= sum;
+    }
+  }
+
+/* Convert the float factors of a pixel to integers, which sum up to (1<<bits) */
+
+static void pixel_init_int(gavl_transform_pixel_t * p, int factors_per_pixel,
+                           int bits)
+  {
+  int fac_max_i, k, l;
+  float fac_max_f;
+  int sum_i;
+  int min_index_k, max_index_k;
+  int min_index_l, max_index_l;
+  
+  fac_max_i = (1<<bits);
+  fac_max_f = (float)(fac_max_i);
+  
+  min_index_k = 0;
+  max_index_k = 0;
+  min_index_l = 0;
+  max_index_l = 0;
+      
+  sum_i = 0;
+      
+  for(k = 0; k < factors_per_pixel; k++)
     {
-    sum = 0.0;
-    for(k = 0; k < tab->factors_per_pixel; k++)
+    for(l = 0; l < factors_per_pixel; l++)
       {
-      for(l = 0; l < tab->factors_per_pixel; l++)
+      p->factors_i[k][l] = (int)(fac_max_f * p->factors[k][l]+0.5);
+      sum_i += p->factors_i[k][l];
+
+      if(k || l)
         {
-        sum += tab->pixels[i][j].factors[k][l];
+        if(p->factors_i[k][l] > p->factors_i[max_index_k][max_index_l])
+          {
+          max_index_k = k;
+          max_index_l = l;
+          }
+        if(p->factors_i[k][l] < p->factors_i[min_index_k][min_index_l])
+          {
+          min_index_k = k;
+          min_index_l = l;
+          }
         }
       }
-    for(k = 0; k < tab->factors_per_pixel; k++)
+    }
+      
+  if(sum_i > fac_max_i)
+    p->factors_i[max_index_k][max_index_l] -= (sum_i - fac_max_i);
+  else if(sum_i < fac_max_i)
+    p->factors_i[min_index_k][min_index_l] += (fac_max_i - sum_i);
+  }
+
+/* Same for one dimension of the coefficient table */
+
+static void lut_init_int(const float (*lut_f)[MAX_TRANSFORM_FILTER],
+                         int (*lut_i)[MAX_TRANSFORM_FILTER],
+                         int factors_per_pixel, int bits)
+  {
+  int i, k, sum_i, min_index, max_index;
+  int fac_max_i = (1<<bits);
+  
+  for(i = 0; i < TRANSFORM_PHASES; i++)
+    {
+    sum_i = 0;
+    min_index = 0;
+    max_index = 0;
+    
+    for(k = 0; k < factors_per_pixel; k++)
       {
-      for(l = 0; l < tab->factors_per_pixel; l++)
-        tab->pixels[i][j].factors[k][l] /= sum;
+      lut_i[i][k] = (int)((float)fac_max_i * lut_f[i][k] + 0.5);
+      sum_i += lut_i[i][k];
+      
+      if(lut_i[i][k] > lut_i[i][max_index])
+        max_index = k;
+      if(lut_i[i][k] < lut_i[i][min_index])
+        min_index = k;
       }
+    if(sum_i > fac_max_i)
+      lut_i[i][max_index] -= (sum_i - fac_max_i);
+    else if(sum_i < fac_max_i)
+      lut_i[i][min_index] += (fac_max_i - sum_i);
+    }
+  }
+
+/* Calculate the complete pixel, if the filter must be cut at the image border */
+
+static void init_border(const gavl_transform_table_t * tab,
+                        int index_x, int index_y, int phase_x, int phase_y,
+                        gavl_transform_pixel_t * border)
+  {
+  int k, l;
+  
+  border->index_x = index_x;
+  border->index_y = index_y;
+  border->outside = 0;
+  
+  for(k = 0; k < tab->factors_per_pixel; k++)
+    {
+    for(l = 0; l < tab->factors_per_pixel; l++)
+      border->factors[k][l] = tab->lut_f[phase_y][k] * tab->lut_f[phase_x][l];
     }
+  
+  shift_borders(border, tab->factors_per_pixel, tab->width, tab->height);
+  normalize(border, tab->factors_per_pixel);
+
+  if(tab->bits)
+    pixel_init_int(border, tab->factors_per_pixel, tab->bits);
+  }
+
+/*
+ *  Set up the entry for one destination pixel from the source position
+ *  in plane coordinates. If the filter must be cut at the image border,
+ *  the complete pixel is calculated in border and 1 is returned.
+ */
+
+static inline int init_entry(const gavl_transform_table_t * tab,
+                             double x_src_f, double y_src_f,
+                             gavl_transform_entry_t * e,
+                             gavl_transform_pixel_t * border)
+  {
+  int x_src_nearest, y_src_nearest;
+  int x_fixed, y_fixed;
+  int index_x, index_y, phase_x, phase_y;
+
+  e->reserved = 0;
+  
+  if((x_src_f < 0.0) || (x_src_f > (double)tab->width) || 
+     (y_src_f < 0.0) || (y_src_f > (double)tab->height))
+    {
+    e->type = TRANSFORM_ENTRY_OUTSIDE;
+    e->index_x = 0;
+    e->index_y = 0;
+    return 0;
+    }
+
+  e->type = TRANSFORM_ENTRY_FILTER;
+  e->phase_x = 0;
+  e->phase_y = 0;
+  
+  if(tab->factors_per_pixel == 1)
+    {
+    x_src_nearest = ROUND(x_src_f);
+    y_src_nearest = ROUND(y_src_f);
+    
+    if(x_src_nearest > tab->width - 1)
+      x_src_nearest = tab->width - 1;
+    if(y_src_nearest > tab->height - 1)
+      y_src_nearest = tab->height - 1;
+
+    if((tab->width <= 0xffff) && (tab->height <= 0xffff))
+      {
+      e->index_x = x_src_nearest;
+      e->index_y = y_src_nearest;
+      return 0;
+      }
+
+    /* The index doesn't fit into the entry */
+    border->index_x = x_src_nearest;
+    border->index_y = y_src_nearest;
+    border->outside = 0;
+    border->factors[0][0] = 1.0;
+    if(tab->bits)
+      pixel_init_int(border, 1, tab->bits);
+    e->type = TRANSFORM_ENTRY_BORDER;
+    return 1;
+    }
+
+  /* Position in 1/TRANSFORM_PHASES pixels */
+  x_fixed = (int)(x_src_f * TRANSFORM_PHASES + 0.5) + TRANSFORM_PHASES / 2;
+  y_fixed = (int)(y_src_f * TRANSFORM_PHASES + 0.5) + TRANSFORM_PHASES / 2;
+
+  index_x = (x_fixed >> TRANSFORM_PHASE_BITS) - tab->factors_per_pixel/2;
+  index_y = (y_fixed >> TRANSFORM_PHASE_BITS) - tab->factors_per_pixel/2;
+  phase_x = x_fixed & (TRANSFORM_PHASES - 1);
+  phase_y = y_fixed & (TRANSFORM_PHASES - 1);
+  
+  if((index_x >= 0) && (index_x + tab->factors_per_pixel <= tab->width) &&
+     (index_y >= 0) && (index_y + tab->factors_per_pixel <= tab->height) &&
+     (tab->width <= 0xffff) && (tab->height <= 0xffff))
+    {
+    e->index_x = index_x;
+    e->index_y = index_y;
+    e->phase_x = phase_x;
+    e->phase_y = phase_y;
+    return 0;
+    }
+
+  init_border(tab, index_x, index_y, phase_x, phase_y, border);
+  e->type = TRANSFORM_ENTRY_BORDER;
+  return 1;
+  }
+
+static void set_border_index(gavl_transform_entry_t * e, int index)
+  {
+  e->index_x = index & 0xffff;
+  e->index_y = index >> 16;
   }
 
 typedef struct
   {
-  float off_x;
-  float off_y;
-  float scale_x, scale_y;
-  int width;
-  int height;
   gavl_image_transform_func func;
-  gavl_video_scale_get_weight weight_func;
   gavl_transform_table_t * tab;
   void * func_priv;
-  gavl_video_options_t * opt;
   } slice_data_t;
 
 static void init_slice(void* p, int start, int end)
   {
-  int i, j, k, l;
+  int i, j, num;
   slice_data_t * sd = p;
-
+  gavl_transform_table_t * tab = sd->tab;
+  gavl_transform_pixel_t * border;
   double x_src_f, y_src_f, x_dst_f, y_dst_f;
-  int x_src_nearest, y_src_nearest;
-  double t;
-  double w_x[MAX_TRANSFORM_FILTER];
-  double w_y;
+
+  border = malloc(tab->width * sizeof(*border));
   
   for(i = start; i < end; i++)
     {
-    y_dst_f = sd->scale_y * (double)i + sd->off_y;
-    for(j = 0; j < sd->width; j++)
+    num = 0;
+    y_dst_f = tab->scale_y * (double)i + tab->off_y;
+    for(j = 0; j < tab->width; j++)
       {
-      x_dst_f = sd->scale_x * (double)j + sd->off_x;
+      x_dst_f = tab->scale_x * (double)j + tab->off_x;
       
       sd->func(sd->func_priv, x_dst_f, y_dst_f, &x_src_f, &y_src_f);
 
-      //      fprintf(stderr, "Transform: src: %f %f -> dst: %f %f\n",
-      //              x_src_f, y_src_f, x_dst_f, y_dst_f);
-
-      //      x_src_f = (x_src_f - sd->off_x) / sd->scale_x;
-      //      y_src_f = (y_src_f - sd->off_y) / sd->scale_y;
-
-      x_src_f = (x_src_f) / sd->scale_x;
-      y_src_f = (y_src_f) / sd->scale_y;
-      
-      if((x_src_f < 0.0) || (x_src_f > (double)sd->width) || 
-         (y_src_f < 0.0) || (y_src_f > (double)sd->height))
-        {
-        sd->tab->pixels[i][j].outside = 1;
-        //        fprintf(stderr, "Outside\n");
-        continue;
-        }
-
-      /* ... */
-      x_src_nearest = ROUND(x_src_f);
-      y_src_nearest = ROUND(y_src_f);
-
-      sd->tab->pixels[i][j].index_x =
-        x_src_nearest - sd->tab->factors_per_pixel/2;
-      sd->tab->pixels[i][j].index_y =
-        y_src_nearest - sd->tab->factors_per_pixel/2;
-      
-      if(sd->tab->factors_per_pixel == 1)
-        {
-        if(sd->tab->pixels[i][j].index_x < 0)
-          sd->tab->pixels[i][j].index_x = 0;
-        if(sd->tab->pixels[i][j].index_x > sd->width - 1)
-          sd->tab->pixels[i][j].index_x = sd->width - 1;
-        if(sd->tab->pixels[i][j].index_y < 0)
-          sd->tab->pixels[i][j].index_y = 0;
-        if(sd->tab->pixels[i][j].index_y > sd->height - 1)
-          sd->tab->pixels[i][j].index_y = sd->height - 1;
-        continue;
-        }
-      
-      /* x weights */
-      t = (x_src_f - 0.5 - sd->tab->pixels[i][j].index_x);
-      //      t = (x_src_f - sd->tab->pixels[i][j].index_x);
-      for(k = 0; k < sd->tab->factors_per_pixel; k++)
-        {
-        //        fprintf(stderr, "%d w_x(%f)\n", k, t);
-        
-        w_x[k] = sd->weight_func(sd->opt, t);
-
-
-        t -= 1.0;
-        }
-
-      t = (y_src_f - 0.5 - sd->tab->pixels[i][j].index_y);
-      //      t = (y_src_f - sd->tab->pixels[i][j].index_y);
-      
-      for(k = 0; k < sd->tab->factors_per_pixel; k++)
+      if(init_entry(tab, x_src_f / tab->scale_x, y_src_f / tab->scale_y,
+                    &tab->entries[i][j], &border[num]))
         {
-        /* Y-weight */
-        w_y = sd->weight_func(sd->opt, t);
-        
-        //        fprintf(stderr, "%d w_y(%f)\n", k, t);
-        
-        for(l = 0; l < sd->tab->factors_per_pixel; l++)
-          sd->tab->pixels[i][j].factors[k][l] = w_y * w_x[l];
-        t -= 1.0;
+        set_border_index(&tab->entries[i][j], num);
+        num++;
         }
-      
       }
-    shift_borders(sd->tab, sd->width, i, sd->height);
-    normalize(sd->tab, sd->width, i);
+    
+    if(num)
+      {
+      tab->border[i] = malloc(num * sizeof(*border));
+      memcpy(tab->border[i], border, num * sizeof(*border));
+      tab->num_border[i] = num;
+      }
     }
-  
+  free(border);
   }
-     
+
 void gavl_transform_table_init(gavl_transform_table_t * tab,
                                gavl_video_options_t * opt,
                                gavl_image_transform_func func, void * priv,
+                               const double (*matrix)[3],
                                float off_x, float off_y, float scale_x,
                                float scale_y, int width, int height)
   {
-  int delta;
-  int scanline;
-  int nt;
-  int i;
-  
+  int i, k;
+  double t, sum;
+  gavl_video_scale_get_weight weight_func;
   slice_data_t sd;
 
-  sd.off_x = off_x;
-  sd.off_y = off_y;
-  sd.scale_x = scale_x;
-  sd.scale_y = scale_y;
-  sd.width = width;
-  sd.height = height;
-  sd.tab = tab;
-  sd.func = func;
-  sd.func_priv = priv;
-  sd.opt = opt;
-  
   /* (re)alloc */
   
   gavl_transform_table_free(tab);
   
+  tab->off_x = off_x;
+  tab->off_y = off_y;
+  tab->scale_x = scale_x;
+  tab->scale_y = scale_y;
+  tab->width = width;
+  tab->height = height;
+  tab->bits = 0;
   
   /* Get factors per pixel and filter_func */
-  sd.weight_func =
+  weight_func =
     gavl_video_scale_get_weight_func(opt, &tab->factors_per_pixel);
   
   if(tab->factors_per_pixel > MAX_TRANSFORM_FILTER)
@@ -319,102 +435,194 @@ void gavl_transform_table_init(gavl_transform_table_t * tab,
     fprintf(stderr, "BUG: tab->factors_per_pixel > MAX_TRANSFORM_FILTER\n");
     return;
     }
+
+  /* Coefficients for each phase */
+  
+  if(tab->factors_per_pixel > 1)
+    {
+    for(i = 0; i < TRANSFORM_PHASES; i++)
+      {
+      t = (double)i / TRANSFORM_PHASES - 1.0 + (double)(tab->factors_per_pixel/2);
+      sum = 0.0;
+      for(k = 0; k < tab->factors_per_pixel; k++)
+        {
+        tab->lut_f[i][k] = weight_func(opt, t);
+        sum += tab->lut_f[i][k];
+        t -= 1.0;
+        }
+      for(k = 0; k < tab->factors_per_pixel; k++)
+        tab->lut_f[i][k] /= sum;
+      }
+    }
+  
+  if(matrix)
+    {
+    tab->parametric = 1;
+    memcpy(tab->matrix, matrix, sizeof(tab->matrix));
+    return;
+    }
+
+  tab->parametric = 0;
   
-  tab->pixels = malloc(height * sizeof(*tab->pixels));
-  tab->pixels[0] = calloc(width * height, sizeof(**tab->pixels));
+  tab->entries = malloc(height * sizeof(*tab->entries));
+  tab->entries[0] = malloc(width * height * sizeof(**tab->entries));
   
   for(i = 1; i < height; i++)
-    tab->pixels[i] = tab->pixels[0] + i * width;
+    tab->entries[i] = tab->entries[0] + i * width;
+
+  tab->border     = calloc(height, sizeof(*tab->border));
+  tab->num_border = calloc(height, sizeof(*tab->num_border));
 
-  nt = opt->num_threads;
-  if(nt > height)
-    nt = height;
-  if(nt < 1)
-    nt = 1;
+  sd.tab = tab;
+  sd.func = func;
+  sd.func_priv = priv;
   
-  delta = height / nt;
-  scanline = 0;
+  gavl_video_run_slices(opt, init_slice, &sd, height);
+  }
+
+void gavl_transform_table_init_int(gavl_transform_table_t * tab,
+                                   int bits)
+  {
+  int i, j;
+
+  tab->bits = bits;
 
-  for(i = 0; i < nt - 1; i++)
+  /* Split the bits between the two dimensions */
+  lut_init_int((const float (*)[MAX_TRANSFORM_FILTER])tab->lut_f, tab->lut_i_x,
+               tab->factors_per_pixel, bits - bits / 2);
+  lut_init_int((const float (*)[MAX_TRANSFORM_FILTER])tab->lut_f, tab->lut_i_y,
+               tab->factors_per_pixel, bits / 2);
+  
+  if(tab->parametric)
+    return;
+  
+  for(i = 0; i < tab->height; i++)
     {
-    opt->run_func(init_slice, &sd, scanline, scanline+delta,
-                  opt->run_data, i);
-        
-    scanline += delta;
+    for(j = 0; j < tab->num_border[i]; j++)
+      pixel_init_int(&tab->border[i][j], tab->factors_per_pixel, bits);
     }
-  opt->run_func(init_slice, &sd, scanline, height,
-                opt->run_data, nt - 1);
-  
-  for(i = 0; i < nt; i++)
-    opt->stop_func(opt->stop_data, i);
   }
 
-void gavl_transform_table_init_int(gavl_transform_table_t * tab,
-                                   int bits, int width, int height)
+void gavl_transform_table_get_entries(const gavl_transform_table_t * tab,
+                                      int row, int start, int num,
+                                      gavl_transform_entry_t * entries,
+                                      gavl_transform_pixel_t * border)
   {
-  int fac_max_i, i, j, k, l;
-  float fac_max_f, sum_f;
-  int sum_i;
-  int min_index_k, max_index_k;
-  int min_index_l, max_index_l;
+  int i, num_border = 0;
+  double x_dst_f, y_dst_f;
+  double x, y, w, dx, dy, dw;
+
+  /* Homogeneous source coordinates, scaled to the plane */
   
-  //  fac_max_i = (1<<bits) - 1;
-  //  fprintf(stderr, "Init int %d\n", bits);
-  fac_max_i = (1<<bits);
-  fac_max_f = (float)(fac_max_i);
+  y_dst_f = tab->scale_y * (double)row + tab->off_y;
+  x_dst_f = tab->scale_x * (double)start + tab->off_x;
+
+  x = (tab->matrix[0][0] * x_dst_f + tab->matrix[0][1] * y_dst_f +
+       tab->matrix[0][2]) / tab->scale_x;
+  y = (tab->matrix[1][0] * x_dst_f + tab->matrix[1][1] * y_dst_f +
+       tab->matrix[1][2]) / tab->scale_y;
+  w = tab->matrix[2][0] * x_dst_f + tab->matrix[2][1] * y_dst_f +
+    tab->matrix[2][2];
   
-  for(i = 0; i < height; i++)
+  dx = tab->matrix[0][0];
+  dy = tab->matrix[1][0] * tab->scale_x / tab->scale_y;
+  dw = tab->matrix[2][0] * tab->scale_x;
+
+  if(dw == 0.0)
     {
-    for(j = 0; j < width; j++)
+    /* Affine */
+    if(w <= 0.0)
       {
-      //      if(tab->pixels[i][j].outside)
-      //       continue;
-
-      if(tab->pixels[i][j].outside)
-        continue;
-      
-      min_index_k = 0;
-      max_index_k = 0;
-      min_index_l = 0;
-      max_index_l = 0;
-      
-      sum_i = 0;
-      sum_f = 0.0;
-      
-      for(k = 0; k < tab->factors_per_pixel; k++)
+      for(i = 0; i < num; i++)
+        init_entry(tab, -1.0, -1.0, &entries[i], NULL);
+      return;
+      }
+    
+    x /= w;
+    y /= w;
+    dx /= w;
+    dy /= w;
+    
+    for(i = 0; i < num; i++)
+      {
+      if(init_entry(tab, x, y, &entries[i], &border[num_border]))
         {
-        for(l = 0; l < tab->factors_per_pixel; l++)
-          {
-          tab->pixels[i][j].factors_i[k][l] =
-            (int)(fac_max_f * tab->pixels[i][j].factors[k][l]+0.5);
-          sum_i += tab->pixels[i][j].factors_i[k][l];
-          sum_f += tab->pixels[i][j].factors[k][l];
+        set_border_index(&entries[i], num_border);
+        num_border++;
+        }
+      x += dx;
+      y += dy;
+      }
+    return;
+    }
+  
+  for(i = 0; i < num; i++)
+    {
+    /* Points behind the viewer are outside */
+    if(w <= 0.0)
+      init_entry(tab, -1.0, -1.0, &entries[i], NULL);
+    else if(init_entry(tab, x / w, y / w, &entries[i], &border[num_border]))
+      {
+      set_border_index(&entries[i], num_border);
+      num_border++;
+      }
+    x += dx;
+    y += dy;
+    w += dw;
+    }
+  }
+
+void gavl_transform_table_expand(const gavl_transform_table_t * tab,
+                                 const gavl_transform_entry_t * entries,
+                                 const gavl_transform_pixel_t * border,
+                                 gavl_transform_pixel_t * pixels,
+                                 int num)
+  {
+  int i, k, l;
+  const int * fac_x;
+  const int * fac_y;
+  
+  for(i = 0; i < num; i++)
+    {
+    switch(entries[i].type)
+      {
+      case TRANSFORM_ENTRY_FILTER:
+        pixels[i].index_x = entries[i].index_x;
+        pixels[i].index_y = entries[i].index_y;
+        pixels[i].outside = 0;
 
-          if(k || l)
+        if(tab->factors_per_pixel == 1)
+          break;
+        
+        if(tab->bits)
+          {
+          fac_x = tab->lut_i_x[entries[i].phase_x];
+          fac_y = tab->lut_i_y[entries[i].phase_y];
+          for(k = 0; k < tab->factors_per_pixel; k++)
             {
-            if(tab->pixels[i][j].factors_i[k][l] >
-               tab->pixels[i][j].factors_i[max_index_k][max_index_l])
-              {
-              max_index_k = k;
-              max_index_l = l;
-              }
-            if(tab->pixels[i][j].factors_i[k][l] <
-               tab->pixels[i][j].factors_i[min_index_k][min_index_l])
-              {
-              min_index_k = k;
-              min_index_l = l;
-              }
+            for(l = 0; l < tab->factors_per_pixel; l++)
+              pixels[i].factors_i[k][l] = fac_y[k] * fac_x[l];
             }
           }
-        }
-      
-      if(sum_i > fac_max_i)
-        tab->pixels[i][j].factors_i[max_index_k][max_index_l]
-          -= (sum_i - fac_max_i);
-      else if(sum_i < fac_max_i)
-        tab->pixels[i][j].factors_i[min_index_k][min_index_l]
-          += (fac_max_i - sum_i);
-      //  gavl_video_scale_table_dump_int(tab);
+        else
+          {
+          for(k = 0; k < tab->factors_per_pixel; k++)
+            {
+            for(l = 0; l < tab->factors_per_pixel; l++)
+              pixels[i].factors[k][l] =
+                tab->lut_f[entries[i].phase_y][k] *
+                tab->lut_f[entries[i].phase_x][l];
+            }
+          }
+        break;
+      case TRANSFORM_ENTRY_OUTSIDE:
+        pixels[i].outside = 1;
+        break;
+      case TRANSFORM_ENTRY_BORDER:
+        memcpy(&pixels[i],
+               &border[entries[i].index_x | (entries[i].index_y << 16)],
+               sizeof(pixels[i]));
+        break;
       }
     }
   }
@@ -422,11 +630,24 @@ void gavl_transform_table_init_int(gavl_transform_table_t * tab,
 void
 gavl_transform_table_free(gavl_transform_table_t * tab)
   {
-  if(tab->pixels)
+  int i;
+  if(tab->entries)
+    {
+    if(tab->entries[0])
+      free(tab->entries[0]);
+    free(tab->entries);
+    tab->entries = NULL;
+    }
+  if(tab->border)
     {
-    if(tab->pixels[0])
-      free(tab->pixels[0]);
-    free(tab->pixels);
-    tab->pixels = NULL;
+    for(i = 0; i < tab->height; i++)
+      {
+      if(tab->border[i])
+        free(tab->border[i]);
+      }
+    free(tab->border);
+    free(tab->num_border);
+    tab->border = NULL;
+    tab->num_border = NULL;
     }
   }
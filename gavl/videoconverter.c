@@ -22,6 +22,7 @@
 #include <stdlib.h> /* calloc, free */
 
 #include <string.h>
+#include <unistd.h> /* sysconf */
 
 //#define DEBUG
 
@@ -32,6 +33,8 @@
 #include "gavl.h"
 #include "config.h"
 #include "video.h"
+#include "scale.h"
+#include "deinterlace.h"
 
 /***************************************************
  * Create and destroy video converters
@@ -41,29 +44,201 @@ gavl_video_converter_t * gavl_video_converter_create()
   {
   gavl_video_converter_t * ret = calloc(1,sizeof(gavl_video_converter_t));
   gavl_video_options_set_defaults(&ret->options);
+  ret->cur_plan = -1;
   return ret;
   }
 
-static void video_converter_cleanup(gavl_video_converter_t* cnv)
+static void destroy_contexts(gavl_video_convert_context_t * ctx,
+                             int num_band_threads)
   {
-  gavl_video_convert_context_t * ctx;
-  while(cnv->first_context)
+  int i;
+  gavl_video_convert_context_t * next;
+  while(ctx)
     {
-    ctx = cnv->first_context->next;
+    next = ctx->next;
     
-    if(cnv->first_context->scaler)
-      gavl_video_scaler_destroy(cnv->first_context->scaler);
-    if(cnv->first_context->output_frame && cnv->first_context->next)
-      gavl_video_frame_destroy(cnv->first_context->output_frame);
-    free(cnv->first_context);
-    cnv->first_context = ctx;
+    if(ctx->scaler)
+      gavl_video_scaler_destroy(ctx->scaler);
+    if(ctx->deinterlacer)
+      gavl_video_deinterlacer_destroy(ctx->deinterlacer);
+    if(ctx->output_frame && ctx->next)
+      gavl_video_frame_destroy(ctx->output_frame);
+    if(ctx->band_frames)
+      {
+      for(i = 0; i < num_band_threads; i++)
+        gavl_video_frame_destroy(ctx->band_frames[i]);
+      free(ctx->band_frames);
+      }
+    free(ctx);
+    ctx = next;
     }
+  }
+
+/* Forget the current chain without freeing it */
+
+static void video_converter_detach(gavl_video_converter_t* cnv)
+  {
+  cnv->first_context = NULL;
   cnv->last_context = NULL;
   cnv->num_contexts = 0;
+  cnv->have_frames = 0;
+  cnv->fused_first = NULL;
+  cnv->fused_last = NULL;
+  cnv->band_threads = NULL;
+  cnv->num_band_threads = 0;
+  }
+
+static void video_converter_cleanup(gavl_video_converter_t* cnv)
+  {
+  destroy_contexts(cnv->first_context, cnv->num_band_threads);
+  if(cnv->band_threads)
+    free(cnv->band_threads);
+  video_converter_detach(cnv);
+  }
+
+/*
+ *  Plan cache
+ */
+
+static void plan_save(gavl_video_converter_t * cnv,
+                      gavl_video_convert_plan_t * plan)
+  {
+  plan->first_context    = cnv->first_context;
+  plan->last_context     = cnv->last_context;
+  plan->num_contexts     = cnv->num_contexts;
+  plan->have_frames      = cnv->have_frames;
+  plan->fused_first      = cnv->fused_first;
+  plan->fused_last       = cnv->fused_last;
+  plan->band_height      = cnv->band_height;
+  plan->num_bands        = cnv->num_bands;
+  plan->band_threads     = cnv->band_threads;
+  plan->num_band_threads = cnv->num_band_threads;
+  }
+
+static void plan_restore(gavl_video_converter_t * cnv,
+                         const gavl_video_convert_plan_t * plan)
+  {
+  cnv->first_context    = plan->first_context;
+  cnv->last_context     = plan->last_context;
+  cnv->num_contexts     = plan->num_contexts;
+  cnv->have_frames      = plan->have_frames;
+  cnv->fused_first      = plan->fused_first;
+  cnv->fused_last       = plan->fused_last;
+  cnv->band_height      = plan->band_height;
+  cnv->num_bands        = plan->num_bands;
+  cnv->band_threads     = plan->band_threads;
+  cnv->num_band_threads = plan->num_band_threads;
+  }
+
+static void plan_free(gavl_video_convert_plan_t * plan)
+  {
+  destroy_contexts(plan->first_context, plan->num_band_threads);
+  if(plan->band_threads)
+    free(plan->band_threads);
+  memset(plan, 0, sizeof(*plan));
+  }
+
+static int plan_matches(const gavl_video_convert_plan_t * plan,
+                        const gavl_video_converter_t * cnv)
+  {
+  return gavl_video_formats_equal(&plan->input_format, &cnv->input_format) &&
+    gavl_video_formats_equal(&plan->output_format, &cnv->output_format) &&
+    !memcmp(&plan->options, &cnv->options, sizeof(plan->options));
+  }
+
+/* Give the current chain back to the cache */
+
+static void plan_release(gavl_video_converter_t * cnv)
+  {
+  if(cnv->cur_plan < 0)
+    return;
+  plan_save(cnv, &cnv->plans[cnv->cur_plan]);
+  video_converter_detach(cnv);
+  cnv->cur_plan = -1;
+  }
+
+static void plan_cache_clear(gavl_video_converter_t * cnv)
+  {
+  int i;
+  plan_release(cnv);
+  for(i = 0; i < cnv->num_plans; i++)
+    plan_free(&cnv->plans[i]);
+  cnv->num_plans = 0;
+  }
+
+/* Store the current (freshly built) chain in the cache */
+
+static void plan_add(gavl_video_converter_t * cnv, int num_steps)
+  {
+  int i, idx;
+  gavl_video_convert_plan_t * plan;
+  
+  if(cnv->num_plans < cnv->max_plans)
+    idx = cnv->num_plans++;
+  else
+    {
+    /* Evict the least recently used plan */
+    idx = 0;
+    for(i = 1; i < cnv->num_plans; i++)
+      {
+      if(cnv->plans[i].last_used < cnv->plans[idx].last_used)
+        idx = i;
+      }
+    plan_free(&cnv->plans[idx]);
+    }
+  
+  plan = &cnv->plans[idx];
+  gavl_video_format_copy(&plan->input_format, &cnv->input_format);
+  gavl_video_format_copy(&plan->output_format, &cnv->output_format);
+  memcpy(&plan->options, &cnv->options, sizeof(plan->options));
+  plan->num_steps = num_steps;
+  plan->last_used = ++cnv->plan_counter;
+  cnv->cur_plan = idx;
+  }
+
+void gavl_video_converter_set_plan_cache_size(gavl_video_converter_t* cnv,
+                                              int num_plans)
+  {
+  /* The current chain stays in use but leaves the cache */
+  if(cnv->cur_plan >= 0)
+    {
+    memset(&cnv->plans[cnv->cur_plan], 0, sizeof(cnv->plans[cnv->cur_plan]));
+    cnv->cur_plan = -1;
+    }
+  plan_cache_clear(cnv);
+
+  if(num_plans < 0)
+    num_plans = 0;
+
+  cnv->max_plans = num_plans;
+
+  if(cnv->plans)
+    {
+    free(cnv->plans);
+    cnv->plans = NULL;
+    }
+  if(num_plans)
+    cnv->plans = calloc(num_plans, sizeof(*cnv->plans));
+  }
+
+static void batch_cleanup(gavl_video_converter_t* cnv)
+  {
+  int i;
+  if(!cnv->batch_threads)
+    return;
+  for(i = 0; i < cnv->num_batch_threads; i++)
+    gavl_video_converter_destroy(cnv->batch_threads[i].cnv);
+  free(cnv->batch_threads);
+  cnv->batch_threads = NULL;
+  cnv->num_batch_threads = 0;
   }
 
 void gavl_video_converter_destroy(gavl_video_converter_t* cnv)
   {
+  batch_cleanup(cnv);
+  plan_cache_clear(cnv);
+  if(cnv->plans)
+    free(cnv->plans);
   video_converter_cleanup(cnv);
   free(cnv);
   }
@@ -204,7 +379,368 @@ static int add_context_deinterlace(gavl_video_converter_t * cnv,
   return 1;
   }
 
-int gavl_video_converter_reinit(gavl_video_converter_t * cnv)
+/*
+ *  Fused conversion
+ *
+ *  A context can produce its output in bands, if it's a pixelformat
+ *  conversion, a progressive scaler, which writes the whole image, or
+ *  a copy or blend deinterlacer.
+ *  Pixelformat conversions can also consume their input in bands, because
+ *  each output scanline depends only on the same input scanline(s).
+ */
+
+static int context_can_produce_bands(gavl_video_convert_context_t * ctx)
+  {
+  if(ctx->scaler)
+    return gavl_video_scaler_can_scale_band(ctx->scaler);
+  if(ctx->deinterlacer)
+    return gavl_video_deinterlacer_can_deinterlace_band(ctx->deinterlacer);
+  return 1;
+  }
+
+static int context_can_consume_bands(gavl_video_convert_context_t * ctx)
+  {
+  return !ctx->scaler && !ctx->deinterlacer;
+  }
+
+static int get_cache_size()
+  {
+#ifdef _SC_LEVEL2_CACHE_SIZE
+  long ret = sysconf(_SC_LEVEL2_CACHE_SIZE);
+  if(ret > 0)
+    return ret;
+#endif
+  return 256 * 1024;
+  }
+
+static void update_band_alignment(const gavl_video_format_t * format,
+                                  int * align)
+  {
+  int sub_h, sub_v;
+  gavl_pixelformat_chroma_sub(format->pixelformat, &sub_h, &sub_v);
+  if(sub_v > *align)
+    *align = sub_v;
+  }
+
+/* Band height: All band buffers and the band of the output
+   frame should fit into half of the L2 cache */
+
+static int get_band_height(gavl_video_converter_t * cnv)
+  {
+  int ret;
+  int align = 1;
+  int bytes_per_line = 0;
+  gavl_video_convert_context_t * ctx = cnv->fused_first;
+  
+  update_band_alignment(&ctx->input_format, &align);
+  
+  while(1)
+    {
+    bytes_per_line += gavl_video_format_get_image_size(&ctx->output_format) /
+      ctx->output_format.frame_height;
+    update_band_alignment(&ctx->output_format, &align);
+    
+    if(ctx == cnv->fused_last)
+      break;
+    ctx = ctx->next;
+    }
+
+  ret = get_cache_size() / (2 * bytes_per_line);
+  ret -= ret % align;
+  
+  if(ret < align)
+    ret = align;
+  if(ret > cnv->fused_first->output_format.image_height)
+    ret = cnv->fused_first->output_format.image_height;
+  return ret;
+  }
+
+/* Find the contexts we can fuse. Our conversion chains are short enough
+   so we support only one group of fused contexts. */
+
+static void init_fused(gavl_video_converter_t * cnv)
+  {
+  gavl_video_convert_context_t * ctx;
+  
+  if(!(cnv->options.conversion_flags & GAVL_FUSED_CONVERSION))
+    return;
+
+  ctx = cnv->first_context;
+  
+  while(ctx && ctx->next)
+    {
+    if(context_can_produce_bands(ctx) &&
+       context_can_consume_bands(ctx->next))
+      break;
+    ctx = ctx->next;
+    }
+
+  if(!ctx || !ctx->next)
+    return;
+
+  cnv->fused_first = ctx;
+  
+  while(ctx->next && context_can_consume_bands(ctx->next))
+    {
+    ctx->fused = 1;
+    ctx = ctx->next;
+    }
+  cnv->fused_last = ctx;
+
+  cnv->band_height = get_band_height(cnv);
+  cnv->num_bands = (cnv->fused_first->output_format.image_height +
+                    cnv->band_height - 1) / cnv->band_height;
+  }
+
+/* Do a pixelformat conversion for h scanlines */
+
+static void convert_band(gavl_video_convert_context_t * ctx,
+                         const gavl_video_frame_t * src, int src_y,
+                         gavl_video_frame_t * dst, int dst_y, int h)
+  {
+  gavl_video_convert_context_t band_ctx;
+  gavl_video_frame_t in_frame;
+  gavl_video_frame_t out_frame;
+  gavl_rectangle_i_t rect;
+
+  memcpy(&band_ctx, ctx, sizeof(band_ctx));
+  memset(&in_frame, 0, sizeof(in_frame));
+  memset(&out_frame, 0, sizeof(out_frame));
+  
+  band_ctx.input_format.image_height = h;
+  band_ctx.output_format.image_height = h;
+
+  rect.x = 0;
+  rect.w = ctx->input_format.image_width;
+  rect.h = h;
+
+  rect.y = src_y;
+  gavl_video_frame_get_subframe(ctx->input_format.pixelformat,
+                                src, &in_frame, &rect);
+  rect.y = dst_y;
+  gavl_video_frame_get_subframe(ctx->output_format.pixelformat,
+                                dst, &out_frame, &rect);
+
+  band_ctx.input_frame = &in_frame;
+  band_ctx.output_frame = &out_frame;
+  band_ctx.func(&band_ctx);
+  }
+
+static void fused_func(void * data, int start, int end)
+  {
+  int band, y, h, height;
+  gavl_video_convert_context_t * ctx;
+  const gavl_video_frame_t * src;
+  gavl_video_band_thread_t * t = data;
+  gavl_video_converter_t * cnv = t->cnv;
+
+  height = cnv->fused_first->output_format.image_height;
+  
+  for(band = start; band < end; band++)
+    {
+    y = band * cnv->band_height;
+    h = cnv->band_height;
+    if(y + h > height)
+      h = height - y;
+
+    /* The first context reads from the full frame */
+    ctx = cnv->fused_first;
+
+    if(ctx->scaler)
+      gavl_video_scaler_scale_band(ctx->scaler,
+                                   ctx->band_frames[t->thread], y, h,
+                                   t->thread);
+    else if(ctx->deinterlacer)
+      gavl_video_deinterlacer_deinterlace_band(ctx->deinterlacer,
+                                               ctx->input_frame,
+                                               ctx->band_frames[t->thread],
+                                               y, h);
+    else
+      convert_band(ctx, ctx->input_frame, y,
+                   ctx->band_frames[t->thread], 0, h);
+
+    /* The others read from band buffers */
+    
+    while(ctx->fused)
+      {
+      src = ctx->band_frames[t->thread];
+      ctx = ctx->next;
+      
+      if(ctx->fused)
+        convert_band(ctx, src, 0, ctx->band_frames[t->thread], 0, h);
+      else
+        convert_band(ctx, src, 0, ctx->output_frame, y, h);
+      }
+    }
+  }
+
+static void convert_fused(gavl_video_converter_t * cnv)
+  {
+  int i, nt, delta, band;
+  gavl_video_convert_context_t * ctx = cnv->fused_first;
+
+  if(ctx->scaler)
+    gavl_video_scaler_scale_band_init(ctx->scaler, ctx->input_frame);
+
+  nt = cnv->num_band_threads;
+  if(nt > cnv->num_bands)
+    nt = cnv->num_bands;
+  
+  delta = cnv->num_bands / nt;
+  band = 0;
+  
+  for(i = 0; i < nt - 1; i++)
+    {
+    cnv->options.run_func(fused_func, &cnv->band_threads[i],
+                          band, band + delta, cnv->options.run_data, i);
+    band += delta;
+    }
+  cnv->options.run_func(fused_func, &cnv->band_threads[nt - 1],
+                        band, cnv->num_bands, cnv->options.run_data, nt - 1);
+  
+  for(i = 0; i < nt; i++)
+    cnv->options.stop_func(cnv->options.stop_data, i);
+  }
+
+/*
+ *  Sliced pixelformat conversion: Split the image into horizontal
+ *  slices, which start at multiples of the vertical chroma subsampling
+ */
+
+static int get_slice_alignment(gavl_video_convert_context_t * ctx)
+  {
+  int align = 1;
+  update_band_alignment(&ctx->input_format, &align);
+  update_band_alignment(&ctx->output_format, &align);
+  return align;
+  }
+
+static void slice_func(void * data, int start, int end)
+  {
+  int y, h, align;
+  gavl_video_convert_context_t * ctx = data;
+
+  align = get_slice_alignment(ctx);
+  
+  y = start * align;
+  h = end * align - y;
+  if(y + h > ctx->input_format.image_height)
+    h = ctx->input_format.image_height - y;
+
+  convert_band(ctx, ctx->input_frame, y, ctx->output_frame, y, h);
+  }
+
+static int context_can_slice(gavl_video_convert_context_t * ctx)
+  {
+  return (ctx->options->num_threads > 1) &&
+    context_can_consume_bands(ctx) &&
+    (ctx->input_format.image_height >= 2 * get_slice_alignment(ctx));
+  }
+
+static void convert_sliced(gavl_video_convert_context_t * ctx)
+  {
+  int align = get_slice_alignment(ctx);
+  
+  gavl_video_run_slices(ctx->options, slice_func, ctx,
+                        (ctx->input_format.image_height + align - 1) / align);
+  }
+
+static void alloc_band_frames(gavl_video_converter_t * cnv,
+                              gavl_video_convert_context_t * ctx)
+  {
+  int i;
+  gavl_video_format_t band_format;
+
+  gavl_video_format_copy(&band_format, &ctx->output_format);
+  band_format.image_height = cnv->band_height;
+  band_format.frame_height = cnv->band_height;
+  
+  ctx->band_frames = calloc(cnv->num_band_threads,
+                            sizeof(*ctx->band_frames));
+  for(i = 0; i < cnv->num_band_threads; i++)
+    {
+    ctx->band_frames[i] = gavl_video_frame_create(&band_format);
+    gavl_video_frame_clear(ctx->band_frames[i], &band_format);
+    }
+  }
+
+/*
+ *  Cost based planning: Compare csp then scale with scale then csp.
+ *  The intermediate formats are the same as the ones set up below.
+ */
+
+static void scaled_format(gavl_video_format_t * ret,
+                          const gavl_video_format_t * in_format,
+                          const gavl_video_format_t * out_format)
+  {
+  gavl_video_format_copy(ret, in_format);
+  ret->image_width  = out_format->image_width;
+  ret->image_height = out_format->image_height;
+  ret->frame_width  = out_format->image_width;
+  ret->frame_height = out_format->image_height;
+  }
+
+static int scaler_can_convert(gavl_pixelformat_t in, gavl_pixelformat_t out)
+  {
+  return (in == out) || gavl_pixelformat_can_scale(in, out);
+  }
+
+static double add_costs(double c1, double c2)
+  {
+  if((c1 < 0.0) || (c2 < 0.0))
+    return -1.0;
+  return c1 + c2;
+  }
+
+static void plan_by_cost(gavl_video_converter_t * cnv,
+                         const gavl_video_format_t * in_format,
+                         const gavl_video_format_t * out_format,
+                         gavl_pixelformat_t tmp_csp,
+                         int * csp_then_scale)
+  {
+  double cost_csp_first = -1.0;
+  double cost_scale_first = -1.0;
+  gavl_video_format_t tmp_format;
+  gavl_pixelformat_t pfmt;
+  
+  /* csp (in -> tmp) then scale (tmp -> out) */
+
+  pfmt = (tmp_csp != GAVL_PIXELFORMAT_NONE) ? tmp_csp : out_format->pixelformat;
+  
+  if(scaler_can_convert(pfmt, out_format->pixelformat))
+    {
+    gavl_video_format_copy(&tmp_format, in_format);
+    tmp_format.pixelformat = pfmt;
+    cost_csp_first =
+      add_costs(gavl_video_cost_pixelformat(&cnv->options, in_format, &tmp_format),
+                gavl_video_cost_scale(&cnv->options, &tmp_format, out_format));
+    }
+
+  /* scale (in -> tmp) then csp (tmp -> out) */
+
+  pfmt = (tmp_csp != GAVL_PIXELFORMAT_NONE) ? tmp_csp : in_format->pixelformat;
+  
+  if(scaler_can_convert(in_format->pixelformat, pfmt))
+    {
+    scaled_format(&tmp_format, in_format, out_format);
+    tmp_format.pixelformat = pfmt;
+    cost_scale_first =
+      add_costs(gavl_video_cost_scale(&cnv->options, in_format, &tmp_format),
+                gavl_video_cost_pixelformat(&cnv->options, &tmp_format, out_format));
+    }
+  
+  if(cost_csp_first < 0.0)
+    {
+    if(cost_scale_first >= 0.0)
+      *csp_then_scale = 0;
+    }
+  else if(cost_scale_first < 0.0)
+    *csp_then_scale = 1;
+  else
+    *csp_then_scale = (cost_csp_first < cost_scale_first);
+  }
+
+static int build_chain(gavl_video_converter_t * cnv)
   {
   int csp_then_scale = 0;
   gavl_pixelformat_t tmp_csp = GAVL_PIXELFORMAT_NONE;
@@ -360,6 +896,10 @@ int gavl_video_converter_reinit(gavl_video_converter_t * cnv)
               gavl_pixelformat_can_scale(tmp_csp, output_format->pixelformat));
 #endif
       }
+
+    /* Optionally let the cost model decide */
+    if(cnv->options.conversion_flags & GAVL_COST_BASED_PLANNING)
+      plan_by_cost(cnv, &tmp_format, output_format, tmp_csp, &csp_then_scale);
     
     if(csp_then_scale) /* csp then scale */
       {
@@ -457,6 +997,8 @@ int gavl_video_converter_reinit(gavl_video_converter_t * cnv)
       return -1;
     }
 
+  init_fused(cnv);
+  
   /* Now, create temporary frames for the contexts */
 
   cnv->have_frames = 0;
@@ -464,20 +1006,109 @@ int gavl_video_converter_reinit(gavl_video_converter_t * cnv)
   return cnv->num_contexts;
   }
 
+/*
+ *  The motion adaptive deinterlacer keeps the previous frame, so the
+ *  result of a frame depends on the frames converted before.
+ */
+
+static int chain_has_history(gavl_video_converter_t * cnv)
+  {
+  gavl_video_convert_context_t * ctx = cnv->first_context;
+
+  while(ctx)
+    {
+    if(ctx->deinterlacer &&
+       (cnv->options.deinterlace_mode == GAVL_DEINTERLACE_ADAPTIVE))
+      return 1;
+    ctx = ctx->next;
+    }
+  return 0;
+  }
+
+static void chain_reset(gavl_video_converter_t * cnv)
+  {
+  gavl_video_convert_context_t * ctx = cnv->first_context;
+
+  while(ctx)
+    {
+    if(ctx->deinterlacer)
+      gavl_video_deinterlacer_reset(ctx->deinterlacer);
+    ctx = ctx->next;
+    }
+  }
+
+void gavl_video_converter_reset(gavl_video_converter_t * cnv)
+  {
+  chain_reset(cnv);
+  }
+
+int gavl_video_converter_reinit(gavl_video_converter_t * cnv)
+  {
+  int i, ret;
+
+  batch_cleanup(cnv);
+
+  if(!cnv->max_plans)
+    return build_chain(cnv);
+
+  plan_release(cnv);
+  
+  for(i = 0; i < cnv->num_plans; i++)
+    {
+    if(plan_matches(&cnv->plans[i], cnv))
+      {
+      plan_restore(cnv, &cnv->plans[i]);
+      /* The history is from before the format switch */
+      chain_reset(cnv);
+      cnv->plans[i].last_used = ++cnv->plan_counter;
+      cnv->cur_plan = i;
+      return cnv->plans[i].num_steps;
+      }
+    }
+
+  ret = build_chain(cnv);
+
+  if(ret < 0)
+    video_converter_cleanup(cnv);
+  else
+    plan_add(cnv, ret);
+  return ret;
+  }
+
 static void alloc_frames(gavl_video_converter_t * cnv)
   {
+  int i;
   gavl_video_convert_context_t * tmp_ctx;
 
   if(cnv->have_frames)
     return;
 
+  if(cnv->fused_first)
+    {
+    cnv->num_band_threads = cnv->options.num_threads;
+    cnv->band_threads = calloc(cnv->num_band_threads,
+                               sizeof(*cnv->band_threads));
+    for(i = 0; i < cnv->num_band_threads; i++)
+      {
+      cnv->band_threads[i].cnv = cnv;
+      cnv->band_threads[i].thread = i;
+      }
+    }
+  
   tmp_ctx = cnv->first_context;
   while(tmp_ctx && tmp_ctx->next)
     {
-    tmp_ctx->output_frame =
-      gavl_video_frame_create(&tmp_ctx->output_format);
-    gavl_video_frame_clear(tmp_ctx->output_frame, &tmp_ctx->output_format);
-    
+    if(tmp_ctx->fused)
+      {
+      alloc_band_frames(cnv, tmp_ctx);
+      tmp_ctx->output_frame = NULL;
+      }
+    else
+      {
+      tmp_ctx->output_frame =
+        gavl_video_frame_create(&tmp_ctx->output_format);
+      gavl_video_frame_clear(tmp_ctx->output_frame, &tmp_ctx->output_format);
+      }
     tmp_ctx->next->input_frame = tmp_ctx->output_frame;
     tmp_ctx = tmp_ctx->next;
     }
@@ -520,10 +1151,141 @@ void gavl_video_convert(gavl_video_converter_t * cnv,
   
   while(tmp_ctx)
     {
+    if(tmp_ctx == cnv->fused_first)
+      {
+      gavl_video_frame_copy_metadata(cnv->fused_last->output_frame,
+                                     tmp_ctx->input_frame);
+      convert_fused(cnv);
+      tmp_ctx = cnv->fused_last->next;
+      continue;
+      }
+    
     gavl_video_frame_copy_metadata(tmp_ctx->output_frame,
                                    tmp_ctx->input_frame);
-    tmp_ctx->func(tmp_ctx);
+    if(context_can_slice(tmp_ctx))
+      convert_sliced(tmp_ctx);
+    else
+      tmp_ctx->func(tmp_ctx);
     tmp_ctx = tmp_ctx->next;
     }
 
   }
+
+/*
+ *  Batch conversion: Each thread converts a contiguous range of frames
+ *  with its own single threaded converter. Chains, which depend on
+ *  previous frames, are run sequentially.
+ */
+
+static int batch_init(gavl_video_converter_t * cnv)
+  {
+  int i;
+  gavl_video_options_t * opt;
+  
+  cnv->num_batch_threads = cnv->options.num_threads;
+  cnv->batch_threads = calloc(cnv->num_batch_threads,
+                              sizeof(*cnv->batch_threads));
+  
+  for(i = 0; i < cnv->num_batch_threads; i++)
+    {
+    cnv->batch_threads[i].cnv = gavl_video_converter_create();
+    opt = gavl_video_converter_get_options(cnv->batch_threads[i].cnv);
+    gavl_video_options_copy(opt, &cnv->options);
+    gavl_video_options_set_thread_pool(opt, NULL);
+    
+    if(gavl_video_converter_init(cnv->batch_threads[i].cnv,
+                                 &cnv->input_format,
+                                 &cnv->output_format) < 0)
+      {
+      batch_cleanup(cnv);
+      return 0;
+      }
+    }
+  return 1;
+  }
+
+static void batch_func(void * data, int start, int end)
+  {
+  int i;
+  gavl_video_batch_thread_t * t = data;
+  
+  for(i = start; i < end; i++)
+    gavl_video_convert(t->cnv, t->input_frames[i], t->output_frames[i]);
+  }
+
+void gavl_video_convert_batch(gavl_video_converter_t * cnv,
+                              const gavl_video_frame_t ** input_frames,
+                              gavl_video_frame_t ** output_frames,
+                              int num_frames)
+  {
+  int i, nt, start, end;
+  
+  if((cnv->options.num_threads < 2) || (num_frames < 2) ||
+     chain_has_history(cnv) ||
+     (!cnv->batch_threads && !batch_init(cnv)))
+    {
+    for(i = 0; i < num_frames; i++)
+      gavl_video_convert(cnv, input_frames[i], output_frames[i]);
+    return;
+    }
+
+  nt = cnv->num_batch_threads;
+  if(nt > num_frames)
+    nt = num_frames;
+
+  start = 0;
+  for(i = 0; i < nt; i++)
+    {
+    end = ((i + 1) * num_frames) / nt;
+    cnv->batch_threads[i].input_frames = input_frames;
+    cnv->batch_threads[i].output_frames = output_frames;
+    cnv->options.run_func(batch_func, &cnv->batch_threads[i],
+                          start, end, cnv->options.run_data, i);
+    start = end;
+    }
+
+  for(i = 0; i < nt; i++)
+    cnv->options.stop_func(cnv->options.stop_data, i);
+  }
+
+int gavl_video_converter_get_plan(gavl_video_converter_t * cnv,
+                                  gavl_video_step_t * steps,
+                                  int max_steps)
+  {
+  int ret = 0;
+  gavl_video_step_t * step;
+  gavl_video_convert_context_t * ctx = cnv->first_context;
+
+  while(ctx)
+    {
+    if(ret < max_steps)
+      {
+      step = steps + ret;
+      gavl_video_format_copy(&step->input_format, &ctx->input_format);
+      gavl_video_format_copy(&step->output_format, &ctx->output_format);
+
+      if(ctx->scaler)
+        {
+        step->type = GAVL_VIDEO_STEP_SCALE;
+        step->cost = gavl_video_cost_scale(ctx->options, &ctx->input_format,
+                                           &ctx->output_format);
+        }
+      else if(ctx->deinterlacer)
+        {
+        step->type = GAVL_VIDEO_STEP_DEINTERLACE;
+        step->cost = gavl_video_cost_deinterlace(ctx->options,
+                                                 &ctx->input_format);
+        }
+      else
+        {
+        step->type = GAVL_VIDEO_STEP_PIXELFORMAT;
+        step->cost = gavl_video_cost_pixelformat(ctx->options,
+                                                 &ctx->input_format,
+                                                 &ctx->output_format);
+        }
+      }
+    ret++;
+    ctx = ctx->next;
+    }
+  return ret;
+  }
@@ -0,0 +1,380 @@
+/*****************************************************************
+ * gavl - a general purpose audio/video processing library
+ *
+ * Copyright (c) 2001 - 2012 Members of the Gmerlin project
+ * gmerlin-general@lists.sourceforge.net
+ * http://gmerlin.sourceforge.net
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * *****************************************************************/
+
+/*
+ *  Cost model for the video converter
+ *
+ *  The costs of the single conversion steps are obtained by running
+ *  the actual routines on small probe images. The results are cached
+ *  for the lifetime of the process, so each combination of pixelformats
+ *  and options is measured only once.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include <gavl.h>
+#include <config.h>
+#include <video.h>
+#include <accel.h>
+
+#define PROBE_WIDTH  256
+#define PROBE_HEIGHT 128
+
+/* Scaler probe: Downscale by 3/4 */
+#define PROBE_WIDTH_SCALED  192
+#define PROBE_HEIGHT_SCALED  96
+
+#define PROBE_RUNS 3
+
+typedef enum
+  {
+  COST_PIXELFORMAT,
+  COST_SCALE,
+  COST_DEINTERLACE,
+  } cost_type_t;
+
+typedef struct
+  {
+  cost_type_t type;
+  gavl_pixelformat_t in;
+  gavl_pixelformat_t out;
+  int accel_flags;
+  int quality;
+  gavl_scale_mode_t scale_mode;
+  int scale_order;
+  gavl_deinterlace_mode_t deinterlace_mode;
+
+  double cost; /* Per unit (see below), < 0 if unsupported */
+  } cost_entry_t;
+
+static cost_entry_t * costs = NULL;
+static int num_costs = 0;
+static int costs_alloc = 0;
+static pthread_mutex_t costs_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void set_probe_format(gavl_video_format_t * format,
+                             gavl_pixelformat_t pixelformat,
+                             int width, int height)
+  {
+  memset(format, 0, sizeof(*format));
+  format->image_width  = width;
+  format->image_height = height;
+  format->frame_width  = width;
+  format->frame_height = height;
+  format->pixel_width  = 1;
+  format->pixel_height = 1;
+  format->pixelformat = pixelformat;
+  }
+
+/* Options for the probes: Same routines but single threaded and
+   without rectangles */
+
+static void set_probe_options(gavl_video_options_t * dst,
+                              const gavl_video_options_t * src)
+  {
+  gavl_video_options_copy(dst, src);
+  gavl_video_options_set_thread_pool(dst, NULL);
+  gavl_video_options_set_rectangles(dst, NULL, NULL);
+  memset(&dst->src_rect, 0, sizeof(dst->src_rect));
+  memset(&dst->dst_rect, 0, sizeof(dst->dst_rect));
+  dst->conversion_flags &= ~GAVL_COST_BASED_PLANNING;
+  }
+
+static uint64_t get_min_time(uint64_t t, uint64_t min, int run)
+  {
+  return (!run || (t < min)) ? t : min;
+  }
+
+/* Time per pixel */
+
+static double measure_pixelformat(const gavl_video_options_t * opt,
+                                  gavl_pixelformat_t in,
+                                  gavl_pixelformat_t out)
+  {
+  int i;
+  uint64_t t, min = 0;
+  gavl_video_convert_context_t ctx;
+  gavl_video_frame_t * in_frame;
+  gavl_video_frame_t * out_frame;
+  gavl_video_options_t probe_opt;
+
+  memset(&ctx, 0, sizeof(ctx));
+  set_probe_options(&probe_opt, opt);
+
+  ctx.func = gavl_find_pixelformat_converter(&probe_opt, in, out,
+                                             PROBE_WIDTH, PROBE_HEIGHT);
+  if(!ctx.func)
+    return -1.0;
+
+  set_probe_format(&ctx.input_format, in, PROBE_WIDTH, PROBE_HEIGHT);
+  set_probe_format(&ctx.output_format, out, PROBE_WIDTH, PROBE_HEIGHT);
+
+  in_frame = gavl_video_frame_create(&ctx.input_format);
+  out_frame = gavl_video_frame_create(&ctx.output_format);
+  gavl_video_frame_clear(in_frame, &ctx.input_format);
+
+  ctx.options = &probe_opt;
+  ctx.input_frame = in_frame;
+  ctx.output_frame = out_frame;
+
+  /* Warm up the caches */
+  ctx.func(&ctx);
+
+  for(i = 0; i < PROBE_RUNS; i++)
+    {
+    t = gavl_benchmark_get_time(probe_opt.accel_flags);
+    ctx.func(&ctx);
+    t = gavl_benchmark_get_time(probe_opt.accel_flags) - t;
+    min = get_min_time(t, min, i);
+    }
+
+  gavl_video_frame_destroy(in_frame);
+  gavl_video_frame_destroy(out_frame);
+
+  return (double)min / (PROBE_WIDTH * PROBE_HEIGHT);
+  }
+
+/*
+ *  The work of the scaler is roughly proportional to the output width
+ *  times the sum of input and output heights (horizontal pass on the
+ *  input lines, vertical pass on the output lines). We return the
+ *  time per unit of that.
+ */
+
+static double scale_units(int in_height, int out_width, int out_height)
+  {
+  return (double)out_width * (in_height + out_height) * 0.5;
+  }
+
+static double measure_scale(const gavl_video_options_t * opt,
+                            gavl_pixelformat_t pixelformat)
+  {
+  int i;
+  uint64_t t, min = 0;
+  gavl_video_scaler_t * scaler;
+  gavl_video_format_t in_format;
+  gavl_video_format_t out_format;
+  gavl_video_frame_t * in_frame;
+  gavl_video_frame_t * out_frame;
+
+  set_probe_format(&in_format, pixelformat, PROBE_WIDTH, PROBE_HEIGHT);
+  set_probe_format(&out_format, pixelformat,
+                   PROBE_WIDTH_SCALED, PROBE_HEIGHT_SCALED);
+
+  scaler = gavl_video_scaler_create();
+  set_probe_options(gavl_video_scaler_get_options(scaler), opt);
+
+  if(!gavl_video_scaler_init(scaler, &in_format, &out_format))
+    {
+    gavl_video_scaler_destroy(scaler);
+    return -1.0;
+    }
+
+  in_frame = gavl_video_frame_create(&in_format);
+  out_frame = gavl_video_frame_create(&out_format);
+  gavl_video_frame_clear(in_frame, &in_format);
+
+  gavl_video_scaler_scale(scaler, in_frame, out_frame);
+
+  for(i = 0; i < PROBE_RUNS; i++)
+    {
+    t = gavl_benchmark_get_time(opt->accel_flags);
+    gavl_video_scaler_scale(scaler, in_frame, out_frame);
+    t = gavl_benchmark_get_time(opt->accel_flags) - t;
+    min = get_min_time(t, min, i);
+    }
+
+  gavl_video_frame_destroy(in_frame);
+  gavl_video_frame_destroy(out_frame);
+  gavl_video_scaler_destroy(scaler);
+
+  return (double)min / scale_units(PROBE_HEIGHT,
+                                   PROBE_WIDTH_SCALED, PROBE_HEIGHT_SCALED);
+  }
+
+/* Time per pixel */
+
+static double measure_deinterlace(const gavl_video_options_t * opt,
+                                  gavl_pixelformat_t pixelformat)
+  {
+  int i;
+  uint64_t t, min = 0;
+  gavl_video_deinterlacer_t * deinterlacer;
+  gavl_video_format_t format;
+  gavl_video_frame_t * in_frame;
+  gavl_video_frame_t * out_frame;
+
+  set_probe_format(&format, pixelformat, PROBE_WIDTH, PROBE_HEIGHT);
+  format.interlace_mode = GAVL_INTERLACE_TOP_FIRST;
+
+  deinterlacer = gavl_video_deinterlacer_create();
+  set_probe_options(gavl_video_deinterlacer_get_options(deinterlacer), opt);
+
+  if(!gavl_video_deinterlacer_init(deinterlacer, &format))
+    {
+    gavl_video_deinterlacer_destroy(deinterlacer);
+    return -1.0;
+    }
+
+  in_frame = gavl_video_frame_create(&format);
+  out_frame = gavl_video_frame_create(&format);
+  gavl_video_frame_clear(in_frame, &format);
+
+  gavl_video_deinterlacer_deinterlace(deinterlacer, in_frame, out_frame);
+
+  for(i = 0; i < PROBE_RUNS; i++)
+    {
+    t = gavl_benchmark_get_time(opt->accel_flags);
+    gavl_video_deinterlacer_deinterlace(deinterlacer, in_frame, out_frame);
+    t = gavl_benchmark_get_time(opt->accel_flags) - t;
+    min = get_min_time(t, min, i);
+    }
+
+  gavl_video_frame_destroy(in_frame);
+  gavl_video_frame_destroy(out_frame);
+  gavl_video_deinterlacer_destroy(deinterlacer);
+
+  return (double)min / (PROBE_WIDTH * PROBE_HEIGHT);
+  }
+
+static void init_entry(cost_entry_t * e, cost_type_t type,
+                       const gavl_video_options_t * opt,
+                       gavl_pixelformat_t in,
+                       gavl_pixelformat_t out)
+  {
+  memset(e, 0, sizeof(*e));
+  e->type = type;
+  e->in = in;
+  e->out = out;
+  e->accel_flags = opt->accel_flags;
+  e->quality = opt->quality;
+
+  /* Only the options, which select the routines */
+  if(type == COST_SCALE)
+    {
+    e->scale_mode = opt->scale_mode;
+    e->scale_order = opt->scale_order;
+    }
+  else if(type == COST_DEINTERLACE)
+    e->deinterlace_mode = opt->deinterlace_mode;
+  }
+
+static double get_cost(cost_type_t type,
+                       const gavl_video_options_t * opt,
+                       gavl_pixelformat_t in,
+                       gavl_pixelformat_t out)
+  {
+  int i;
+  cost_entry_t e;
+
+  init_entry(&e, type, opt, in, out);
+
+  pthread_mutex_lock(&costs_mutex);
+
+  for(i = 0; i < num_costs; i++)
+    {
+    if((costs[i].type == e.type) &&
+       (costs[i].in == e.in) &&
+       (costs[i].out == e.out) &&
+       (costs[i].accel_flags == e.accel_flags) &&
+       (costs[i].quality == e.quality) &&
+       (costs[i].scale_mode == e.scale_mode) &&
+       (costs[i].scale_order == e.scale_order) &&
+       (costs[i].deinterlace_mode == e.deinterlace_mode))
+      {
+      e.cost = costs[i].cost;
+      pthread_mutex_unlock(&costs_mutex);
+      return e.cost;
+      }
+    }
+
+  /* Measure with the lock held, so we measure each entry only once
+     and concurrent probes don't disturb each other */
+
+  switch(type)
+    {
+    case COST_PIXELFORMAT:
+      e.cost = measure_pixelformat(opt, in, out);
+      break;
+    case COST_SCALE:
+      e.cost = measure_scale(opt, in);
+      break;
+    case COST_DEINTERLACE:
+      e.cost = measure_deinterlace(opt, in);
+      break;
+    }
+
+  if(num_costs == costs_alloc)
+    {
+    costs_alloc += 32;
+    costs = realloc(costs, costs_alloc * sizeof(*costs));
+    }
+  costs[num_costs++] = e;
+
+  pthread_mutex_unlock(&costs_mutex);
+  return e.cost;
+  }
+
+double gavl_video_cost_pixelformat(const gavl_video_options_t * opt,
+                                   const gavl_video_format_t * in_format,
+                                   const gavl_video_format_t * out_format)
+  {
+  double ret;
+
+  if(in_format->pixelformat == out_format->pixelformat)
+    return 0.0;
+
+  ret = get_cost(COST_PIXELFORMAT, opt,
+                 in_format->pixelformat, out_format->pixelformat);
+  if(ret < 0.0)
+    return ret;
+  return ret * in_format->image_width * in_format->image_height;
+  }
+
+double gavl_video_cost_scale(const gavl_video_options_t * opt,
+                             const gavl_video_format_t * in_format,
+                             const gavl_video_format_t * out_format)
+  {
+  double ret;
+
+  /* Scalers, which also change the subsampling, run in the
+     source pixelformat */
+  ret = get_cost(COST_SCALE, opt, in_format->pixelformat,
+                 in_format->pixelformat);
+  if(ret < 0.0)
+    return ret;
+  return ret * scale_units(in_format->image_height,
+                           out_format->image_width,
+                           out_format->image_height);
+  }
+
+double gavl_video_cost_deinterlace(const gavl_video_options_t * opt,
+                                   const gavl_video_format_t * format)
+  {
+  double ret;
+  ret = get_cost(COST_DEINTERLACE, opt, format->pixelformat,
+                 format->pixelformat);
+  if(ret < 0.0)
+    return ret;
+  return ret * format->image_width * format->image_height;
+  }
@@ -82,6 +82,7 @@ void gavl_video_options_set_run_func(gavl_video_options_t * opt,
   {
   opt->run_func = run;
   opt->run_data = client_data;
+  opt->thread_pool = NULL;
   }
 
 gavl_video_run_func
@@ -99,6 +100,7 @@ void gavl_video_options_set_stop_func(gavl_video_options_t * opt,
   {
   opt->stop_func = stop;
   opt->stop_data = client_data;
+  opt->thread_pool = NULL;
   }
 
 gavl_video_stop_func
@@ -109,6 +111,72 @@ gavl_video_options_get_stop_func(const gavl_video_options_t * opt,
   return opt->stop_func;
   }
 
+void gavl_video_options_set_thread_pool(gavl_video_options_t * opt,
+                                        gavl_thread_pool_t * pool)
+  {
+  if(!pool)
+    {
+    opt->num_threads = 1;
+    opt->run_func = run_func_default;
+    opt->run_data = NULL;
+    opt->stop_func = stop_func_default;
+    opt->stop_data = NULL;
+    opt->thread_pool = NULL;
+    return;
+    }
+  opt->num_threads = gavl_thread_pool_get_num_threads(pool);
+  opt->run_func = gavl_thread_pool_run;
+  opt->run_data = pool;
+  opt->stop_func = gavl_thread_pool_stop;
+  opt->stop_data = pool;
+  opt->thread_pool = pool;
+  }
+
+gavl_thread_pool_t *
+gavl_video_options_get_thread_pool(const gavl_video_options_t * opt)
+  {
+  return opt->thread_pool;
+  }
+
+/* With a thread pool, we make more slices than threads so idle
+   workers can steal the remaining ones */
+
+#define SLICES_PER_THREAD 4
+
+void gavl_video_run_slices(const gavl_video_options_t * opt,
+                           void (*func)(void*, int, int),
+                           void * data, int num)
+  {
+  int delta;
+  int scanline;
+  int ns;
+  int i;
+
+  if(num <= 0)
+    return;
+  
+  ns = opt->num_threads;
+  if(opt->thread_pool)
+    ns *= SLICES_PER_THREAD;
+  
+  if(ns > num)
+    ns = num;
+  if(ns < 1)
+    ns = 1;
+
+  delta = num / ns;
+  scanline = 0;
+  for(i = 0; i < ns - 1; i++)
+    {
+    opt->run_func(func, data, scanline, scanline+delta, opt->run_data, i);
+    scanline += delta;
+    }
+  opt->run_func(func, data, scanline, num, opt->run_data, ns - 1);
+  
+  for(i = 0; i < ns; i++)
+    opt->stop_func(opt->stop_data, i);
+  }
+
 void gavl_video_options_set_rectangles(gavl_video_options_t * opt,
                                        const gavl_rectangle_f_t * src_rect,
                                        const gavl_rectangle_i_t * dst_rect)
@@ -27,15 +27,42 @@
 
 typedef void (*gavl_blend_func_t)(gavl_overlay_blend_context_t * ctx,
                                   gavl_video_frame_t * frame,
-                                  gavl_video_frame_t * overlay);
+                                  gavl_video_frame_t * overlay,
+                                  int width, int height);
+
+/* Line functions for the common 8 bit cases. They are called for
+   spans of partially transparent overlay pixels only, see blend_c.c */
+
+typedef struct
+  {
+  /* Blend num RGBA_32 pixels onto RGB_32 */
+  void (*blend_rgb_32)(uint8_t * dst, const uint8_t * ovl, int num);
+
+  /* Blend the Y channel of num YUVA_32 pixels onto a luma plane */
+  void (*blend_y_8)(uint8_t * dst, const uint8_t * ovl, int num);
+
+  /* Blend the chroma of every sub_h'th YUVA_32 pixel onto num samples
+     of the chroma planes */
+  void (*blend_uv_8)(uint8_t * dst_u, uint8_t * dst_v,
+                     const uint8_t * ovl, int num, int sub_h);
+  } gavl_blend_funcs_t;
 
 struct gavl_overlay_blend_context_s
   {
   gavl_video_format_t dst_format;
   gavl_video_format_t ovl_format;
   gavl_blend_func_t func;
+  gavl_blend_funcs_t funcs;
 
   gavl_overlay_t * ovl;
+
+  /* Frame, from which the overlay pixels are taken: Either ovl or
+     ovl_premultiplied */
+  gavl_video_frame_t * ovl_frame;
+
+  /* Premultiplied copy of the overlay (GAVL_PREMULTIPLY_OVERLAYS) */
+  int premultiply;
+  gavl_video_frame_t * ovl_premultiplied;
   
   gavl_video_frame_t * ovl_win;
   gavl_video_frame_t * dst_win;
@@ -50,10 +77,40 @@ struct gavl_overlay_blend_context_s
   gavl_video_sink_t * sink;
   };
 
+/* Compositor: One blend context per layer, all layers are blended
+   in horizontal bands of the dirty rectangle */
+
+#define COMPOSITOR_BAND_HEIGHT 16
+
+struct gavl_overlay_compositor_s
+  {
+  gavl_video_format_t dst_format;
+  gavl_video_format_t ovl_format;
+
+  gavl_video_options_t opt;
+
+  gavl_overlay_blend_context_t ** layers;
+  int num_layers;
+
+  /* Valid during gavl_overlay_compositor_blend() */
+  gavl_rectangle_i_t dirty;
+  gavl_video_frame_t * dst_frame;
+  };
+
 gavl_blend_func_t
 gavl_find_blend_func_c(gavl_overlay_blend_context_t * ctx,
                        gavl_pixelformat_t frame_format,
                        gavl_pixelformat_t * overlay_format);
 
+void gavl_init_blend_funcs_c(gavl_blend_funcs_t * funcs, int premultiplied);
+
+#ifdef HAVE_SSE2
+void gavl_init_blend_funcs_sse2(gavl_blend_funcs_t * funcs, int premultiplied);
+#endif
+
+#ifdef HAVE_AVX2
+void gavl_init_blend_funcs_avx2(gavl_blend_funcs_t * funcs, int premultiplied);
+#endif
+
                        
 #endif // BLEND_H_INCLUDED
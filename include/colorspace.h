@@ -1278,4 +1278,12 @@ void gavl_init_rgb_yuv_funcs_sse3(gavl_pixelformat_function_table_t *,
                                   const gavl_video_options_t * opt);
 #endif
 
+#ifdef HAVE_AVX2
+void gavl_init_rgb_yuv_funcs_avx2(gavl_pixelformat_function_table_t *,
+                                  int width, const gavl_video_options_t * opt);
+
+void gavl_init_yuv_rgb_funcs_avx2(gavl_pixelformat_function_table_t *,
+                                  int width, const gavl_video_options_t * opt);
+#endif
+
 #endif // COLORSPACE_H_INCLUDED
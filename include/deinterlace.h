@@ -30,12 +30,47 @@ typedef void (*gavl_video_deinterlace_func)(gavl_video_deinterlacer_t*,
                                             const gavl_video_frame_t*in,
                                             gavl_video_frame_t*out);
 
+/* Deinterlace the scanlines [start, end[ of one plane */
+
+typedef void (*gavl_video_deinterlace_band_func)(gavl_video_deinterlacer_t*,
+                                                 const gavl_video_frame_t*in,
+                                                 gavl_video_frame_t*out,
+                                                 int plane, int start, int end);
+
 typedef void (*gavl_video_deinterlace_blend_func)(const uint8_t * t,
                                                   const uint8_t * m,
                                                   const uint8_t * b,
                                                   uint8_t * dst,
                                                   int num);
 
+/* Lines for the motion adaptive deinterlacer. The missing line is
+   interpolated from the lines above and below (which belong to the
+   kept field), the missing line itself and the same lines of the
+   previous frame */
+
+typedef struct
+  {
+  const uint8_t * prev;
+  const uint8_t * prev_above;
+  const uint8_t * prev_below;
+  const uint8_t * cur;
+  const uint8_t * above;
+  const uint8_t * below;
+  uint8_t * dst;
+  } gavl_video_deinterlace_lines_t;
+
+/* Process the samples [start, end[. The neighbours start - 2*advance
+   and end - 1 + 2*advance must be valid. Returns the number of
+   processed samples, the rest is done in C. */
+
+typedef int (*gavl_video_deinterlace_adaptive_func)(const gavl_video_deinterlace_lines_t * l,
+                                                    int start, int end, int advance);
+
+typedef struct
+  {
+  gavl_video_deinterlace_adaptive_func func_8;
+  } gavl_video_deinterlace_adaptive_func_table_t;
+
 typedef struct
   {
   gavl_video_deinterlace_blend_func func_packed_15;
@@ -51,6 +86,14 @@ struct gavl_video_deinterlacer_s
   gavl_video_format_t format;
   gavl_video_format_t half_height_format;
   gavl_video_deinterlace_func func;
+
+  /* Set by the copy and blend deinterlacers, which can
+     process arbitrary bands of scanlines */
+  gavl_video_deinterlace_band_func band_func;
+
+  /* Frames for the slice function */
+  const gavl_video_frame_t * input_frame;
+  gavl_video_frame_t * output_frame;
   
   gavl_video_frame_t * src_field;
   gavl_video_frame_t * dst_field;
@@ -70,8 +113,27 @@ struct gavl_video_deinterlacer_s
   int sub_v;
   
   int mixed;
+
+  /* Motion adaptive */
+  gavl_video_deinterlace_adaptive_func adaptive_func;
+  int bytes_per_sample; /* 1, 2 or 4 (float) */
+  int advance;          /* Distance of horizontal neighbours in samples */
+  
+  gavl_video_frame_t * history[2];
+  int history_index;    /* History frame, which receives the current frame */
+  int have_history;
   };
 
+/* Band interface for the fused conversion (see videoconverter.c).
+   The band frame starts at scanline y of the output frame */
+
+int gavl_video_deinterlacer_can_deinterlace_band(gavl_video_deinterlacer_t * d);
+
+void gavl_video_deinterlacer_deinterlace_band(gavl_video_deinterlacer_t * d,
+                                              const gavl_video_frame_t * in,
+                                              gavl_video_frame_t * band,
+                                              int y, int h);
+
 /* Find conversion function */
 
 int gavl_deinterlacer_init_scale(gavl_video_deinterlacer_t * d);
@@ -81,6 +143,14 @@ int gavl_deinterlacer_init_blend(gavl_video_deinterlacer_t * d);
 
 int gavl_deinterlacer_init_copy(gavl_video_deinterlacer_t * d);
 
+int gavl_deinterlacer_init_adaptive(gavl_video_deinterlacer_t * d);
+
+void gavl_deinterlacer_cleanup_adaptive(gavl_video_deinterlacer_t * d);
+
+/* Called after each frame */
+void gavl_deinterlacer_finish_adaptive(gavl_video_deinterlacer_t * d,
+                                       int interlaced);
+
 void
 gavl_find_deinterlacer_blend_funcs_c(gavl_video_deinterlace_blend_func_table_t * tab,
                                      const gavl_video_options_t * opt,
@@ -98,6 +168,34 @@ gavl_find_deinterlacer_blend_funcs_mmxext(gavl_video_deinterlace_blend_func_tabl
                                           const gavl_video_format_t * format);
 #endif
 
+#ifdef HAVE_SSE2
+void
+gavl_find_deinterlacer_blend_funcs_sse2(gavl_video_deinterlace_blend_func_table_t * tab,
+                                        const gavl_video_options_t * opt,
+                                        const gavl_video_format_t * format);
+#endif
+
+#ifdef HAVE_AVX2
+void
+gavl_find_deinterlacer_blend_funcs_avx2(gavl_video_deinterlace_blend_func_table_t * tab,
+                                        const gavl_video_options_t * opt,
+                                        const gavl_video_format_t * format);
+#endif
+
+#ifdef HAVE_SSE2
+void
+gavl_find_deinterlacer_adaptive_funcs_sse2(gavl_video_deinterlace_adaptive_func_table_t * tab,
+                                           const gavl_video_options_t * opt,
+                                           const gavl_video_format_t * format);
+#endif
+
+#ifdef HAVE_AVX2
+void
+gavl_find_deinterlacer_adaptive_funcs_avx2(gavl_video_deinterlace_adaptive_func_table_t * tab,
+                                           const gavl_video_options_t * opt,
+                                           const gavl_video_format_t * format);
+#endif
+
 #ifdef HAVE_3DNOW
 void
 gavl_find_deinterlacer_blend_funcs_3dnow(gavl_video_deinterlace_blend_func_table_t * tab,
@@ -49,4 +49,9 @@ void gavl_dsp_init_ssse3(gavl_dsp_funcs_t * funcs,
                          int quality);
 #endif
 
+#ifdef HAVE_AVX2
+void gavl_dsp_init_avx2(gavl_dsp_funcs_t * funcs, 
+                        int quality);
+#endif
+
 #endif // DSP_H_INCLUDED
@@ -155,6 +155,78 @@ typedef void (*gavl_video_run_func)(gavl_video_process_func func,
  */
  
 typedef void (*gavl_video_stop_func)(void * client_data, int thread);
+
+/** \brief Thread pool
+ *
+ *  The builtin thread pool can be used instead of application supplied
+ *  run- and stop functions. It can be shared among many converters
+ *  (also from different application threads). Each worker has its own
+ *  task queue and idle workers steal tasks from the others.
+ *  Use \ref gavl_video_options_set_thread_pool to use it for video
+ *  processing. Other code can pass \ref gavl_thread_pool_run and
+ *  \ref gavl_thread_pool_stop together with the pool as client data.
+ *
+ *  You don't want to know what's inside
+ */
+
+typedef struct gavl_thread_pool_s gavl_thread_pool_t;
+
+/** \brief Create a thread pool
+ *  \param num_threads Number of worker threads (0 means number of CPUs)
+ *  \returns A newly allocated thread pool
+ *
+ *  The worker threads are started when the first task is submitted.
+ */
+
+GAVL_PUBLIC
+gavl_thread_pool_t * gavl_thread_pool_create(int num_threads);
+
+/** \brief Destroy a thread pool
+ *  \param pool A thread pool
+ *
+ *  The pool must not be used by any converter anymore.
+ */
+
+GAVL_PUBLIC
+void gavl_thread_pool_destroy(gavl_thread_pool_t * pool);
+
+/** \brief Get the number of worker threads
+ *  \param pool A thread pool
+ *  \returns Number of worker threads
+ */
+
+GAVL_PUBLIC
+int gavl_thread_pool_get_num_threads(gavl_thread_pool_t * pool);
+
+/** \brief Run function for thread pools
+ *  \param func Function to execute
+ *  \param gavl_data 1. Argument for func
+ *  \param start 2. Argument for func
+ *  \param end   3. Argument for func
+ *  \param client_data The thread pool
+ *  \param thread Number of the preferred worker thread
+ *
+ *  This is a \ref gavl_video_run_func, which submits the task to a
+ *  thread pool.
+ */
+
+GAVL_PUBLIC
+void gavl_thread_pool_run(gavl_video_process_func func,
+                          void * gavl_data,
+                          int start, int end,
+                          void * client_data, int thread);
+
+/** \brief Stop function for thread pools
+ *  \param client_data The thread pool
+ *  \param thread Number of the preferred worker thread
+ *
+ *  This is a \ref gavl_video_stop_func. It returns after all tasks,
+ *  which were submitted by the calling thread, are finished.
+ *  While waiting, the calling thread executes queued tasks itself.
+ */
+
+GAVL_PUBLIC
+void gavl_thread_pool_stop(void * client_data, int thread);
   
 /**
  * @}
@@ -224,6 +296,16 @@ typedef void (*gavl_video_stop_func)(void * client_data, int thread);
 #define GAVL_ACCEL_3DNOW    (1<<5) //!< AMD 3Dnow
 #define GAVL_ACCEL_3DNOWEXT (1<<6) //!< AMD 3Dnow ext
 #define GAVL_ACCEL_SSSE3    (1<<7) //!< Intel SSSE3
+#define GAVL_ACCEL_AVX2     (1<<8) //!< Intel AVX2
+#define GAVL_ACCEL_AVX      (1<<9) //!< Intel AVX
+#define GAVL_ACCEL_FMA      (1<<10) //!< Fused multiply add (FMA3)
+#define GAVL_ACCEL_F16C     (1<<11) //!< Half float conversion
+#define GAVL_ACCEL_BMI2     (1<<12) //!< Bit manipulation instructions 2
+#define GAVL_ACCEL_AVX512F  (1<<13) //!< AVX-512 Foundation
+#define GAVL_ACCEL_AVX512BW (1<<14) //!< AVX-512 Byte and word instructions
+#define GAVL_ACCEL_AVX512VL (1<<15) //!< AVX-512 Vector length extensions
+
+/* Bits 16 and up are used internally */
 
 /** \brief Get the supported acceleration flags
  *  \returns A combination of GAVL_ACCEL_* flags.
@@ -3081,7 +3163,50 @@ int gavl_video_frames_equal(const gavl_video_format_t * format,
  */
 
 #define GAVL_RESAMPLE_CHROMA    (1<<3)
-  
+
+/** \ingroup video_conversion_flags
+ * \brief Fused conversion
+ *
+ *  Run consecutive conversion steps over horizontal bands of the image,
+ *  which are small enough to stay in the 2nd level cache. Intermediate
+ *  frames between the fused steps are replaced by small band buffers.
+ *  This saves memory bandwidth for large images. Steps, which cannot be
+ *  done in bands, are still done for the whole frame.
+ */
+
+#define GAVL_FUSED_CONVERSION   (1<<4)
+
+/** \ingroup video_conversion_flags
+ * \brief Cost based planning
+ *
+ *  Choose the order of pixelformat conversion and scaling by the
+ *  estimated costs of the conversion steps instead of fixed rules.
+ *  The costs are measured once per process by running the actual
+ *  routines on small probe images. This can make the first
+ *  initialization of a converter slower. Note that the fixed rules
+ *  also take the quality into account, which is ignored here.
+ *
+ *  See also \ref gavl_video_converter_get_plan
+ */
+
+#define GAVL_COST_BASED_PLANNING (1<<5)
+
+/** \ingroup video_conversion_flags
+ * \brief Premultiply overlays
+ *
+ *  Let the overlay blend context multiply the color channels of each
+ *  overlay with its alpha once, when the overlay is set. Blending it
+ *  then saves one multiplication per pixel and channel, which pays off
+ *  if the same overlay is blended onto many frames. The results can
+ *  differ from the straight alpha blending by one.
+ *  It is used for RGB_32 and 8 bit planar YUV frames without alpha,
+ *  and ignored for all other formats.
+ *
+ *  Since 2.0.0
+ */
+
+#define GAVL_PREMULTIPLY_OVERLAYS (1<<6)
+
 /** \ingroup video_options
  * Alpha handling mode
  *
@@ -3106,13 +3231,15 @@ typedef enum
     GAVL_DEINTERLACE_NONE      = 0, /*!< Don't care about interlacing                */
     GAVL_DEINTERLACE_COPY      = 1, /*!< Take one field and copy it to the other     */
     GAVL_DEINTERLACE_SCALE     = 2, /*!< Take one field and scale it vertically by 2 */
-    GAVL_DEINTERLACE_BLEND     = 3  /*!< Linear blend fields together */
+    GAVL_DEINTERLACE_BLEND     = 3, /*!< Linear blend fields together */
+    GAVL_DEINTERLACE_ADAPTIVE  = 4, /*!< Motion adaptive, edge directed interpolation of one field. Since 2.0.0 */
   } gavl_deinterlace_mode_t;
 
 /** \ingroup video_options
  * \brief Specifies which field to drop when deinterlacing
  *
- * This is used for deinterlacing with GAVL_DEINTERLACE_COPY and GAVL_DEINTERLACE_SCALE.
+ * This is used for deinterlacing with GAVL_DEINTERLACE_COPY, GAVL_DEINTERLACE_SCALE
+ * and GAVL_DEINTERLACE_ADAPTIVE.
  */
   
 typedef enum
@@ -3136,6 +3263,7 @@ typedef enum
     GAVL_SCALE_CUBIC_CATMULL, /*!< Cubic Catmull-Rom */
     GAVL_SCALE_SINC_LANCZOS,  /*!< Sinc with Lanczos window. Set order with \ref gavl_video_options_set_scale_order */
     GAVL_SCALE_NONE,          /*!< Used internally when the scaler is used as a convolver */
+    GAVL_SCALE_BOX,           /*!< Area averaging. Fast and alias free for downscaling by integer factors. The downscale filter is ignored. Since 2.0.0 */
   } gavl_scale_mode_t;
 
 /** \ingroup video_options
@@ -3526,6 +3654,31 @@ gavl_video_stop_func
 gavl_video_options_get_stop_func(const gavl_video_options_t * opt,
                                  void ** client_data);
 
+/*!  \ingroup video_options
+ *   \brief Use a thread pool
+ *   \param opt Video options
+ *   \param pool A thread pool or NULL
+ *
+ *  This sets the number of threads, the run- and stop functions
+ *  for the thread pool. The pool is not owned by the options and
+ *  must be kept alive as long as it's used. Passing NULL restores the
+ *  single threaded defaults.
+ */
+
+GAVL_PUBLIC
+void gavl_video_options_set_thread_pool(gavl_video_options_t * opt,
+                                        gavl_thread_pool_t * pool);
+
+/*!  \ingroup video_options
+ *   \brief Get the thread pool
+ *   \param opt Video options
+ *   \returns The thread pool or NULL
+ */
+
+GAVL_PUBLIC
+gavl_thread_pool_t *
+gavl_video_options_get_thread_pool(const gavl_video_options_t * opt);
+
   
 /***************************************************
  * Create and destroy video converters
@@ -3630,6 +3783,71 @@ int gavl_video_converter_init(gavl_video_converter_t* cnv,
   
 GAVL_PUBLIC
 int gavl_video_converter_reinit(gavl_video_converter_t* cnv);
+
+/*! \ingroup video_converter
+ *  \brief Set the size of the conversion plan cache
+ *  \param cnv A video converter
+ *  \param num_plans Maximum number of cached plans (0 disables the cache)
+ *
+ * With the plan cache enabled, \ref gavl_video_converter_init and
+ * \ref gavl_video_converter_reinit keep the fully initialized
+ * conversion chains (including scalers, deinterlacers and temporary frames)
+ * of previous initializations. If the input format, output format and
+ * options match a cached plan, it is reused instead of being rebuilt.
+ * If the cache is full, the least recently used plan is freed.
+ *
+ * This is useful if an application switches back and forth between
+ * a small number of formats. The default is 0.
+ *
+ * Since 2.0.0
+ */
+
+GAVL_PUBLIC
+void gavl_video_converter_set_plan_cache_size(gavl_video_converter_t* cnv,
+                                              int num_plans);
+
+/*! \ingroup video_converter
+ *  \brief Type of a conversion step
+ */
+
+typedef enum
+  {
+    GAVL_VIDEO_STEP_PIXELFORMAT = 0, //!< Pixelformat conversion
+    GAVL_VIDEO_STEP_SCALE,           //!< Scaling (can also change the chroma subsampling)
+    GAVL_VIDEO_STEP_DEINTERLACE,     //!< Deinterlacing
+  } gavl_video_step_type_t;
+
+/*! \ingroup video_converter
+ *  \brief Description of a conversion step
+ */
+
+typedef struct
+  {
+  gavl_video_step_type_t type;       //!< Type
+  gavl_video_format_t input_format;  //!< Input format of this step
+  gavl_video_format_t output_format; //!< Output format of this step
+  double cost; //!< Estimated time per frame in units of \ref gavl_benchmark_get_time, negative if unknown
+  } gavl_video_step_t;
+
+/*! \ingroup video_converter
+ *  \brief Get the conversion steps of an initialized converter
+ *  \param cnv A video converter
+ *  \param steps Returns the steps
+ *  \param max_steps Number of elements in steps
+ *  \returns The total number of conversion steps
+ *
+ * At most max_steps steps are stored. Pass NULL and 0 to get only
+ * the number of steps. The costs come from the same measurements as
+ * with \ref GAVL_COST_BASED_PLANNING. If they weren't measured before,
+ * calling this function will measure them.
+ *
+ * Since 2.0.0
+ */
+
+GAVL_PUBLIC
+int gavl_video_converter_get_plan(gavl_video_converter_t* cnv,
+                                  gavl_video_step_t * steps,
+                                  int max_steps);
  
   
 /***************************************************
@@ -3648,6 +3866,48 @@ void gavl_video_convert(gavl_video_converter_t * cnv,
                         const gavl_video_frame_t * input_frame,
                         gavl_video_frame_t * output_frame);
 
+/*! \ingroup video_converter
+ *  \brief Convert multiple frames at once
+ *  \param cnv A video converter
+ *  \param input_frames Input frames
+ *  \param output_frames Output frames
+ *  \param num_frames Number of frames
+ *
+ * This has the same result as calling \ref gavl_video_convert for
+ * each frame. If more than one thread is configured, the frames are
+ * distributed among the threads, which convert them independently.
+ * This needs only one synchronization per batch instead of several
+ * per frame, which is much faster for many small images.
+ * Each thread uses its own copy of the conversion chain, which is
+ * created on the first call after (re)initialization.
+ *
+ * With \ref GAVL_DEINTERLACE_ADAPTIVE, each frame depends on the
+ * previous one, so the frames are converted sequentially in the
+ * calling thread.
+ *
+ * Since 2.0.0
+ */
+  
+GAVL_PUBLIC
+void gavl_video_convert_batch(gavl_video_converter_t * cnv,
+                              const gavl_video_frame_t ** input_frames,
+                              gavl_video_frame_t ** output_frames,
+                              int num_frames);
+
+/*! \ingroup video_converter
+ *  \brief Forget previous frames
+ *  \param cnv A video converter
+ *
+ * Call this after seeking. It calls \ref gavl_video_deinterlacer_reset
+ * for the deinterlacer of the conversion chain, so the next frame
+ * doesn't use the history from before the seek.
+ *
+ * Since 2.0.0
+ */
+
+GAVL_PUBLIC
+void gavl_video_converter_reset(gavl_video_converter_t * cnv);
+
 /*! \defgroup video_scaler Scaler
  *  \ingroup video
  *  \brief Video scaler
@@ -3764,6 +4024,50 @@ void gavl_video_scaler_scale(gavl_video_scaler_t * scaler,
                              const gavl_video_frame_t * input_frame,
                              gavl_video_frame_t * output_frame);
 
+/*! \ingroup video_scaler
+ *  \brief Initialize a video scaler for multiple outputs
+ *  \param scaler A video scaler
+ *  \param src_format Input format
+ *  \param dst_formats Output formats
+ *  \param num_outputs Number of outputs
+ *  \returns 1 on success, 0 on error
+ *
+ * This sets up the scaler to produce several output sizes
+ * (e.g. a resolution ladder) from one input frame with
+ * \ref gavl_video_scaler_scale_multi. All output formats must have the
+ * pixelformat of the input format, otherwise 0 is returned. The
+ * rectangles in the options are ignored, each output gets the whole image.
+ *
+ * For progressive video and a quality of \ref GAVL_QUALITY_DEFAULT or less,
+ * smaller outputs are scaled from larger outputs instead of the input.
+ * This reads the input only once and needs less filter taps.
+ *
+ * Since 2.0.0
+ */
+
+GAVL_PUBLIC
+int gavl_video_scaler_init_multi(gavl_video_scaler_t * scaler,
+                                 const gavl_video_format_t * src_format,
+                                 const gavl_video_format_t * dst_formats,
+                                 int num_outputs);
+
+/*! \ingroup video_scaler
+ *  \brief Scale video into multiple outputs
+ *  \param scaler A video scaler
+ *  \param input_frame Input frame
+ *  \param output_frames Output frames (one for each output format)
+ *
+ * The scaler must be initialized with \ref gavl_video_scaler_init_multi.
+ *
+ * Since 2.0.0
+ */
+
+GAVL_PUBLIC
+void gavl_video_scaler_scale_multi(gavl_video_scaler_t * scaler,
+                                   const gavl_video_frame_t * input_frame,
+                                   gavl_video_frame_t ** output_frames);
+
+
 /*! \defgroup video_deinterlacer Deinterlacer
  *  \ingroup video
  *  \brief Deinterlacer
@@ -3835,6 +4139,21 @@ void gavl_video_deinterlacer_deinterlace(gavl_video_deinterlacer_t * deinterlace
                                          const gavl_video_frame_t * input_frame,
                                          gavl_video_frame_t * output_frame);
 
+/*! \ingroup video_deinterlacer
+ *  \brief Forget previous frames
+ *  \param deinterlacer A video deinterlacer
+ *
+ * The motion adaptive mode (\ref GAVL_DEINTERLACE_ADAPTIVE) uses the
+ * previous frame. Call this after seeking, so the next frame is
+ * interpolated from itself only.
+ *
+ * Since 2.0.0
+ */
+
+GAVL_PUBLIC
+void gavl_video_deinterlacer_reset(gavl_video_deinterlacer_t * deinterlacer);
+
+
   
   
 /**************************************************
@@ -3956,7 +4275,106 @@ void gavl_overlay_blend(gavl_overlay_blend_context_t * ctx,
 
 GAVL_PUBLIC gavl_video_sink_t *
 gavl_overlay_blend_context_get_sink(gavl_overlay_blend_context_t * ctx);
-  
+
+/*! \ingroup video_blend
+ *  \brief Opaque overlay compositor
+ *
+ *  A compositor blends several overlays (layers) onto a video frame.
+ *  Unlike using one \ref gavl_overlay_blend_context_t for each layer,
+ *  the destination frame is traversed only once: The union of all overlay
+ *  rectangles is processed in horizontal bands and all layers are blended
+ *  into a band before the next one is started. If the options
+ *  specify multiple threads, the bands are distributed among them.
+ *
+ *  You don't want to know what's inside.
+ *
+ *  Since 2.0.0
+ */
+
+typedef struct gavl_overlay_compositor_s gavl_overlay_compositor_t;
+
+/*! \ingroup video_blend
+ *  \brief Create an overlay compositor
+ *  \returns A newly allocated compositor.
+ *
+ *  Since 2.0.0
+ */
+
+GAVL_PUBLIC
+gavl_overlay_compositor_t * gavl_overlay_compositor_create();
+
+/*! \ingroup video_blend
+ *  \brief Destroy an overlay compositor and free all associated memory
+ *  \param c An overlay compositor
+ *
+ *  Since 2.0.0
+ */
+
+GAVL_PUBLIC
+void gavl_overlay_compositor_destroy(gavl_overlay_compositor_t * c);
+
+/*! \ingroup video_blend
+ *  \brief Get options from an overlay compositor
+ *  \param c An overlay compositor
+ *  \returns Options (See \ref video_options)
+ *
+ *  Change the options before calling \ref gavl_overlay_compositor_init.
+ *
+ *  Since 2.0.0
+ */
+
+GAVL_PUBLIC gavl_video_options_t *
+gavl_overlay_compositor_get_options(gavl_overlay_compositor_t * c);
+
+/*! \ingroup video_blend
+ *  \brief Initialize an overlay compositor
+ *  \param c An overlay compositor
+ *  \param frame_format The format of the destination frames
+ *  \param overlay_format The format of the overlays
+ *  \param num_layers Number of layers
+ *  \returns 1 on success, 0 on error
+ *
+ *  All layers share the same overlay format, which might be changed
+ *  like in \ref gavl_overlay_blend_context_init. Layer 0 is the bottom
+ *  one, layer num_layers-1 is on top.
+ *
+ *  Since 2.0.0
+ */
+
+GAVL_PUBLIC
+int gavl_overlay_compositor_init(gavl_overlay_compositor_t * c,
+                                 const gavl_video_format_t * frame_format,
+                                 gavl_video_format_t * overlay_format,
+                                 int num_layers);
+
+/*! \ingroup video_blend
+ *  \brief Set the overlay of a layer
+ *  \param c An overlay compositor
+ *  \param layer Index of the layer
+ *  \param ovl An overlay or NULL to switch the layer off
+ *
+ *  The overlay must stay valid as long as it is blended.
+ *
+ *  Since 2.0.0
+ */
+
+GAVL_PUBLIC
+void gavl_overlay_compositor_set_overlay(gavl_overlay_compositor_t * c,
+                                         int layer,
+                                         gavl_overlay_t * ovl);
+
+/*! \ingroup video_blend
+ *  \brief Blend all layers onto a video frame
+ *  \param c An overlay compositor
+ *  \param dst_frame Destination frame
+ *
+ *  Since 2.0.0
+ */
+
+GAVL_PUBLIC
+void gavl_overlay_compositor_blend(gavl_overlay_compositor_t * c,
+                                   gavl_video_frame_t * dst_frame);
+
 /*! \defgroup video_transform Image transformation
  * \ingroup video
  *
@@ -4040,6 +4458,34 @@ int gavl_image_transform_init(gavl_image_transform_t * t,
                               gavl_video_format_t * format,
                               gavl_image_transform_func func, void * priv);
 
+/** \brief Initialize a transformation engine for a perspective transform
+ *  \param t A transformation engine
+ *  \param format Format (can be changed)
+ *  \param matrix Coordinate transform matrix
+ *  \returns 1 if the transform was sucessfully initialized, 0 else.
+ *
+ * The matrix maps destination coordinates to homogeneous source
+ * coordinates:
+ *
+ * xsrc = (m[0][0] * xdst + m[0][1] * ydst + m[0][2]) / w
+ *
+ * ysrc = (m[1][0] * xdst + m[1][1] * ydst + m[1][2]) / w
+ *
+ * w = m[2][0] * xdst + m[2][1] * ydst + m[2][2]
+ *
+ * For affine transforms (rotation, scaling, shearing), the last row
+ * is 0, 0, 1. Coordinates are the same as for \ref gavl_image_transform_func.
+ * The source coordinates are calculated on the fly, so unlike
+ * \ref gavl_image_transform_init, no per pixel table is built.
+ *
+ * Since 2.0.0.
+ */
+
+GAVL_PUBLIC
+int gavl_image_transform_init_matrix(gavl_image_transform_t * t,
+                                     gavl_video_format_t * format,
+                                     const double matrix[3][3]);
+
 /** \brief Transform an image
  *  \param t A transformation engine
  *  \param in_frame Input frame
@@ -459,6 +459,27 @@ typedef struct
 
   void (*shuffle_8_4)(void * ptr, int num, uint8_t * mask);
   
+  /** \brief Get the sums of absolute differences for several candidates (8 bit)
+   *  \param block Block to search for
+   *  \param block_stride Byte distance between scanlines for block
+   *  \param ref Plane 2 at the position of the block
+   *  \param ref_stride Byte distance between scanlines for ref
+   *  \param w Width
+   *  \param h Height
+   *  \param offsets Byte offsets of the candidates relative to ref
+   *  \param num Number of candidates
+   *  \param costs Returns the sums of absolute differences
+   *
+   *  This is the same as calling sad_8 for each candidate,
+   *  but the block is loaded only once.
+   *
+   *  Since 2.0.0
+   */
+  
+  void (*sad_candidates_8)(const uint8_t * block, int block_stride,
+                           const uint8_t * ref, int ref_stride,
+                           int w, int h,
+                           const int * offsets, int num, int * costs);
   
   } gavl_dsp_funcs_t;
 
@@ -632,6 +653,100 @@ gavl_dsp_video_frame_shuffle_bytes(gavl_dsp_context_t * ctx,
                                    const uint32_t * src_masks,
                                    const uint32_t * dst_masks);
 
+/** \brief Motion search strategies
+ *
+ *  Since 2.0.0
+ */
+
+typedef enum
+  {
+    GAVL_MOTION_SEARCH_FULL = 0, //!< Test all vectors within the range
+    GAVL_MOTION_SEARCH_DIAMOND,  //!< Diamond search (large diamond, then small diamond)
+    GAVL_MOTION_SEARCH_HEXAGON,  //!< Hexagon search (hexagon, then small diamond)
+  } gavl_motion_search_mode_t;
+
+/** \brief Motion vector
+ *
+ *  Since 2.0.0
+ */
+
+typedef struct
+  {
+  int x;    //!< Horizontal offset of the matching block in the reference plane
+  int y;    //!< Vertical offset of the matching block in the reference plane
+  int cost; //!< Sum of absolute differences
+  } gavl_motion_vector_t;
+
+/*!
+  \brief Find the best matching position of a block in a reference plane
+  \param ctx An initialized dsp context
+  \param cur Plane containing the block
+  \param cur_stride Byte distance between scanlines for cur
+  \param ref Reference plane
+  \param ref_stride Byte distance between scanlines for ref
+  \param width Width of the planes
+  \param height Height of the planes
+  \param block Position and size of the block in cur
+  \param range Maximum horizontal and vertical displacement
+  \param mode Search strategy
+  \param mv Start vector on input, best vector on output
+
+  Both planes have 8 bit samples. The candidate positions are kept
+  inside the reference plane. The search starts with the zero vector
+  and the vector passed in mv (e.g. the one of a neighbouring block).
+  All candidates of one search step are evaluated with one call to
+  the sad_candidates_8 function.
+
+  Since 2.0.0
+*/
+
+GAVL_PUBLIC
+void gavl_dsp_sad_search(gavl_dsp_context_t * ctx,
+                         const uint8_t * cur, int cur_stride,
+                         const uint8_t * ref, int ref_stride,
+                         int width, int height,
+                         const gavl_rectangle_i_t * block,
+                         int range,
+                         gavl_motion_search_mode_t mode,
+                         gavl_motion_vector_t * mv);
+
+/*!
+  \brief Calculate a motion field between two video frames
+  \param ctx An initialized dsp context
+  \param opt Video options for multithreading or NULL
+  \param format The format of the frames
+  \param cur Current frame
+  \param ref Reference frame
+  \param block_size Width and height of the blocks
+  \param range Maximum horizontal and vertical displacement
+  \param mode Search strategy
+  \param field Returns the motion vectors
+  \returns 1 on success, 0 if the format is not supported
+
+  The luminance plane is divided into blocks of block_size x block_size
+  pixels. Incomplete blocks at the right and bottom border are skipped.
+  field must have space for
+  (image_width / block_size) * (image_height / block_size) vectors,
+  which are stored row by row. The vector of the left neighbour is
+  used as start vector for each block.
+  If opt is non-NULL, the block rows are distributed among the threads
+  configured there.
+
+  Supported are GRAY_8 and the planar 8 bit YUV formats.
+
+  Since 2.0.0
+*/
+
+GAVL_PUBLIC
+int gavl_dsp_motion_field(gavl_dsp_context_t * ctx,
+                          const gavl_video_options_t * opt,
+                          const gavl_video_format_t * format,
+                          const gavl_video_frame_t * cur,
+                          const gavl_video_frame_t * ref,
+                          int block_size, int range,
+                          gavl_motion_search_mode_t mode,
+                          gavl_motion_vector_t * field);
+
 /**
  * @}
  */
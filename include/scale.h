@@ -48,6 +48,7 @@ typedef struct
   int factors_per_pixel;
   int do_clip; /* Use routines with clipping */
   int normalized;
+  struct gavl_video_scale_table_entry_s * entry; /* Cache entry, see scale_table.c */
   } gavl_video_scale_table_t;
 
 typedef void
@@ -242,6 +243,18 @@ void gavl_init_scale_funcs_generic_y_sse2(gavl_scale_funcs_t * tab,
 void gavl_init_scale_funcs_bilinear_y_sse2(gavl_scale_funcs_t * tab,
                                           int src_advance, int dst_advance);
 
+void gavl_init_scale_funcs_bicubic_x_sse2(gavl_scale_funcs_t * tab,
+                                          int src_advance, int dst_advance);
+
+void gavl_init_scale_funcs_quadratic_x_sse2(gavl_scale_funcs_t * tab,
+                                            int src_advance, int dst_advance);
+
+void gavl_init_scale_funcs_generic_x_sse2(gavl_scale_funcs_t * tab,
+                                          int src_advance, int dst_advance);
+
+void gavl_init_scale_funcs_bilinear_x_sse2(gavl_scale_funcs_t * tab,
+                                           int src_advance, int dst_advance);
+
 
 #endif
 
@@ -253,6 +266,33 @@ void gavl_init_scale_funcs_bicubic_x_noclip_sse3(gavl_scale_funcs_t * tab);
 void gavl_init_scale_funcs_generic_x_sse3(gavl_scale_funcs_t * tab);
 
 
+#endif
+
+#ifdef HAVE_AVX2
+void gavl_init_scale_funcs_bicubic_y_avx2(gavl_scale_funcs_t * tab,
+                                          int src_advance, int dst_advance);
+
+void gavl_init_scale_funcs_quadratic_y_avx2(gavl_scale_funcs_t * tab,
+                                            int src_advance, int dst_advance);
+
+void gavl_init_scale_funcs_generic_y_avx2(gavl_scale_funcs_t * tab,
+                                          int src_advance, int dst_advance);
+
+void gavl_init_scale_funcs_bilinear_y_avx2(gavl_scale_funcs_t * tab,
+                                           int src_advance, int dst_advance);
+
+void gavl_init_scale_funcs_bicubic_x_avx2(gavl_scale_funcs_t * tab,
+                                          int src_advance, int dst_advance);
+
+void gavl_init_scale_funcs_quadratic_x_avx2(gavl_scale_funcs_t * tab,
+                                            int src_advance, int dst_advance);
+
+void gavl_init_scale_funcs_generic_x_avx2(gavl_scale_funcs_t * tab,
+                                          int src_advance, int dst_advance);
+
+void gavl_init_scale_funcs_bilinear_x_avx2(gavl_scale_funcs_t * tab,
+                                           int src_advance, int dst_advance);
+
 #endif
 
 void gavl_init_scale_funcs(gavl_scale_funcs_t * tab,
@@ -301,6 +341,23 @@ typedef struct
   int src_offset,  dst_offset;
   } gavl_video_scale_offsets_t;
 
+/*
+ *  For 2 directions, the intermediate image is never stored completely.
+ *  Each thread keeps a window of intermediate rows, which is filled
+ *  on demand by the first pass and consumed by the second pass.
+ */
+
+typedef struct
+  {
+  gavl_video_scale_context_t * ctx;
+  uint8_t * buffer;
+  int buffer_alloc;
+  
+  /* Rows of the intermediate image, which are currently in the buffer */
+  int first_row;
+  int last_row; /* Exclusive */
+  } gavl_video_scale_window_t;
+
 /*
  *  Scale context is for one plane of one field.
  *  This means, that depending on the video format, we have 1 - 6 scale contexts.
@@ -332,14 +389,16 @@ struct gavl_video_scale_context_s
 
   gavl_video_scale_offsets_t * offset;
   
-  /* Temporary buffer */
-  uint8_t * buffer;
-  int buffer_alloc;
-  int buffer_stride;
-  
-  /* Size of temporary buffer in pixels */
+  /* Size of the intermediate image in pixels */
   int buffer_width;
   int buffer_height;
+  int buffer_stride;
+
+  /* Windows into the intermediate image (one per thread) */
+  gavl_video_scale_window_t * windows;
+  int num_windows;
+  int window_rows;  /* Maximum number of rows in a window */
+  int vertical_first; /* 1 for Y then X */
 
   int num_directions;
 
@@ -361,8 +420,6 @@ struct gavl_video_scale_context_s
   uint8_t * src;
   int src_stride;
 
-  gavl_video_frame_t * dst_frame;
-  
   const gavl_video_options_t * opt;
   
   //  uint8_t * dst;
@@ -398,6 +455,46 @@ void gavl_video_scale_context_scale(gavl_video_scale_context_t * ctx,
                                     const gavl_video_frame_t * src,
                                     gavl_video_frame_t * dst);
 
+/*
+ *  Row wise scaling: gavl_video_scale_context_scale_init() sets up the
+ *  source. After that, gavl_video_scale_context_scale_rows() and
+ *  gavl_video_scale_context_scale_band() can be called for any range of
+ *  destination scanlines (also from several threads).
+ *  gavl_video_scale_context_scale_rows() writes the scanlines to their
+ *  position in dst, gavl_video_scale_context_scale_band() writes the first
+ *  scanline of the range into the first scanline of dst.
+ *  Each thread must pass its own index (0 .. num_threads - 1) and should
+ *  process its ranges from top to bottom, so the intermediate rows
+ *  can be reused.
+ */
+
+void gavl_video_scale_context_scale_init(gavl_video_scale_context_t * ctx,
+                                         const gavl_video_frame_t * src);
+
+void gavl_video_scale_context_scale_rows(gavl_video_scale_context_t * ctx,
+                                         gavl_video_frame_t * dst,
+                                         int start, int end, int thread);
+
+void gavl_video_scale_context_scale_band(gavl_video_scale_context_t * ctx,
+                                         gavl_video_frame_t * dst,
+                                         int start, int end, int thread);
+
+/* One plane of one field to be scaled by the threads */
+
+typedef struct
+  {
+  gavl_video_scale_context_t * ctx;
+  gavl_video_frame_t * dst;
+  int offset;   /* Sum of the costs of all previous jobs */
+  int row_cost; /* Cost of one destination row */
+  } gavl_video_scale_job_t;
+
+typedef struct
+  {
+  gavl_video_scaler_t * s;
+  int thread;
+  } gavl_video_scaler_thread_t;
+
 struct gavl_video_scaler_s
   {
   gavl_video_options_t opt;
@@ -418,8 +515,8 @@ struct gavl_video_scaler_s
   gavl_video_frame_t * src;
   gavl_video_frame_t * dst;
 
-  gavl_video_frame_t * src_field;
-  gavl_video_frame_t * dst_field;
+  gavl_video_frame_t * src_field[2];
+  gavl_video_frame_t * dst_field[2];
   
   gavl_video_format_t src_format;
   gavl_video_format_t dst_format;
@@ -427,7 +524,32 @@ struct gavl_video_scaler_s
   gavl_rectangle_i_t dst_rect;
   //  gavl_rectangle_f_t src_rect;
 
+  /* Multithreaded scaling */
+  gavl_video_scale_job_t jobs[2 * GAVL_MAX_PLANES];
+  int num_jobs;
+  gavl_video_scaler_thread_t * threads;
+  int num_threads;
+
+  /* Multiple outputs (gavl_video_scaler_init_multi()) */
+  gavl_video_scaler_t ** outputs;
+  int * output_src;   /* Output, which is the source of an output, -1 for the input */
+  int * output_order; /* Outputs sorted by size, largest first */
+  int num_outputs;
+  int outputs_alloc;
   };
 
+/* Band wise scaling for the fused video converter */
+
+int gavl_video_scaler_can_scale_band(gavl_video_scaler_t * s);
+
+void gavl_video_scaler_scale_band_init(gavl_video_scaler_t * s,
+                                       const gavl_video_frame_t * src);
+
+/* Scale the scanlines y...y+h-1 into dst, which starts at scanline y */
+
+void gavl_video_scaler_scale_band(gavl_video_scaler_t * s,
+                                  gavl_video_frame_t * dst,
+                                  int y, int h, int thread);
+
 
 #endif // SCALE_H_INCLUDED
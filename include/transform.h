@@ -24,6 +24,13 @@
 
 #define MAX_TRANSFORM_FILTER 4
 
+/* Fractional source positions are quantized to 1/TRANSFORM_PHASES pixels */
+
+#define TRANSFORM_PHASE_BITS 8
+#define TRANSFORM_PHASES     (1<<TRANSFORM_PHASE_BITS)
+
+/* Full description of one destination pixel */
+
 typedef struct 
   {
   int index_x;
@@ -34,12 +41,31 @@ typedef struct
   int   factors_i[MAX_TRANSFORM_FILTER][MAX_TRANSFORM_FILTER];
   } gavl_transform_pixel_t;
 
+/* Compact table entry */
+
+#define TRANSFORM_ENTRY_FILTER  0 /* Filter with the coefficient tables   */
+#define TRANSFORM_ENTRY_OUTSIDE 1 /* Outside the source image             */
+#define TRANSFORM_ENTRY_BORDER  2 /* Filter was cut at the image border,
+                                     index_x | (index_y << 16) is the index
+                                     into the border pixels of the row    */
+
+typedef struct
+  {
+  uint16_t index_x;
+  uint16_t index_y;
+  uint8_t phase_x;
+  uint8_t phase_y;
+  uint8_t type;
+  uint8_t reserved;
+  } gavl_transform_entry_t;
+
 typedef struct gavl_transform_context_s gavl_transform_context_t;
 
 typedef void
 (*gavl_transform_scanline_func)(gavl_transform_context_t * ctx,
-                                gavl_transform_pixel_t * pixels,
-                                uint8_t * dest_start);
+                                const gavl_transform_entry_t * entries,
+                                const gavl_transform_pixel_t * border,
+                                uint8_t * dest_start, int width);
 
 typedef struct
   {
@@ -97,23 +123,84 @@ void gavl_init_transform_funcs_bicubic_mmxext(gavl_transform_funcs_t * tab,
 
 #endif
 
+#ifdef HAVE_AVX2
+void gavl_init_transform_funcs_bilinear_avx2(gavl_transform_funcs_t * tab,
+                                             int advance);
+void gavl_init_transform_funcs_quadratic_avx2(gavl_transform_funcs_t * tab,
+                                              int advance);
+void gavl_init_transform_funcs_bicubic_avx2(gavl_transform_funcs_t * tab,
+                                            int advance);
+#endif
+
+/*
+ *  The destination is processed in tiles. For rotations and lens
+ *  distortions, the source pixels needed by one tile are close to
+ *  each other, so they stay in the cache while the tile is processed.
+ */
+
+#define TRANSFORM_TILE_WIDTH  64
+#define TRANSFORM_TILE_HEIGHT 16
 
+/*
+ *  The table stores one compact entry per destination pixel. The filter
+ *  coefficients are looked up by the fractional phase of the source
+ *  position. Only pixels, where the filter hits the image border, are
+ *  stored completely.
+ *
+ *  For perspective (and affine) transforms, the table is not stored at all.
+ *  The entries are calculated on the fly while transforming.
+ */
 
 typedef struct 
   {
-  gavl_transform_pixel_t ** pixels;
+  gavl_transform_entry_t ** entries;
+  gavl_transform_pixel_t ** border;
+  int * num_border;
+  
   int factors_per_pixel; /* Per dimension */
+  int width;
+  int height;
+  
+  /* Coefficients by phase */
+  float lut_f[TRANSFORM_PHASES][MAX_TRANSFORM_FILTER];
+
+  int bits;
+  int lut_i_x[TRANSFORM_PHASES][MAX_TRANSFORM_FILTER];
+  int lut_i_y[TRANSFORM_PHASES][MAX_TRANSFORM_FILTER];
+
+  /* Perspective transform */
+  int parametric;
+  double matrix[3][3];
+  float off_x;
+  float off_y;
+  float scale_x;
+  float scale_y;
   } gavl_transform_table_t;
 
 void gavl_transform_table_init(gavl_transform_table_t * t,
                                gavl_video_options_t * opt,
                                gavl_image_transform_func func, void * priv,
+                               const double (*matrix)[3],
                                float off_x, float off_y, float scale_x,
                                float scale_y, int width, int height);
 
 void gavl_transform_table_init_int(gavl_transform_table_t * tab,
-                                   int bits, int width, int height);
+                                   int bits);
+
+/* Calculate the entries for a part of a row, used for parametric tables */
+
+void gavl_transform_table_get_entries(const gavl_transform_table_t * tab,
+                                      int row, int start, int num,
+                                      gavl_transform_entry_t * entries,
+                                      gavl_transform_pixel_t * border);
+
+/* Expand compact entries into complete pixels */
 
+void gavl_transform_table_expand(const gavl_transform_table_t * tab,
+                                 const gavl_transform_entry_t * entries,
+                                 const gavl_transform_pixel_t * border,
+                                 gavl_transform_pixel_t * pixels,
+                                 int num);
 
 void
 gavl_transform_table_free(gavl_transform_table_t * tab);
@@ -149,7 +236,8 @@ int
 gavl_transform_context_init(gavl_image_transform_t * t,
                             gavl_video_options_t * opt,
                             int field_index, int plane_index,
-                            gavl_image_transform_func func, void * priv);
+                            gavl_image_transform_func func, void * priv,
+                            const double (*matrix)[3]);
 
 void
 gavl_transform_context_transform(gavl_transform_context_t * ctx,
@@ -74,8 +74,17 @@ struct gavl_video_options_s
   
   void (*stop_func)(void * gavl_data, int thread);
   void * stop_data;
+
+  /* Set if run_func and stop_func belong to a thread pool (not owned) */
+  gavl_thread_pool_t * thread_pool;
   };
 
+/* Distribute the range 0..num-1 among the threads and wait until done */
+
+void gavl_video_run_slices(const gavl_video_options_t * opt,
+                           void (*func)(void*, int, int),
+                           void * data, int num);
+
 typedef struct gavl_video_convert_context_s gavl_video_convert_context_t;
 
 typedef void (*gavl_video_func_t)(gavl_video_convert_context_t * ctx);
@@ -94,8 +103,56 @@ struct gavl_video_convert_context_s
   
   struct gavl_video_convert_context_s * next;
   gavl_video_func_t func;
+
+  /* Fused conversion: The output goes into band buffers (one per thread),
+     which are read by the next context */
+  int fused;
+  gavl_video_frame_t ** band_frames;
   };
 
+/* Thread specific data for fused conversion */
+
+typedef struct
+  {
+  gavl_video_converter_t * cnv;
+  int thread;
+  } gavl_video_band_thread_t;
+
+/* Thread specific data for batch conversion */
+
+typedef struct
+  {
+  gavl_video_converter_t * cnv; /* Single threaded converter */
+  const gavl_video_frame_t ** input_frames;
+  gavl_video_frame_t ** output_frames;
+  } gavl_video_batch_thread_t;
+
+/* Cached conversion plan: The context chain together with the
+   formats and options it was built for */
+
+typedef struct
+  {
+  gavl_video_format_t input_format;
+  gavl_video_format_t output_format;
+  gavl_video_options_t options;
+  int num_steps; /* Return value of gavl_video_converter_reinit() */
+  
+  gavl_video_convert_context_t * first_context;
+  gavl_video_convert_context_t * last_context;
+  int num_contexts;
+  int have_frames;
+  
+  gavl_video_convert_context_t * fused_first;
+  gavl_video_convert_context_t * fused_last;
+  int band_height;
+  int num_bands;
+  
+  gavl_video_band_thread_t * band_threads;
+  int num_band_threads;
+
+  int64_t last_used;
+  } gavl_video_convert_plan_t;
+
 struct gavl_video_converter_s
   {
   gavl_video_format_t input_format;
@@ -108,6 +165,27 @@ struct gavl_video_converter_s
   int num_contexts;
 
   int have_frames;
+
+  /* Fused conversion */
+  gavl_video_convert_context_t * fused_first;
+  gavl_video_convert_context_t * fused_last;
+  
+  int band_height;
+  int num_bands;
+
+  gavl_video_band_thread_t * band_threads;
+  int num_band_threads;
+
+  /* Plan cache */
+  gavl_video_convert_plan_t * plans;
+  int num_plans;
+  int max_plans;
+  int cur_plan; /* Index of the current chain in plans or -1 */
+  int64_t plan_counter;
+
+  /* Batch conversion: One converter per thread */
+  gavl_video_batch_thread_t * batch_threads;
+  int num_batch_threads;
   };
 
 
@@ -141,6 +219,20 @@ gavl_pixelformat_t gavl_pixelformat_get_intermediate(gavl_pixelformat_t in_csp,
                         CLEAR_MASK_PLANE_2|\
                         CLEAR_MASK_PLANE_3)
 
+/* Cost model (videocost.c): Estimated time for one frame in units
+   of gavl_benchmark_get_time(). Negative if the step is not supported */
+
+double gavl_video_cost_pixelformat(const gavl_video_options_t * opt,
+                                   const gavl_video_format_t * in_format,
+                                   const gavl_video_format_t * out_format);
+
+double gavl_video_cost_scale(const gavl_video_options_t * opt,
+                             const gavl_video_format_t * in_format,
+                             const gavl_video_format_t * out_format);
+
+double gavl_video_cost_deinterlace(const gavl_video_options_t * opt,
+                                   const gavl_video_format_t * format);
+
 void gavl_video_frame_clear_mask(gavl_video_frame_t * frame,
                                  const gavl_video_format_t * format, int mask);
 
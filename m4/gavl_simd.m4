@@ -125,6 +125,22 @@ dnl
     AC_MSG_RESULT(no)
   fi
 
+dnl
+dnl Check for AVX2 intrinsics. AVX2 code is compiled with -mavx2 in
+dnl its own directory and called only if the CPU supports it
+dnl
+
+  AC_MSG_CHECKING([if C compiler accepts AVX2 intrinsics])
+  CFLAGS="$2 -mavx2"
+  AC_TRY_LINK([#include <immintrin.h>],[__m256i m1 = _mm256_set1_epi16(1); m1 = _mm256_add_epi16(m1, m1)],HAVE_AVX2=true)
+  CFLAGS=$2
+  if test "$HAVE_AVX2" = true; then
+    AVX2_CFLAGS="-mavx2"
+    AC_MSG_RESULT(yes)
+  else
+    AC_MSG_RESULT(no)
+  fi
+
 dnl
 dnl Check for MMX intrinsics
 dnl
@@ -183,8 +199,11 @@ dnl Check for SSE2 intrinsics
 dnl
 
   AC_MSG_CHECKING([if C compiler accepts SSE2 intrinsics])
+  CFLAGS="$2 -msse2"
   AC_TRY_LINK([#include <emmintrin.h>],[__m128d m1; m1 = _mm_set1_pd(1.0)],HAVE_SSE2_INT=true)
+  CFLAGS=$2
   if test "$HAVE_SSE2_INT" = true; then
+    SSE2_CFLAGS="-msse2"
     AC_MSG_RESULT(yes)
   else
     AC_MSG_RESULT(no)
@@ -223,6 +242,7 @@ AH_TEMPLATE([HAVE_SSE],    [SSE Supported])
 AH_TEMPLATE([HAVE_SSE2],   [SSE2 Supported])
 AH_TEMPLATE([HAVE_SSE3],   [SSE3 Supported])
 AH_TEMPLATE([HAVE_SSSE3],   [SSSE3 Supported])
+AH_TEMPLATE([HAVE_AVX2],   [AVX2 Supported])
 
 GAVL_CHECK_SIMD_INTERNAL($1, $2)
 
@@ -245,6 +265,7 @@ if test x"$HAVE_SSE2" = "xtrue"; then
 AC_DEFINE(HAVE_SSE2)
 fi
 AM_CONDITIONAL(HAVE_SSE2, test "x$HAVE_SSE2" = "xtrue")
+AC_SUBST(SSE2_CFLAGS)
 
 if test x"$HAVE_SSE3" = "xtrue"; then
 AC_DEFINE(HAVE_SSE3)
@@ -256,6 +277,12 @@ AC_DEFINE(HAVE_SSSE3)
 fi
 AM_CONDITIONAL(HAVE_SSSE3, test "x$HAVE_SSSE3" = "xtrue")
 
+if test x"$HAVE_AVX2" = "xtrue"; then
+AC_DEFINE(HAVE_AVX2)
+fi
+AM_CONDITIONAL(HAVE_AVX2, test "x$HAVE_AVX2" = "xtrue")
+AC_SUBST(AVX2_CFLAGS)
+
 if test x"$ARCH_X86" = "xtrue"; then
 AC_DEFINE(ARCH_X86)
 fi
@@ -27,6 +27,7 @@
 
 
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
 #include <stdio.h>
 #include <unistd.h>
@@ -910,6 +911,10 @@ static void benchmark_pixelformat()
       gavl_video_options_set_accel_flags(ctx.opt, GAVL_ACCEL_SSE3);
       do_pixelformat(&ctx, &b, in_format, out_format, "SSE3");
       fflush(stdout);
+
+      gavl_video_options_set_accel_flags(ctx.opt, GAVL_ACCEL_AVX2);
+      do_pixelformat(&ctx, &b, in_format, out_format, "AVX2");
+      fflush(stdout);
       
       }
     }
@@ -1144,6 +1149,7 @@ deinterlace_modes[] =
     { "Scanline doubler", GAVL_DEINTERLACE_COPY },
     { "Upscale",          GAVL_DEINTERLACE_SCALE },
     { "Blend",            GAVL_DEINTERLACE_BLEND },
+    { "Motion adaptive",  GAVL_DEINTERLACE_ADAPTIVE },
   };
 
 static void benchmark_deinterlace()
@@ -1515,6 +1521,255 @@ static void benchmark_dsp_interpolate()
   
   }
 
+/* DSP functions */
+
+#define DSP_WIDTH  720
+#define DSP_HEIGHT 576
+
+typedef enum
+  {
+    DSP_SAD,
+    DSP_SAD_F,
+    DSP_AVERAGE,
+    DSP_INTERPOLATE,
+    DSP_BSWAP,
+    DSP_ARITH,
+    DSP_SHIFT,
+    DSP_SHUFFLE,
+    DSP_SAD_CANDIDATES,
+  } dsp_func_type_t;
+
+#define DSP_FUNC(name, type, bytes) \
+  { #name, type, offsetof(gavl_dsp_funcs_t, name), bytes }
+
+static const struct
+  {
+  const char * name;
+  dsp_func_type_t type;
+  size_t offset;
+  int bytes; /* Bytes per element */
+  }
+dsp_funcs[] =
+  {
+    DSP_FUNC(sad_rgb15,         DSP_SAD,         2),
+    DSP_FUNC(sad_rgb16,         DSP_SAD,         2),
+    DSP_FUNC(sad_8,             DSP_SAD,         1),
+    DSP_FUNC(sad_16,            DSP_SAD,         2),
+    DSP_FUNC(sad_f,             DSP_SAD_F,       4),
+    DSP_FUNC(average_rgb15,     DSP_AVERAGE,     2),
+    DSP_FUNC(average_rgb16,     DSP_AVERAGE,     2),
+    DSP_FUNC(average_8,         DSP_AVERAGE,     1),
+    DSP_FUNC(average_16,        DSP_AVERAGE,     2),
+    DSP_FUNC(average_f,         DSP_AVERAGE,     4),
+    DSP_FUNC(interpolate_rgb15, DSP_INTERPOLATE, 2),
+    DSP_FUNC(interpolate_rgb16, DSP_INTERPOLATE, 2),
+    DSP_FUNC(interpolate_8,     DSP_INTERPOLATE, 1),
+    DSP_FUNC(interpolate_16,    DSP_INTERPOLATE, 2),
+    DSP_FUNC(interpolate_f,     DSP_INTERPOLATE, 4),
+    DSP_FUNC(bswap_16,          DSP_BSWAP,       2),
+    DSP_FUNC(bswap_32,          DSP_BSWAP,       4),
+    DSP_FUNC(bswap_64,          DSP_BSWAP,       8),
+    DSP_FUNC(add_u8,            DSP_ARITH,       1),
+    DSP_FUNC(add_u8_s,          DSP_ARITH,       1),
+    DSP_FUNC(add_s8,            DSP_ARITH,       1),
+    DSP_FUNC(add_u16,           DSP_ARITH,       2),
+    DSP_FUNC(add_u16_s,         DSP_ARITH,       2),
+    DSP_FUNC(add_s16,           DSP_ARITH,       2),
+    DSP_FUNC(add_s32,           DSP_ARITH,       4),
+    DSP_FUNC(add_float,         DSP_ARITH,       4),
+    DSP_FUNC(add_double,        DSP_ARITH,       8),
+    DSP_FUNC(sub_u8,            DSP_ARITH,       1),
+    DSP_FUNC(sub_u8_s,          DSP_ARITH,       1),
+    DSP_FUNC(sub_s8,            DSP_ARITH,       1),
+    DSP_FUNC(sub_u16,           DSP_ARITH,       2),
+    DSP_FUNC(sub_u16_s,         DSP_ARITH,       2),
+    DSP_FUNC(sub_s16,           DSP_ARITH,       2),
+    DSP_FUNC(sub_s32,           DSP_ARITH,       4),
+    DSP_FUNC(sub_float,         DSP_ARITH,       4),
+    DSP_FUNC(sub_double,        DSP_ARITH,       8),
+    DSP_FUNC(shift_up_16,       DSP_SHIFT,       2),
+    DSP_FUNC(shift_down_16,     DSP_SHIFT,       2),
+    DSP_FUNC(shuffle_8_4,       DSP_SHUFFLE,     4),
+    DSP_FUNC(sad_candidates_8,  DSP_SAD_CANDIDATES, 1),
+  };
+
+/* 16x16 block, all candidates of a 32x32 search window */
+#define DSP_BLOCK_SIZE     16
+#define DSP_NUM_CANDIDATES (32*32)
+
+static const struct
+  {
+  int flag;
+  const char * name;
+  }
+dsp_flavours[] =
+  {
+    { GAVL_ACCEL_C,      "C" },
+    { GAVL_ACCEL_MMX,    "MMX" },
+    { GAVL_ACCEL_MMXEXT, "MMXEXT" },
+    { GAVL_ACCEL_SSE,    "SSE" },
+    { GAVL_ACCEL_SSSE3,  "SSSE3" },
+    { GAVL_ACCEL_AVX2,   "AVX2" },
+  };
+
+typedef void (*dsp_func_t)(void);
+
+typedef struct
+  {
+  gavl_dsp_context_t * ctx;
+  gavl_dsp_funcs_t * funcs;
+  int index;
+
+  uint8_t * src_1;
+  uint8_t * src_2;
+  uint8_t * dst;
+
+  int offsets[DSP_NUM_CANDIDATES];
+  int costs[DSP_NUM_CANDIDATES];
+  } dsp_func_context_t;
+
+static dsp_func_t get_dsp_func(dsp_func_context_t * ctx)
+  {
+  return *(dsp_func_t*)((uint8_t*)ctx->funcs + dsp_funcs[ctx->index].offset);
+  }
+
+static void dsp_func(void * data)
+  {
+  dsp_func_context_t * ctx = data;
+  dsp_func_t f = get_dsp_func(ctx);
+  int stride = DSP_WIDTH * dsp_funcs[ctx->index].bytes;
+  int num = DSP_WIDTH * DSP_HEIGHT;
+  uint8_t mask[4] = { 3, 2, 1, 0 };
+
+  switch(dsp_funcs[ctx->index].type)
+    {
+    case DSP_SAD:
+      ((int (*)(const uint8_t *, const uint8_t *, int, int, int, int))f)
+        (ctx->src_1, ctx->src_2, stride, stride, DSP_WIDTH, DSP_HEIGHT);
+      break;
+    case DSP_SAD_F:
+      ((float (*)(const uint8_t *, const uint8_t *, int, int, int, int))f)
+        (ctx->src_1, ctx->src_2, stride, stride, DSP_WIDTH, DSP_HEIGHT);
+      break;
+    case DSP_AVERAGE:
+      ((void (*)(const uint8_t *, const uint8_t *, uint8_t *, int))f)
+        (ctx->src_1, ctx->src_2, ctx->dst, num);
+      break;
+    case DSP_INTERPOLATE:
+      ((void (*)(const uint8_t *, const uint8_t *, uint8_t *, int, float))f)
+        (ctx->src_1, ctx->src_2, ctx->dst, num, 0.3);
+      break;
+    case DSP_BSWAP:
+      ((void (*)(void *, int))f)(ctx->dst, num);
+      break;
+    case DSP_ARITH:
+      ((void (*)(const void *, const void *, void *, int))f)
+        (ctx->src_1, ctx->src_2, ctx->dst, num);
+      break;
+    case DSP_SHIFT:
+      ((void (*)(void *, int, int))f)(ctx->dst, num, 4);
+      break;
+    case DSP_SHUFFLE:
+      ((void (*)(void *, int, uint8_t *))f)(ctx->dst, num, mask);
+      break;
+    case DSP_SAD_CANDIDATES:
+      ((void (*)(const uint8_t *, int, const uint8_t *, int, int, int,
+                 const int *, int, int *))f)
+        (ctx->src_1, stride, ctx->src_2, stride,
+         DSP_BLOCK_SIZE, DSP_BLOCK_SIZE,
+         ctx->offsets, DSP_NUM_CANDIDATES, ctx->costs);
+      break;
+    }
+  }
+
+static void benchmark_dsp()
+  {
+  dsp_func_context_t ctx;
+  gavl_benchmark_t b;
+  int i, j;
+  int size = DSP_WIDTH * DSP_HEIGHT * 8;
+  int accel_supported = gavl_accel_supported() | GAVL_ACCEL_C;
+  
+  memset(&ctx, 0, sizeof(ctx));
+  memset(&b, 0, sizeof(b));
+
+  b.func = dsp_func;
+  b.data = &ctx;
+
+  printf("Size: %d x %d\n", DSP_WIDTH, DSP_HEIGHT);
+  
+  if(do_html)
+    {
+    printf("<p><table border=\"1\" width=\"100%%\"><tr><td>Function</td><td>Flavour</td>");
+    gavl_benchmark_print_header(&b);
+    printf("</tr>\n");
+    }
+  else
+    {
+    printf("Function                Flavour ");
+    gavl_benchmark_print_header(&b);
+    printf("\n");
+    }
+
+  /* The data don't change the speed, so we fill them only once */
+  ctx.src_1 = malloc(size);
+  ctx.src_2 = malloc(size);
+  ctx.dst   = malloc(size);
+
+  for(i = 0; i < size; i++)
+    {
+    ctx.src_1[i] = rand();
+    ctx.src_2[i] = rand();
+    ctx.dst[i]   = rand();
+    }
+
+  for(i = 0; i < DSP_NUM_CANDIDATES; i++)
+    ctx.offsets[i] = (i / 32) * DSP_WIDTH + (i % 32);
+  
+  ctx.ctx = gavl_dsp_context_create();
+  
+  /* Disable autoselection */
+  gavl_dsp_context_set_quality(ctx.ctx, 0);
+  ctx.funcs = gavl_dsp_context_get_funcs(ctx.ctx);
+  
+  for(i = 0; i < sizeof(dsp_funcs)/sizeof(dsp_funcs[0]); i++)
+    {
+    ctx.index = i;
+    
+    for(j = 0; j < sizeof(dsp_flavours)/sizeof(dsp_flavours[0]); j++)
+      {
+      if(!(dsp_flavours[j].flag & accel_supported))
+        continue;
+
+      gavl_dsp_context_set_accel_flags(ctx.ctx, dsp_flavours[j].flag);
+
+      if(!get_dsp_func(&ctx))
+        continue;
+      
+      if(do_html)
+        printf("<tr><td>%s</td><td>%s</td>", dsp_funcs[i].name,
+               dsp_flavours[j].name);
+      else
+        printf("%-23s %-7s ", dsp_funcs[i].name, dsp_flavours[j].name);
+      
+      gavl_benchmark_run(&b);
+      gavl_benchmark_print_results(&b);
+      if(do_html)
+        printf("</tr>");
+      printf("\n");
+      fflush(stdout);
+      }
+    }
+  
+  gavl_dsp_context_destroy(ctx.ctx);
+  free(ctx.src_1);
+  free(ctx.src_2);
+  free(ctx.dst);
+  
+  if(do_html)
+    printf("</table>\n");
+  }
+
 /* Image transformation */
 
 static const struct
@@ -1761,6 +2016,7 @@ static void benchmark_image_transform()
 #define BENCHMARK_INTERPOLATE  (1<<9)
 #define BENCHMARK_SAD          (1<<10)
 #define BENCHMARK_TRANSFORM    (1<<11)
+#define BENCHMARK_DSP          (1<<12)
 
 static const struct
   {
@@ -1781,6 +2037,7 @@ benchmark_flags[] =
     { "-deint", "Deinterlacing",           BENCHMARK_DEINTERLACE},
     { "-ip", "Video frame interpolation",  BENCHMARK_INTERPOLATE},
     { "-it", "Image transformation",  BENCHMARK_TRANSFORM},
+    { "-dsp", "DSP functions",  BENCHMARK_DSP},
     //    { "-sad", "SAD routines",              BENCHMARK_SAD},
   };
 
@@ -1933,6 +2190,8 @@ int main(int argc, char ** argv)
       printf("<a href=\"#ip\">Video frame interpolation</a><br>\n");
     if(flags & BENCHMARK_TRANSFORM)
       printf("<a href=\"#it\">Video image transformation</a><br>\n");
+    if(flags & BENCHMARK_DSP)
+      printf("<a href=\"#dsp\">DSP functions</a><br>\n");
     }
   else
     printf("Times are %s\n", gavl_benchmark_get_desc(gavl_accel_supported()));
@@ -2011,6 +2270,15 @@ int main(int argc, char ** argv)
     print_header("Video image transformation");
     benchmark_image_transform();
     }
+  if(flags & BENCHMARK_DSP)
+    {
+    if(do_html)
+      {
+      printf("<a name=\"dsp\"></a>");
+      }
+    print_header("DSP functions");
+    benchmark_dsp();
+    }
   
   if(do_html)
     {
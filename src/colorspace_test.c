@@ -2654,6 +2654,135 @@ static gavl_video_frame_t * create_picture(gavl_pixelformat_t pixelformat,
   return  ret;
   }
 
+/* Size of one sample in bytes. Packed formats with bitfields
+   (RGB 15/16) are compared bytewise. */
+
+static int sample_size(gavl_pixelformat_t pixelformat)
+  {
+  int bytes, channels;
+  
+  if(gavl_pixelformat_is_planar(pixelformat))
+    return gavl_pixelformat_bytes_per_component(pixelformat);
+
+  bytes = gavl_pixelformat_bytes_per_pixel(pixelformat);
+  channels = gavl_pixelformat_num_channels(pixelformat);
+
+  if(bytes % channels)
+    return 1;
+  return bytes / channels;
+  }
+
+/* Maximum difference of the samples (floats in units of 1/255).
+   The unused 4th byte of RGB_32 and BGR_32 is skipped. */
+
+static int frame_diff(const gavl_video_format_t * format,
+                      const gavl_video_frame_t * f1,
+                      const gavl_video_frame_t * f2)
+  {
+  int i, j, k, num_planes, sub_h, sub_v, width, height, size;
+  int diff, ret = 0;
+  int skip_padding;
+  const uint8_t * s1, * s2;
+  float diff_f;
+  
+  num_planes = gavl_pixelformat_num_planes(format->pixelformat);
+  gavl_pixelformat_chroma_sub(format->pixelformat, &sub_h, &sub_v);
+  size = sample_size(format->pixelformat);
+
+  skip_padding = (format->pixelformat == GAVL_RGB_32) ||
+    (format->pixelformat == GAVL_BGR_32);
+  
+  for(i = 0; i < num_planes; i++)
+    {
+    width = format->image_width;
+    height = format->image_height;
+    
+    if(i)
+      {
+      width /= sub_h;
+      height /= sub_v;
+      }
+
+    if(num_planes > 1)
+      width *= gavl_pixelformat_bytes_per_component(format->pixelformat);
+    else
+      width *= gavl_pixelformat_bytes_per_pixel(format->pixelformat);
+    width /= size;
+    
+    for(j = 0; j < height; j++)
+      {
+      s1 = f1->planes[i] + j * f1->strides[i];
+      s2 = f2->planes[i] + j * f2->strides[i];
+
+      for(k = 0; k < width; k++)
+        {
+        if(skip_padding && ((k & 3) == 3))
+          continue;
+        
+        switch(size)
+          {
+          case 1:
+            diff = s1[k] - s2[k];
+            break;
+          case 2:
+            diff = ((const uint16_t*)s1)[k] - ((const uint16_t*)s2)[k];
+            break;
+          default:
+            diff_f = ((const float*)s1)[k] - ((const float*)s2)[k];
+            diff = (int)(diff_f * 255.0 + (diff_f < 0.0 ? -0.5 : 0.5));
+            break;
+          }
+        if(diff < 0)
+          diff = -diff;
+        if(diff > ret)
+          ret = diff;
+        }
+      }
+    }
+  return ret;
+  }
+
+/*
+ *  Compare the AVX2 version with the C version. Returns the maximum
+ *  difference of the samples or -1 if there is no AVX2 version.
+ */
+
+static int compare_avx2(gavl_video_converter_t * cnv,
+                        const gavl_video_format_t * input_format,
+                        const gavl_video_format_t * output_format,
+                        const gavl_video_frame_t * input_frame,
+                        gavl_alpha_mode_t alpha_mode)
+  {
+  int ret = -1;
+  gavl_video_frame_t * c_frame;
+  gavl_video_frame_t * avx2_frame;
+  gavl_video_options_t * opt = gavl_video_converter_get_options(cnv);
+  
+  c_frame = gavl_video_frame_create(output_format);
+  avx2_frame = gavl_video_frame_create(output_format);
+  gavl_video_frame_clear(c_frame, output_format);
+  gavl_video_frame_clear(avx2_frame, output_format);
+  
+  gavl_video_options_set_alpha_mode(opt, alpha_mode);
+
+  gavl_video_options_set_accel_flags(opt, GAVL_ACCEL_C);
+  if(gavl_video_converter_init(cnv, input_format, output_format) <= 0)
+    goto fail;
+  gavl_video_convert(cnv, input_frame, c_frame);
+  
+  gavl_video_options_set_accel_flags(opt, GAVL_ACCEL_AVX2);
+  if(gavl_video_converter_init(cnv, input_format, output_format) <= 0)
+    goto fail;
+  gavl_video_convert(cnv, input_frame, avx2_frame);
+
+  ret = frame_diff(output_format, c_frame, avx2_frame);
+  
+  fail:
+  gavl_video_frame_destroy(c_frame);
+  gavl_video_frame_destroy(avx2_frame);
+  return ret;
+  }
+
 int main(int argc, char ** argv)
   {
 #ifdef ALL_PIXELFORMATS
@@ -2661,6 +2790,9 @@ int main(int argc, char ** argv)
 #endif
   const char * tmp1, * tmp2;
   char filename_buffer[128];
+  int k, diff, ret = 0;
+  static const gavl_alpha_mode_t alpha_modes[] =
+    { GAVL_ALPHA_IGNORE, GAVL_ALPHA_BLEND_COLOR };
 
   //  float background[3] = { 1.0, 0.0, 0.0 };
     
@@ -2840,6 +2972,33 @@ int main(int argc, char ** argv)
                    output_frame, &output_format);
         fprintf(stderr, "Wrote %s\n", filename_buffer);
         }
+
+      gavl_video_options_set_accel_flags(opt, GAVL_ACCEL_AVX2);
+      gavl_video_frame_clear(output_frame, &output_format);
+      sprintf(filename_buffer, "%s_to_%s_avx2.png", tmp1, tmp2);
+      if(gavl_video_converter_init(cnv, &input_format, &output_format) <= 0)
+        fprintf(stderr, "No AVX2 Conversion defined yet\n");
+      else
+        {
+        fprintf(stderr, "AVX2 Version:    ");
+        gavl_video_convert(cnv, input_frame, output_frame);
+        write_file(filename_buffer,
+                   output_frame, &output_format);
+        fprintf(stderr, "Wrote %s\n", filename_buffer);
+        }
+
+      /* The AVX2 versions must be within +-1 of the C versions */
+      for(k = 0; k < sizeof(alpha_modes) / sizeof(alpha_modes[0]); k++)
+        {
+        diff = compare_avx2(cnv, &input_format, &output_format,
+                            input_frame, alpha_modes[k]);
+        if(diff < 0)
+          continue;
+        fprintf(stderr, "AVX2 vs. C (alpha mode %d): max difference %d%s\n",
+                alpha_modes[k], diff, (diff > 1) ? " FAILED" : "");
+        if(diff > 1)
+          ret = 1;
+        }
 #endif
       
       gavl_video_frame_destroy(output_frame);
@@ -2849,5 +3008,5 @@ int main(int argc, char ** argv)
     }
 #endif  
   
-  return 0;
+  return ret;
   }
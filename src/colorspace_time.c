@@ -162,6 +162,21 @@ int main()
         gavl_video_options_set_accel_flags(opt, GAVL_ACCEL_MMXEXT);
         fprintf(stderr, "MMXEXT Version: ");
         
+        if(gavl_video_converter_init(cnv, &input_format, &output_format) < 1)
+          fprintf(stderr, "No Conversion defined yet\n");
+        else
+          {
+          timer_init();
+          for(k = 0; k < NUM_CONVERSIONS; k++)
+            gavl_video_convert(cnv, input_frame, output_frame);
+          timer_stop();
+          }
+
+        /* Now, initialize with AVX2 */
+
+        gavl_video_options_set_accel_flags(opt, GAVL_ACCEL_AVX2);
+        fprintf(stderr, "AVX2 Version:   ");
+        
         if(gavl_video_converter_init(cnv, &input_format, &output_format) < 1)
           fprintf(stderr, "No Conversion defined yet\n");
         else